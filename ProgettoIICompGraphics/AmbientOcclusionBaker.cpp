@@ -0,0 +1,216 @@
+#include "AmbientOcclusionBaker.hpp"
+
+#include "Hash.hpp"
+#include "Material.hpp"
+#include "Mesh.hpp"
+#include "MeshInstanceNode.hpp"
+#include "Parallel.hpp"
+#include "TriangleBvh.hpp"
+#include "Vertex.hpp"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+#include <glm/gtc/constants.hpp>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace AmbientOcclusionBaker {
+	// Part of the cache key, bumped whenever the bake changes
+	static constexpr uint32_t CACHE_VERSION = 1;
+	// Distance the rays start off the surface, so they don't hit it
+	static constexpr float RAY_OFFSET = 0.005f;
+
+	/**
+	 * Collects the mesh nodes to bake and the ones occluding them below a node.
+	 *
+	 * \param node The node to start from.
+	 * \param targets The output list of the lit nodes with their CPU data.
+	 * \param occluders The output list of every opaque node with its positions, the targets included.
+	 */
+	static void collectMeshes(SceneNode* node, std::vector<MeshInstanceNode*>& targets, std::vector<MeshInstanceNode*>& occluders);
+
+	/**
+	 * Loads the baked values of every mesh from the cache on disk.
+	 *
+	 * \param cachePath The path of the cache file.
+	 * \param key The key of the current scene.
+	 * \param values The values of every mesh, sized to their vertex count (output variable).
+	 * \return False if there is no cache or it is out of date.
+	 */
+	static bool loadCache(const std::string& cachePath, const uint64_t key, std::vector<std::vector<uint8_t>>& values);
+
+	/**
+	 * Saves the baked values of every mesh to the cache on disk.
+	 *
+	 * \param cachePath The path of the cache file.
+	 * \param key The key of the current scene.
+	 * \param values The values of every mesh.
+	 */
+	static void saveCache(const std::string& cachePath, const uint64_t key, const std::vector<std::vector<uint8_t>>& values);
+}
+
+void AmbientOcclusionBaker::collectMeshes(SceneNode* node, std::vector<MeshInstanceNode*>& targets, std::vector<MeshInstanceNode*>& occluders) {
+	if (MeshInstanceNode* meshNode = dynamic_cast<MeshInstanceNode*>(node)) {
+		const Material* material = meshNode->getMaterial().get();
+		const Mesh* mesh = meshNode->getMesh();
+		if (!material->transparentFlag && mesh->drawType == GL_TRIANGLES && !mesh->getIndices().empty()) {
+			occluders.emplace_back(meshNode);
+			if (material->litFlag && !mesh->getVertices().empty()) {
+				targets.emplace_back(meshNode);
+			}
+		}
+	}
+	for (const std::shared_ptr<SceneNode>& child : node->getChildren()) {
+		AmbientOcclusionBaker::collectMeshes(child.get(), targets, occluders);
+	}
+}
+
+bool AmbientOcclusionBaker::loadCache(const std::string& cachePath, const uint64_t key, std::vector<std::vector<uint8_t>>& values) {
+	std::ifstream file(cachePath, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	uint64_t fileKey = 0;
+	file.read(reinterpret_cast<char*>(&fileKey), sizeof(fileKey));
+	if (!file || fileKey != key) {
+		return false;
+	}
+	for (std::vector<uint8_t>& meshValues : values) {
+		file.read(reinterpret_cast<char*>(meshValues.data()), meshValues.size());
+	}
+	return static_cast<bool>(file);
+}
+
+void AmbientOcclusionBaker::saveCache(const std::string& cachePath, const uint64_t key, const std::vector<std::vector<uint8_t>>& values) {
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+	std::ofstream file(cachePath, std::ios::binary);
+	if (!file) {
+		std::cerr << "Could not save the ambient occlusion cache: " << cachePath << std::endl;
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+	for (const std::vector<uint8_t>& meshValues : values) {
+		file.write(reinterpret_cast<const char*>(meshValues.data()), meshValues.size());
+	}
+}
+
+void AmbientOcclusionBaker::bake(const std::shared_ptr<SceneNode>& root, const std::string& name, const uint32_t samples, const float maxDistance) {
+	const double startTime = glfwGetTime();
+	std::vector<MeshInstanceNode*> targets;
+	std::vector<MeshInstanceNode*> occluders;
+	AmbientOcclusionBaker::collectMeshes(root.get(), targets, occluders);
+	// Every mesh with the instances it gets averaged over, in the order they were found
+	std::vector<Mesh*> meshes;
+	std::unordered_map<Mesh*, std::vector<const MeshInstanceNode*>> meshInstances;
+	for (const MeshInstanceNode* target : targets) {
+		std::vector<const MeshInstanceNode*>& instances = meshInstances[target->getMesh()];
+		if (instances.empty()) {
+			meshes.emplace_back(target->getMesh());
+		}
+		instances.emplace_back(target);
+	}
+	if (meshes.empty()) {
+		std::cout << "Baked ambient occlusion: " << name << " (nothing to bake)" << std::endl;
+		return;
+	}
+	// FNV-1a over everything the occlusion depends on
+	uint64_t key = Hash::FNV_OFFSET_BASIS;
+	const auto addToKey = [&key](const void* data, const size_t size) {
+		key = Hash::fnv1a(data, size, key);
+	};
+	addToKey(&CACHE_VERSION, sizeof(CACHE_VERSION));
+	addToKey(&samples, sizeof(samples));
+	addToKey(&maxDistance, sizeof(maxDistance));
+	const auto addMeshToKey = [&addToKey](const Mesh* mesh) {
+		const std::vector<glm::vec3> positions = mesh->getPositions();
+		const std::vector<uint32_t>& indices = mesh->getIndices();
+		const size_t counts[2] = { positions.size(), indices.size() };
+		addToKey(counts, sizeof(counts));
+		addToKey(positions.data(), positions.size() * sizeof(glm::vec3));
+		addToKey(indices.data(), indices.size() * sizeof(uint32_t));
+	};
+	for (Mesh* mesh : meshes) {
+		addMeshToKey(mesh);
+		for (const MeshInstanceNode* instance : meshInstances[mesh]) {
+			addToKey(&instance->getWorldTransform().getTransformMatrix(), sizeof(glm::mat4));
+		}
+	}
+	for (const MeshInstanceNode* occluder : occluders) {
+		addMeshToKey(occluder->getMesh());
+		addToKey(&occluder->getWorldTransform().getTransformMatrix(), sizeof(glm::mat4));
+	}
+	std::vector<std::vector<uint8_t>> values(meshes.size());
+	size_t vertexCount = 0;
+	for (size_t i = 0; i < meshes.size(); ++i) {
+		values[i].resize(meshes[i]->getVertices().size());
+		vertexCount += values[i].size();
+	}
+	const std::string cachePath = "assets/occlusion/" + name + ".occlusion";
+	if (AmbientOcclusionBaker::loadCache(cachePath, key, values)) {
+		for (size_t i = 0; i < meshes.size(); ++i) {
+			meshes[i]->setVertexOcclusion(values[i]);
+		}
+		std::cout << "Loaded ambient occlusion: " << cachePath << std::endl;
+		return;
+	}
+	// Every opaque triangle in world space
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	for (const MeshInstanceNode* occluder : occluders) {
+		const Mesh* mesh = occluder->getMesh();
+		const glm::mat4& worldMatrix = occluder->getWorldTransform().getTransformMatrix();
+		const uint32_t baseVertex = static_cast<uint32_t>(positions.size());
+		for (const glm::vec3& position : mesh->getPositions()) {
+			positions.emplace_back(worldMatrix * glm::vec4(position, 1.0f));
+		}
+		const Mesh::Lod& fullDetail = mesh->getLod(0);
+		for (uint32_t i = 0; i < fullDetail.indexCount; ++i) {
+			indices.emplace_back(baseVertex + mesh->getIndices()[fullDetail.indexOffset + i]);
+		}
+	}
+	const TriangleBvh bvh(positions, indices);
+	for (size_t i = 0; i < meshes.size(); ++i) {
+		const std::vector<Vertex>& vertices = meshes[i]->getVertices();
+		const std::vector<const MeshInstanceNode*>& instances = meshInstances.at(meshes[i]);
+		std::vector<glm::mat4> worldMatrices;
+		std::vector<glm::mat3> normalMatrices;
+		for (const MeshInstanceNode* instance : instances) {
+			worldMatrices.emplace_back(instance->getWorldTransform().getTransformMatrix());
+			normalMatrices.emplace_back(glm::transpose(glm::inverse(glm::mat3(worldMatrices.back()))));
+		}
+		std::vector<uint8_t>& meshValues = values[i];
+		Parallel::forEach(vertices.size(), [&](const size_t vertex) {
+			// Seeded by the vertex, so every bake of the same scene gives the same result
+			std::minstd_rand random(static_cast<uint32_t>(vertex) + 1);
+			std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+			uint32_t occluded = 0;
+			uint32_t cast = 0;
+			for (size_t instance = 0; instance < instances.size(); ++instance) {
+				const glm::vec3 normal = normalMatrices[instance] * vertices[vertex].normal;
+				if (glm::length(normal) < 1e-6f) {
+					continue;
+				}
+				const glm::vec3 unitNormal = glm::normalize(normal);
+				const glm::vec3 tangent = glm::normalize(glm::cross(glm::abs(unitNormal.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), unitNormal));
+				const glm::vec3 bitangent = glm::cross(unitNormal, tangent);
+				const glm::vec3 origin = glm::vec3(worldMatrices[instance] * glm::vec4(vertices[vertex].position, 1.0f)) + unitNormal * RAY_OFFSET;
+				for (uint32_t sample = 0; sample < samples; ++sample) {
+					const float radius = std::sqrt(distribution(random));
+					const float angle = glm::two_pi<float>() * distribution(random);
+					const glm::vec3 direction = tangent * (radius * std::cos(angle)) + bitangent * (radius * std::sin(angle)) + unitNormal * std::sqrt(glm::max(1.0f - radius * radius, 0.0f));
+					occluded += bvh.isOccluded(origin, direction, maxDistance) ? 1 : 0;
+					++cast;
+				}
+			}
+			meshValues[vertex] = cast > 0 ? static_cast<uint8_t>(std::lround(255.0f * static_cast<float>(occluded) / static_cast<float>(cast))) : 0;
+		});
+		meshes[i]->setVertexOcclusion(meshValues);
+	}
+	AmbientOcclusionBaker::saveCache(cachePath, key, values);
+	std::cout << "Baked ambient occlusion: " << name << " (" << meshes.size() << " meshes, " << targets.size() << " instances, " << vertexCount << " vertices, " << bvh.getTriangleCount() << " triangles, " << glfwGetTime() - startTime << " s)" << std::endl;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+/**
+ * Forward declaration of the scene node class.
+ */
+class SceneNode;
+
+namespace AmbientOcclusionBaker {
+	static constexpr uint32_t DEFAULT_SAMPLES = 64;
+	static constexpr float DEFAULT_DISTANCE = 1.5f;
+
+	/**
+	 * Bakes the ambient occlusion of every vertex of the static meshes below a node and stores it in the meshes.
+	 * Each vertex casts cosine weighted rays over its hemisphere against a BVH of every opaque mesh below the node, on every
+	 * hardware thread; a mesh shared by several instances gets the average of all of them. The result is cached on disk and
+	 * only baked again when the meshes or their placement change.
+	 * The meshes must keep their CPU data (Mesh::DataRetention::ALL) to be baked, or at least their positions to occlude.
+	 *
+	 * \param root The node whose descendants never move.
+	 * \param name The name of the cache file in assets/occlusion.
+	 * \param samples The rays cast per vertex and instance.
+	 * \param maxDistance The distance past which nothing occludes a vertex.
+	 */
+	void bake(const std::shared_ptr<SceneNode>& root, const std::string& name, const uint32_t samples = DEFAULT_SAMPLES, const float maxDistance = DEFAULT_DISTANCE);
+}
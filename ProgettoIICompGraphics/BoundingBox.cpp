@@ -16,6 +16,20 @@ BoundingBox::BoundingBox(const std::vector<Vertex>& vertices)
 	}
 }
 
+BoundingBox::BoundingBox(const glm::vec3& _minValues, const glm::vec3& _maxValues)
+	:
+	maxValues(_maxValues),
+	minValues(_minValues)
+{}
+
+const glm::vec3& BoundingBox::getMinValues() const {
+	return this->minValues;
+}
+
+const glm::vec3& BoundingBox::getMaxValues() const {
+	return this->maxValues;
+}
+
 BoundingBox BoundingBox::transform(const glm::mat4& transformationMatrix) const {
 	std::vector<Vertex> verts(8);
 	// Transform the current bounding box's vertices by the matrix
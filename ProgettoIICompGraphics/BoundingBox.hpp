@@ -19,6 +19,28 @@ public:
 	 */
 	BoundingBox(const std::vector<Vertex>& vertices);
 
+	/**
+	 * Constructor for an axis aligned bounding box from its corners.
+	 *
+	 * \param _minValues The minimum values on each axis.
+	 * \param _maxValues The maximum values on each axis.
+	 */
+	BoundingBox(const glm::vec3& _minValues, const glm::vec3& _maxValues);
+
+	/**
+	 * Getter for the bounding box's minimum corner.
+	 *
+	 * \return The minimum values on each axis.
+	 */
+	const glm::vec3& getMinValues() const;
+
+	/**
+	 * Getter for the bounding box's maximum corner.
+	 *
+	 * \return The maximum values on each axis.
+	 */
+	const glm::vec3& getMaxValues() const;
+
 	/**
 	 * Creates a new bounding box given a transformation matrix.
 	 *
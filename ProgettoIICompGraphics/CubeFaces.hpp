@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace CubeFaces {
+	// Faces of a cubemap, in the OpenGL order (+X, -X, +Y, -Y, +Z, -Z)
+	static constexpr uint32_t COUNT = 6;
+
+	// Direction each face looks at
+	static const glm::vec3 DIRECTIONS[COUNT] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+
+	// Up vector of each face, matching the orientation of the cubemap texels
+	static const glm::vec3 UPS[COUNT] = {
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+}
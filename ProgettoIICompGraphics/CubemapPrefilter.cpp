@@ -0,0 +1,304 @@
+#include "CubemapPrefilter.hpp"
+
+#include "Hash.hpp"
+#include "Parallel.hpp"
+#include "TextureLoader.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <glfw/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <iostream>
+#include <stb_image.h>
+#include <stdexcept>
+
+namespace CubemapPrefilter {
+	// Part of the cache key, bumped whenever the filter changes
+	static constexpr uint32_t CACHE_VERSION = 1;
+
+	/**
+	 * A level of the source cubemap, in floating point so the filter doesn't band.
+	 */
+	struct SourceLevel {
+		uint32_t size;
+		std::array<std::vector<glm::vec3>, 6> faces;
+	};
+
+	/**
+	 * A direction of the GGX lobe around the normal, shared by every texel of a level.
+	 */
+	struct LobeSample {
+		glm::vec3 direction; /* Reflected direction, with the normal along z */
+		float weight; /* Cosine of the direction with the normal */
+		float sourceLevel; /* Level of the source to read, wider samples read blurrier levels */
+	};
+
+	/**
+	 * Converts a position on a face to its direction, as OpenGL samples a cubemap.
+	 *
+	 * \param face The face of the cubemap.
+	 * \param coordinates The horizontal and vertical coordinates on the face, in [-1, 1].
+	 * \return The direction, not normalized.
+	 */
+	static glm::vec3 faceDirection(const uint32_t face, const glm::vec2& coordinates);
+
+	/**
+	 * Finds the face a direction points to, as OpenGL samples a cubemap.
+	 *
+	 * \param direction The direction.
+	 * \param coordinates The horizontal and vertical coordinates on the face, in [-1, 1] (output variable).
+	 * \return The face of the cubemap.
+	 */
+	static uint32_t directionFace(const glm::vec3& direction, glm::vec2& coordinates);
+
+	/**
+	 * Reads a source level along a direction, filtering the four closest texels of the face.
+	 *
+	 * \param level The level to read.
+	 * \param direction The direction.
+	 * \return The filtered colour.
+	 */
+	static glm::vec3 sample(const SourceLevel& level, const glm::vec3& direction);
+
+	/**
+	 * Loads the faces of a cubemap and averages them down to BASE_SIZE texels.
+	 *
+	 * \param cubemapDirectory The directory of the faces.
+	 * \return The first level of the source.
+	 */
+	static SourceLevel loadSource(const std::string& cubemapDirectory);
+
+	/**
+	 * Averages every 2x2 texels of a level.
+	 *
+	 * \param level The level to reduce.
+	 * \return The level with half the size.
+	 */
+	static SourceLevel downsample(const SourceLevel& level);
+
+	/**
+	 * Hashes the filter settings and the faces of a cubemap by their size and time of last change.
+	 *
+	 * \param cubemapDirectory The directory of the faces.
+	 * \return The key of the cached mip chain.
+	 */
+	static uint64_t computeKey(const std::string& cubemapDirectory);
+}
+
+glm::vec3 CubemapPrefilter::faceDirection(const uint32_t face, const glm::vec2& coordinates) {
+	switch (face) {
+		case 0:
+			return glm::vec3(1.0f, -coordinates.y, -coordinates.x);
+		case 1:
+			return glm::vec3(-1.0f, -coordinates.y, coordinates.x);
+		case 2:
+			return glm::vec3(coordinates.x, 1.0f, coordinates.y);
+		case 3:
+			return glm::vec3(coordinates.x, -1.0f, -coordinates.y);
+		case 4:
+			return glm::vec3(coordinates.x, -coordinates.y, 1.0f);
+		default:
+			return glm::vec3(-coordinates.x, -coordinates.y, -1.0f);
+	}
+}
+
+uint32_t CubemapPrefilter::directionFace(const glm::vec3& direction, glm::vec2& coordinates) {
+	const glm::vec3 magnitude = glm::abs(direction);
+	if (magnitude.x >= magnitude.y && magnitude.x >= magnitude.z) {
+		coordinates = glm::vec2(direction.x > 0.0f ? -direction.z : direction.z, -direction.y) / magnitude.x;
+		return direction.x > 0.0f ? 0 : 1;
+	}
+	if (magnitude.y >= magnitude.z) {
+		coordinates = glm::vec2(direction.x, direction.y > 0.0f ? direction.z : -direction.z) / magnitude.y;
+		return direction.y > 0.0f ? 2 : 3;
+	}
+	coordinates = glm::vec2(direction.z > 0.0f ? direction.x : -direction.x, -direction.y) / magnitude.z;
+	return direction.z > 0.0f ? 4 : 5;
+}
+
+glm::vec3 CubemapPrefilter::sample(const SourceLevel& level, const glm::vec3& direction) {
+	glm::vec2 coordinates;
+	const std::vector<glm::vec3>& face = level.faces[CubemapPrefilter::directionFace(direction, coordinates)];
+	// Texel space, clamped to the face so the texels along the edges filter with themselves
+	const float last = static_cast<float>(level.size - 1);
+	const glm::vec2 texel = glm::clamp((coordinates * 0.5f + 0.5f) * static_cast<float>(level.size) - 0.5f, glm::vec2(0.0f), glm::vec2(last));
+	const glm::uvec2 first(texel);
+	const glm::uvec2 second = glm::min(first + 1u, glm::uvec2(level.size - 1));
+	const glm::vec2 blend = texel - glm::vec2(first);
+	const glm::vec3 top = glm::mix(face[first.y * level.size + first.x], face[first.y * level.size + second.x], blend.x);
+	const glm::vec3 bottom = glm::mix(face[second.y * level.size + first.x], face[second.y * level.size + second.x], blend.x);
+	return glm::mix(top, bottom, blend.y);
+}
+
+CubemapPrefilter::SourceLevel CubemapPrefilter::loadSource(const std::string& cubemapDirectory) {
+	SourceLevel result{ BASE_SIZE, {} };
+	stbi_set_flip_vertically_on_load(false);
+	for (uint32_t face = 0; face < 6; ++face) {
+		const std::string path = TextureLoader::getCubemapFacePath(cubemapDirectory, face);
+		int32_t width, height, channels;
+		uint8_t* data = stbi_load(path.c_str(), &width, &height, &channels, 3);
+		if (!data) {
+			throw std::runtime_error("Could not load the cubemap face: " + path);
+		}
+		std::vector<glm::vec3>& texels = result.faces[face];
+		texels.resize(static_cast<size_t>(BASE_SIZE) * BASE_SIZE);
+		// Every texel is the average of the source texels it covers
+		Parallel::forEach(BASE_SIZE, [&](const size_t row) {
+			const uint32_t firstY = static_cast<uint32_t>(row * height / BASE_SIZE);
+			const uint32_t endY = std::max(static_cast<uint32_t>((row + 1) * height / BASE_SIZE), firstY + 1);
+			for (uint32_t column = 0; column < BASE_SIZE; ++column) {
+				const uint32_t firstX = column * width / BASE_SIZE;
+				const uint32_t endX = std::max((column + 1) * width / BASE_SIZE, firstX + 1);
+				glm::vec3 sum(0.0f);
+				for (uint32_t y = firstY; y < endY; ++y) {
+					const uint8_t* sourceRow = data + (static_cast<size_t>(y) * width + firstX) * 3;
+					for (uint32_t x = firstX; x < endX; ++x, sourceRow += 3) {
+						sum += glm::vec3(sourceRow[0], sourceRow[1], sourceRow[2]);
+					}
+				}
+				texels[row * BASE_SIZE + column] = sum / (255.0f * static_cast<float>((endX - firstX) * (endY - firstY)));
+			}
+		});
+		stbi_image_free(data);
+	}
+	return result;
+}
+
+CubemapPrefilter::SourceLevel CubemapPrefilter::downsample(const SourceLevel& level) {
+	SourceLevel result{ level.size / 2, {} };
+	for (uint32_t face = 0; face < 6; ++face) {
+		const std::vector<glm::vec3>& texels = level.faces[face];
+		result.faces[face].resize(static_cast<size_t>(result.size) * result.size);
+		for (uint32_t y = 0; y < result.size; ++y) {
+			for (uint32_t x = 0; x < result.size; ++x) {
+				const size_t first = static_cast<size_t>(y) * 2 * level.size + x * 2;
+				result.faces[face][y * result.size + x] = (texels[first] + texels[first + 1] + texels[first + level.size] + texels[first + level.size + 1]) * 0.25f;
+			}
+		}
+	}
+	return result;
+}
+
+uint64_t CubemapPrefilter::computeKey(const std::string& cubemapDirectory) {
+	// The filter settings and the state of every face file
+	const uint32_t settings[4] = { CACHE_VERSION, BASE_SIZE, LEVEL_COUNT, SAMPLE_COUNT };
+	uint64_t key = Hash::fnv1a(settings, sizeof(settings));
+	for (uint32_t face = 0; face < 6; ++face) {
+		key = Hash::hashFileState(TextureLoader::getCubemapFacePath(cubemapDirectory, face), key);
+	}
+	return key;
+}
+
+std::vector<CubemapPrefilter::Level> CubemapPrefilter::load(const std::string& cubemapDirectory) {
+	const std::string cachePath = "assets/prefiltered/" + cubemapDirectory + ".cubemap";
+	const uint64_t key = CubemapPrefilter::computeKey(cubemapDirectory);
+	std::vector<Level> levels(LEVEL_COUNT);
+	for (uint32_t level = 0; level < LEVEL_COUNT; ++level) {
+		levels[level].size = BASE_SIZE >> level;
+		for (std::vector<uint8_t>& face : levels[level].faces) {
+			face.resize(static_cast<size_t>(levels[level].size) * levels[level].size * 3);
+		}
+	}
+	// Load the cooked levels if they are up to date
+	std::ifstream cacheFile(cachePath, std::ios::binary);
+	uint64_t cacheKey = 0;
+	if (cacheFile && cacheFile.read(reinterpret_cast<char*>(&cacheKey), sizeof(cacheKey)) && cacheKey == key) {
+		for (Level& level : levels) {
+			for (std::vector<uint8_t>& face : level.faces) {
+				cacheFile.read(reinterpret_cast<char*>(face.data()), face.size());
+			}
+		}
+		if (cacheFile) {
+			std::cout << "Loaded prefiltered cubemap: " << cachePath << std::endl;
+			return levels;
+		}
+	}
+	cacheFile.close();
+	const double startTime = glfwGetTime();
+	// Pyramid of the source, down to a single texel per face
+	std::vector<SourceLevel> source;
+	source.emplace_back(CubemapPrefilter::loadSource(cubemapDirectory));
+	while (source.back().size > 1) {
+		source.emplace_back(CubemapPrefilter::downsample(source.back()));
+	}
+	const float baseTexelAngle = 4.0f * glm::pi<float>() / (6.0f * static_cast<float>(BASE_SIZE * BASE_SIZE));
+	for (uint32_t level = 0; level < LEVEL_COUNT; ++level) {
+		const uint32_t size = levels[level].size;
+		const float roughness = static_cast<float>(level) / static_cast<float>(LEVEL_COUNT - 1);
+		const float alpha = roughness * roughness;
+		// Importance sampled GGX lobe with the view along the normal, the same for every texel of the level
+		std::vector<LobeSample> lobe;
+		for (uint32_t i = 0; i < (level == 0 ? 1 : SAMPLE_COUNT); ++i) {
+			// Hammersley point set
+			uint32_t bits = i;
+			bits = (bits << 16u) | (bits >> 16u);
+			bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+			bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+			bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+			bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+			const glm::vec2 point(static_cast<float>(i) / static_cast<float>(SAMPLE_COUNT), static_cast<float>(bits) * 2.3283064365386963e-10f);
+			const float phi = glm::two_pi<float>() * point.x;
+			const float cosTheta = std::sqrt((1.0f - point.y) / (1.0f + (alpha * alpha - 1.0f) * point.y));
+			const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+			const glm::vec3 half(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+			const glm::vec3 direction = 2.0f * cosTheta * half - glm::vec3(0.0f, 0.0f, 1.0f);
+			if (direction.z <= 0.0f) {
+				continue;
+			}
+			// Samples covering more solid angle than a texel read the level of the source as wide as them
+			float sourceLevel = 0.0f;
+			if (alpha > 0.0f) {
+				const float denominator = cosTheta * cosTheta * (alpha * alpha - 1.0f) + 1.0f;
+				const float pdf = alpha * alpha / (glm::pi<float>() * denominator * denominator) * 0.25f;
+				const float sampleAngle = 1.0f / (static_cast<float>(SAMPLE_COUNT) * pdf);
+				sourceLevel = glm::clamp(0.5f * std::log2(sampleAngle / baseTexelAngle) + 1.0f, 0.0f, static_cast<float>(source.size() - 1));
+			}
+			lobe.emplace_back(LobeSample{ direction, direction.z, sourceLevel });
+		}
+		// Every row of every face on its own
+		Parallel::forEach(static_cast<size_t>(size) * 6, [&](const size_t item) {
+			const uint32_t face = static_cast<uint32_t>(item / size);
+			const uint32_t row = static_cast<uint32_t>(item % size);
+			uint8_t* texels = levels[level].faces[face].data() + static_cast<size_t>(row) * size * 3;
+			for (uint32_t column = 0; column < size; ++column) {
+				const glm::vec2 coordinates = (glm::vec2(column, row) + 0.5f) / static_cast<float>(size) * 2.0f - 1.0f;
+				const glm::vec3 normal = glm::normalize(CubemapPrefilter::faceDirection(face, coordinates));
+				const glm::vec3 tangent = glm::normalize(glm::cross(glm::abs(normal.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), normal));
+				const glm::vec3 bitangent = glm::cross(normal, tangent);
+				glm::vec3 sum(0.0f);
+				float weight = 0.0f;
+				for (const LobeSample& lobeSample : lobe) {
+					const glm::vec3 direction = tangent * lobeSample.direction.x + bitangent * lobeSample.direction.y + normal * lobeSample.direction.z;
+					const uint32_t first = static_cast<uint32_t>(lobeSample.sourceLevel);
+					const uint32_t second = std::min(first + 1, static_cast<uint32_t>(source.size() - 1));
+					const glm::vec3 color = glm::mix(CubemapPrefilter::sample(source[first], direction), CubemapPrefilter::sample(source[second], direction), lobeSample.sourceLevel - static_cast<float>(first));
+					sum += color * lobeSample.weight;
+					weight += lobeSample.weight;
+				}
+				const glm::vec3 color = glm::clamp(sum / weight, glm::vec3(0.0f), glm::vec3(1.0f)) * 255.0f + 0.5f;
+				texels[column * 3] = static_cast<uint8_t>(color.r);
+				texels[column * 3 + 1] = static_cast<uint8_t>(color.g);
+				texels[column * 3 + 2] = static_cast<uint8_t>(color.b);
+			}
+		});
+	}
+	// Save the cooked levels for the next runs
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+	std::ofstream file(cachePath, std::ios::binary);
+	if (file) {
+		file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+		for (const Level& level : levels) {
+			for (const std::vector<uint8_t>& face : level.faces) {
+				file.write(reinterpret_cast<const char*>(face.data()), face.size());
+			}
+		}
+	}
+	else {
+		std::cerr << "Could not save the prefiltered cubemap cache: " << cachePath << std::endl;
+	}
+	std::cout << "Built prefiltered cubemap: " << cubemapDirectory << " (" << LEVEL_COUNT << " levels, " << glfwGetTime() - startTime << " s)" << std::endl;
+	return levels;
+}
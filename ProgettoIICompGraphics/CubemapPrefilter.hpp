@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Cooks the roughness-indexed mip chain of a cubemap for glossy reflections.
+ * Every level is the cubemap convolved on the CPU with the GGX lobe of a roughness, going from a mirror at level 0 to
+ * fully rough at the last level, so shaders pick the blur of a material with a single textureLod. The filter runs on
+ * every hardware thread and is cached on disk, it is redone only when the faces of the cubemap change.
+ */
+namespace CubemapPrefilter {
+	static constexpr uint32_t BASE_SIZE = 128;
+	static constexpr uint32_t LEVEL_COUNT = 6;
+	static constexpr uint32_t SAMPLE_COUNT = 128;
+
+	/**
+	 * A level of the mip chain, its roughness is level / (LEVEL_COUNT - 1).
+	 */
+	struct Level {
+		uint32_t size; /* Texels on each side of the faces */
+		std::array<std::vector<uint8_t>, 6> faces; /* RGB texels of every face */
+	};
+
+	/**
+	 * Loads the prefiltered mip chain of a cubemap from the cache, or filters the faces and caches the result.
+	 *
+	 * \param cubemapDirectory The directory of the faces in assets/textures, as given to TextureLoader::loadCubemap.
+	 * \return The LEVEL_COUNT levels, from BASE_SIZE texels down.
+	 */
+	std::vector<Level> load(const std::string& cubemapDirectory);
+}
@@ -2,10 +2,24 @@
 
 #include <glad/glad.h>
 
-ElementBuffer::ElementBuffer(const std::vector<uint32_t>& indices, const bool dynamic)
+ElementBuffer::ElementBuffer(const std::vector<uint32_t>& indices, const size_t vertexCount, const bool dynamic)
 	:
-	SimpleBuffer(GL_ELEMENT_ARRAY_BUFFER, dynamic)
+	SimpleBuffer(GL_ELEMENT_ARRAY_BUFFER, dynamic),
+	indexType(vertexCount < 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT)
 {
 	this->bind();
-	glBufferData(this->type, static_cast<int64_t>(indices.size() * sizeof(uint32_t)), indices.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
-}
\ No newline at end of file
+	if (this->indexType == GL_UNSIGNED_SHORT) {
+		std::vector<uint16_t> shortIndices;
+		shortIndices.reserve(indices.size());
+		for (const uint32_t index : indices) {
+			shortIndices.emplace_back(static_cast<uint16_t>(index));
+		}
+		glBufferData(this->type, static_cast<int64_t>(shortIndices.size() * sizeof(uint16_t)), shortIndices.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+	} else {
+		glBufferData(this->type, static_cast<int64_t>(indices.size() * sizeof(uint32_t)), indices.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+	}
+}
+
+size_t ElementBuffer::getIndexSize() const {
+	return this->indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
@@ -7,6 +7,8 @@
  * Class to hold the information of an ElementBuffer (the indices of an object).
  */
 class ElementBuffer : public SimpleBuffer {
+public:
+	const uint32_t indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
 public:
 	// Erase copy constructors, as it would break opengl
 	ElementBuffer(const ElementBuffer&) = delete;
@@ -14,9 +16,18 @@ public:
 
 	/**
 	 * Constructor for the element buffer.
+	 * The indices are stored as 16 bit values when the vertex count allows it.
 	 *
 	 * \param indices The indices to save in the GPU buffer.
+	 * \param vertexCount The amount of vertices the indices refer to.
 	 * \param dynamic Flag to check if the data can be overwritten.
 	 */
-	ElementBuffer(const std::vector<uint32_t>& indices, const bool dynamic = false);
-};
\ No newline at end of file
+	ElementBuffer(const std::vector<uint32_t>& indices, const size_t vertexCount = SIZE_MAX, const bool dynamic = false);
+
+	/**
+	 * Getter for the size of a single index in bytes.
+	 *
+	 * \return The size of an index.
+	 */
+	size_t getIndexSize() const;
+};
@@ -0,0 +1,313 @@
+#include "EnvironmentLighting.hpp"
+
+#include "CubemapPrefilter.hpp"
+#include "Hash.hpp"
+#include "Parallel.hpp"
+#include "Shader.hpp"
+#include "Texture.hpp"
+#include "TextureLoader.hpp"
+#include "UniformBuffer.hpp"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+#include <iostream>
+#include <memory>
+#include <stb_image.h>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENVIRONMENT_LIGHTING_SSE
+#include <emmintrin.h>
+#endif
+
+namespace EnvironmentLighting {
+	// Part of the cache key, bumped whenever the projection changes
+	static constexpr uint32_t CACHE_VERSION = 1;
+	// Sums of every row, 3 colour channels for each harmonic
+	static constexpr uint32_t SUM_COUNT = COEFFICIENT_COUNT * 3;
+
+	// Normalization of the harmonics, the shader only evaluates the polynomials
+	static constexpr float BASIS_SCALES[COEFFICIENT_COUNT] = { 0.282095f, 0.488603f, 0.488603f, 0.488603f, 1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f };
+	// Cosine lobe convolution of each band, over pi so the result is the radiance reflected by a white surface
+	static constexpr float BAND_SCALES[COEFFICIENT_COUNT] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+
+	/**
+	 * Direction of the texels of every face, as OpenGL samples a cubemap.
+	 * For x, y and z: the face coordinate used (0 horizontal, 1 vertical, 2 the constant 1) and its sign.
+	 */
+	static constexpr int32_t FACE_AXES[6][3][2] = {
+		{ { 2, 1 }, { 1, -1 }, { 0, -1 } },
+		{ { 2, -1 }, { 1, -1 }, { 0, 1 } },
+		{ { 0, 1 }, { 2, 1 }, { 1, 1 } },
+		{ { 0, 1 }, { 2, -1 }, { 1, -1 } },
+		{ { 0, 1 }, { 1, -1 }, { 2, 1 } },
+		{ { 0, -1 }, { 1, -1 }, { 2, -1 } }
+	};
+
+	/**
+	 * Layout of the environmentBuffer uniform block (std140).
+	 */
+	struct EnvironmentParameters {
+		glm::vec4 irradiance[COEFFICIENT_COUNT]; /* Coefficients of the polynomials, intensity included (rgb) */
+		glm::vec4 reflection; /* Last level of the prefiltered cubemap (x) and intensity of the reflections (y) */
+	};
+
+	static std::unique_ptr<UniformBuffer> environmentBuffer = nullptr;
+	static Coefficients radiance{};
+	static std::shared_ptr<Texture> reflections = nullptr;
+	static float intensity = 1.0f;
+	static bool enabled = true;
+	static float projectionTime = 0.0f;
+
+	/**
+	 * Adds the texels of a face row to the sums of the polynomials of every harmonic.
+	 *
+	 * \param row The RGB texels of the row.
+	 * \param face The face of the cubemap.
+	 * \param size The texels on each side of the face.
+	 * \param vertical The vertical face coordinate of the row, in [-1, 1].
+	 * \param sums The sums of the row, SUM_COUNT values (output variable).
+	 */
+	static void projectRow(const uint8_t* row, const uint32_t face, const uint32_t size, const float vertical, float* sums);
+
+	/**
+	 * Adds a single texel to the sums of the polynomials.
+	 *
+	 * \param direction The unit direction of the texel.
+	 * \param color The colour of the texel times its solid angle.
+	 * \param sums The sums to add to.
+	 */
+	static void addTexel(const glm::vec3& direction, const glm::vec3& color, float* sums);
+
+	/**
+	 * Hashes the faces of a cubemap by their size and time of last change.
+	 *
+	 * \param cubemapDirectory The directory of the faces.
+	 * \return The key of the cached projection.
+	 */
+	static uint64_t computeKey(const std::string& cubemapDirectory);
+
+	/**
+	 * Uploads the coefficients of the current projection, scaled by the intensity.
+	 *
+	 */
+	static void upload();
+}
+
+void EnvironmentLighting::addTexel(const glm::vec3& direction, const glm::vec3& color, float* sums) {
+	const float polynomials[COEFFICIENT_COUNT] = {
+		1.0f,
+		direction.y,
+		direction.z,
+		direction.x,
+		direction.x * direction.y,
+		direction.y * direction.z,
+		3.0f * direction.z * direction.z - 1.0f,
+		direction.x * direction.z,
+		direction.x * direction.x - direction.y * direction.y
+	};
+	for (uint32_t i = 0; i < COEFFICIENT_COUNT; ++i) {
+		sums[i * 3] += polynomials[i] * color.r;
+		sums[i * 3 + 1] += polynomials[i] * color.g;
+		sums[i * 3 + 2] += polynomials[i] * color.b;
+	}
+}
+
+void EnvironmentLighting::projectRow(const uint8_t* row, const uint32_t face, const uint32_t size, const float vertical, float* sums) {
+	const int32_t(&axes)[3][2] = FACE_AXES[face];
+	// Solid angle of a texel is its area on the unit cube over the cube of its distance, the bytes are scaled to [0, 1] with it
+	const float texelArea = 4.0f / (static_cast<float>(size) * static_cast<float>(size)) / 255.0f;
+	const float step = 2.0f / static_cast<float>(size);
+	uint32_t texel = 0;
+#ifdef ENVIRONMENT_LIGHTING_SSE
+	__m128 accumulators[SUM_COUNT];
+	for (__m128& accumulator : accumulators) {
+		accumulator = _mm_setzero_ps();
+	}
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 verticalLanes = _mm_set1_ps(vertical);
+	const __m128 signs[3] = { _mm_set1_ps(static_cast<float>(axes[0][1])), _mm_set1_ps(static_cast<float>(axes[1][1])), _mm_set1_ps(static_cast<float>(axes[2][1])) };
+	const __m128 texelAreaLanes = _mm_set1_ps(texelArea);
+	for (; texel + 4 <= size; texel += 4) {
+		const float first = (static_cast<float>(texel) + 0.5f) * step - 1.0f;
+		const __m128 horizontal = _mm_add_ps(_mm_set1_ps(first), _mm_mul_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(step)));
+		const __m128 coordinates[3] = { horizontal, verticalLanes, one };
+		const __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(one, _mm_add_ps(_mm_mul_ps(horizontal, horizontal), _mm_mul_ps(verticalLanes, verticalLanes)))));
+		const __m128 x = _mm_mul_ps(_mm_mul_ps(coordinates[axes[0][0]], signs[0]), inverseLength);
+		const __m128 y = _mm_mul_ps(_mm_mul_ps(coordinates[axes[1][0]], signs[1]), inverseLength);
+		const __m128 z = _mm_mul_ps(_mm_mul_ps(coordinates[axes[2][0]], signs[2]), inverseLength);
+		const __m128 weight = _mm_mul_ps(texelAreaLanes, _mm_mul_ps(inverseLength, _mm_mul_ps(inverseLength, inverseLength)));
+		const uint8_t* texels = row + texel * 3;
+		const __m128 colors[3] = {
+			_mm_mul_ps(_mm_set_ps(texels[9], texels[6], texels[3], texels[0]), weight),
+			_mm_mul_ps(_mm_set_ps(texels[10], texels[7], texels[4], texels[1]), weight),
+			_mm_mul_ps(_mm_set_ps(texels[11], texels[8], texels[5], texels[2]), weight)
+		};
+		const __m128 polynomials[COEFFICIENT_COUNT] = {
+			one,
+			y,
+			z,
+			x,
+			_mm_mul_ps(x, y),
+			_mm_mul_ps(y, z),
+			_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(z, z)), one),
+			_mm_mul_ps(x, z),
+			_mm_sub_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))
+		};
+		for (uint32_t i = 0; i < COEFFICIENT_COUNT; ++i) {
+			for (uint32_t channel = 0; channel < 3; ++channel) {
+				accumulators[i * 3 + channel] = _mm_add_ps(accumulators[i * 3 + channel], _mm_mul_ps(polynomials[i], colors[channel]));
+			}
+		}
+	}
+	for (uint32_t i = 0; i < SUM_COUNT; ++i) {
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, accumulators[i]);
+		sums[i] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+#endif
+	// Texels left out of the packs of four, or all of them without SSE
+	for (; texel < size; ++texel) {
+		const float coordinates[3] = { (static_cast<float>(texel) + 0.5f) * step - 1.0f, vertical, 1.0f };
+		const glm::vec3 direction(coordinates[axes[0][0]] * axes[0][1], coordinates[axes[1][0]] * axes[1][1], coordinates[axes[2][0]] * axes[2][1]);
+		const float inverseLength = 1.0f / glm::length(direction);
+		const uint8_t* color = row + texel * 3;
+		const float weight = texelArea * inverseLength * inverseLength * inverseLength;
+		EnvironmentLighting::addTexel(direction * inverseLength, glm::vec3(color[0], color[1], color[2]) * weight, sums);
+	}
+}
+
+uint64_t EnvironmentLighting::computeKey(const std::string& cubemapDirectory) {
+	// The version and the state of every face file
+	uint64_t key = Hash::fnv1a(&CACHE_VERSION, sizeof(CACHE_VERSION));
+	for (uint32_t face = 0; face < 6; ++face) {
+		key = Hash::hashFileState(TextureLoader::getCubemapFacePath(cubemapDirectory, face), key);
+	}
+	return key;
+}
+
+void EnvironmentLighting::upload() {
+	EnvironmentParameters parameters{};
+	for (uint32_t i = 0; i < COEFFICIENT_COUNT; ++i) {
+		const float scale = enabled ? intensity * BAND_SCALES[i] * BASIS_SCALES[i] : 0.0f;
+		parameters.irradiance[i] = glm::vec4(radiance[i] * scale, 0.0f);
+	}
+	parameters.reflection = glm::vec4(static_cast<float>(CubemapPrefilter::LEVEL_COUNT - 1), reflections && enabled ? intensity : 0.0f, 0.0f, 0.0f);
+	environmentBuffer->bind();
+	environmentBuffer->uploadSubData(&parameters, sizeof(EnvironmentParameters), 0);
+	environmentBuffer->unbind();
+}
+
+void EnvironmentLighting::initialize() {
+	environmentBuffer = std::make_unique<UniformBuffer>(false);
+	environmentBuffer->bind();
+	environmentBuffer->uploadData(sizeof(EnvironmentParameters));
+	environmentBuffer->unbind();
+	EnvironmentLighting::upload();
+}
+
+void EnvironmentLighting::setCubemap(const std::string& cubemapDirectory) {
+	reflections = TextureLoader::loadCubemap(cubemapDirectory, true);
+	const std::string cachePath = "assets/irradiance/" + cubemapDirectory + ".sh";
+	const uint64_t key = EnvironmentLighting::computeKey(cubemapDirectory);
+	std::ifstream cacheFile(cachePath, std::ios::binary);
+	uint64_t cacheKey = 0;
+	if (cacheFile && cacheFile.read(reinterpret_cast<char*>(&cacheKey), sizeof(cacheKey)) && cacheKey == key && cacheFile.read(reinterpret_cast<char*>(radiance.data()), sizeof(Coefficients))) {
+		projectionTime = 0.0f;
+		EnvironmentLighting::upload();
+		std::cout << "Loaded environment lighting: " << cachePath << std::endl;
+		return;
+	}
+	const double startTime = glfwGetTime();
+	std::vector<float> sums(SUM_COUNT, 0.0f);
+	stbi_set_flip_vertically_on_load(false);
+	for (uint32_t face = 0; face < 6; ++face) {
+		const std::string path = TextureLoader::getCubemapFacePath(cubemapDirectory, face);
+		int32_t width, height, channels;
+		uint8_t* data = stbi_load(path.c_str(), &width, &height, &channels, 3);
+		if (!data) {
+			throw std::runtime_error("Could not load the cubemap face: " + path);
+		}
+		if (width != height) {
+			stbi_image_free(data);
+			throw std::runtime_error("The cubemap face is not square: " + path);
+		}
+		// Every row sums on its own, then the rows are added up in order so the result doesn't depend on the threads
+		const uint32_t size = static_cast<uint32_t>(width);
+		std::vector<float> rowSums(static_cast<size_t>(size) * SUM_COUNT, 0.0f);
+		Parallel::forEach(size, [&](const size_t row) {
+			const float vertical = (static_cast<float>(row) + 0.5f) * 2.0f / static_cast<float>(size) - 1.0f;
+			EnvironmentLighting::projectRow(data + row * size * 3, face, size, vertical, rowSums.data() + row * SUM_COUNT);
+		});
+		stbi_image_free(data);
+		for (uint32_t row = 0; row < size; ++row) {
+			for (uint32_t i = 0; i < SUM_COUNT; ++i) {
+				sums[i] += rowSums[static_cast<size_t>(row) * SUM_COUNT + i];
+			}
+		}
+	}
+	for (uint32_t i = 0; i < COEFFICIENT_COUNT; ++i) {
+		radiance[i] = glm::vec3(sums[i * 3], sums[i * 3 + 1], sums[i * 3 + 2]) * BASIS_SCALES[i];
+	}
+	projectionTime = static_cast<float>(glfwGetTime() - startTime);
+	EnvironmentLighting::upload();
+	// Save the projection for the next runs
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+	std::ofstream file(cachePath, std::ios::binary);
+	if (file) {
+		file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+		file.write(reinterpret_cast<const char*>(radiance.data()), sizeof(Coefficients));
+	}
+	else {
+		std::cerr << "Could not save the environment lighting cache: " << cachePath << std::endl;
+	}
+	std::cout << "Built environment lighting: " << cubemapDirectory << " (" << projectionTime << " s)" << std::endl;
+}
+
+void EnvironmentLighting::enable(const Shader* shader, const Texture* localReflections) {
+	environmentBuffer->activate(BINDING_POINT);
+	const uint32_t blockIndex = glGetUniformBlockIndex(shader->id, "environmentBuffer");
+	if (blockIndex != GL_INVALID_INDEX) {
+		glUniformBlockBinding(shader->id, blockIndex, BINDING_POINT);
+	}
+	const Texture* environmentMap = localReflections != nullptr ? localReflections : reflections.get();
+	if (environmentMap) {
+		environmentMap->activate(REFLECTIONS_TEXTURE_UNIT);
+		shader->setUniform("environmentMap", REFLECTIONS_TEXTURE_UNIT);
+		glActiveTexture(GL_TEXTURE0);
+	}
+}
+
+void EnvironmentLighting::setIntensity(const float _intensity) {
+	intensity = _intensity;
+	EnvironmentLighting::upload();
+}
+
+float EnvironmentLighting::getIntensity() {
+	return intensity;
+}
+
+void EnvironmentLighting::setEnabled(const bool _enabled) {
+	enabled = _enabled;
+	EnvironmentLighting::upload();
+}
+
+bool EnvironmentLighting::isEnabled() {
+	return enabled;
+}
+
+const EnvironmentLighting::Coefficients& EnvironmentLighting::getRadiance() {
+	return radiance;
+}
+
+const std::shared_ptr<Texture>& EnvironmentLighting::getReflections() {
+	return reflections;
+}
+
+float EnvironmentLighting::getProjectionTime() {
+	return projectionTime;
+}
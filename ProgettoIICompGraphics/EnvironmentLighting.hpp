@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+
+/**
+ * Forward declaration of the shader class.
+ */
+class Shader;
+
+/**
+ * Forward declaration of the texture class.
+ */
+class Texture;
+
+/**
+ * Image based light from the skybox.
+ * The faces of a cubemap are projected on the CPU onto the first 9 spherical harmonics (3 bands), which are convolved
+ * with the cosine lobe and uploaded in a uniform block. Lit shaders get the irradiance around any normal with a few
+ * multiply-adds, without sampling the cubemap. The projection is cached on disk per cubemap.
+ * Reflective materials read the prefiltered mip chain of the same cubemap (see CubemapPrefilter) at the level of their roughness.
+ */
+namespace EnvironmentLighting {
+	// Same values on shader
+	static constexpr uint32_t COEFFICIENT_COUNT = 9;
+	static constexpr uint32_t BINDING_POINT = 2;
+	static constexpr int32_t REFLECTIONS_TEXTURE_UNIT = 11;
+
+	using Coefficients = std::array<glm::vec3, COEFFICIENT_COUNT>;
+
+	/**
+	 * Creates the uniform block, with no ambient light until a cubemap is set.
+	 *
+	 */
+	void initialize();
+
+	/**
+	 * Projects the faces of a cubemap and loads its prefiltered mip chain, or loads the cached ones, and makes it the sky light.
+	 *
+	 * \param cubemapDirectory The directory of the faces in assets/textures, as given to TextureLoader::loadCubemap.
+	 */
+	void setCubemap(const std::string& cubemapDirectory);
+
+	/**
+	 * Binds the uniform block and the reflections to a shader, the shader must already be active.
+	 *
+	 * \param shader The shader to bind the block to.
+	 * \param localReflections The cubemap of a reflection probe to reflect instead of the sky, nullptr for the sky.
+	 */
+	void enable(const Shader* shader, const Texture* localReflections = nullptr);
+
+	/**
+	 * Setter for the scale of the ambient light and the reflections.
+	 *
+	 * \param _intensity The new scale.
+	 */
+	void setIntensity(const float _intensity);
+
+	/**
+	 * Getter for the scale of the ambient light and the reflections.
+	 *
+	 * \return The scale of the sky light.
+	 */
+	float getIntensity();
+
+	/**
+	 * Toggles the sky light, shaders get no irradiance nor reflections when disabled.
+	 *
+	 * \param _enabled The new state.
+	 */
+	void setEnabled(const bool _enabled);
+
+	/**
+	 * Getter for the state of the sky light.
+	 *
+	 * \return True if the shaders get the irradiance and the reflections of the cubemap.
+	 */
+	bool isEnabled();
+
+	/**
+	 * Getter for the projection of the current cubemap.
+	 *
+	 * \return The radiance coefficients of the 9 spherical harmonics.
+	 */
+	const Coefficients& getRadiance();
+
+	/**
+	 * Getter for the prefiltered mip chain of the current cubemap.
+	 *
+	 * \return The reflections cubemap, null until a cubemap is set.
+	 */
+	const std::shared_ptr<Texture>& getReflections();
+
+	/**
+	 * Getter for the time taken by the last projection.
+	 *
+	 * \return The seconds taken, 0 if the projection came from the cache.
+	 */
+	float getProjectionTime();
+}
@@ -0,0 +1,47 @@
+#include "FloatingObjects.hpp"
+
+#include "Material.hpp"
+#include "SceneNode.hpp"
+#include "WaveModel.hpp"
+
+FloatingObjects::FloatingObjects(const std::shared_ptr<Material>& _waterMaterial, const float _tilt)
+	:
+	waterMaterial(_waterMaterial),
+	nodes(),
+	restPositions(),
+	restRotations(),
+	pointsX(),
+	pointsZ(),
+	heights(),
+	normals(),
+	tilt(_tilt)
+{}
+
+void FloatingObjects::add(const std::shared_ptr<SceneNode>& node) {
+	const glm::vec3 worldPosition(node->getWorldTransform().getTransformMatrix()[3]);
+	this->nodes.emplace_back(node);
+	this->restPositions.emplace_back(node->getLocalTransform().getPosition());
+	this->restRotations.emplace_back(node->getLocalTransform().getRotation());
+	this->pointsX.emplace_back(worldPosition.x);
+	this->pointsZ.emplace_back(worldPosition.z);
+	this->heights.emplace_back(0.0f);
+	this->normals.emplace_back(0.0f, 1.0f, 0.0f);
+}
+
+void FloatingObjects::update(const float time) {
+	if (this->nodes.empty()) {
+		return;
+	}
+	WaveModel::evaluate(WaveModel::fromMaterial(*this->waterMaterial), time, this->nodes.size(), this->pointsX.data(), this->pointsZ.data(), this->heights.data(), this->normals.data());
+	for (size_t i = 0; i < this->nodes.size(); ++i) {
+		const glm::vec3& normal = this->normals[i];
+		// Lean around x and z so the up axis follows the normal
+		const glm::vec3 lean = glm::degrees(glm::vec3(glm::atan(normal.z, normal.y), 0.0f, -glm::atan(normal.x, normal.y))) * this->tilt;
+		this->nodes[i]->setRotation(this->restRotations[i] + lean);
+		this->nodes[i]->setPosition(this->restPositions[i] + glm::vec3(0.0f, this->heights[i], 0.0f));
+	}
+}
+
+size_t FloatingObjects::getCount() const {
+	return this->nodes.size();
+}
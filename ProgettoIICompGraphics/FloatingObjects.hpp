@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+/**
+ * Forward declaration of the material class.
+ */
+class Material;
+
+/**
+ * Forward declaration of the scene node class.
+ */
+class SceneNode;
+
+/**
+ * Set of nodes bobbing on the water, moved every frame to the height and slope of the waves under them.
+ * The nodes keep their horizontal position, their parents are expected not to be rotated or scaled.
+ */
+class FloatingObjects {
+private:
+	std::shared_ptr<Material> waterMaterial;
+	std::vector<std::shared_ptr<SceneNode>> nodes;
+	std::vector<glm::vec3> restPositions;
+	std::vector<glm::vec3> restRotations;
+	// Query points and results, kept between frames to avoid allocations
+	std::vector<float> pointsX;
+	std::vector<float> pointsZ;
+	std::vector<float> heights;
+	std::vector<glm::vec3> normals;
+	float tilt;
+public:
+	/**
+	 * Constructor for an empty set of floating objects.
+	 *
+	 * \param _waterMaterial The material the waves are read from.
+	 * \param _tilt How much the nodes lean with the slope of the waves (0 keeps them upright, 1 follows the normal).
+	 */
+	FloatingObjects(const std::shared_ptr<Material>& _waterMaterial, const float _tilt = 1.0f);
+
+	/**
+	 * Adds a node, its current position is the one it floats around.
+	 *
+	 * \param node The node to move.
+	 */
+	void add(const std::shared_ptr<SceneNode>& node);
+
+	/**
+	 * Moves every node onto the waves.
+	 *
+	 * \param time The time in seconds, the same sent to the shaders.
+	 */
+	void update(const float time);
+
+	/**
+	 * Getter for the amount of nodes.
+	 *
+	 * \return The amount of floating nodes.
+	 */
+	size_t getCount() const;
+};
@@ -0,0 +1,87 @@
+#include "FrameBuffer.hpp"
+
+#include "Texture2D.hpp"
+#include <glad/glad.h>
+#include <stdexcept>
+
+uint32_t FrameBuffer::generateBuffer() {
+	uint32_t id;
+	glGenFramebuffers(1, &id);
+	return id;
+}
+
+FrameBuffer::FrameBuffer(const int32_t _width, const int32_t _height, const std::vector<int32_t>& colorFormats, const bool depth, const bool depthTexture)
+	:
+	colorAttachments(),
+	depthAttachment(nullptr),
+	depthRenderBuffer(0),
+	id(FrameBuffer::generateBuffer()),
+	width(_width),
+	height(_height)
+{
+	this->bind();
+	std::vector<uint32_t> drawBuffers;
+	for (size_t i = 0; i < colorFormats.size(); ++i) {
+		const std::shared_ptr<Texture2D> texture = std::make_shared<Texture2D>(colorFormats[i], GL_RGBA);
+		texture->uploadData(this->width, this->height, static_cast<const uint8_t*>(nullptr), false);
+		texture->setParameters({
+			{ GL_TEXTURE_MIN_FILTER, GL_LINEAR },
+			{ GL_TEXTURE_MAG_FILTER, GL_LINEAR },
+			{ GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE },
+			{ GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE }
+		});
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + static_cast<uint32_t>(i), GL_TEXTURE_2D, texture->textureId, 0);
+		drawBuffers.emplace_back(GL_COLOR_ATTACHMENT0 + static_cast<uint32_t>(i));
+		this->colorAttachments.emplace_back(texture);
+	}
+	if (drawBuffers.empty()) {
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+	} else {
+		glDrawBuffers(static_cast<int32_t>(drawBuffers.size()), drawBuffers.data());
+	}
+	if (depth && depthTexture) {
+		this->depthAttachment = std::make_shared<Texture2D>(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT);
+		this->depthAttachment->uploadData(this->width, this->height, static_cast<const float*>(nullptr), false);
+		this->depthAttachment->setParameters({
+			{ GL_TEXTURE_MIN_FILTER, GL_NEAREST },
+			{ GL_TEXTURE_MAG_FILTER, GL_NEAREST },
+			{ GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE },
+			{ GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE }
+		});
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, this->depthAttachment->textureId, 0);
+	} else if (depth) {
+		glGenRenderbuffers(1, &this->depthRenderBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, this->depthRenderBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, this->width, this->height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, this->depthRenderBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	}
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		throw std::runtime_error("Framebuffer is not complete!");
+	}
+	this->unbind();
+}
+
+FrameBuffer::~FrameBuffer() {
+	if (this->depthRenderBuffer != 0) {
+		glDeleteRenderbuffers(1, &this->depthRenderBuffer);
+	}
+	glDeleteFramebuffers(1, &this->id);
+}
+
+void FrameBuffer::bind() const {
+	glBindFramebuffer(GL_FRAMEBUFFER, this->id);
+}
+
+void FrameBuffer::unbind() const {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+const std::shared_ptr<Texture2D>& FrameBuffer::getColorAttachment(const size_t index) const {
+	return this->colorAttachments[index];
+}
+
+const std::shared_ptr<Texture2D>& FrameBuffer::getDepthAttachment() const {
+	return this->depthAttachment;
+}
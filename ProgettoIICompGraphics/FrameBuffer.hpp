@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Forward declaration of the texture2D class.
+ */
+class Texture2D;
+
+/**
+ * Class that handles an OpenGL framebuffer with texture color attachments.
+ */
+class FrameBuffer {
+private:
+	/**
+	 * Generates the id of the framebuffer.
+	 *
+	 * \return The id of the framebuffer.
+	 */
+	static uint32_t generateBuffer();
+
+	std::vector<std::shared_ptr<Texture2D>> colorAttachments;
+	std::shared_ptr<Texture2D> depthAttachment;
+	uint32_t depthRenderBuffer;
+public:
+	const uint32_t id;
+	const int32_t width;
+	const int32_t height;
+public:
+	// Erase copy constructors, as it would break opengl
+	FrameBuffer(const FrameBuffer&) = delete;
+	FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+	/**
+	 * Creates a framebuffer and its attachments.
+	 *
+	 * \param _width The width of the attachments.
+	 * \param _height The height of the attachments.
+	 * \param colorFormats The internal formats of the color attachments (e.g.: GL_RGBA8), a texture is created for each.
+	 * \param depth Flag to add a depth renderbuffer.
+	 * \param depthTexture Flag to make the depth a texture that can be sampled instead of a renderbuffer.
+	 */
+	FrameBuffer(const int32_t _width, const int32_t _height, const std::vector<int32_t>& colorFormats, const bool depth = true, const bool depthTexture = false);
+
+	/**
+	 * Deallocates the GPU memory of the framebuffer and its depth renderbuffer.
+	 *
+	 */
+	~FrameBuffer();
+
+	/**
+	 * Binds the framebuffer as the render target.
+	 *
+	 */
+	void bind() const;
+
+	/**
+	 * Binds the default framebuffer back as the render target.
+	 *
+	 */
+	void unbind() const;
+
+	/**
+	 * Getter for a color attachment.
+	 *
+	 * \param index The index of the attachment.
+	 * \return The texture of the attachment.
+	 */
+	const std::shared_ptr<Texture2D>& getColorAttachment(const size_t index) const;
+
+	/**
+	 * Getter for the depth attachment.
+	 *
+	 * \return The depth texture, null if the depth is a renderbuffer.
+	 */
+	const std::shared_ptr<Texture2D>& getDepthAttachment() const;
+};
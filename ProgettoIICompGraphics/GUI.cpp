@@ -1,13 +1,18 @@
 #include "GUI.hpp"
 
 #include "BoundingBox.hpp"
+#include "EnvironmentLighting.hpp"
+#include "LightClusters.hpp"
+#include "Lightmap.hpp"
 #include "LightSystem.hpp"
 #include "Material.hpp"
 #include "MaterialLoader.hpp"
 #include "MeshInstanceNode.hpp"
+#include "Renderer.hpp"
 #include "SceneNode.hpp"
 #include "Shader.hpp"
 #include "ShaderLoader.hpp"
+#include "ShadowAtlas.hpp"
 #include <glfw/glfw3.h>
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_glfw.h>
@@ -127,12 +132,22 @@ void GUI::drawLightsEditor() const {
 	// Create the window
 	ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Once);
 	ImGui::Begin("Lights editor", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_AlwaysVerticalScrollbar);
+	// New lights start as a white point light in front of the camera's default position
+	if (LightSystem::getLightCount() < LightSystem::MAX_LIGHTS && ImGui::Button("Add light")) {
+		LightSystem::setLight(LightSystem::getLightCount(), LightSystem::PointLight{
+			glm::vec3(0.0f, 2.0f, 0.0f),
+			glm::vec3(0.0f),
+			glm::vec3(1.0f),
+			glm::vec3(1.0f),
+			10.0f, 0.1f, 1.0f, 0.05f
+		});
+	}
 	// Read the lights
-	LightSystem::Lights& lights = LightSystem::getAllLights();
+	std::vector<LightSystem::Light>& lights = LightSystem::getAllLights();
 	// Show lights in imgui
-	for (size_t i = 0; i < LightSystem::MAX_LIGHTS; ++i) {
+	for (size_t i = 0; i < lights.size(); ++i) {
 		if (ImGui::TreeNode(("Light " + std::to_string(i)).c_str())) {
-			LightSystem::Light& light = lights.lights[i];
+			LightSystem::Light& light = lights[i];
 			if (ImGui::Combo("Type", reinterpret_cast<int32_t*>(&light.type), items, 4)) {
 				LightSystem::setLight(i, light);
 			}
@@ -145,6 +160,12 @@ void GUI::drawLightsEditor() const {
 			if (ImGui::ColorEdit3("Specular", &light.specular.x)) {
 				LightSystem::setLight(i, light);
 			}
+			// Baked lights only change the lightmaps on the next bake
+			bool baked = (light.flags & LightSystem::LIGHT_FLAG_BAKED) != 0;
+			if (ImGui::Checkbox("Baked", &baked)) {
+				light.flags = baked ? (light.flags | LightSystem::LIGHT_FLAG_BAKED) : (light.flags & ~LightSystem::LIGHT_FLAG_BAKED);
+				LightSystem::setLight(i, light);
+			}
 			switch (light.type) {
 				case LightSystem::LIGHT_TYPE::NONE:
 					break;
@@ -238,6 +259,98 @@ void GUI::drawControls() const {
 	ImGui::End();
 }
 
+void GUI::drawRendererSettings() const {
+	ImGui::Begin("Renderer", nullptr);
+	float lodBias = Renderer::getLodBias();
+	if (ImGui::SliderFloat("LOD bias", &lodBias, 0.0f, 8.0f)) {
+		Renderer::setLodBias(lodBias);
+	}
+	float impostorDistance = Renderer::getImpostorDistance();
+	if (ImGui::SliderFloat("Impostor distance", &impostorDistance, 0.0f, 100.0f)) {
+		Renderer::setImpostorDistance(impostorDistance);
+	}
+	float hlodDistance = Renderer::getHlodDistance();
+	if (ImGui::SliderFloat("HLOD distance", &hlodDistance, 0.0f, 100.0f)) {
+		Renderer::setHlodDistance(hlodDistance);
+	}
+	ImGui::Text("Triangles: %u", Renderer::getDrawnTriangleCount());
+	bool meshletCulling = Renderer::isMeshletCullingEnabled();
+	if (ImGui::Checkbox("Meshlet culling", &meshletCulling)) {
+		Renderer::setMeshletCulling(meshletCulling);
+	}
+	const Mesh::CullingStatistics& meshletStatistics = Renderer::getMeshletStatistics();
+	ImGui::Text("Meshlets: %u tested, %u outside the frustum, %u back facing", meshletStatistics.testedMeshlets, meshletStatistics.frustumCulledMeshlets, meshletStatistics.coneCulledMeshlets);
+	ImGui::Text("Triangles rejected: %u", meshletStatistics.rejectedTriangles);
+	bool clusteredLights = LightClusters::isEnabled();
+	if (ImGui::Checkbox("Clustered lights", &clusteredLights)) {
+		LightClusters::setEnabled(clusteredLights);
+	}
+	const LightClusters::Statistics& clusterStatistics = LightClusters::getStatistics();
+	ImGui::Text("Lights: %u visible, %u per cluster at most, %u list entries", clusterStatistics.assignedLights, clusterStatistics.maxClusterLights, clusterStatistics.indexCount);
+	bool lightTree = LightSystem::isLightTreeEnabled();
+	if (ImGui::Checkbox("Light tree", &lightTree)) {
+		LightSystem::setLightTreeEnabled(lightTree);
+	}
+	float cutErrorRatio = LightSystem::getCutErrorRatio();
+	if (ImGui::SliderFloat("Light cut error", &cutErrorRatio, 0.0f, 0.2f)) {
+		LightSystem::setCutErrorRatio(cutErrorRatio);
+	}
+	ImGui::Text("Light cut: %zu lights", LightSystem::getCut().size());
+	bool deferredShading = Renderer::isDeferredShadingEnabled();
+	if (ImGui::Checkbox("Deferred shading", &deferredShading)) {
+		Renderer::setDeferredShading(deferredShading);
+	}
+	ImGui::Text("Deferred objects: %u, frame: %.2f ms", Renderer::getDeferredObjectCount(), 1000.0f / ImGui::GetIO().Framerate);
+	static const char* prePassLabels[3] = { "Depth pre-pass (lit)", "Depth pre-pass (unlit)", "Depth pre-pass (deferred)" };
+	for (uint32_t i = 0; i < 3; ++i) {
+		const Renderer::OPAQUE_QUEUE queue = static_cast<Renderer::OPAQUE_QUEUE>(i);
+		bool depthPrePass = Renderer::isDepthPrePassEnabled(queue);
+		if (ImGui::Checkbox(prePassLabels[i], &depthPrePass)) {
+			Renderer::setDepthPrePass(queue, depthPrePass);
+		}
+	}
+	bool orderIndependentTransparency = Renderer::isOrderIndependentTransparencyEnabled();
+	if (ImGui::Checkbox("Order independent transparency", &orderIndependentTransparency)) {
+		Renderer::setOrderIndependentTransparency(orderIndependentTransparency);
+	}
+	bool reducedResolutionTransparency = Renderer::isReducedResolutionTransparencyEnabled();
+	if (ImGui::Checkbox("Reduced resolution transparency", &reducedResolutionTransparency)) {
+		Renderer::setReducedResolutionTransparency(reducedResolutionTransparency);
+	}
+	const LightSystem::UploadStatistics& uploadStatistics = LightSystem::getUploadStatistics();
+	ImGui::Text("Light uploads: %u (%zu bytes)", uploadStatistics.uploads, uploadStatistics.bytes);
+	bool environmentLighting = EnvironmentLighting::isEnabled();
+	if (ImGui::Checkbox("Sky lighting", &environmentLighting)) {
+		EnvironmentLighting::setEnabled(environmentLighting);
+	}
+	float environmentIntensity = EnvironmentLighting::getIntensity();
+	if (ImGui::SliderFloat("Sky lighting intensity", &environmentIntensity, 0.0f, 4.0f)) {
+		EnvironmentLighting::setIntensity(environmentIntensity);
+	}
+	float probeBudget = Renderer::getProbeBudget();
+	if (ImGui::SliderFloat("Probe budget (ms)", &probeBudget, 0.0f, 4.0f)) {
+		Renderer::setProbeBudget(probeBudget);
+	}
+	ImGui::Text("Reflection probes: %zu, %u faces captured", Renderer::getReflectionProbes().size(), Renderer::getCapturedProbeFaceCount());
+	if (ImGui::Button("Capture probes")) {
+		Renderer::invalidateReflectionProbes();
+	}
+	bool shadows = ShadowAtlas::isEnabled();
+	if (ImGui::Checkbox("Shadows", &shadows)) {
+		ShadowAtlas::setEnabled(shadows);
+	}
+	const ShadowAtlas::Statistics& shadowStatistics = ShadowAtlas::getStatistics();
+	ImGui::Text("Shadow tiles: %u, %u static and %u dynamic redrawn, %u casters drawn, %u moving", shadowStatistics.tiles, shadowStatistics.staticTiles, shadowStatistics.dynamicTiles, shadowStatistics.drawnCasters, shadowStatistics.movingCasters);
+	if (Lightmap* lightmap = Renderer::getLightmap()) {
+		const glm::uvec2 lightmapSize = lightmap->getSize();
+		ImGui::Text("Lightmap: %zu objects, %ux%u texels, baked in %.2f s", lightmap->getInstanceCount(), lightmapSize.x, lightmapSize.y, lightmap->getBakeTime());
+		if (ImGui::Button("Bake lightmap")) {
+			lightmap->bake();
+		}
+	}
+	ImGui::End();
+}
+
 void GUI::endRendering() const {
 	ImGui::Render();
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
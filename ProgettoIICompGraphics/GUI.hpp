@@ -36,5 +36,6 @@ public:
 	void drawResources() const;
 	void drawControls() const;
 	void drawLightsEditor() const;
+	void drawRendererSettings() const;
 	void endRendering() const;
 };
@@ -0,0 +1,24 @@
+#include "Hash.hpp"
+
+#include <filesystem>
+
+namespace Hash {
+	// Prime of the 64 bit FNV-1a
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+}
+
+uint64_t Hash::fnv1a(const void* data, const size_t size, const uint64_t hash) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t result = hash;
+	for (size_t i = 0; i < size; ++i) {
+		result = (result ^ bytes[i]) * FNV_PRIME;
+	}
+	return result;
+}
+
+uint64_t Hash::hashFileState(const std::string& path, const uint64_t hash) {
+	std::error_code error;
+	const uintmax_t fileSize = std::filesystem::file_size(path, error);
+	const int64_t lastChange = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+	return Hash::fnv1a(&lastChange, sizeof(lastChange), Hash::fnv1a(&fileSize, sizeof(fileSize), hash));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Hash {
+	// Offset basis of the 64 bit FNV-1a, the hash of no bytes
+	static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+	/**
+	 * Hashes raw bytes with the 64 bit FNV-1a, passing the previous hash chains several values in one key.
+	 *
+	 * \param data The bytes to hash.
+	 * \param size The amount of bytes.
+	 * \param hash The hash of the previous values, the offset basis to start a new one.
+	 * \return The hash of the previous values followed by the bytes.
+	 */
+	uint64_t fnv1a(const void* data, const size_t size, const uint64_t hash = FNV_OFFSET_BASIS);
+
+	/**
+	 * Hashes the size and the last write time of a file, for the keys of caches built from it.
+	 * Missing files hash as an error value, so the caches are rebuilt once they appear.
+	 *
+	 * \param path The path of the file.
+	 * \param hash The hash of the previous values, the offset basis to start a new one.
+	 * \return The hash of the previous values followed by the file state.
+	 */
+	uint64_t hashFileState(const std::string& path, const uint64_t hash = FNV_OFFSET_BASIS);
+}
@@ -0,0 +1,182 @@
+#include "Hlod.hpp"
+
+#include "FrameBuffer.hpp"
+#include "Material.hpp"
+#include "Mesh.hpp"
+#include "MeshInstanceNode.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "Shader.hpp"
+#include "ShaderLoader.hpp"
+#include "Texture2D.hpp"
+#include "Vertex.hpp"
+#include "VertexArray.hpp"
+#include <glad/glad.h>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+Hlod::Hlod(const std::shared_ptr<SceneNode>& root, const float _distance, const float cellSize, const float simplifyRatio, const float _fadeRange)
+	:
+	clusters(),
+	atlas(nullptr),
+	proxyMaterial(nullptr),
+	distance(_distance),
+	fadeRange(glm::max(_fadeRange, 0.001f))
+{
+	// Group the children by the horizontal grid cell their center falls in
+	std::map<std::pair<int32_t, int32_t>, std::vector<MeshInstanceNode*>> cells;
+	std::vector<const Material*> materials;
+	std::unordered_map<const Material*, uint32_t> materialCells;
+	for (const std::shared_ptr<SceneNode>& child : root->getChildren()) {
+		std::vector<MeshInstanceNode*> meshes;
+		Hlod::collectMeshes(child.get(), meshes);
+		if (meshes.empty()) {
+			continue;
+		}
+		glm::vec3 minValues(std::numeric_limits<float>::max());
+		glm::vec3 maxValues(std::numeric_limits<float>::lowest());
+		for (MeshInstanceNode* meshNode : meshes) {
+			const BoundingBox bounds = meshNode->getBoundingBox();
+			minValues = glm::min(minValues, bounds.getMinValues());
+			maxValues = glm::max(maxValues, bounds.getMaxValues());
+			if (materialCells.emplace(meshNode->getMaterial().get(), static_cast<uint32_t>(materials.size())).second) {
+				materials.emplace_back(meshNode->getMaterial().get());
+			}
+		}
+		const glm::vec3 center = (minValues + maxValues) * 0.5f;
+		std::vector<MeshInstanceNode*>& cell = cells[{ static_cast<int32_t>(glm::floor(center.x / cellSize)), static_cast<int32_t>(glm::floor(center.z / cellSize)) }];
+		cell.insert(cell.end(), meshes.begin(), meshes.end());
+	}
+	if (cells.empty()) {
+		std::cout << "Built HLOD: " << root->name << " (nothing to merge)" << std::endl;
+		return;
+	}
+	// Bake the materials and create the material shared by all the proxies
+	const uint32_t gridSize = static_cast<uint32_t>(glm::ceil(glm::sqrt(static_cast<float>(materials.size()))));
+	this->bakeAtlas(materials, gridSize);
+	this->proxyMaterial = std::make_shared<Material>(
+		root->name + "Hlod",
+		ShaderLoader::load("hlod"),
+		std::unordered_map<std::string, Material::MaterialValueType>(),
+		std::unordered_map<std::string, std::shared_ptr<Texture>>{ { "atlas", this->atlas->getColorAttachment(0) } },
+		true,
+		false
+	);
+	// Inset the cells so the lower mip levels don't bleed into the neighbours
+	const float padding = 4.0f / static_cast<float>(ATLAS_CELL_RESOLUTION);
+	const float cellScale = (1.0f - 2.0f * padding) / static_cast<float>(gridSize);
+	size_t sourceTriangles = 0;
+	size_t proxyTriangles = 0;
+	for (auto& [cellCoordinates, meshes] : cells) {
+		// Merge the meshes in world space, the tangent slot holds the atlas cell (offset.xy, scale)
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		for (const MeshInstanceNode* meshNode : meshes) {
+			const Mesh* mesh = meshNode->getMesh();
+			const glm::mat4& worldMatrix = meshNode->getWorldTransform().getTransformMatrix();
+			const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(worldMatrix)));
+			const uint32_t materialCell = materialCells.at(meshNode->getMaterial().get());
+			const glm::vec2 cellOffset = (glm::vec2(static_cast<float>(materialCell % gridSize), static_cast<float>(materialCell / gridSize)) + padding) / static_cast<float>(gridSize);
+			const uint32_t baseVertex = static_cast<uint32_t>(vertices.size());
+			for (const Vertex& vertex : mesh->getVertices()) {
+				Vertex merged;
+				merged.position = glm::vec3(worldMatrix * glm::vec4(vertex.position, 1.0f));
+				merged.normal = glm::normalize(normalMatrix * vertex.normal);
+				merged.uv = vertex.uv;
+				merged.tangent = glm::vec3(cellOffset, cellScale);
+				vertices.emplace_back(merged);
+			}
+			const Mesh::Lod& fullDetail = mesh->getLod(0);
+			for (uint32_t i = 0; i < fullDetail.indexCount; ++i) {
+				indices.emplace_back(baseVertex + mesh->getIndices()[fullDetail.indexOffset + i]);
+			}
+		}
+		const std::string proxyName = "HlodProxy" + std::to_string(cellCoordinates.first) + "_" + std::to_string(cellCoordinates.second);
+		sourceTriangles += indices.size() / 3;
+		MeshOptimizer::weldVertices(vertices, indices);
+		const size_t targetIndexCount = static_cast<size_t>(static_cast<float>(indices.size() / 3) * simplifyRatio) * 3;
+		indices = MeshSimplifier::simplify(vertices, indices, targetIndexCount);
+		MeshOptimizer::optimize(vertices, indices);
+		proxyTriangles += indices.size() / 3;
+		const std::shared_ptr<Mesh> proxyMesh = std::make_shared<Mesh>(std::move(vertices), std::move(indices), GL_TRIANGLES, Mesh::DataRetention::NONE, Mesh::VertexFormat::FULL);
+		this->clusters.emplace_back(Cluster{ std::make_shared<MeshInstanceNode>(proxyName, proxyMesh, this->proxyMaterial, Transform()), meshes, 0.0f });
+	}
+	std::cout << "Built HLOD: " << root->name << " (" << this->clusters.size() << " clusters, " << materials.size() << " materials, triangles " << sourceTriangles << " -> " << proxyTriangles << ")" << std::endl;
+}
+
+Hlod::~Hlod() = default;
+
+void Hlod::collectMeshes(SceneNode* node, std::vector<MeshInstanceNode*>& meshes) {
+	if (MeshInstanceNode* meshNode = dynamic_cast<MeshInstanceNode*>(node)) {
+		const Material* material = meshNode->getMaterial().get();
+		if (material->litFlag && !material->transparentFlag && !meshNode->getMesh()->getVertices().empty()) {
+			meshes.emplace_back(meshNode);
+		}
+	}
+	for (const std::shared_ptr<SceneNode>& child : node->getChildren()) {
+		Hlod::collectMeshes(child.get(), meshes);
+	}
+}
+
+void Hlod::bakeAtlas(const std::vector<const Material*>& materials, const uint32_t gridSize) {
+	const std::shared_ptr<Shader> atlasShader = ShaderLoader::load("hlod_atlas");
+	const int32_t atlasSize = static_cast<int32_t>(gridSize) * ATLAS_CELL_RESOLUTION;
+	this->atlas = std::make_unique<FrameBuffer>(atlasSize, atlasSize, std::vector<int32_t>{ GL_RGBA8 }, false);
+	int32_t viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	// The quad is generated in the vertex shader, an empty vertex array is enough
+	const VertexArray quadVao;
+	this->atlas->bind();
+	quadVao.bind();
+	for (size_t i = 0; i < materials.size(); ++i) {
+		glViewport(static_cast<int32_t>(i % gridSize) * ATLAS_CELL_RESOLUTION, static_cast<int32_t>(i / gridSize) * ATLAS_CELL_RESOLUTION, ATLAS_CELL_RESOLUTION, ATLAS_CELL_RESOLUTION);
+		materials[i]->activate(atlasShader.get());
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		materials[i]->deactivate();
+	}
+	quadVao.unbind();
+	this->atlas->unbind();
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	const std::shared_ptr<Texture2D>& texture = this->atlas->getColorAttachment(0);
+	texture->bind();
+	glGenerateMipmap(GL_TEXTURE_2D);
+	texture->setParameters({
+		{ GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR },
+		{ GL_TEXTURE_MAX_LEVEL, 3 }
+	});
+}
+
+void Hlod::update(const glm::vec3& viewPoint) {
+	for (Cluster& cluster : this->clusters) {
+		// Measure from the closest point of the proxy, so big clusters don't switch while the camera is inside them
+		const BoundingBox bounds = cluster.proxy->getBoundingBox();
+		const float clusterDistance = glm::distance(viewPoint, glm::clamp(viewPoint, bounds.getMinValues(), bounds.getMaxValues()));
+		cluster.fade = glm::clamp((clusterDistance - this->distance) / this->fadeRange, 0.0f, 1.0f);
+	}
+}
+
+size_t Hlod::getClusterCount() const {
+	return this->clusters.size();
+}
+
+const std::vector<MeshInstanceNode*>& Hlod::getClusterMeshes(const size_t cluster) const {
+	return this->clusters[cluster].meshes;
+}
+
+MeshInstanceNode* Hlod::getClusterProxy(const size_t cluster) const {
+	return this->clusters[cluster].proxy.get();
+}
+
+float Hlod::getClusterFade(const size_t cluster) const {
+	return this->clusters[cluster].fade;
+}
+
+void Hlod::setDistance(const float _distance) {
+	this->distance = glm::max(_distance, 0.0f);
+}
+
+float Hlod::getDistance() const {
+	return this->distance;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+/**
+ * Forward declaration of the framebuffer class.
+ */
+class FrameBuffer;
+
+/**
+ * Forward declaration of the material class.
+ */
+class Material;
+
+/**
+ * Forward declaration of the mesh instance node class.
+ */
+class MeshInstanceNode;
+
+/**
+ * Forward declaration of the scene node class.
+ */
+class SceneNode;
+
+/**
+ * Hierarchical level of detail of the static children of a node.
+ * Children close to each other are grouped in clusters, each cluster is merged into a single simplified proxy mesh
+ * textured from an atlas of the source materials, so it can be drawn with a single call in place of the children when far away.
+ * The source meshes must keep their CPU data (Mesh::DataRetention::ALL), only opaque materials are merged.
+ */
+class Hlod {
+public:
+	static constexpr float DEFAULT_CELL_SIZE = 16.0f;
+	static constexpr float DEFAULT_SIMPLIFY_RATIO = 0.5f;
+	static constexpr int32_t ATLAS_CELL_RESOLUTION = 256;
+private:
+	/**
+	 * A group of children drawn as a single proxy.
+	 */
+	struct Cluster {
+		std::shared_ptr<MeshInstanceNode> proxy; /* The merged mesh */
+		std::vector<MeshInstanceNode*> meshes; /* The meshes replaced by the proxy */
+		float fade; /* How much the proxy replaced the meshes (0-1) */
+	};
+
+	std::vector<Cluster> clusters;
+	std::unique_ptr<FrameBuffer> atlas;
+	std::shared_ptr<Material> proxyMaterial;
+	float distance;
+	float fadeRange;
+
+	/**
+	 * Renders the albedo of every material in a cell of the atlas.
+	 *
+	 * \param materials The materials to bake.
+	 * \param gridSize The amount of cells on each side of the atlas.
+	 */
+	void bakeAtlas(const std::vector<const Material*>& materials, const uint32_t gridSize);
+
+	/**
+	 * Collects the opaque mesh nodes below a node that still have their CPU data.
+	 *
+	 * \param node The node to start from.
+	 * \param meshes The output list.
+	 */
+	static void collectMeshes(SceneNode* node, std::vector<MeshInstanceNode*>& meshes);
+public:
+	// Erase copy constructors, as it would break opengl
+	Hlod(const Hlod&) = delete;
+	Hlod& operator=(const Hlod&) = delete;
+
+	/**
+	 * Builds the clusters of the children of a node, their proxies and the texture atlas.
+	 * Make sure the OpenGL state has been set up first.
+	 *
+	 * \param root The node whose children get grouped.
+	 * \param _distance The distance at which the proxies start replacing the children.
+	 * \param cellSize The size of the horizontal grid cells children are grouped by.
+	 * \param simplifyRatio The fraction of triangles kept when simplifying the merged meshes.
+	 * \param _fadeRange The distance over which the children and the proxies cross-fade.
+	 */
+	Hlod(const std::shared_ptr<SceneNode>& root, const float _distance, const float cellSize = DEFAULT_CELL_SIZE, const float simplifyRatio = DEFAULT_SIMPLIFY_RATIO, const float _fadeRange = 4.0f);
+
+	/**
+	 * Destructor for the HLOD.
+	 *
+	 */
+	~Hlod();
+
+	/**
+	 * Updates the fade of every cluster.
+	 *
+	 * \param viewPoint The view point in the scene.
+	 */
+	void update(const glm::vec3& viewPoint);
+
+	/**
+	 * Getter for the amount of clusters.
+	 *
+	 * \return The amount of clusters.
+	 */
+	size_t getClusterCount() const;
+
+	/**
+	 * Getter for the meshes replaced by a cluster.
+	 *
+	 * \param cluster The index of the cluster.
+	 * \return The mesh nodes of the cluster.
+	 */
+	const std::vector<MeshInstanceNode*>& getClusterMeshes(const size_t cluster) const;
+
+	/**
+	 * Getter for the proxy of a cluster.
+	 *
+	 * \param cluster The index of the cluster.
+	 * \return The proxy node, it is not part of the scene graph.
+	 */
+	MeshInstanceNode* getClusterProxy(const size_t cluster) const;
+
+	/**
+	 * Getter for how much a cluster is replaced by its proxy, 1 means the meshes are not drawn.
+	 *
+	 * \param cluster The index of the cluster.
+	 * \return The fade of the cluster (0-1).
+	 */
+	float getClusterFade(const size_t cluster) const;
+
+	/**
+	 * Setter for the distance at which the proxies start replacing the children.
+	 *
+	 * \param _distance The new distance.
+	 */
+	void setDistance(const float _distance);
+
+	/**
+	 * Getter for the distance at which the proxies start replacing the children.
+	 *
+	 * \return The current distance.
+	 */
+	float getDistance() const;
+};
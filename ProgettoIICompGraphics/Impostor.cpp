@@ -0,0 +1,225 @@
+#include "Impostor.hpp"
+
+#include "EnvironmentLighting.hpp"
+#include "FrameBuffer.hpp"
+#include "LightClusters.hpp"
+#include "LightSystem.hpp"
+#include "Material.hpp"
+#include "Mesh.hpp"
+#include "MeshInstanceNode.hpp"
+#include "Shader.hpp"
+#include "ShaderLoader.hpp"
+#include "ShadowAtlas.hpp"
+#include "Texture2D.hpp"
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+Impostor::Impostor(const std::vector<std::shared_ptr<SceneNode>>& _instances, const float _distance, const float _fadeRange, const uint32_t _viewCount, const int32_t _viewResolution)
+	:
+	instances(_instances),
+	instanceMeshes(),
+	instanceFades(_instances.size(), 0.0f),
+	visibleInstances(),
+	instanceCapacity(_instances.size()),
+	atlas(nullptr),
+	shader(ShaderLoader::load("impostor")),
+	vao(),
+	quadVbo(4 * sizeof(glm::vec2), false),
+	instanceVbo(_instances.size() * sizeof(InstanceData)),
+	boundsCenter(0.0f),
+	halfSize(0.0f),
+	atlasGrid(0),
+	referenceScale(1.0f),
+	visibleMin(0.0f),
+	visibleMax(0.0f),
+	distance(_distance),
+	fadeRange(glm::max(_fadeRange, 0.001f)),
+	viewCount(_viewCount),
+	viewResolution(_viewResolution)
+{
+	if (this->instances.empty()) {
+		throw std::runtime_error("Impostor needs at least one instance!");
+	}
+	for (const std::shared_ptr<SceneNode>& instance : this->instances) {
+		std::vector<MeshInstanceNode*> meshes;
+		Impostor::collectMeshes(instance.get(), meshes);
+		this->instanceMeshes.emplace_back(std::move(meshes));
+	}
+	// Quad corners, drawn as a triangle strip
+	const glm::vec2 corners[4] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, 1.0f } };
+	this->vao.bind();
+	this->quadVbo.bind();
+	this->quadVbo.uploadData(corners, sizeof(corners));
+	this->vao.linkAttrib(0, 2, sizeof(glm::vec2), GL_FLOAT, 0);
+	this->instanceVbo.bind();
+	this->vao.linkAttrib(1, 4, sizeof(InstanceData), GL_FLOAT, offsetof(InstanceData, positionScale));
+	this->vao.linkAttrib(2, 1, sizeof(InstanceData), GL_FLOAT, offsetof(InstanceData, fade));
+	this->vao.setAttribDivisor(1);
+	this->vao.setAttribDivisor(2);
+	this->vao.unbind();
+	this->instanceVbo.unbind();
+	this->bake();
+}
+
+Impostor::~Impostor() = default;
+
+void Impostor::collectMeshes(SceneNode* node, std::vector<MeshInstanceNode*>& meshes) {
+	if (MeshInstanceNode* meshNode = dynamic_cast<MeshInstanceNode*>(node)) {
+		meshes.emplace_back(meshNode);
+	}
+	for (const std::shared_ptr<SceneNode>& child : node->getChildren()) {
+		Impostor::collectMeshes(child.get(), meshes);
+	}
+}
+
+void Impostor::bake() {
+	const std::shared_ptr<Shader> bakeShader = ShaderLoader::load("impostor_bake");
+	// Place the prototype at the origin, keeping its orientation and scale
+	const glm::mat4& rootMatrix = this->instances[0]->getWorldTransform().getTransformMatrix();
+	const glm::mat4 toLocal = glm::translate(glm::mat4(1.0f), -glm::vec3(rootMatrix[3]));
+	this->referenceScale = glm::length(glm::vec3(rootMatrix[0]));
+	std::vector<glm::mat4> bakeMatrices;
+	glm::vec3 minValues(std::numeric_limits<float>::max());
+	glm::vec3 maxValues(std::numeric_limits<float>::lowest());
+	for (MeshInstanceNode* meshNode : this->instanceMeshes[0]) {
+		bakeMatrices.emplace_back(toLocal * meshNode->getWorldTransform().getTransformMatrix());
+		const BoundingBox bounds = meshNode->getMesh()->getBoundingBox().transform(bakeMatrices.back());
+		minValues = glm::min(minValues, bounds.getMinValues());
+		maxValues = glm::max(maxValues, bounds.getMaxValues());
+	}
+	if (bakeMatrices.empty()) {
+		throw std::runtime_error("Impostor prototype has no meshes!");
+	}
+	this->boundsCenter = (minValues + maxValues) * 0.5f;
+	// The quad has to cover the prototype from every angle around the vertical axis
+	const glm::vec2 horizontalExtent = glm::vec2(maxValues.x - minValues.x, maxValues.z - minValues.z) * 0.5f;
+	this->halfSize = glm::vec2(glm::length(horizontalExtent), (maxValues.y - minValues.y) * 0.5f);
+	// Lay the views out in a grid
+	this->atlasGrid.x = static_cast<uint32_t>(glm::ceil(glm::sqrt(static_cast<float>(this->viewCount))));
+	this->atlasGrid.y = (this->viewCount + this->atlasGrid.x - 1) / this->atlasGrid.x;
+	this->atlas = std::make_unique<FrameBuffer>(static_cast<int32_t>(this->atlasGrid.x) * this->viewResolution, static_cast<int32_t>(this->atlasGrid.y) * this->viewResolution, std::vector<int32_t>{ GL_RGBA8, GL_RGBA8 });
+	int32_t viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	this->atlas->bind();
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	const float radius = this->halfSize.x;
+	const glm::mat4 projectionMatrix = glm::ortho(-radius, radius, -this->halfSize.y, this->halfSize.y, radius * 0.5f, radius * 3.5f);
+	for (uint32_t view = 0; view < this->viewCount; ++view) {
+		const float angle = glm::two_pi<float>() * static_cast<float>(view) / static_cast<float>(this->viewCount);
+		const glm::vec3 direction(glm::sin(angle), 0.0f, glm::cos(angle));
+		const glm::mat4 cameraMatrix = projectionMatrix * glm::lookAt(this->boundsCenter + direction * radius * 2.0f, this->boundsCenter, glm::vec3(0.0f, 1.0f, 0.0f));
+		glViewport(static_cast<int32_t>(view % this->atlasGrid.x) * this->viewResolution, static_cast<int32_t>(view / this->atlasGrid.x) * this->viewResolution, this->viewResolution, this->viewResolution);
+		for (size_t i = 0; i < bakeMatrices.size(); ++i) {
+			const MeshInstanceNode* meshNode = this->instanceMeshes[0][i];
+			meshNode->getMaterial()->activate(bakeShader.get());
+			bakeShader->setUniform("cameraMatrix", cameraMatrix);
+			bakeShader->setUniform("objMatrix", bakeMatrices[i]);
+			meshNode->getMesh()->setDecodingUniforms(bakeShader.get());
+			meshNode->getMesh()->draw();
+			meshNode->getMaterial()->deactivate();
+		}
+	}
+	this->atlas->unbind();
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	// Few mip levels, so the views don't bleed into each other
+	for (size_t i = 0; i < 2; ++i) {
+		const std::shared_ptr<Texture2D>& texture = this->atlas->getColorAttachment(i);
+		texture->bind();
+		glGenerateMipmap(GL_TEXTURE_2D);
+		texture->setParameters({
+			{ GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR },
+			{ GL_TEXTURE_MAX_LEVEL, 3 }
+		});
+	}
+	std::cout << "Baked impostor: " << this->instances[0]->name << " (" << this->viewCount << " views, " << this->instances.size() << " instances)" << std::endl;
+}
+
+void Impostor::update(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint) {
+	this->visibleInstances.clear();
+	this->visibleMin = glm::vec3(std::numeric_limits<float>::max());
+	this->visibleMax = glm::vec3(std::numeric_limits<float>::lowest());
+	const glm::vec3 extent(this->halfSize.x, this->halfSize.y, this->halfSize.x);
+	for (size_t i = 0; i < this->instances.size(); ++i) {
+		const glm::mat4& rootMatrix = this->instances[i]->getWorldTransform().getTransformMatrix();
+		const glm::vec3 position(rootMatrix[3]);
+		const float scale = glm::length(glm::vec3(rootMatrix[0])) / this->referenceScale;
+		const glm::vec3 center = position + this->boundsCenter * scale;
+		const float fade = glm::clamp((glm::distance(viewPoint, center) - this->distance) / this->fadeRange, 0.0f, 1.0f);
+		this->instanceFades[i] = fade;
+		if (fade <= 0.0f || BoundingBox(center - extent * scale, center + extent * scale).isCulled(cameraMatrix)) {
+			continue;
+		}
+		this->visibleInstances.emplace_back(InstanceData{ glm::vec4(position, scale), fade });
+		this->visibleMin = glm::min(this->visibleMin, center - extent * scale);
+		this->visibleMax = glm::max(this->visibleMax, center + extent * scale);
+	}
+	if (this->visibleInstances.empty()) {
+		return;
+	}
+	this->instanceVbo.bind();
+	if (this->visibleInstances.size() > this->instanceCapacity) {
+		this->instanceCapacity = this->visibleInstances.size();
+		this->instanceVbo.uploadData(this->visibleInstances.data(), this->visibleInstances.size() * sizeof(InstanceData));
+	} else {
+		this->instanceVbo.uploadSubData(this->visibleInstances.data(), this->visibleInstances.size() * sizeof(InstanceData), 0);
+	}
+	this->instanceVbo.unbind();
+}
+
+void Impostor::render(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint) const {
+	if (this->visibleInstances.empty()) {
+		return;
+	}
+	this->shader->activate();
+	// Activate lighting
+	LightSystem::enable(this->shader.get());
+	LightClusters::enable(this->shader.get());
+	EnvironmentLighting::enable(this->shader.get());
+	ShadowAtlas::enable(this->shader.get());
+	LightSystem::enableObjectLights(this->shader.get(), LightSystem::findLights(this->visibleMin, this->visibleMax));
+	this->shader->setUniform("cameraMatrix", cameraMatrix);
+	this->shader->setUniform("cameraPosition", viewPoint);
+	this->shader->setUniform("boundsCenter", this->boundsCenter);
+	this->shader->setUniform("halfSize", this->halfSize);
+	this->shader->setUniform("atlasGrid", this->atlasGrid.x, this->atlasGrid.y);
+	this->shader->setUniform("viewCount", this->viewCount);
+	this->atlas->getColorAttachment(0)->activate(0);
+	this->shader->setUniform("albedoAtlas", 0);
+	this->atlas->getColorAttachment(1)->activate(1);
+	this->shader->setUniform("normalAtlas", 1);
+	this->vao.bind();
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<int32_t>(this->visibleInstances.size()));
+	this->vao.unbind();
+	this->atlas->getColorAttachment(1)->deactivate(1);
+	this->atlas->getColorAttachment(0)->deactivate(0);
+}
+
+size_t Impostor::getInstanceCount() const {
+	return this->instances.size();
+}
+
+const std::vector<MeshInstanceNode*>& Impostor::getInstanceMeshes(const size_t instance) const {
+	return this->instanceMeshes[instance];
+}
+
+float Impostor::getInstanceFade(const size_t instance) const {
+	return this->instanceFades[instance];
+}
+
+uint32_t Impostor::getVisibleCount() const {
+	return static_cast<uint32_t>(this->visibleInstances.size());
+}
+
+void Impostor::setDistance(const float _distance) {
+	this->distance = glm::max(_distance, 0.0f);
+}
+
+float Impostor::getDistance() const {
+	return this->distance;
+}
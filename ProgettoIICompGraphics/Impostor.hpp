@@ -0,0 +1,167 @@
+#pragma once
+
+#include "VertexArray.hpp"
+#include "VertexBuffer.hpp"
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+/**
+ * Forward declaration of the framebuffer class.
+ */
+class FrameBuffer;
+
+/**
+ * Forward declaration of the mesh instance node class.
+ */
+class MeshInstanceNode;
+
+/**
+ * Forward declaration of the scene node class.
+ */
+class SceneNode;
+
+/**
+ * Forward declaration of the shader class.
+ */
+class Shader;
+
+/**
+ * Billboard impostor shared by all the instances of a prototype (e.g.: a tree).
+ * The prototype is rendered from several angles around the vertical axis into an albedo and normal atlas,
+ * far instances are then drawn as camera facing quads in a single instanced draw call.
+ * Instances are expected to share the orientation of the first one, only their position and uniform scale are used.
+ */
+class Impostor {
+public:
+	static constexpr uint32_t DEFAULT_VIEW_COUNT = 16;
+	static constexpr int32_t DEFAULT_VIEW_RESOLUTION = 256;
+private:
+	/**
+	 * Per instance data sent to the GPU.
+	 */
+	struct InstanceData {
+		glm::vec4 positionScale; /* World position of the instance's root and its scale relative to the prototype */
+		float fade; /* How much the impostor replaced the meshes (0-1) */
+	};
+
+	std::vector<std::shared_ptr<SceneNode>> instances;
+	std::vector<std::vector<MeshInstanceNode*>> instanceMeshes;
+	std::vector<float> instanceFades;
+	std::vector<InstanceData> visibleInstances;
+	size_t instanceCapacity;
+
+	std::unique_ptr<FrameBuffer> atlas;
+	std::shared_ptr<Shader> shader;
+	const VertexArray vao;
+	const VertexBuffer quadVbo;
+	const VertexBuffer instanceVbo;
+
+	glm::vec3 boundsCenter; // Center of the prototype relative to its root position
+	glm::vec2 halfSize; // Half width and height of the quad
+	glm::uvec2 atlasGrid; // Columns and rows of views in the atlas
+	float referenceScale; // Scale of the prototype when it was baked
+	glm::vec3 visibleMin; // Minimum corner of the visible instances, for the lights reaching them
+	glm::vec3 visibleMax; // Maximum corner of the visible instances, for the lights reaching them
+	float distance;
+	float fadeRange;
+
+	/**
+	 * Renders the first instance from every view into the atlas.
+	 *
+	 */
+	void bake();
+
+	/**
+	 * Collects the mesh nodes below a node.
+	 *
+	 * \param node The node to start from.
+	 * \param meshes The output list.
+	 */
+	static void collectMeshes(SceneNode* node, std::vector<MeshInstanceNode*>& meshes);
+public:
+	const uint32_t viewCount;
+	const int32_t viewResolution;
+public:
+	// Erase copy constructors, as it would break opengl
+	Impostor(const Impostor&) = delete;
+	Impostor& operator=(const Impostor&) = delete;
+
+	/**
+	 * Creates the impostor and bakes its atlas, the first instance is used as the prototype.
+	 * Make sure the OpenGL state has been set up first.
+	 *
+	 * \param _instances The root nodes of all the instances.
+	 * \param _distance The distance at which the impostor starts replacing the meshes.
+	 * \param _fadeRange The distance over which the meshes and the impostor cross-fade.
+	 * \param _viewCount The amount of angles the prototype is rendered from.
+	 * \param _viewResolution The resolution of each view in the atlas.
+	 */
+	Impostor(const std::vector<std::shared_ptr<SceneNode>>& _instances, const float _distance, const float _fadeRange = 4.0f, const uint32_t _viewCount = DEFAULT_VIEW_COUNT, const int32_t _viewResolution = DEFAULT_VIEW_RESOLUTION);
+
+	/**
+	 * Destructor for the impostor.
+	 *
+	 */
+	~Impostor();
+
+	/**
+	 * Updates the fade of every instance and uploads the visible ones.
+	 *
+	 * \param cameraMatrix The camera's combined matrix.
+	 * \param viewPoint The view point in the scene.
+	 */
+	void update(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint);
+
+	/**
+	 * Draws all the visible instances with a single draw call.
+	 *
+	 * \param cameraMatrix The camera's combined matrix.
+	 * \param viewPoint The view point in the scene.
+	 */
+	void render(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint) const;
+
+	/**
+	 * Getter for the amount of instances.
+	 *
+	 * \return The amount of instances.
+	 */
+	size_t getInstanceCount() const;
+
+	/**
+	 * Getter for the meshes of an instance.
+	 *
+	 * \param instance The index of the instance.
+	 * \return The mesh nodes of the instance.
+	 */
+	const std::vector<MeshInstanceNode*>& getInstanceMeshes(const size_t instance) const;
+
+	/**
+	 * Getter for how much an instance is replaced by the impostor, 1 means the meshes are not drawn.
+	 *
+	 * \param instance The index of the instance.
+	 * \return The fade of the instance (0-1).
+	 */
+	float getInstanceFade(const size_t instance) const;
+
+	/**
+	 * Getter for the amount of instances drawn as impostors in the last update.
+	 *
+	 * \return The amount of visible impostors.
+	 */
+	uint32_t getVisibleCount() const;
+
+	/**
+	 * Setter for the distance at which the impostor starts replacing the meshes.
+	 *
+	 * \param _distance The new distance.
+	 */
+	void setDistance(const float _distance);
+
+	/**
+	 * Getter for the distance at which the impostor starts replacing the meshes.
+	 *
+	 * \return The current distance.
+	 */
+	float getDistance() const;
+};
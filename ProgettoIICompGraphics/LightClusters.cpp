@@ -0,0 +1,370 @@
+#include "LightClusters.hpp"
+
+#include "LightSystem.hpp"
+#include "Parallel.hpp"
+#include "Shader.hpp"
+#include "TextureBuffer.hpp"
+#include "UniformBuffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <glad/glad.h>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_CLUSTERS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace LightClusters {
+	// Below this many lights the assignment is cheaper than waking the worker threads
+	static constexpr size_t PARALLEL_LIGHT_COUNT = 64;
+
+	/**
+	 * Layout of the clustersBuffer uniform block (std140).
+	 */
+	struct ClusterParameters {
+		glm::uvec4 grid; /* Tiles along x and y, slices, and 1 if the culling is enabled */
+		glm::vec4 depth; /* Near and far planes, scale and bias turning the log of the view depth into a slice */
+		glm::vec4 tileScale; /* Inverse of the tile size in pixels (xy) */
+	};
+
+	/**
+	 * A point or spot light moved to view space, with the clusters its range overlaps.
+	 */
+	struct LightBounds {
+		uint16_t index;
+		bool isSpot;
+		glm::vec3 center;
+		float range;
+		glm::vec3 direction;
+		float cosOuter;
+		float sinOuter;
+		glm::uvec2 slices; /* First and last slice */
+		glm::uvec2 tilesX; /* First and last tile along x */
+		glm::uvec2 tilesY; /* First and last tile along y */
+	};
+
+	/**
+	 * View space bounding boxes of the clusters, split by component so four tiles are tested at once.
+	 */
+	struct ClusterBounds {
+		alignas(16) float minX[CLUSTER_COUNT];
+		alignas(16) float minY[CLUSTER_COUNT];
+		alignas(16) float minZ[CLUSTER_COUNT];
+		alignas(16) float maxX[CLUSTER_COUNT];
+		alignas(16) float maxY[CLUSTER_COUNT];
+		alignas(16) float maxZ[CLUSTER_COUNT];
+	};
+
+	static std::unique_ptr<UniformBuffer> clustersBuffer = nullptr;
+	static std::unique_ptr<TextureBuffer> clusterLights = nullptr;
+	static std::unique_ptr<TextureBuffer> clusterLightIndices = nullptr;
+	static ClusterParameters parameters;
+	static bool enabled = true;
+	static Statistics statistics;
+
+	// Cluster bounds, rebuilt when the projection or the viewport change
+	static ClusterBounds bounds;
+	static glm::mat4 boundsProjection(0.0f);
+	static glm::ivec2 boundsViewport(0);
+
+	// Per frame lists, the unpacked ones keep MAX_LIGHTS_PER_CLUSTER slots for every cluster
+	static std::vector<uint16_t> unpackedIndices;
+	static std::vector<uint32_t> clusterCounts;
+	static std::vector<glm::uvec2> clusterRanges;
+	static std::vector<uint16_t> packedIndices;
+	static std::vector<uint16_t> directionalLights;
+	static std::vector<LightBounds> localLights;
+
+	/**
+	 * Rebuilds the bounding boxes of the clusters.
+	 *
+	 * \param projectionMatrix The perspective projection matrix of the camera.
+	 * \param viewport The size of the viewport in pixels.
+	 */
+	static void buildBounds(const glm::mat4& projectionMatrix, const glm::ivec2& viewport);
+
+	/**
+	 * Moves a light to view space and finds the clusters its range overlaps.
+	 *
+	 * \param light The light to bound.
+	 * \param index The position of the light in the light buffer.
+	 * \param viewMatrix The view matrix of the camera.
+	 * \param projectionMatrix The perspective projection matrix of the camera.
+	 * \param viewport The size of the viewport in pixels.
+	 * \param result The bounds of the light.
+	 * \return False if the light is outside the frustum.
+	 */
+	static bool boundLight(const LightSystem::Light& light, const uint16_t index, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::ivec2& viewport, LightBounds& result);
+
+	/**
+	 * Checks a spot light's cone against the bounding sphere of a cluster.
+	 *
+	 * \param light The spot light.
+	 * \param cluster The cluster to test.
+	 * \return True if the cone may reach the cluster.
+	 */
+	static bool coneTouchesCluster(const LightBounds& light, const uint32_t cluster);
+
+	/**
+	 * Fills the light lists of a range of slices.
+	 *
+	 * \param firstSlice The first slice to fill.
+	 * \param endSlice The slice after the last one to fill.
+	 */
+	static void assignSlices(const uint32_t firstSlice, const uint32_t endSlice);
+
+	/**
+	 * Converts a slice index to its distance from the camera.
+	 *
+	 * \param slice The slice index, can be the one past the last.
+	 * \return The view depth where the slice starts.
+	 */
+	static float sliceDepth(const uint32_t slice);
+}
+
+void LightClusters::initialize() {
+	clustersBuffer = std::make_unique<UniformBuffer>();
+	clustersBuffer->bind();
+	clustersBuffer->uploadData(&parameters, sizeof(ClusterParameters));
+	clustersBuffer->unbind();
+	clusterLights = std::make_unique<TextureBuffer>(GL_RG32UI);
+	clusterLightIndices = std::make_unique<TextureBuffer>(GL_R16UI);
+	unpackedIndices.resize(static_cast<size_t>(CLUSTER_COUNT) * MAX_LIGHTS_PER_CLUSTER);
+	clusterCounts.resize(CLUSTER_COUNT);
+	clusterRanges.resize(CLUSTER_COUNT);
+}
+
+float LightClusters::sliceDepth(const uint32_t slice) {
+	return parameters.depth.x * std::pow(parameters.depth.y / parameters.depth.x, static_cast<float>(slice) / static_cast<float>(SLICES));
+}
+
+void LightClusters::buildBounds(const glm::mat4& projectionMatrix, const glm::ivec2& viewport) {
+	const glm::vec2 tileSize = glm::ceil(glm::vec2(viewport) / glm::vec2(TILES_X, TILES_Y));
+	for (uint32_t slice = 0; slice < SLICES; ++slice) {
+		const float nearDepth = sliceDepth(slice);
+		const float farDepth = sliceDepth(slice + 1);
+		for (uint32_t y = 0; y < TILES_Y; ++y) {
+			// Window coordinates to normalized device coordinates, then to view space at both depths of the slice
+			const float ndcMinY = 2.0f * y * tileSize.y / viewport.y - 1.0f;
+			const float ndcMaxY = 2.0f * (y + 1) * tileSize.y / viewport.y - 1.0f;
+			for (uint32_t x = 0; x < TILES_X; ++x) {
+				const float ndcMinX = 2.0f * x * tileSize.x / viewport.x - 1.0f;
+				const float ndcMaxX = 2.0f * (x + 1) * tileSize.x / viewport.x - 1.0f;
+				const uint32_t cluster = (slice * TILES_Y + y) * TILES_X + x;
+				bounds.minX[cluster] = glm::min(ndcMinX * nearDepth, ndcMinX * farDepth) / projectionMatrix[0][0];
+				bounds.maxX[cluster] = glm::max(ndcMaxX * nearDepth, ndcMaxX * farDepth) / projectionMatrix[0][0];
+				bounds.minY[cluster] = glm::min(ndcMinY * nearDepth, ndcMinY * farDepth) / projectionMatrix[1][1];
+				bounds.maxY[cluster] = glm::max(ndcMaxY * nearDepth, ndcMaxY * farDepth) / projectionMatrix[1][1];
+				// The camera looks down -z
+				bounds.minZ[cluster] = -farDepth;
+				bounds.maxZ[cluster] = -nearDepth;
+			}
+		}
+	}
+	boundsProjection = projectionMatrix;
+	boundsViewport = viewport;
+}
+
+bool LightClusters::boundLight(const LightSystem::Light& light, const uint16_t index, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::ivec2& viewport, LightBounds& result) {
+	result.index = index;
+	result.isSpot = light.type == LightSystem::LIGHT_TYPE::SPOT;
+	result.center = glm::vec3(viewMatrix * glm::vec4(light.position, 1.0f));
+	result.range = light.range;
+	if (result.isSpot) {
+		result.direction = glm::normalize(glm::mat3(viewMatrix) * light.direction);
+		result.cosOuter = light.outerCutOff;
+		result.sinOuter = glm::sqrt(glm::max(1.0f - light.outerCutOff * light.outerCutOff, 0.0f));
+		// Cones wider than a half space are bounded by their sphere alone
+		result.isSpot = light.outerCutOff > 0.0f;
+	}
+	// Depth range
+	const float nearDepth = glm::max(-result.center.z - result.range, parameters.depth.x);
+	const float farDepth = glm::min(-result.center.z + result.range, parameters.depth.y);
+	if (nearDepth > farDepth) {
+		return false;
+	}
+	const auto toSlice = [](const float depth) {
+		const float slice = std::log(depth) * parameters.depth.z + parameters.depth.w;
+		return static_cast<uint32_t>(glm::clamp(slice, 0.0f, static_cast<float>(SLICES - 1)));
+	};
+	result.slices = glm::uvec2(toSlice(nearDepth), toSlice(farDepth));
+	// Screen rectangle of the light's bounding box, its extremes lie on the nearest or farthest depth
+	const glm::vec2 scale(projectionMatrix[0][0], projectionMatrix[1][1]);
+	const glm::vec2 low = glm::vec2(result.center) - result.range;
+	const glm::vec2 high = glm::vec2(result.center) + result.range;
+	const glm::vec2 ndcMin = glm::min(low / nearDepth, low / farDepth) * scale;
+	const glm::vec2 ndcMax = glm::max(high / nearDepth, high / farDepth) * scale;
+	if (ndcMin.x > 1.0f || ndcMin.y > 1.0f || ndcMax.x < -1.0f || ndcMax.y < -1.0f) {
+		return false;
+	}
+	const glm::vec2 tileSize = glm::ceil(glm::vec2(viewport) / glm::vec2(TILES_X, TILES_Y));
+	const glm::vec2 tileMin = glm::floor((ndcMin * 0.5f + 0.5f) * glm::vec2(viewport) / tileSize);
+	const glm::vec2 tileMax = glm::floor((ndcMax * 0.5f + 0.5f) * glm::vec2(viewport) / tileSize);
+	result.tilesX = glm::uvec2(glm::clamp(glm::vec2(tileMin.x, tileMax.x), 0.0f, static_cast<float>(TILES_X - 1)));
+	result.tilesY = glm::uvec2(glm::clamp(glm::vec2(tileMin.y, tileMax.y), 0.0f, static_cast<float>(TILES_Y - 1)));
+	return true;
+}
+
+bool LightClusters::coneTouchesCluster(const LightBounds& light, const uint32_t cluster) {
+	const glm::vec3 minValues(bounds.minX[cluster], bounds.minY[cluster], bounds.minZ[cluster]);
+	const glm::vec3 maxValues(bounds.maxX[cluster], bounds.maxY[cluster], bounds.maxZ[cluster]);
+	const glm::vec3 center = (minValues + maxValues) * 0.5f;
+	const float radius = glm::distance(minValues, maxValues) * 0.5f;
+	// Distance of the sphere from the cone's surface, measured perpendicular to it
+	const glm::vec3 toCenter = center - light.center;
+	const float alongAxis = glm::dot(toCenter, light.direction);
+	const float fromAxis = glm::sqrt(glm::max(glm::dot(toCenter, toCenter) - alongAxis * alongAxis, 0.0f));
+	const float fromSurface = light.cosOuter * fromAxis - light.sinOuter * alongAxis;
+	return fromSurface <= radius && alongAxis >= -radius && alongAxis <= light.range + radius;
+}
+
+void LightClusters::assignSlices(const uint32_t firstSlice, const uint32_t endSlice) {
+	const uint32_t firstCluster = firstSlice * TILES_X * TILES_Y;
+	const uint32_t endCluster = endSlice * TILES_X * TILES_Y;
+	// Directional lights reach every cluster
+	for (uint32_t cluster = firstCluster; cluster < endCluster; ++cluster) {
+		const uint32_t count = static_cast<uint32_t>(std::min<size_t>(directionalLights.size(), MAX_LIGHTS_PER_CLUSTER));
+		std::copy(directionalLights.begin(), directionalLights.begin() + count, unpackedIndices.begin() + static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER);
+		clusterCounts[cluster] = count;
+	}
+	const auto addLight = [](const LightBounds& light, const uint32_t cluster) {
+		if (light.isSpot && !coneTouchesCluster(light, cluster)) {
+			return;
+		}
+		uint32_t& count = clusterCounts[cluster];
+		if (count < MAX_LIGHTS_PER_CLUSTER) {
+			unpackedIndices[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER + count] = light.index;
+		}
+		++count;
+	};
+	for (const LightBounds& light : localLights) {
+		const uint32_t sliceBegin = std::max(light.slices.x, firstSlice);
+		const uint32_t sliceEnd = std::min(light.slices.y + 1, endSlice);
+		const float rangeSquared = light.range * light.range;
+		for (uint32_t slice = sliceBegin; slice < sliceEnd; ++slice) {
+			for (uint32_t y = light.tilesY.x; y <= light.tilesY.y; ++y) {
+				const uint32_t row = (slice * TILES_Y + y) * TILES_X;
+#ifdef LIGHT_CLUSTERS_SSE
+				// Sphere against four boxes at once, the rows are aligned to four tiles
+				const __m128 centerX = _mm_set1_ps(light.center.x);
+				const __m128 centerY = _mm_set1_ps(light.center.y);
+				const __m128 centerZ = _mm_set1_ps(light.center.z);
+				const __m128 zero = _mm_setzero_ps();
+				for (uint32_t x = light.tilesX.x & ~3u; x <= light.tilesX.y; x += 4) {
+					const uint32_t cluster = row + x;
+					const __m128 distanceX = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(bounds.minX + cluster), centerX), zero), _mm_max_ps(_mm_sub_ps(centerX, _mm_load_ps(bounds.maxX + cluster)), zero));
+					const __m128 distanceY = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(bounds.minY + cluster), centerY), zero), _mm_max_ps(_mm_sub_ps(centerY, _mm_load_ps(bounds.maxY + cluster)), zero));
+					const __m128 distanceZ = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(bounds.minZ + cluster), centerZ), zero), _mm_max_ps(_mm_sub_ps(centerZ, _mm_load_ps(bounds.maxZ + cluster)), zero));
+					const __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(distanceX, distanceX), _mm_mul_ps(distanceY, distanceY)), _mm_mul_ps(distanceZ, distanceZ));
+					const int32_t mask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_set1_ps(rangeSquared)));
+					for (uint32_t lane = 0; lane < 4; ++lane) {
+						if ((mask & (1 << lane)) && x + lane >= light.tilesX.x && x + lane <= light.tilesX.y) {
+							addLight(light, cluster + lane);
+						}
+					}
+				}
+#else
+				for (uint32_t x = light.tilesX.x; x <= light.tilesX.y; ++x) {
+					const uint32_t cluster = row + x;
+					const glm::vec3 minValues(bounds.minX[cluster], bounds.minY[cluster], bounds.minZ[cluster]);
+					const glm::vec3 maxValues(bounds.maxX[cluster], bounds.maxY[cluster], bounds.maxZ[cluster]);
+					const glm::vec3 distance = glm::max(minValues - light.center, 0.0f) + glm::max(light.center - maxValues, 0.0f);
+					if (glm::dot(distance, distance) <= rangeSquared) {
+						addLight(light, cluster);
+					}
+				}
+#endif
+			}
+		}
+	}
+}
+
+void LightClusters::update(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+	int32_t viewportData[4];
+	glGetIntegerv(GL_VIEWPORT, viewportData);
+	const glm::ivec2 viewport(glm::max(viewportData[2], 1), glm::max(viewportData[3], 1));
+	// Near and far planes of the perspective projection, slices grow exponentially between them
+	const float nearPlane = projectionMatrix[3][2] / (projectionMatrix[2][2] - 1.0f);
+	const float farPlane = projectionMatrix[3][2] / (projectionMatrix[2][2] + 1.0f);
+	const float logDepthRange = std::log(farPlane / nearPlane);
+	const glm::vec2 tileSize = glm::ceil(glm::vec2(viewport) / glm::vec2(TILES_X, TILES_Y));
+	parameters.grid = glm::uvec4(TILES_X, TILES_Y, SLICES, enabled ? 1 : 0);
+	parameters.depth = glm::vec4(nearPlane, farPlane, SLICES / logDepthRange, -(SLICES * std::log(nearPlane)) / logDepthRange);
+	parameters.tileScale = glm::vec4(1.0f / tileSize, 0.0f, 0.0f);
+	clustersBuffer->bind();
+	clustersBuffer->uploadSubData(&parameters, sizeof(ClusterParameters), 0);
+	clustersBuffer->unbind();
+	if (!enabled) {
+		return;
+	}
+	if (projectionMatrix != boundsProjection || viewport != boundsViewport) {
+		buildBounds(projectionMatrix, viewport);
+	}
+	// Split the lights by how they are culled, point and spot lights come from the cut of the light tree
+	directionalLights.clear();
+	localLights.clear();
+	const std::vector<LightSystem::Light>& lights = LightSystem::getAllLights();
+	for (size_t i = 0; i < lights.size(); ++i) {
+		if (lights[i].type == LightSystem::LIGHT_TYPE::DIRECTIONAL) {
+			directionalLights.emplace_back(static_cast<uint16_t>(i));
+		}
+	}
+	for (const uint32_t i : LightSystem::getCut()) {
+		LightBounds lightBounds;
+		if (boundLight(LightSystem::getBufferLight(i), static_cast<uint16_t>(i), viewMatrix, projectionMatrix, viewport, lightBounds)) {
+			localLights.emplace_back(lightBounds);
+		}
+	}
+	// Slices are handed out one at a time to the persistent workers, so no list is written by two threads
+	if (localLights.size() < PARALLEL_LIGHT_COUNT) {
+		assignSlices(0, SLICES);
+	} else {
+		Parallel::forEach(SLICES, [](const size_t slice) {
+			assignSlices(static_cast<uint32_t>(slice), static_cast<uint32_t>(slice) + 1);
+		}, 1);
+	}
+	// Pack the lists one after the other
+	statistics = Statistics{ static_cast<uint32_t>(directionalLights.size() + localLights.size()), 0, 0, 0 };
+	packedIndices.clear();
+	for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+		const uint32_t count = std::min(clusterCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+		const auto first = unpackedIndices.begin() + static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER;
+		clusterRanges[cluster] = glm::uvec2(static_cast<uint32_t>(packedIndices.size()), count);
+		packedIndices.insert(packedIndices.end(), first, first + count);
+		statistics.maxClusterLights = std::max(statistics.maxClusterLights, count);
+		statistics.droppedLights += clusterCounts[cluster] - count;
+	}
+	statistics.indexCount = static_cast<uint32_t>(packedIndices.size());
+	if (packedIndices.empty()) {
+		packedIndices.emplace_back(0);
+	}
+	clusterLights->uploadData(clusterRanges.data(), clusterRanges.size() * sizeof(glm::uvec2));
+	clusterLightIndices->uploadData(packedIndices.data(), packedIndices.size() * sizeof(uint16_t));
+}
+
+void LightClusters::enable(const Shader* shader) {
+	clustersBuffer->activate(BINDING_POINT);
+	const uint32_t blockIndex = glGetUniformBlockIndex(shader->id, "clustersBuffer");
+	if (blockIndex != GL_INVALID_INDEX) {
+		glUniformBlockBinding(shader->id, blockIndex, BINDING_POINT);
+	}
+	clusterLights->activate(CLUSTERS_TEXTURE_UNIT);
+	shader->setUniform("clusterLights", CLUSTERS_TEXTURE_UNIT);
+	clusterLightIndices->activate(INDICES_TEXTURE_UNIT);
+	shader->setUniform("clusterLightIndices", INDICES_TEXTURE_UNIT);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void LightClusters::setEnabled(const bool _enabled) {
+	enabled = _enabled;
+}
+
+bool LightClusters::isEnabled() {
+	return enabled;
+}
+
+const LightClusters::Statistics& LightClusters::getStatistics() {
+	return statistics;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * Forward declaration of the shader class.
+ */
+class Shader;
+
+/**
+ * Clustered light culling for the forward shaders.
+ * The view frustum is split in a grid of screen tiles and exponential depth slices, every frame the lights of the
+ * LightSystem are assigned on the CPU to the clusters their range (and cone, for spot lights) touches. Shaders find
+ * the cluster of a fragment from its window position and only go through the lights listed for it.
+ */
+namespace LightClusters {
+	// Same values on shader
+	static constexpr uint32_t TILES_X = 16;
+	static constexpr uint32_t TILES_Y = 9;
+	static constexpr uint32_t SLICES = 24;
+	static constexpr uint32_t CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+	static constexpr uint32_t BINDING_POINT = 1;
+	static constexpr int32_t CLUSTERS_TEXTURE_UNIT = 14;
+	static constexpr int32_t INDICES_TEXTURE_UNIT = 15;
+	// Lights kept per cluster, the ones past it are dropped
+	static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+	/**
+	 * Counters of the last assignment.
+	 */
+	struct Statistics {
+		uint32_t assignedLights; /* Lights touching at least one cluster */
+		uint32_t indexCount; /* Entries of all the cluster lists */
+		uint32_t maxClusterLights; /* Length of the longest cluster list */
+		uint32_t droppedLights; /* Entries left out of full cluster lists */
+	};
+
+	/**
+	 * Creates the buffers of the clusters, must be called after LightSystem::initialize.
+	 *
+	 */
+	void initialize();
+
+	/**
+	 * Assigns the lights to the clusters of the camera and uploads the lists.
+	 *
+	 * \param viewMatrix The view matrix of the camera.
+	 * \param projectionMatrix The perspective projection matrix of the camera.
+	 */
+	void update(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+
+	/**
+	 * Binds the cluster lists to a shader, the shader must already be active.
+	 *
+	 * \param shader The shader to bind the lists to.
+	 */
+	void enable(const Shader* shader);
+
+	/**
+	 * Toggles the clustered culling, shaders go through the lights of their object when disabled.
+	 *
+	 * \param _enabled The new state.
+	 */
+	void setEnabled(const bool _enabled);
+
+	/**
+	 * Getter for the state of the clustered culling.
+	 *
+	 * \return True if the shaders go through the lights of their cluster.
+	 */
+	bool isEnabled();
+
+	/**
+	 * Getter for the counters of the last assignment.
+	 *
+	 * \return The counters of the last assignment.
+	 */
+	const Statistics& getStatistics();
+}
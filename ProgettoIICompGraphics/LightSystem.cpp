@@ -1,48 +1,223 @@
 #include "LightSystem.hpp"
 
-#include "UniformBuffer.hpp"
+#include "Shader.hpp"
+#include "TextureBuffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <glad/glad.h>
+#include <glm/gtc/constants.hpp>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
 
 namespace LightSystem {
-    static Lights lights;
-    static UniformBuffer* lightsBuffer;
+	// Side of the cells on the xz plane the lights are sorted in, to find the ones near an object
+	static constexpr float GRID_CELL_SIZE = 8.0f;
+	// Lights and representatives in a cut at most
+	static constexpr size_t MAX_CUT_LIGHTS = 512;
+	// Clusters wider than this fraction of their distance from the view point are always split
+	static constexpr float MAX_CLUSTER_ANGLE = 0.5f;
+	static constexpr uint32_t NO_CHILD = std::numeric_limits<uint32_t>::max();
+
+	/**
+	 * A node of the light tree, a single light or a cluster of the lights below it.
+	 */
+	struct TreeNode {
+		glm::vec3 minValues; /* Bounding box of the lights' positions */
+		glm::vec3 maxValues;
+		float intensity; /* Summed brightness of the lights */
+		uint32_t light; /* Buffer index of the light, or of the cluster's representative */
+		uint32_t children[2]; /* Nodes of the two halves, NO_CHILD for single lights */
+	};
+
+	// Same layout as getLight on shader
+	static_assert(sizeof(Light) == 6 * sizeof(glm::uvec4), "Lights must take 6 texels of the light buffer");
+
+	static std::vector<Light> lights;
+	static size_t bufferCapacity = 0;
+
+	// The GPU copies of the lights, written one frame and read the next while the other one is written
+	static std::unique_ptr<TextureBuffer> lightsBuffers[2];
+	static size_t allocatedLights[2] = { 0, 0 };
+	// Slots changed since each copy was written, empty when the first slot isn't before the end
+	static size_t dirtyBegin[2] = { 0, 0 };
+	static size_t dirtyEnd[2] = { 0, 0 };
+	static uint32_t currentBuffer = 0;
+	static UploadStatistics uploadStatistics{ 0, 0 };
+
+	// Lights of every cell, rebuilt after a light changes
+	static std::unordered_map<int64_t, std::vector<uint32_t>> lightGrid;
+	static std::vector<uint32_t> directionalLights;
+	static bool gridDirty = true;
+	// Last query that reached every light, so lights spanning several cells are tested once
+	static std::vector<uint32_t> queryMarks;
+	static uint32_t queryMark = 0;
+	static std::vector<std::pair<float, uint32_t>> candidates;
+
+	// Light tree, rebuilt on the flush after a light changes
+	static std::vector<TreeNode> treeNodes;
+	static std::vector<uint32_t> treeRoots;
+	// Representatives of the clusters, stored in the light buffer after the lights
+	static std::vector<Light> treeLights;
+	static bool treeDirty = true;
+	// Copies of the light buffer still missing the representatives of the current tree
+	static bool treeUploads[2] = { false, false };
+	static std::vector<uint32_t> cut;
+	static bool lightTreeEnabled = true;
+	static float cutErrorRatio = 0.02f;
+
+	/**
+	 * Stores a light and marks it for the next flush, the storage grows to fit the position.
+	 *
+	 * \param position The slot of the light.
+	 * \param light The light to store.
+	 */
+	static void storeLight(const size_t position, const Light& light);
+
+	/**
+	 * Sorts the point and spot lights in the cells their range overlaps.
+	 *
+	 */
+	static void rebuildGrid();
+
+	/**
+	 * Packs the coordinates of a cell in a single key.
+	 *
+	 * \param x The cell along x.
+	 * \param z The cell along z.
+	 * \return The key of the cell.
+	 */
+	static int64_t cellKey(const int32_t x, const int32_t z);
+
+	/**
+	 * Rebuilds the light trees of the point and spot lights, baked and dynamic ones apart.
+	 *
+	 */
+	static void rebuildTree();
+
+	/**
+	 * Builds the subtree of a range of lights, splitting them at the median of their widest axis.
+	 *
+	 * \param items The lights of the tree, reordered in place.
+	 * \param begin The first light of the range.
+	 * \param end The light after the last one of the range.
+	 * \param directionWeight Scale of the directions against the positions when splitting, 0 to ignore them.
+	 * \return The index of the subtree's root.
+	 */
+	static uint32_t buildNode(std::vector<uint32_t>& items, const size_t begin, const size_t end, const float directionWeight);
+
+	/**
+	 * Computes the brightness of a light, its strongest color channel.
+	 *
+	 * \param light The light.
+	 * \return The brightness of the light.
+	 */
+	static float lightIntensity(const Light& light);
 }
 
 void LightSystem::initialize() {
-	lightsBuffer = new UniformBuffer();
-    lightsBuffer->bind();
-    lightsBuffer->uploadData(&lights, sizeof(Lights));
+	lightsBuffers[0] = std::make_unique<TextureBuffer>(GL_RGBA32UI);
+	lightsBuffers[1] = std::make_unique<TextureBuffer>(GL_RGBA32UI);
+}
+
+int64_t LightSystem::cellKey(const int32_t x, const int32_t z) {
+	return static_cast<int64_t>((static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z));
+}
+
+void LightSystem::storeLight(const size_t position, const Light& light) {
+	if (position >= MAX_LIGHTS) {
+		throw std::runtime_error("Light position " + std::to_string(position) + " is past the maximum amount of lights!");
+	}
+	if (position >= lights.size()) {
+		lights.resize(position + 1, Light{});
+	}
+	lights[position] = light;
+	gridDirty = true;
+	treeDirty = true;
+	for (uint32_t buffer = 0; buffer < 2; ++buffer) {
+		if (dirtyBegin[buffer] >= dirtyEnd[buffer]) {
+			dirtyBegin[buffer] = position;
+			dirtyEnd[buffer] = position + 1;
+		} else {
+			dirtyBegin[buffer] = std::min(dirtyBegin[buffer], position);
+			dirtyEnd[buffer] = std::max(dirtyEnd[buffer], position + 1);
+		}
+	}
+}
+
+void LightSystem::flush() {
+	uploadStatistics = UploadStatistics{ 0, 0 };
+	if (treeDirty) {
+		rebuildTree();
+	}
+	// Grow geometrically, adding lights one at a time shouldn't reallocate the buffers every frame
+	const size_t usedSlots = lights.size() + treeLights.size();
+	if (usedSlots > bufferCapacity) {
+		bufferCapacity = std::max(std::max(bufferCapacity * 2, usedSlots), static_cast<size_t>(32));
+	}
+	currentBuffer = 1 - currentBuffer;
+	TextureBuffer* buffer = lightsBuffers[currentBuffer].get();
+	if (allocatedLights[currentBuffer] < bufferCapacity) {
+		// Reallocating orphans the old storage, every light is written again
+		buffer->uploadData(nullptr, bufferCapacity * sizeof(Light));
+		buffer->uploadSubData(lights.data(), lights.size() * sizeof(Light), 0);
+		allocatedLights[currentBuffer] = bufferCapacity;
+		treeUploads[currentBuffer] = true;
+		uploadStatistics = UploadStatistics{ 1, lights.size() * sizeof(Light) };
+	} else if (dirtyBegin[currentBuffer] < dirtyEnd[currentBuffer]) {
+		// Erased trailing slots may have shrunk the lights below the range, the shaders never read them
+		const size_t end = std::min(dirtyEnd[currentBuffer], lights.size());
+		if (dirtyBegin[currentBuffer] < end) {
+			const size_t size = (end - dirtyBegin[currentBuffer]) * sizeof(Light);
+			buffer->uploadSubData(lights.data() + dirtyBegin[currentBuffer], size, dirtyBegin[currentBuffer] * sizeof(Light));
+			uploadStatistics = UploadStatistics{ 1, size };
+		}
+	}
+	dirtyBegin[currentBuffer] = 0;
+	dirtyEnd[currentBuffer] = 0;
+	if (treeUploads[currentBuffer] && !treeLights.empty()) {
+		const size_t size = treeLights.size() * sizeof(Light);
+		buffer->uploadSubData(treeLights.data(), size, lights.size() * sizeof(Light));
+		++uploadStatistics.uploads;
+		uploadStatistics.bytes += size;
+	}
+	treeUploads[currentBuffer] = false;
+}
+
+const LightSystem::UploadStatistics& LightSystem::getUploadStatistics() {
+	return uploadStatistics;
 }
 
 void LightSystem::setLight(const size_t position, const DirectionalLight& directionalLight) {
-	lightsBuffer->bind();
 	Light light{};
 	light.type = LIGHT_TYPE::DIRECTIONAL;
 	light.direction = glm::normalize(directionalLight.direction);
 	light.ambient = directionalLight.ambient;
 	light.diffuse = directionalLight.diffuse;
 	light.specular = directionalLight.specular;
-	lights.lights[position] = light;
-	lightsBuffer->uploadSubData(&light, sizeof(Light), position * sizeof(Light));
+	light.flags = directionalLight.baked ? LIGHT_FLAG_BAKED : 0;
+	storeLight(position, light);
 }
 
 void LightSystem::setLight(const size_t position, const PointLight& pointLight) {
-	lightsBuffer->bind();
 	Light light{};
 	light.type = LIGHT_TYPE::POINT;
 	light.position = pointLight.position;
 	light.ambient = pointLight.ambient;
 	light.diffuse = pointLight.diffuse;
 	light.specular = pointLight.specular;
+	light.flags = pointLight.baked ? LIGHT_FLAG_BAKED : 0;
 	light.range = pointLight.range;
 	light.constant = pointLight.constant;
 	light.linear = pointLight.linear;
 	light.quadratic = pointLight.quadratic;
-	lights.lights[position] = light;
-	lightsBuffer->uploadSubData(&light, sizeof(Light), position * sizeof(Light));
+	storeLight(position, light);
 }
 
 void LightSystem::setLight(const size_t position, const SpotLight& spotLight) {
-	lightsBuffer->bind();
 	Light light{};
 	light.type = LIGHT_TYPE::SPOT;
 	light.position = spotLight.position;
@@ -50,33 +225,349 @@ void LightSystem::setLight(const size_t position, const SpotLight& spotLight) {
 	light.ambient = spotLight.ambient;
 	light.diffuse = spotLight.diffuse;
 	light.specular = spotLight.specular;
+	light.flags = spotLight.baked ? LIGHT_FLAG_BAKED : 0;
 	light.range = spotLight.range;
 	light.constant = spotLight.constant;
 	light.linear = spotLight.linear;
 	light.quadratic = spotLight.quadratic;
 	light.cutOff = spotLight.cutOff;
 	light.outerCutOff = spotLight.outerCutOff;
-	lights.lights[position] = light;
-	lightsBuffer->uploadSubData(&light, sizeof(Light), position * sizeof(Light));
+	storeLight(position, light);
 }
 
 void LightSystem::setLight(const size_t position, const Light& anyLight) {
-	lights.lights[position] = anyLight;
-	lightsBuffer->uploadSubData(&anyLight, sizeof(Light), position * sizeof(Light));
+	storeLight(position, anyLight);
 }
 
 void LightSystem::eraseLight(const size_t position) {
-	Light light{};
-	light.type = LIGHT_TYPE::NONE;
-	lights.lights[position] = light;
-	lightsBuffer->uploadSubData(&light, sizeof(Light), position * sizeof(Light));
+	if (position >= lights.size()) {
+		return;
+	}
+	storeLight(position, Light{});
+	// Trailing empty slots are dropped, so the light count only covers used slots
+	while (!lights.empty() && lights.back().type == LIGHT_TYPE::NONE) {
+		lights.pop_back();
+	}
+}
+
+void LightSystem::setShadow(const size_t position, const uint32_t shadow) {
+	if (position >= lights.size() || lights[position].shadow == shadow) {
+		return;
+	}
+	Light light = lights[position];
+	light.shadow = shadow;
+	storeLight(position, light);
 }
 
-void LightSystem::enableAt(const uint32_t bindingPoint) {
-	lightsBuffer->bind();
-	lightsBuffer->activate(bindingPoint);
+void LightSystem::enable(const Shader* shader) {
+	lightsBuffers[currentBuffer]->activate(LIGHTS_TEXTURE_UNIT);
+	shader->setUniform("lights", LIGHTS_TEXTURE_UNIT);
+	glActiveTexture(GL_TEXTURE0);
 }
 
-LightSystem::Lights& LightSystem::getAllLights() {
+std::vector<LightSystem::Light>& LightSystem::getAllLights() {
 	return lights;
 }
+
+size_t LightSystem::getLightCount() {
+	return lights.size();
+}
+
+const LightSystem::Light& LightSystem::getBufferLight(const uint32_t index) {
+	return index < lights.size() ? lights[index] : treeLights[index - lights.size()];
+}
+
+float LightSystem::lightIntensity(const Light& light) {
+	const glm::vec3 color = light.ambient + light.diffuse + light.specular;
+	return glm::max(color.r, glm::max(color.g, color.b));
+}
+
+float LightSystem::lightAttenuation(const Light& light, const float distance) {
+	return 1.0f / glm::max(light.constant + light.linear * distance + light.quadratic * distance * distance, 1e-4f);
+}
+
+void LightSystem::rebuildTree() {
+	treeNodes.clear();
+	treeRoots.clear();
+	treeLights.clear();
+	// Baked and dynamic lights never share a representative, the shaders of static objects skip the baked ones
+	std::vector<uint32_t> pointLights[2];
+	std::vector<uint32_t> spotLights[2];
+	for (uint32_t i = 0; i < lights.size(); ++i) {
+		const uint32_t baked = (lights[i].flags & LIGHT_FLAG_BAKED) ? 1 : 0;
+		if (lights[i].type == LIGHT_TYPE::POINT) {
+			pointLights[baked].emplace_back(i);
+		} else if (lights[i].type == LIGHT_TYPE::SPOT) {
+			spotLights[baked].emplace_back(i);
+		}
+	}
+	for (uint32_t baked = 0; baked < 2; ++baked) {
+		if (!pointLights[baked].empty()) {
+			treeRoots.emplace_back(buildNode(pointLights[baked], 0, pointLights[baked].size(), 0.0f));
+		}
+		if (!spotLights[baked].empty()) {
+			// Directions span at most 2 per axis, weigh them as half the size of the whole set so cones pointing apart split early
+			glm::vec3 minValues(std::numeric_limits<float>::max());
+			glm::vec3 maxValues(std::numeric_limits<float>::lowest());
+			for (const uint32_t i : spotLights[baked]) {
+				minValues = glm::min(minValues, lights[i].position);
+				maxValues = glm::max(maxValues, lights[i].position);
+			}
+			treeRoots.emplace_back(buildNode(spotLights[baked], 0, spotLights[baked].size(), glm::distance(minValues, maxValues) * 0.5f));
+		}
+	}
+	treeDirty = false;
+	treeUploads[0] = true;
+	treeUploads[1] = true;
+}
+
+uint32_t LightSystem::buildNode(std::vector<uint32_t>& items, const size_t begin, const size_t end, const float directionWeight) {
+	if (end - begin == 1) {
+		const Light& light = lights[items[begin]];
+		treeNodes.emplace_back(TreeNode{ light.position, light.position, lightIntensity(light), items[begin], { NO_CHILD, NO_CHILD } });
+		return static_cast<uint32_t>(treeNodes.size() - 1);
+	}
+	// Split at the median of the widest axis, among the positions and the weighted directions
+	glm::vec3 minPosition(std::numeric_limits<float>::max());
+	glm::vec3 maxPosition(std::numeric_limits<float>::lowest());
+	glm::vec3 minDirection(std::numeric_limits<float>::max());
+	glm::vec3 maxDirection(std::numeric_limits<float>::lowest());
+	for (size_t i = begin; i < end; ++i) {
+		const Light& light = lights[items[i]];
+		minPosition = glm::min(minPosition, light.position);
+		maxPosition = glm::max(maxPosition, light.position);
+		minDirection = glm::min(minDirection, light.direction);
+		maxDirection = glm::max(maxDirection, light.direction);
+	}
+	const glm::vec3 positionExtent = maxPosition - minPosition;
+	const glm::vec3 directionExtent = (maxDirection - minDirection) * directionWeight;
+	uint32_t axis = 0;
+	float widest = positionExtent.x;
+	for (uint32_t i = 1; i < 6; ++i) {
+		const float extent = i < 3 ? positionExtent[i] : directionExtent[i - 3];
+		if (extent > widest) {
+			widest = extent;
+			axis = i;
+		}
+	}
+	const size_t middle = (begin + end) / 2;
+	std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end, [axis](const uint32_t first, const uint32_t second) {
+		return axis < 3 ? lights[first].position[axis] < lights[second].position[axis] : lights[first].direction[axis - 3] < lights[second].direction[axis - 3];
+	});
+	const uint32_t first = buildNode(items, begin, middle, directionWeight);
+	const uint32_t second = buildNode(items, middle, end, directionWeight);
+	// The representative is the one of the brighter half, carrying the color of both
+	const TreeNode& firstNode = treeNodes[first];
+	const TreeNode& secondNode = treeNodes[second];
+	const Light firstLight = getBufferLight(firstNode.light);
+	const Light secondLight = getBufferLight(secondNode.light);
+	Light representative = firstNode.intensity >= secondNode.intensity ? firstLight : secondLight;
+	representative.ambient = firstLight.ambient + secondLight.ambient;
+	representative.diffuse = firstLight.diffuse + secondLight.diffuse;
+	representative.specular = firstLight.specular + secondLight.specular;
+	// The shadows of a light don't match the ones of a whole cluster
+	representative.shadow = 0;
+	// Its range and cone grow to reach everything the two halves did
+	const float firstDistance = glm::distance(representative.position, firstLight.position);
+	const float secondDistance = glm::distance(representative.position, secondLight.position);
+	representative.range = glm::max(firstLight.range + firstDistance, secondLight.range + secondDistance);
+	if (representative.type == LIGHT_TYPE::SPOT) {
+		const auto angleOf = [](const float cosine) {
+			return std::acos(glm::clamp(cosine, -1.0f, 1.0f));
+		};
+		const float firstDivergence = angleOf(glm::dot(representative.direction, firstLight.direction));
+		const float secondDivergence = angleOf(glm::dot(representative.direction, secondLight.direction));
+		const float outerAngle = glm::min(glm::max(angleOf(firstLight.outerCutOff) + firstDivergence, angleOf(secondLight.outerCutOff) + secondDivergence), glm::pi<float>());
+		// Keep the inner cone inside the outer one, the shaders divide by their difference
+		const float innerAngle = glm::min(glm::max(angleOf(firstLight.cutOff) + firstDivergence, angleOf(secondLight.cutOff) + secondDivergence), outerAngle - 1e-3f);
+		representative.outerCutOff = std::cos(outerAngle);
+		representative.cutOff = std::cos(innerAngle);
+	}
+	treeLights.emplace_back(representative);
+	TreeNode node{};
+	node.minValues = glm::min(firstNode.minValues, secondNode.minValues);
+	node.maxValues = glm::max(firstNode.maxValues, secondNode.maxValues);
+	node.intensity = firstNode.intensity + secondNode.intensity;
+	node.light = static_cast<uint32_t>(lights.size() + treeLights.size() - 1);
+	node.children[0] = first;
+	node.children[1] = second;
+	treeNodes.emplace_back(node);
+	return static_cast<uint32_t>(treeNodes.size() - 1);
+}
+
+void LightSystem::updateCut(const glm::vec3& viewPoint) {
+	cut.clear();
+	if (!lightTreeEnabled) {
+		for (uint32_t i = 0; i < lights.size(); ++i) {
+			if (lights[i].type == LIGHT_TYPE::POINT || lights[i].type == LIGHT_TYPE::SPOT) {
+				cut.emplace_back(i);
+			}
+		}
+		return;
+	}
+	// Light given at the view point by the representatives of the cut
+	float totalLight = 0.0f;
+	const auto estimate = [&viewPoint](const TreeNode& node) {
+		const Light& light = getBufferLight(node.light);
+		return node.intensity * lightAttenuation(light, glm::distance(viewPoint, light.position));
+	};
+	// Clusters by the most light they could give at the view point, an upper bound of the error of their representative
+	std::priority_queue<std::pair<float, uint32_t>> clusters;
+	const auto addNode = [&](const uint32_t index) {
+		const TreeNode& node = treeNodes[index];
+		totalLight += estimate(node);
+		if (node.children[0] == NO_CHILD) {
+			cut.emplace_back(node.light);
+			return;
+		}
+		const float distance = glm::distance(glm::clamp(viewPoint, node.minValues, node.maxValues), viewPoint);
+		const float extent = glm::distance(node.minValues, node.maxValues);
+		const float error = extent > MAX_CLUSTER_ANGLE * distance ? std::numeric_limits<float>::max() : node.intensity * lightAttenuation(getBufferLight(node.light), distance);
+		clusters.emplace(error, index);
+	};
+	for (const uint32_t root : treeRoots) {
+		addNode(root);
+	}
+	// Every split adds one light to the cut
+	while (!clusters.empty() && cut.size() + clusters.size() < MAX_CUT_LIGHTS) {
+		const std::pair<float, uint32_t> cluster = clusters.top();
+		if (cluster.first <= cutErrorRatio * totalLight) {
+			break;
+		}
+		clusters.pop();
+		const TreeNode node = treeNodes[cluster.second];
+		totalLight -= estimate(node);
+		addNode(node.children[0]);
+		addNode(node.children[1]);
+	}
+	while (!clusters.empty()) {
+		cut.emplace_back(treeNodes[clusters.top().second].light);
+		clusters.pop();
+	}
+	std::sort(cut.begin(), cut.end());
+}
+
+const std::vector<uint32_t>& LightSystem::getCut() {
+	return cut;
+}
+
+void LightSystem::setLightTreeEnabled(const bool _enabled) {
+	lightTreeEnabled = _enabled;
+}
+
+bool LightSystem::isLightTreeEnabled() {
+	return lightTreeEnabled;
+}
+
+void LightSystem::setCutErrorRatio(const float ratio) {
+	cutErrorRatio = ratio;
+}
+
+float LightSystem::getCutErrorRatio() {
+	return cutErrorRatio;
+}
+
+void LightSystem::rebuildGrid() {
+	lightGrid.clear();
+	directionalLights.clear();
+	for (uint32_t i = 0; i < lights.size(); ++i) {
+		const Light& light = lights[i];
+		if (light.type == LIGHT_TYPE::DIRECTIONAL) {
+			directionalLights.emplace_back(i);
+		} else if (light.type != LIGHT_TYPE::NONE) {
+			const glm::ivec2 minCell(glm::floor((glm::vec2(light.position.x, light.position.z) - light.range) / GRID_CELL_SIZE));
+			const glm::ivec2 maxCell(glm::floor((glm::vec2(light.position.x, light.position.z) + light.range) / GRID_CELL_SIZE));
+			for (int32_t x = minCell.x; x <= maxCell.x; ++x) {
+				for (int32_t z = minCell.y; z <= maxCell.y; ++z) {
+					lightGrid[cellKey(x, z)].emplace_back(i);
+				}
+			}
+		}
+	}
+	queryMarks.assign(lights.size(), 0);
+	queryMark = 0;
+	gridDirty = false;
+}
+
+LightSystem::ObjectLights LightSystem::findLights(const glm::vec3& minValues, const glm::vec3& maxValues) {
+	if (gridDirty) {
+		rebuildGrid();
+	}
+	++queryMark;
+	// Light reaching the box paired with the light's position
+	candidates.clear();
+	for (const uint32_t i : directionalLights) {
+		candidates.emplace_back(std::numeric_limits<float>::max(), i);
+	}
+	const glm::vec3 boxCenter = (minValues + maxValues) * 0.5f;
+	const float boxRadius = glm::distance(minValues, maxValues) * 0.5f;
+	const auto testLights = [&](const std::vector<uint32_t>& cellLights) {
+		for (const uint32_t i : cellLights) {
+			if (queryMarks[i] == queryMark) {
+				continue;
+			}
+			queryMarks[i] = queryMark;
+			const Light& light = lights[i];
+			// Closest point of the box to the light
+			const float distance = glm::distance(glm::clamp(light.position, minValues, maxValues), light.position);
+			if (distance > light.range) {
+				continue;
+			}
+			// Spot cones are tested against the sphere around the box
+			if (light.type == LIGHT_TYPE::SPOT && light.outerCutOff > 0.0f) {
+				const glm::vec3 toCenter = boxCenter - light.position;
+				const float alongAxis = glm::dot(toCenter, light.direction);
+				const float fromAxis = glm::sqrt(glm::max(glm::dot(toCenter, toCenter) - alongAxis * alongAxis, 0.0f));
+				const float sinOuter = glm::sqrt(1.0f - light.outerCutOff * light.outerCutOff);
+				if (light.outerCutOff * fromAxis - sinOuter * alongAxis > boxRadius || alongAxis < -boxRadius) {
+					continue;
+				}
+			}
+			candidates.emplace_back(lightIntensity(light) * lightAttenuation(light, distance), i);
+		}
+	};
+	const glm::ivec2 minCell(glm::floor(glm::vec2(minValues.x, minValues.z) / GRID_CELL_SIZE));
+	const glm::ivec2 maxCell(glm::floor(glm::vec2(maxValues.x, maxValues.z) / GRID_CELL_SIZE));
+	const int64_t cellCount = (static_cast<int64_t>(maxCell.x) - minCell.x + 1) * (static_cast<int64_t>(maxCell.y) - minCell.y + 1);
+	if (cellCount <= static_cast<int64_t>(lightGrid.size())) {
+		for (int32_t x = minCell.x; x <= maxCell.x; ++x) {
+			for (int32_t z = minCell.y; z <= maxCell.y; ++z) {
+				const auto cell = lightGrid.find(cellKey(x, z));
+				if (cell != lightGrid.end()) {
+					testLights(cell->second);
+				}
+			}
+		}
+	} else {
+		// Boxes covering more cells than there are filled ones walk the filled cells instead
+		for (const auto& [key, cellLights] : lightGrid) {
+			const int32_t x = static_cast<int32_t>(key >> 32);
+			const int32_t z = static_cast<int32_t>(key & 0xFFFFFFFF);
+			if (x >= minCell.x && x <= maxCell.x && z >= minCell.y && z <= maxCell.y) {
+				testLights(cellLights);
+			}
+		}
+	}
+	if (candidates.size() > MAX_OBJECT_LIGHTS) {
+		std::partial_sort(candidates.begin(), candidates.begin() + MAX_OBJECT_LIGHTS, candidates.end(), [](const auto& first, const auto& second) {
+			return first.first > second.first;
+		});
+		candidates.resize(MAX_OBJECT_LIGHTS);
+	}
+	ObjectLights objectLights{};
+	objectLights.count = static_cast<uint32_t>(candidates.size());
+	for (uint32_t i = 0; i < objectLights.count; ++i) {
+		objectLights.indices[i] = candidates[i].second;
+	}
+	// Keep the buffer order, so neighbouring objects read the lights in the same order
+	std::sort(objectLights.indices, objectLights.indices + objectLights.count);
+	return objectLights;
+}
+
+void LightSystem::enableObjectLights(const Shader* shader, const ObjectLights& objectLights) {
+	shader->setUniform("objectLightCount", objectLights.count);
+	// Arrays are listed by their first element
+	if (objectLights.count > 0) {
+		glUniform1uiv(shader->getUniformLocation("objectLights[0]"), static_cast<int32_t>(objectLights.count), objectLights.indices);
+	}
+}
\ No newline at end of file
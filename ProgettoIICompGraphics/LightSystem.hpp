@@ -1,10 +1,22 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * Forward declaration of the shader class.
+ */
+class Shader;
 
 namespace LightSystem {
+	// Light lists store 16 bit indices, the light tree stores up to as many representatives after the lights
+	static constexpr size_t MAX_LIGHTS = 4096;
 	// Same value on shader
-	static constexpr size_t MAX_LIGHTS = 32;
+	static constexpr size_t MAX_OBJECT_LIGHTS = 16;
+	static constexpr int32_t LIGHTS_TEXTURE_UNIT = 13;
+
+	// The light reaches static objects through their lightmaps, their shaders skip it
+	static constexpr uint32_t LIGHT_FLAG_BAKED = 1;
 
 	enum class LIGHT_TYPE : uint32_t {
 		NONE = 0,
@@ -18,6 +30,7 @@ namespace LightSystem {
 		glm::vec3 ambient;
 		glm::vec3 diffuse;
 		glm::vec3 specular;
+		bool baked = false;
 	};
 
 	struct PointLight {
@@ -29,6 +42,7 @@ namespace LightSystem {
 		float linear;
 		float constant;
 		float quadratic;
+		bool baked = false;
 	};
 
 	struct SpotLight {
@@ -43,9 +57,10 @@ namespace LightSystem {
 		float linear;
 		float constant;
 		float quadratic;
+		bool baked = false;
 	};
 
-	// Arranged this way to assure padding = 4N for the shader to work
+	// Arranged this way to assure padding = 4N for the shader to work, every light takes 6 texels of the light buffer
 	struct Light {
 		glm::vec3 position;
 		LIGHT_TYPE type;
@@ -59,11 +74,24 @@ namespace LightSystem {
 		float quadratic;
 		float cutOff;
 		float outerCutOff;
-		glm::vec2 pad = glm::vec2(0.0f);
+		uint32_t flags = 0;
+		uint32_t shadow = 0; /* First tile of the light in the shadow atlas plus one, 0 if it casts no shadows */
 	};
 
-	struct Lights {
-		Light lights[MAX_LIGHTS];
+	/**
+	 * Transfers to the light buffer done by the last flush.
+	 */
+	struct UploadStatistics {
+		uint32_t uploads; /* Buffer writes */
+		size_t bytes; /* Bytes written */
+	};
+
+	/**
+	 * The lights reaching an object, its shaders only go through these.
+	 */
+	struct ObjectLights {
+		uint32_t count;
+		uint32_t indices[MAX_OBJECT_LIGHTS];
 	};
 
 	void initialize();
@@ -72,6 +100,131 @@ namespace LightSystem {
 	void setLight(const size_t position, const SpotLight& spotLight);
 	void setLight(const size_t position, const Light& anyLight);
 	void eraseLight(const size_t position);
-	void enableAt(const uint32_t bindingPoint);
-	Lights& getAllLights();
+
+	/**
+	 * Links a light to its tiles in the shadow atlas, see ShadowAtlas.
+	 *
+	 * \param position The slot of the light.
+	 * \param shadow The first tile of the light plus one, 0 if it casts no shadows.
+	 */
+	void setShadow(const size_t position, const uint32_t shadow);
+
+	/**
+	 * Uploads the lights changed since the last flush, call it once per frame before rendering.
+	 * The light buffer is double buffered, every flush writes the copy the GPU didn't read in the previous frame
+	 * with a single upload of the range of slots that changed since that copy was last written.
+	 * The light tree is rebuilt here when a light changed, its representatives are stored after the lights.
+	 *
+	 */
+	void flush();
+
+	/**
+	 * Selects the cut of the light tree to shade with from a view point, must be called after flush.
+	 * Starting from the roots, the cluster with the largest error bound is replaced by its two children until every
+	 * cluster left could give less than the error ratio of the total light at the view point. Clusters kept are shaded
+	 * as their representative: one of their lights carrying the color of all of them, with a range covering them all.
+	 * Point and spot lights, baked and dynamic ones, have separate trees. Directional lights are never part of the cut.
+	 *
+	 * \param viewPoint The position of the camera.
+	 */
+	void updateCut(const glm::vec3& viewPoint);
+
+	/**
+	 * Getter for the cut of the light tree, every point and spot light if the tree is disabled.
+	 *
+	 * \return The buffer indices of the lights and representatives in the cut, in buffer order.
+	 */
+	const std::vector<uint32_t>& getCut();
+
+	/**
+	 * Getter for a light as stored in the light buffer.
+	 *
+	 * \param index The buffer index, past the light count for the representatives of the light tree.
+	 * \return The light or representative.
+	 */
+	const Light& getBufferLight(const uint32_t index);
+
+	/**
+	 * Computes the attenuation of a light at a distance, ignoring its range.
+	 * The CPU side of the shaders' attenuation, the denominator is kept off zero.
+	 *
+	 * \param light The light.
+	 * \param distance The distance from the light.
+	 * \return The attenuation factor.
+	 */
+	float lightAttenuation(const Light& light, const float distance);
+
+	/**
+	 * Toggles the light tree, shaders go through every light when disabled.
+	 *
+	 * \param _enabled The new state.
+	 */
+	void setLightTreeEnabled(const bool _enabled);
+
+	/**
+	 * Getter for the state of the light tree.
+	 *
+	 * \return True if the cut replaces distant lights with their representatives.
+	 */
+	bool isLightTreeEnabled();
+
+	/**
+	 * Setter for the error bound of the cut.
+	 *
+	 * \param ratio The fraction of the total light a cluster may give before it is split.
+	 */
+	void setCutErrorRatio(const float ratio);
+
+	/**
+	 * Getter for the error bound of the cut.
+	 *
+	 * \return The fraction of the total light a cluster may give before it is split.
+	 */
+	float getCutErrorRatio();
+
+	/**
+	 * Getter for the transfers of the last flush.
+	 *
+	 * \return The upload counters of the last flush.
+	 */
+	const UploadStatistics& getUploadStatistics();
+
+	/**
+	 * Binds the light buffer to a shader, the shader must already be active.
+	 *
+	 * \param shader The shader to bind the lights to.
+	 */
+	void enable(const Shader* shader);
+
+	/**
+	 * Getter for the lights, slots past the last set light are not stored.
+	 *
+	 * \return The lights, erased slots have the NONE type.
+	 */
+	std::vector<Light>& getAllLights();
+
+	/**
+	 * Getter for the amount of light slots in use.
+	 *
+	 * \return The slot after the last set light.
+	 */
+	size_t getLightCount();
+
+	/**
+	 * Finds the lights whose range (and cone, for spot lights) overlaps a world space box.
+	 * When more than MAX_OBJECT_LIGHTS do, the ones giving the most light at the box are kept.
+	 *
+	 * \param minValues The minimum corner of the box.
+	 * \param maxValues The maximum corner of the box.
+	 * \return The lights reaching the box.
+	 */
+	ObjectLights findLights(const glm::vec3& minValues, const glm::vec3& maxValues);
+
+	/**
+	 * Sends the lights of an object to a shader, the shader must already be active.
+	 *
+	 * \param shader The shader to send the lights to.
+	 * \param objectLights The lights of the object.
+	 */
+	void enableObjectLights(const Shader* shader, const ObjectLights& objectLights);
 }
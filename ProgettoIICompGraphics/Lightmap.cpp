@@ -0,0 +1,521 @@
+#include "Lightmap.hpp"
+
+#include "Hash.hpp"
+#include "LightmapUnwrapper.hpp"
+#include "LightSystem.hpp"
+#include "Material.hpp"
+#include "Mesh.hpp"
+#include "MeshInstanceNode.hpp"
+#include "Parallel.hpp"
+#include "Texture2D.hpp"
+#include "TriangleBvh.hpp"
+#include "Vertex.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <variant>
+
+// Part of the cache key, bumped whenever the bake changes
+static constexpr uint32_t CACHE_VERSION = 1;
+// Distance the shadow and bounce rays start off the surface, so they don't hit it
+static constexpr float RAY_OFFSET = 0.01f;
+// Longest bounce ray, farther surfaces add too little light to be worth the trace
+static constexpr float MAX_BOUNCE_DISTANCE = 32.0f;
+// Average of the albedo textures, which only live on the GPU
+static constexpr float TEXTURE_ALBEDO = 0.5f;
+// Rings of empty texels filled around the charts
+static constexpr uint32_t DILATION_ITERATIONS = 2;
+
+Lightmap::Lightmap(const std::shared_ptr<SceneNode>& root, const std::string& name, const float texelsPerUnit, const uint32_t _indirectSamples)
+	:
+	unwraps(),
+	instances(),
+	occluders(),
+	texture(nullptr),
+	cachePath("assets/lightmaps/" + name + ".lightmap"),
+	atlasSize(0),
+	indirectSamples(std::max(_indirectSamples, 1u)),
+	bakeTime(0.0f)
+{
+	std::vector<MeshInstanceNode*> receivers;
+	Lightmap::collectMeshes(root.get(), receivers, this->occluders);
+	if (receivers.empty()) {
+		std::cout << "Built lightmap: " << name << " (nothing to lightmap)" << std::endl;
+		return;
+	}
+	// Every mesh is unwrapped once, at the scale of its first instance
+	std::unordered_map<const Mesh*, uint32_t> meshUnwraps;
+	uint32_t chartCount = 0;
+	for (MeshInstanceNode* node : receivers) {
+		const Mesh* source = node->getMesh();
+		const glm::mat4& worldMatrix = node->getWorldTransform().getTransformMatrix();
+		const auto [meshUnwrap, inserted] = meshUnwraps.emplace(source, static_cast<uint32_t>(this->unwraps.size()));
+		if (inserted) {
+			const float scale = glm::max(glm::length(glm::vec3(worldMatrix[0])), glm::max(glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2]))));
+			const std::vector<Vertex>& vertices = source->getVertices();
+			const std::vector<uint32_t>& sourceIndices = source->getIndices();
+			const Mesh::Lod& fullDetail = source->getLod(0);
+			LightmapUnwrapper::Unwrap unwrap = LightmapUnwrapper::unwrap(vertices, sourceIndices.data() + fullDetail.indexOffset, fullDetail.indexCount, texelsPerUnit * scale);
+			chartCount += unwrap.chartCount;
+			// The vertices are split along the chart seams, the coarser levels use the first copy of every vertex
+			std::vector<Vertex> meshVertices;
+			std::vector<uint32_t> meshSources(unwrap.vertexRemap);
+			std::vector<uint32_t> firstCopy(vertices.size(), std::numeric_limits<uint32_t>::max());
+			meshVertices.reserve(unwrap.vertexRemap.size());
+			for (uint32_t i = 0; i < unwrap.vertexRemap.size(); ++i) {
+				meshVertices.emplace_back(vertices[unwrap.vertexRemap[i]]);
+				if (firstCopy[unwrap.vertexRemap[i]] == std::numeric_limits<uint32_t>::max()) {
+					firstCopy[unwrap.vertexRemap[i]] = i;
+				}
+			}
+			std::vector<glm::vec2> uvs = unwrap.uvs;
+			std::vector<uint32_t> meshIndices(sourceIndices.size());
+			for (size_t i = 0; i < sourceIndices.size(); ++i) {
+				if (firstCopy[sourceIndices[i]] == std::numeric_limits<uint32_t>::max()) {
+					firstCopy[sourceIndices[i]] = static_cast<uint32_t>(meshVertices.size());
+					meshVertices.emplace_back(vertices[sourceIndices[i]]);
+					meshSources.emplace_back(sourceIndices[i]);
+					uvs.emplace_back(0.0f);
+				}
+				meshIndices[i] = firstCopy[sourceIndices[i]];
+			}
+			// The triangles keep their order, so the levels of detail and the meshlets keep their index ranges
+			std::copy(unwrap.indices.begin(), unwrap.indices.end(), meshIndices.begin() + fullDetail.indexOffset);
+			std::vector<Mesh::Lod> lods;
+			for (uint32_t lod = 0; lod < source->getLodCount(); ++lod) {
+				lods.emplace_back(source->getLod(lod));
+			}
+			Unwrap meshUnwrapData{ source, nullptr, {}, {}, std::move(unwrap.indices), std::move(unwrap.uvs), unwrap.size };
+			for (const uint32_t vertex : unwrap.vertexRemap) {
+				meshUnwrapData.positions.emplace_back(vertices[vertex].position);
+				meshUnwrapData.normals.emplace_back(vertices[vertex].normal);
+			}
+			meshUnwrapData.mesh = std::make_shared<Mesh>(std::move(meshVertices), std::move(meshIndices), std::move(lods), std::vector<Mesh::Meshlet>(source->getMeshlets()), source->drawType, Mesh::DataRetention::NONE, source->vertexFormat);
+			meshUnwrapData.mesh->setLightmapUvs(uvs);
+			// The baked ambient occlusion follows the vertices to their copies
+			const std::vector<uint8_t>& sourceOcclusion = source->getVertexOcclusion();
+			if (!sourceOcclusion.empty()) {
+				std::vector<uint8_t> occlusion;
+				occlusion.reserve(meshSources.size());
+				for (const uint32_t vertex : meshSources) {
+					occlusion.emplace_back(sourceOcclusion[vertex]);
+				}
+				meshUnwrapData.mesh->setVertexOcclusion(occlusion);
+			}
+			this->unwraps.emplace_back(std::move(meshUnwrapData));
+		}
+		// The bounce only knows the material's colours, the textures count as an average grey
+		glm::vec4 reflectance(1.0f);
+		const std::unordered_map<std::string, Material::MaterialValueType>& properties = node->getMaterial()->getProperties();
+		for (const char* property : { "color", "diffuse" }) {
+			const auto value = properties.find(property);
+			if (value != properties.end() && std::holds_alternative<glm::vec4>(value->second)) {
+				reflectance *= std::get<glm::vec4>(value->second);
+			}
+		}
+		this->instances.emplace_back(Instance{ node, meshUnwrap->second, glm::uvec2(0), glm::vec4(0.0f), glm::vec3(reflectance) * TEXTURE_ALBEDO });
+	}
+	// Pack the instances in rows of the smallest square power of two atlas they fit in, tallest first
+	uint64_t area = 0;
+	uint32_t widest = 0;
+	for (const Instance& instance : this->instances) {
+		const glm::uvec2& size = this->unwraps[instance.unwrap].size;
+		area += static_cast<uint64_t>(size.x) * size.y;
+		widest = std::max(widest, size.x);
+	}
+	uint32_t side = 1;
+	while (side < widest || static_cast<uint64_t>(side) * side < area) {
+		side *= 2;
+	}
+	std::vector<uint32_t> order(this->instances.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [this](const uint32_t first, const uint32_t second) {
+		return this->unwraps[this->instances[first].unwrap].size.y > this->unwraps[this->instances[second].unwrap].size.y;
+	});
+	for (; ; side *= 2) {
+		if (side > MAX_ATLAS_SIZE) {
+			throw std::runtime_error("Too many objects to lightmap: " + name);
+		}
+		glm::uvec2 cursor(0);
+		uint32_t rowHeight = 0;
+		for (const uint32_t i : order) {
+			const glm::uvec2& size = this->unwraps[this->instances[i].unwrap].size;
+			if (cursor.x + size.x > side) {
+				cursor = glm::uvec2(0, cursor.y + rowHeight);
+				rowHeight = 0;
+			}
+			this->instances[i].origin = cursor;
+			cursor.x += size.x;
+			rowHeight = std::max(rowHeight, size.y);
+		}
+		if (cursor.y + rowHeight <= side) {
+			break;
+		}
+	}
+	this->atlasSize = glm::uvec2(side);
+	for (Instance& instance : this->instances) {
+		instance.scaleOffset = glm::vec4(glm::vec2(this->unwraps[instance.unwrap].size) / glm::vec2(this->atlasSize), glm::vec2(instance.origin) / glm::vec2(this->atlasSize));
+	}
+	this->texture = std::make_unique<Texture2D>(GL_RGB16F, GL_RGB);
+	this->texture->bind();
+	this->texture->setParameters({
+		{ GL_TEXTURE_MIN_FILTER, GL_LINEAR },
+		{ GL_TEXTURE_MAG_FILTER, GL_LINEAR },
+		{ GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE },
+		{ GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE }
+	});
+	this->texture->unbind();
+	std::cout << "Built lightmap: " << name << " (" << this->instances.size() << " objects, " << this->unwraps.size() << " meshes, " << chartCount << " charts, " << side << "x" << side << " texels)" << std::endl;
+	if (this->loadCache(this->computeKey())) {
+		std::cout << "Loaded lightmap: " << this->cachePath << std::endl;
+	} else {
+		this->bake();
+	}
+}
+
+Lightmap::~Lightmap() = default;
+
+void Lightmap::collectMeshes(SceneNode* node, std::vector<MeshInstanceNode*>& receivers, std::vector<MeshInstanceNode*>& casters) {
+	if (MeshInstanceNode* meshNode = dynamic_cast<MeshInstanceNode*>(node)) {
+		const Material* material = meshNode->getMaterial().get();
+		const Mesh* mesh = meshNode->getMesh();
+		// Only the opaque triangle meshes that still have their CPU data take part in the bake
+		if (!material->transparentFlag && mesh->drawType == GL_TRIANGLES && !mesh->getIndices().empty()) {
+			if (material->staticFlag && material->litFlag && !mesh->getVertices().empty()) {
+				receivers.emplace_back(meshNode);
+			} else {
+				casters.emplace_back(meshNode);
+			}
+		}
+	}
+	for (const std::shared_ptr<SceneNode>& child : node->getChildren()) {
+		Lightmap::collectMeshes(child.get(), receivers, casters);
+	}
+}
+
+std::vector<Lightmap::Texel> Lightmap::rasterize() const {
+	std::vector<Texel> texels;
+	std::vector<uint8_t> covered(static_cast<size_t>(this->atlasSize.x) * this->atlasSize.y, 0);
+	const auto edge = [](const glm::vec2& a, const glm::vec2& b, const glm::vec2& point) {
+		return (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+	};
+	for (const Instance& instance : this->instances) {
+		const Unwrap& unwrap = this->unwraps[instance.unwrap];
+		const glm::mat4& worldMatrix = instance.node->getWorldTransform().getTransformMatrix();
+		const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(worldMatrix)));
+		for (size_t triangle = 0; triangle < unwrap.indices.size() / 3; ++triangle) {
+			const uint32_t* corners = &unwrap.indices[triangle * 3];
+			glm::vec2 points[3];
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				points[corner] = glm::vec2(instance.origin) + unwrap.uvs[corners[corner]] * glm::vec2(unwrap.size);
+			}
+			const float area = edge(points[0], points[1], points[2]);
+			if (glm::abs(area) < 1e-8f) {
+				continue;
+			}
+			const glm::vec3 faceNormal = glm::normalize(normalMatrix * glm::cross(unwrap.positions[corners[1]] - unwrap.positions[corners[0]], unwrap.positions[corners[2]] - unwrap.positions[corners[0]]));
+			const glm::uvec2 first(glm::max(glm::floor(glm::min(points[0], glm::min(points[1], points[2]))), glm::vec2(instance.origin)));
+			const glm::uvec2 last(glm::min(glm::ceil(glm::max(points[0], glm::max(points[1], points[2]))), glm::vec2(instance.origin + unwrap.size)));
+			for (uint32_t y = first.y; y < last.y; ++y) {
+				for (uint32_t x = first.x; x < last.x; ++x) {
+					// Texel centers inside the triangle, the ones on an edge belong to the first triangle found
+					const glm::vec2 center(static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f);
+					const float weight0 = edge(points[1], points[2], center) / area;
+					const float weight1 = edge(points[2], points[0], center) / area;
+					const float weight2 = 1.0f - weight0 - weight1;
+					const uint32_t index = y * this->atlasSize.x + x;
+					if (weight0 < -1e-4f || weight1 < -1e-4f || weight2 < -1e-4f || covered[index]) {
+						continue;
+					}
+					covered[index] = 1;
+					const glm::vec3 position = unwrap.positions[corners[0]] * weight0 + unwrap.positions[corners[1]] * weight1 + unwrap.positions[corners[2]] * weight2;
+					const glm::vec3 normal = normalMatrix * (unwrap.normals[corners[0]] * weight0 + unwrap.normals[corners[1]] * weight1 + unwrap.normals[corners[2]] * weight2);
+					texels.emplace_back(Texel{
+						index,
+						glm::vec3(worldMatrix * glm::vec4(position, 1.0f)),
+						glm::length(normal) > 1e-6f ? glm::normalize(normal) : faceNormal
+					});
+				}
+			}
+		}
+	}
+	return texels;
+}
+
+void Lightmap::bake() {
+	if (this->instances.empty()) {
+		return;
+	}
+	const double startTime = glfwGetTime();
+	std::vector<LightSystem::Light> lights;
+	for (const LightSystem::Light& light : LightSystem::getAllLights()) {
+		if (light.type != LightSystem::LIGHT_TYPE::NONE && (light.flags & LightSystem::LIGHT_FLAG_BAKED)) {
+			lights.emplace_back(light);
+		}
+	}
+	// Every opaque triangle in world space, the lightmapped ones first so the bounce can read their texels
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> triangleInstances;
+	std::vector<uint32_t> firstTriangles;
+	for (uint32_t i = 0; i < this->instances.size(); ++i) {
+		const Unwrap& unwrap = this->unwraps[this->instances[i].unwrap];
+		const glm::mat4& worldMatrix = this->instances[i].node->getWorldTransform().getTransformMatrix();
+		const uint32_t baseVertex = static_cast<uint32_t>(positions.size());
+		for (const glm::vec3& position : unwrap.positions) {
+			positions.emplace_back(worldMatrix * glm::vec4(position, 1.0f));
+		}
+		for (const uint32_t index : unwrap.indices) {
+			indices.emplace_back(baseVertex + index);
+		}
+		firstTriangles.emplace_back(static_cast<uint32_t>(triangleInstances.size()));
+		triangleInstances.insert(triangleInstances.end(), unwrap.indices.size() / 3, i);
+	}
+	for (const MeshInstanceNode* occluder : this->occluders) {
+		const Mesh* mesh = occluder->getMesh();
+		const glm::mat4& worldMatrix = occluder->getWorldTransform().getTransformMatrix();
+		const uint32_t baseVertex = static_cast<uint32_t>(positions.size());
+		for (const glm::vec3& position : mesh->getPositions()) {
+			positions.emplace_back(worldMatrix * glm::vec4(position, 1.0f));
+		}
+		const Mesh::Lod& fullDetail = mesh->getLod(0);
+		for (uint32_t i = 0; i < fullDetail.indexCount; ++i) {
+			indices.emplace_back(baseVertex + mesh->getIndices()[fullDetail.indexOffset + i]);
+		}
+	}
+	const TriangleBvh bvh(positions, indices);
+	const std::vector<Texel> texels = this->rasterize();
+	const size_t texelCount = static_cast<size_t>(this->atlasSize.x) * this->atlasSize.y;
+	std::vector<uint8_t> covered(texelCount, 0);
+	for (const Texel& texel : texels) {
+		covered[texel.index] = 1;
+	}
+	// Direct light, the same terms as the forward shaders without the specular, shadowed by the scene
+	std::vector<glm::vec3> direct(texelCount, glm::vec3(0.0f));
+	Parallel::forEach(texels.size(), [&](const size_t i) {
+		const Texel& texel = texels[i];
+		const glm::vec3 origin = texel.position + texel.normal * RAY_OFFSET;
+		glm::vec3 result(0.0f);
+		for (const LightSystem::Light& light : lights) {
+			glm::vec3 lightDir = glm::normalize(-light.direction);
+			float distance = std::numeric_limits<float>::max();
+			float attenuation = 1.0f;
+			if (light.type != LightSystem::LIGHT_TYPE::DIRECTIONAL) {
+				const glm::vec3 toLight = light.position - texel.position;
+				distance = glm::length(toLight);
+				if (distance > light.range || distance <= 0.0f) {
+					continue;
+				}
+				lightDir = toLight / distance;
+				attenuation = LightSystem::lightAttenuation(light, distance);
+				if (light.type == LightSystem::LIGHT_TYPE::SPOT) {
+					const float theta = glm::dot(lightDir, glm::normalize(-light.direction));
+					attenuation *= glm::clamp((theta - light.outerCutOff) / glm::max(light.cutOff - light.outerCutOff, 1e-4f), 0.0f, 1.0f);
+				}
+			}
+			if (attenuation <= 0.0f) {
+				continue;
+			}
+			const float diffuse = glm::max(glm::dot(texel.normal, lightDir), 0.0f);
+			const bool visible = diffuse > 0.0f && !bvh.isOccluded(origin, lightDir, distance - RAY_OFFSET);
+			result += attenuation * (light.ambient + (visible ? light.diffuse * diffuse : glm::vec3(0.0f)));
+		}
+		direct[texel.index] = result;
+	});
+	// One bounce of the direct light, gathered with cosine weighted rays
+	std::vector<glm::vec3> bounced = direct;
+	std::vector<uint8_t> bouncedCovered = covered;
+	Lightmap::dilate(bounced, bouncedCovered, this->atlasSize, DILATION_ITERATIONS);
+	std::vector<glm::vec3> baked = direct;
+	const size_t lightmappedTriangles = triangleInstances.size();
+	Parallel::forEach(texels.size(), [&](const size_t i) {
+		const Texel& texel = texels[i];
+		const glm::vec3 tangent = glm::normalize(glm::cross(glm::abs(texel.normal.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), texel.normal));
+		const glm::vec3 bitangent = glm::cross(texel.normal, tangent);
+		const glm::vec3 origin = texel.position + texel.normal * RAY_OFFSET;
+		// Seeded by the texel, so every bake of the same scene gives the same result
+		std::minstd_rand random(texel.index + 1);
+		std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+		glm::vec3 indirect(0.0f);
+		for (uint32_t sample = 0; sample < this->indirectSamples; ++sample) {
+			const float radius = std::sqrt(distribution(random));
+			const float angle = glm::two_pi<float>() * distribution(random);
+			const glm::vec3 direction = tangent * (radius * std::cos(angle)) + bitangent * (radius * std::sin(angle)) + texel.normal * std::sqrt(glm::max(1.0f - radius * radius, 0.0f));
+			TriangleBvh::Hit hit;
+			if (!bvh.intersect(origin, direction, MAX_BOUNCE_DISTANCE, hit) || hit.triangle >= lightmappedTriangles) {
+				continue;
+			}
+			// Back faces are the inside of closed meshes, no light comes from them
+			const uint32_t* corners = &indices[hit.triangle * 3];
+			if (glm::dot(glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]), direction) >= 0.0f) {
+				continue;
+			}
+			const Instance& instance = this->instances[triangleInstances[hit.triangle]];
+			const Unwrap& unwrap = this->unwraps[instance.unwrap];
+			const uint32_t* uvCorners = &unwrap.indices[(hit.triangle - firstTriangles[triangleInstances[hit.triangle]]) * 3];
+			const glm::vec2 uv = unwrap.uvs[uvCorners[0]] * (1.0f - hit.barycentrics.x - hit.barycentrics.y) + unwrap.uvs[uvCorners[1]] * hit.barycentrics.x + unwrap.uvs[uvCorners[2]] * hit.barycentrics.y;
+			const glm::uvec2 atlasTexel = glm::min(glm::uvec2(glm::vec2(instance.origin) + uv * glm::vec2(unwrap.size)), this->atlasSize - 1u);
+			indirect += bounced[atlasTexel.y * this->atlasSize.x + atlasTexel.x] * instance.albedo;
+		}
+		baked[texel.index] += indirect / static_cast<float>(this->indirectSamples);
+	});
+	Lightmap::dilate(baked, covered, this->atlasSize, DILATION_ITERATIONS);
+	this->upload(baked);
+	this->saveCache(this->computeKey(), baked);
+	this->bakeTime = static_cast<float>(glfwGetTime() - startTime);
+	std::cout << "Baked lightmap: " << this->cachePath << " (" << texels.size() << " texels, " << lights.size() << " lights, " << bvh.getTriangleCount() << " triangles, " << this->bakeTime << " s)" << std::endl;
+}
+
+void Lightmap::dilate(std::vector<glm::vec3>& texels, std::vector<uint8_t>& covered, const glm::uvec2& size, const uint32_t iterations) {
+	std::vector<std::pair<uint32_t, glm::vec3>> filled;
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+		filled.clear();
+		for (uint32_t y = 0; y < size.y; ++y) {
+			for (uint32_t x = 0; x < size.x; ++x) {
+				if (covered[y * size.x + x]) {
+					continue;
+				}
+				glm::vec3 sum(0.0f);
+				uint32_t count = 0;
+				for (uint32_t neighbourY = (y > 0 ? y - 1 : y); neighbourY <= glm::min(y + 1, size.y - 1); ++neighbourY) {
+					for (uint32_t neighbourX = (x > 0 ? x - 1 : x); neighbourX <= glm::min(x + 1, size.x - 1); ++neighbourX) {
+						if (covered[neighbourY * size.x + neighbourX]) {
+							sum += texels[neighbourY * size.x + neighbourX];
+							++count;
+						}
+					}
+				}
+				if (count > 0) {
+					filled.emplace_back(y * size.x + x, sum / static_cast<float>(count));
+				}
+			}
+		}
+		for (const auto& [index, value] : filled) {
+			texels[index] = value;
+			covered[index] = 1;
+		}
+	}
+}
+
+uint64_t Lightmap::computeKey() const {
+	// FNV-1a over the raw bytes
+	uint64_t key = Hash::FNV_OFFSET_BASIS;
+	const auto add = [&key](const void* data, const size_t size) {
+		key = Hash::fnv1a(data, size, key);
+	};
+	add(&CACHE_VERSION, sizeof(CACHE_VERSION));
+	add(&this->atlasSize, sizeof(this->atlasSize));
+	add(&this->indirectSamples, sizeof(this->indirectSamples));
+	for (const Instance& instance : this->instances) {
+		const Unwrap& unwrap = this->unwraps[instance.unwrap];
+		const size_t counts[2] = { unwrap.positions.size(), unwrap.indices.size() };
+		add(&instance.origin, sizeof(instance.origin));
+		add(&unwrap.size, sizeof(unwrap.size));
+		add(counts, sizeof(counts));
+		add(&instance.albedo, sizeof(instance.albedo));
+		add(&instance.node->getWorldTransform().getTransformMatrix(), sizeof(glm::mat4));
+	}
+	for (const MeshInstanceNode* occluder : this->occluders) {
+		const size_t indexCount = occluder->getMesh()->getIndices().size();
+		add(&indexCount, sizeof(indexCount));
+		add(&occluder->getWorldTransform().getTransformMatrix(), sizeof(glm::mat4));
+	}
+	for (const LightSystem::Light& light : LightSystem::getAllLights()) {
+		if (light.type != LightSystem::LIGHT_TYPE::NONE && (light.flags & LightSystem::LIGHT_FLAG_BAKED)) {
+			add(&light, sizeof(light));
+		}
+	}
+	return key;
+}
+
+bool Lightmap::loadCache(const uint64_t key) {
+	std::ifstream file(this->cachePath, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	uint64_t fileKey = 0;
+	glm::uvec2 fileSize(0);
+	file.read(reinterpret_cast<char*>(&fileKey), sizeof(fileKey));
+	file.read(reinterpret_cast<char*>(&fileSize), sizeof(fileSize));
+	if (!file || fileKey != key || fileSize != this->atlasSize) {
+		return false;
+	}
+	// Half floats, 3 per texel
+	std::vector<uint16_t> halves(static_cast<size_t>(fileSize.x) * fileSize.y * 3);
+	file.read(reinterpret_cast<char*>(halves.data()), halves.size() * sizeof(uint16_t));
+	if (!file) {
+		return false;
+	}
+	std::vector<glm::vec3> texels(halves.size() / 3);
+	for (size_t i = 0; i < texels.size(); ++i) {
+		texels[i] = glm::vec3(glm::unpackHalf1x16(halves[i * 3]), glm::unpackHalf1x16(halves[i * 3 + 1]), glm::unpackHalf1x16(halves[i * 3 + 2]));
+	}
+	this->upload(texels);
+	this->bakeTime = 0.0f;
+	return true;
+}
+
+void Lightmap::saveCache(const uint64_t key, const std::vector<glm::vec3>& texels) const {
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(this->cachePath).parent_path(), error);
+	std::ofstream file(this->cachePath, std::ios::binary);
+	if (!file) {
+		std::cerr << "Could not save the lightmap cache: " << this->cachePath << std::endl;
+		return;
+	}
+	std::vector<uint16_t> halves;
+	halves.reserve(texels.size() * 3);
+	for (const glm::vec3& texel : texels) {
+		halves.emplace_back(glm::packHalf1x16(texel.r));
+		halves.emplace_back(glm::packHalf1x16(texel.g));
+		halves.emplace_back(glm::packHalf1x16(texel.b));
+	}
+	file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+	file.write(reinterpret_cast<const char*>(&this->atlasSize), sizeof(this->atlasSize));
+	file.write(reinterpret_cast<const char*>(halves.data()), halves.size() * sizeof(uint16_t));
+}
+
+void Lightmap::upload(const std::vector<glm::vec3>& texels) const {
+	this->texture->bind();
+	this->texture->uploadData(static_cast<int32_t>(this->atlasSize.x), static_cast<int32_t>(this->atlasSize.y), reinterpret_cast<const float*>(texels.data()), false);
+	this->texture->unbind();
+}
+
+const Texture2D* Lightmap::getTexture() const {
+	return this->texture.get();
+}
+
+glm::uvec2 Lightmap::getSize() const {
+	return this->atlasSize;
+}
+
+float Lightmap::getBakeTime() const {
+	return this->bakeTime;
+}
+
+size_t Lightmap::getInstanceCount() const {
+	return this->instances.size();
+}
+
+MeshInstanceNode* Lightmap::getInstanceNode(const size_t instance) const {
+	return this->instances[instance].node;
+}
+
+Mesh* Lightmap::getInstanceMesh(const size_t instance) const {
+	return this->unwraps[this->instances[instance].unwrap].mesh.get();
+}
+
+const glm::vec4& Lightmap::getInstanceScaleOffset(const size_t instance) const {
+	return this->instances[instance].scaleOffset;
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Forward declaration of the mesh class.
+ */
+class Mesh;
+
+/**
+ * Forward declaration of the mesh instance node class.
+ */
+class MeshInstanceNode;
+
+/**
+ * Forward declaration of the scene node class.
+ */
+class SceneNode;
+
+/**
+ * Forward declaration of the 2D texture class.
+ */
+class Texture2D;
+
+/**
+ * Forward declaration of the triangle BVH class.
+ */
+class TriangleBvh;
+
+/**
+ * Lighting of the baked lights on the static objects below a node, precomputed on the CPU into a single atlas.
+ * Every mesh with a static material gets a second uv set, its instances get a rectangle of the atlas, and each texel
+ * stores the direct light reaching it (shadows included) plus a bounce of indirect light, traced against every opaque mesh.
+ * The bake runs on every hardware thread and is cached on disk, it is redone only when the scene or the baked lights change.
+ * The meshes must keep their CPU data (Mesh::DataRetention::ALL) to be lightmapped or to cast shadows.
+ */
+class Lightmap {
+public:
+	static constexpr float DEFAULT_TEXELS_PER_UNIT = 4.0f;
+	static constexpr uint32_t DEFAULT_INDIRECT_SAMPLES = 32;
+	static constexpr int32_t TEXTURE_UNIT = 12;
+	static constexpr uint32_t MAX_ATLAS_SIZE = 4096;
+private:
+	/**
+	 * A mesh unwrapped for the lightmap, shared by all its instances.
+	 */
+	struct Unwrap {
+		const Mesh* source; /* The mesh of the scene */
+		std::shared_ptr<Mesh> mesh; /* The source mesh with the second uv set */
+		std::vector<glm::vec3> positions; /* Object space positions of the unwrapped vertices */
+		std::vector<glm::vec3> normals; /* Object space normals of the unwrapped vertices */
+		std::vector<uint32_t> indices; /* Full detail triangles */
+		std::vector<glm::vec2> uvs; /* Lightmap uvs, in [0, 1] of the mesh's rectangle */
+		glm::uvec2 size; /* Texels of the mesh's rectangle */
+	};
+
+	/**
+	 * A lightmapped object and its rectangle in the atlas.
+	 */
+	struct Instance {
+		MeshInstanceNode* node;
+		uint32_t unwrap; /* Index of the unwrapped mesh */
+		glm::uvec2 origin; /* First texel of the rectangle */
+		glm::vec4 scaleOffset; /* From the mesh's lightmap uvs to the atlas (scale.xy, offset.xy) */
+		glm::vec3 albedo; /* Average reflectance, used by the indirect bounce */
+	};
+
+	/**
+	 * A texel covered by a lightmapped triangle.
+	 */
+	struct Texel {
+		uint32_t index; /* Index in the atlas */
+		glm::vec3 position; /* World space position sampled */
+		glm::vec3 normal; /* World space normal sampled */
+	};
+
+	std::vector<Unwrap> unwraps;
+	std::vector<Instance> instances;
+	std::vector<MeshInstanceNode*> occluders;
+	std::unique_ptr<Texture2D> texture;
+	std::string cachePath;
+	glm::uvec2 atlasSize;
+	uint32_t indirectSamples;
+	float bakeTime;
+
+	/**
+	 * Finds the lightmapped texels of every instance.
+	 *
+	 * \return The covered texels.
+	 */
+	std::vector<Texel> rasterize() const;
+
+	/**
+	 * Hashes everything the baked texels depend on: the atlas, the objects and the baked lights.
+	 *
+	 * \return The key of the cached bake.
+	 */
+	uint64_t computeKey() const;
+
+	/**
+	 * Loads the texels from the cache on disk.
+	 *
+	 * \param key The key of the current scene.
+	 * \return False if there is no cache or it is out of date.
+	 */
+	bool loadCache(const uint64_t key);
+
+	/**
+	 * Saves the texels to the cache on disk.
+	 *
+	 * \param key The key of the current scene.
+	 * \param texels The baked texels of the whole atlas.
+	 */
+	void saveCache(const uint64_t key, const std::vector<glm::vec3>& texels) const;
+
+	/**
+	 * Uploads the texels of the whole atlas.
+	 *
+	 * \param texels The texels to upload.
+	 */
+	void upload(const std::vector<glm::vec3>& texels) const;
+
+	/**
+	 * Collects the lightmapped mesh nodes and the shadow casting ones below a node.
+	 *
+	 * \param node The node to start from.
+	 * \param receivers The output list of the static nodes to lightmap.
+	 * \param casters The output list of the other opaque nodes.
+	 */
+	static void collectMeshes(SceneNode* node, std::vector<MeshInstanceNode*>& receivers, std::vector<MeshInstanceNode*>& casters);
+
+	/**
+	 * Fills the uncovered texels next to covered ones with the average of their neighbours, so filtering never reads black.
+	 *
+	 * \param texels The texels of the whole atlas.
+	 * \param covered The covered flag of every texel, updated.
+	 * \param size The size of the atlas.
+	 * \param iterations The amount of texel rings to fill.
+	 */
+	static void dilate(std::vector<glm::vec3>& texels, std::vector<uint8_t>& covered, const glm::uvec2& size, const uint32_t iterations);
+public:
+	// Erase copy constructors, as it would break opengl
+	Lightmap(const Lightmap&) = delete;
+	Lightmap& operator=(const Lightmap&) = delete;
+
+	/**
+	 * Unwraps the static meshes below a node, packs them in the atlas and loads the cached bake, or bakes it if out of date.
+	 * Make sure the OpenGL state and the lights have been set up first.
+	 *
+	 * \param root The node whose static descendants get lightmapped.
+	 * \param name The name of the cache file in assets/lightmaps.
+	 * \param texelsPerUnit The wanted texels per world space unit.
+	 * \param _indirectSamples The rays traced per texel for the indirect bounce.
+	 */
+	Lightmap(const std::shared_ptr<SceneNode>& root, const std::string& name, const float texelsPerUnit = DEFAULT_TEXELS_PER_UNIT, const uint32_t _indirectSamples = DEFAULT_INDIRECT_SAMPLES);
+
+	/**
+	 * Destructor for the lightmap.
+	 *
+	 */
+	~Lightmap();
+
+	/**
+	 * Bakes the current baked lights into the atlas and updates the cache.
+	 *
+	 */
+	void bake();
+
+	/**
+	 * Getter for the atlas texture.
+	 *
+	 * \return The lightmap texture.
+	 */
+	const Texture2D* getTexture() const;
+
+	/**
+	 * Getter for the size of the atlas.
+	 *
+	 * \return The texels on each side of the atlas.
+	 */
+	glm::uvec2 getSize() const;
+
+	/**
+	 * Getter for the time taken by the last bake.
+	 *
+	 * \return The seconds taken, 0 if the atlas came from the cache.
+	 */
+	float getBakeTime() const;
+
+	/**
+	 * Getter for the amount of lightmapped objects.
+	 *
+	 * \return The amount of instances.
+	 */
+	size_t getInstanceCount() const;
+
+	/**
+	 * Getter for the node of a lightmapped object.
+	 *
+	 * \param instance The index of the instance.
+	 * \return The mesh node of the scene.
+	 */
+	MeshInstanceNode* getInstanceNode(const size_t instance) const;
+
+	/**
+	 * Getter for the mesh to draw a lightmapped object with.
+	 *
+	 * \param instance The index of the instance.
+	 * \return The node's mesh with the second uv set.
+	 */
+	Mesh* getInstanceMesh(const size_t instance) const;
+
+	/**
+	 * Getter for the rectangle of a lightmapped object in the atlas.
+	 *
+	 * \param instance The index of the instance.
+	 * \return The scale (xy) and offset (zw) from the mesh's lightmap uvs to the atlas.
+	 */
+	const glm::vec4& getInstanceScaleOffset(const size_t instance) const;
+};
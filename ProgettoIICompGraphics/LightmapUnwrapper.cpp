@@ -0,0 +1,189 @@
+#include "LightmapUnwrapper.hpp"
+
+#include "Vertex.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace LightmapUnwrapper {
+	// Every try that doesn't fit scales the texel density by this much
+	static constexpr float DENSITY_STEP = 0.8f;
+	static constexpr uint32_t MAX_TRIES = 32;
+
+	/**
+	 * Triangles unwrapped together with the same planar projection.
+	 */
+	struct Chart {
+		std::vector<uint32_t> triangles;
+		uint32_t axis; /* Axis the triangles face the most (0-2) */
+		glm::vec2 minValues; /* Projected bounds in object space units */
+		glm::vec2 maxValues;
+		glm::uvec2 size; /* Texels taken, padding included */
+		glm::uvec2 origin; /* First texel in the packed rectangle */
+	};
+
+	/**
+	 * Projects a position on the plane perpendicular to an axis.
+	 *
+	 * \param position The position to project.
+	 * \param axis The axis dropped by the projection (0-2).
+	 * \return The coordinates on the plane.
+	 */
+	static glm::vec2 project(const glm::vec3& position, const uint32_t axis);
+
+	/**
+	 * Packs the charts in rows of a rectangle at a texel density.
+	 *
+	 * \param charts The charts to pack, their size and origin are set.
+	 * \param texelsPerUnit The texels per object space unit.
+	 * \param size The size of the rectangle (output variable).
+	 * \return False if the rectangle would exceed MAX_SIZE.
+	 */
+	static bool pack(std::vector<Chart>& charts, const float texelsPerUnit, glm::uvec2& size);
+}
+
+glm::vec2 LightmapUnwrapper::project(const glm::vec3& position, const uint32_t axis) {
+	switch (axis) {
+		case 0:
+			return glm::vec2(position.z, position.y);
+		case 1:
+			return glm::vec2(position.x, position.z);
+		default:
+			return glm::vec2(position.x, position.y);
+	}
+}
+
+bool LightmapUnwrapper::pack(std::vector<Chart>& charts, const float texelsPerUnit, glm::uvec2& size) {
+	uint64_t area = 0;
+	uint32_t widest = 0;
+	for (Chart& chart : charts) {
+		// One texel more than the extent, so the texel centers cover the whole chart
+		const glm::vec2 extent = glm::ceil((chart.maxValues - chart.minValues) * texelsPerUnit);
+		chart.size = glm::uvec2(extent) + 1u + 2 * CHART_PADDING;
+		area += static_cast<uint64_t>(chart.size.x) * chart.size.y;
+		widest = std::max(widest, chart.size.x);
+	}
+	const uint32_t width = std::max(widest, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(area)) * 1.1)));
+	if (width > MAX_SIZE) {
+		return false;
+	}
+	// Tallest charts first, each row is as tall as its first chart
+	std::vector<uint32_t> order(charts.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&charts](const uint32_t first, const uint32_t second) {
+		return charts[first].size.y > charts[second].size.y;
+	});
+	glm::uvec2 cursor(0);
+	uint32_t rowHeight = 0;
+	for (const uint32_t i : order) {
+		Chart& chart = charts[i];
+		if (cursor.x + chart.size.x > width) {
+			cursor = glm::uvec2(0, cursor.y + rowHeight);
+			rowHeight = 0;
+		}
+		chart.origin = cursor;
+		cursor.x += chart.size.x;
+		rowHeight = std::max(rowHeight, chart.size.y);
+	}
+	size = glm::uvec2(width, cursor.y + rowHeight);
+	return size.y <= MAX_SIZE;
+}
+
+LightmapUnwrapper::Unwrap LightmapUnwrapper::unwrap(const std::vector<Vertex>& vertices, const uint32_t* indices, const size_t indexCount, const float texelsPerUnit) {
+	const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+	// Facing of every triangle: its dominant normal axis and the sign along it
+	std::vector<uint32_t> facing(triangleCount);
+	for (uint32_t triangle = 0; triangle < triangleCount; ++triangle) {
+		const glm::vec3& a = vertices[indices[triangle * 3]].position;
+		const glm::vec3& b = vertices[indices[triangle * 3 + 1]].position;
+		const glm::vec3& c = vertices[indices[triangle * 3 + 2]].position;
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		const glm::vec3 magnitude = glm::abs(normal);
+		const uint32_t axis = magnitude.x >= magnitude.y && magnitude.x >= magnitude.z ? 0 : (magnitude.y >= magnitude.z ? 1 : 2);
+		facing[triangle] = axis * 2 + (normal[axis] < 0.0f ? 1 : 0);
+	}
+	// Triangles of every edge, sorted by edge so neighbours are found with a binary search
+	std::vector<std::pair<uint64_t, uint32_t>> edges;
+	edges.reserve(indexCount);
+	const auto edgeKey = [](const uint32_t first, const uint32_t second) {
+		return (static_cast<uint64_t>(std::min(first, second)) << 32) | std::max(first, second);
+	};
+	for (uint32_t triangle = 0; triangle < triangleCount; ++triangle) {
+		for (uint32_t corner = 0; corner < 3; ++corner) {
+			edges.emplace_back(edgeKey(indices[triangle * 3 + corner], indices[triangle * 3 + (corner + 1) % 3]), triangle);
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	// Grow the charts over shared edges between triangles facing the same way
+	std::vector<Chart> charts;
+	std::vector<uint32_t> triangleChart(triangleCount, std::numeric_limits<uint32_t>::max());
+	std::vector<uint32_t> stack;
+	for (uint32_t seed = 0; seed < triangleCount; ++seed) {
+		if (triangleChart[seed] != std::numeric_limits<uint32_t>::max()) {
+			continue;
+		}
+		Chart chart{};
+		chart.axis = facing[seed] / 2;
+		chart.minValues = glm::vec2(std::numeric_limits<float>::max());
+		chart.maxValues = glm::vec2(std::numeric_limits<float>::lowest());
+		triangleChart[seed] = static_cast<uint32_t>(charts.size());
+		stack.emplace_back(seed);
+		while (!stack.empty()) {
+			const uint32_t triangle = stack.back();
+			stack.pop_back();
+			chart.triangles.emplace_back(triangle);
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				const uint64_t key = edgeKey(indices[triangle * 3 + corner], indices[triangle * 3 + (corner + 1) % 3]);
+				for (auto edge = std::lower_bound(edges.begin(), edges.end(), std::make_pair(key, 0u)); edge != edges.end() && edge->first == key; ++edge) {
+					if (triangleChart[edge->second] == std::numeric_limits<uint32_t>::max() && facing[edge->second] == facing[seed]) {
+						triangleChart[edge->second] = static_cast<uint32_t>(charts.size());
+						stack.emplace_back(edge->second);
+					}
+				}
+			}
+		}
+		for (const uint32_t triangle : chart.triangles) {
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				const glm::vec2 projected = project(vertices[indices[triangle * 3 + corner]].position, chart.axis);
+				chart.minValues = glm::min(chart.minValues, projected);
+				chart.maxValues = glm::max(chart.maxValues, projected);
+			}
+		}
+		charts.emplace_back(std::move(chart));
+	}
+	// Lower the density until the charts fit
+	Unwrap result{};
+	float density = texelsPerUnit;
+	uint32_t tries = 0;
+	while (!pack(charts, density, result.size)) {
+		if (++tries == MAX_TRIES) {
+			throw std::runtime_error("Too many lightmap charts to pack: " + std::to_string(charts.size()));
+		}
+		density *= DENSITY_STEP;
+	}
+	// Every chart gets its own copies of its vertices
+	result.indices.resize(indexCount);
+	std::unordered_map<uint32_t, uint32_t> chartVertices;
+	for (const Chart& chart : charts) {
+		chartVertices.clear();
+		const glm::vec2 offset = glm::vec2(chart.origin + CHART_PADDING) + 0.5f;
+		for (const uint32_t triangle : chart.triangles) {
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				const uint32_t source = indices[triangle * 3 + corner];
+				const auto [vertex, inserted] = chartVertices.emplace(source, static_cast<uint32_t>(result.vertexRemap.size()));
+				if (inserted) {
+					const glm::vec2 texel = offset + (project(vertices[source].position, chart.axis) - chart.minValues) * density;
+					result.vertexRemap.emplace_back(source);
+					result.uvs.emplace_back(texel / glm::vec2(result.size));
+				}
+				result.indices[triangle * 3 + corner] = vertex->second;
+			}
+		}
+	}
+	result.chartCount = static_cast<uint32_t>(charts.size());
+	return result;
+}
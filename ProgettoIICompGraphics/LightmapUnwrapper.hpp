@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * Forward declaration of the vertex struct.
+ */
+struct Vertex;
+
+namespace LightmapUnwrapper {
+	// Empty texels around every chart, so filtering and the dilation of the baked texels never mix two charts
+	static constexpr uint32_t CHART_PADDING = 1;
+	// Largest side of the lightmap area of a mesh, the texel density is lowered until the charts fit
+	static constexpr uint32_t MAX_SIZE = 1024;
+
+	/**
+	 * Second uv set of a mesh, its vertices are split where charts meet.
+	 */
+	struct Unwrap {
+		std::vector<uint32_t> vertexRemap; /* Source vertex of every unwrapped vertex */
+		std::vector<uint32_t> indices; /* The source triangles in the same order, over the unwrapped vertices */
+		std::vector<glm::vec2> uvs; /* Lightmap uv of every unwrapped vertex, in [0, 1] */
+		glm::uvec2 size; /* Texels of the lightmap area the uvs span */
+		uint32_t chartCount; /* Amount of charts packed */
+	};
+
+	/**
+	 * Generates a non overlapping uv set for a triangle list.
+	 * Triangles sharing an edge and facing the same axis form a chart, each chart is projected on the plane of its axis
+	 * and the charts are packed in rows inside a rectangle, keeping the same texel density everywhere.
+	 *
+	 * \param vertices The vertices of the mesh.
+	 * \param indices The triangle list indices to unwrap.
+	 * \param indexCount The amount of indices.
+	 * \param texelsPerUnit The wanted texels per object space unit, lowered if the charts don't fit MAX_SIZE.
+	 * \return The unwrapped vertices and uvs.
+	 */
+	Unwrap unwrap(const std::vector<Vertex>& vertices, const uint32_t* indices, const size_t indexCount, const float texelsPerUnit);
+}
@@ -1,7 +1,20 @@
 #include "MainScene.hpp"
 
+#include "AmbientOcclusionBaker.hpp"
+#include "FloatingObjects.hpp"
+#include "Hlod.hpp"
+#include "Impostor.hpp"
+#include "Lightmap.hpp"
+#include "LightSystem.hpp"
+#include "Mesh.hpp"
 #include "MeshLoader.hpp"
+#include "ReflectionProbe.hpp"
+#include "Renderer.hpp"
+#include "ShadowAtlas.hpp"
+#include "WaterClipmap.hpp"
 
+#include <iostream>
+#include <limits>
 #include <random>
 
 namespace MainScene {
@@ -9,16 +22,86 @@ namespace MainScene {
 	static std::shared_ptr<SceneNode> getGrass();
 	static std::shared_ptr<SceneNode> getCity();
 
+	/**
+	 * Creates a node holding every chunk of a split mesh as a child, so each chunk is culled and sorted on its own.
+	 *
+	 * \param name The name of the node, chunks get their index appended.
+	 * \param chunks The chunks of the mesh.
+	 * \param material The material of the chunks.
+	 * \param transform The transform of the node.
+	 * \param parent The node's possible parent.
+	 * \return The node containing the chunks.
+	 */
+	static std::shared_ptr<SceneNode> getChunkedNode(const std::string& name, const std::vector<std::shared_ptr<Mesh>>& chunks, const std::shared_ptr<Material>& material, const Transform& transform, const std::shared_ptr<SceneNode>& parent = nullptr);
+
+	/**
+	 * Grows a box to contain the world bounding boxes of every mesh below a node.
+	 *
+	 * \param node The node to start from.
+	 * \param minValues The minimum corner of the box (input and output variable).
+	 * \param maxValues The maximum corner of the box (input and output variable).
+	 */
+	static void collectBounds(SceneNode* node, glm::vec3& minValues, glm::vec3& maxValues);
+
+	/**
+	 * Frees the CPU copies of every mesh below a node.
+	 *
+	 * \param node The node to start from.
+	 */
+	static void releaseMeshData(SceneNode* node);
+
+	// Window lights laid out on the front and back of every house
+	static constexpr uint32_t WINDOW_FLOORS = 3;
+	static constexpr uint32_t WINDOW_COLUMNS = 3;
+	static constexpr float WINDOW_OFFSET = 0.25f;
+
 	static std::random_device randDevice;
 	static std::mt19937 randEngine(randDevice());
+
+	// Parent of the instanced trees, drawn as impostors when far away
+	static std::shared_ptr<SceneNode> treesNode = nullptr;
+	// Parents of the static props merged in hierarchical levels of detail
+	static std::shared_ptr<SceneNode> lightsNode = nullptr;
+	static std::shared_ptr<SceneNode> housesNode = nullptr;
+	// Root of the static objects baked in the lightmap
+	static std::shared_ptr<SceneNode> cityNode = nullptr;
+	// Nodes following the waves
+	static std::unique_ptr<FloatingObjects> floatingObjects = nullptr;
+}
+
+std::shared_ptr<SceneNode> MainScene::getChunkedNode(const std::string& name, const std::vector<std::shared_ptr<Mesh>>& chunks, const std::shared_ptr<Material>& material, const Transform& transform, const std::shared_ptr<SceneNode>& parent) {
+	std::shared_ptr<SceneNode> node = std::make_shared<SceneNode>(name, transform, parent);
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		std::shared_ptr<SceneNode> chunk = std::make_shared<MeshInstanceNode>(name + "Chunk" + std::to_string(i), chunks[i], material, Transform(), node);
+		node->addChild(chunk);
+	}
+	return node;
+}
+
+void MainScene::collectBounds(SceneNode* node, glm::vec3& minValues, glm::vec3& maxValues) {
+	if (MeshInstanceNode* meshNode = dynamic_cast<MeshInstanceNode*>(node)) {
+		const BoundingBox bounds = meshNode->getBoundingBox();
+		minValues = glm::min(minValues, bounds.getMinValues());
+		maxValues = glm::max(maxValues, bounds.getMaxValues());
+	}
+	for (const std::shared_ptr<SceneNode>& child : node->getChildren()) {
+		collectBounds(child.get(), minValues, maxValues);
+	}
+}
+
+void MainScene::releaseMeshData(SceneNode* node) {
+	if (MeshInstanceNode* meshNode = dynamic_cast<MeshInstanceNode*>(node)) {
+		meshNode->getMesh()->releaseData();
+	}
+	for (const std::shared_ptr<SceneNode>& child : node->getChildren()) {
+		releaseMeshData(child.get());
+	}
 }
 
 std::shared_ptr<SceneNode> MainScene::getSea() {
 	std::shared_ptr<SceneNode> sea = std::make_shared<SceneNode>("Sea", Transform());
-	// Create sea
-	std::shared_ptr<SceneNode> seaNode = std::make_shared<MeshInstanceNode>("Sea", Primitives::generatePlane(500), MaterialLoader::load("water"), Transform(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(150.0f)), sea);
-	sea->addChild(seaNode);
-	std::shared_ptr<SceneNode> seaFloor = std::make_shared<MeshInstanceNode>("Seafloor", Primitives::generatePlane(1), MaterialLoader::load("seafloor"), Transform(glm::vec3(0.0f, -10.0f, 0.0f), glm::vec3(0.0f), glm::vec3(200.0f)), sea);
+	// Create sea, the water surface is drawn by its own clipmap (see setupWater)
+	std::shared_ptr<SceneNode> seaFloor = getChunkedNode("Seafloor", Primitives::generateChunkedPlane(16, glm::vec2(1.0f), 32, Mesh::DataRetention::NONE), MaterialLoader::load("seafloor"), Transform(glm::vec3(0.0f, -10.0f, 0.0f), glm::vec3(0.0f), glm::vec3(200.0f)), sea);
 	sea->addChild(seaFloor);
 	// Add some doughnuts
 	std::vector<std::shared_ptr<Material>> doughnutMaterials = {
@@ -29,23 +112,26 @@ std::shared_ptr<SceneNode> MainScene::getSea() {
 	std::uniform_real_distribution<float> distX(-30.0f, 30.0f);
 	std::uniform_real_distribution<float> distZ(-15.0f, -6.0f);
 	std::uniform_int_distribution<uint32_t> matRand(0, 2);
+	floatingObjects = std::make_unique<FloatingObjects>(MaterialLoader::load("water"));
 	for (uint32_t i = 0; i < 12; ++i) {
 		std::shared_ptr<SceneNode> doughnut = std::make_shared<MeshInstanceNode>("Doughnut", Primitives::generateThorus(1.0f, 0.5f, 15, 15), doughnutMaterials[matRand(randEngine)], Transform(glm::vec3(distX(randEngine), 0.0f, distZ(randEngine)), glm::vec3(0.0f), glm::vec3(0.3f)), sea);
 		doughnut->name = doughnut->name + std::to_string(i);
 		doughnut->setParent(sea);
 		sea->addChild(doughnut);
+		floatingObjects->add(doughnut);
 	}
 	// Return the sea
 	return sea;
 }
 
 std::shared_ptr<SceneNode> MainScene::getGrass() {
-	// Create base grass plane
-	std::shared_ptr<SceneNode> grass = std::make_shared<MeshInstanceNode>("GrassPlane", Primitives::generatePlane(1, glm::vec2(35.0f, 11.0f)), MaterialLoader::load("grass"), Transform(glm::vec3(0.0f, 1.99f, -12.0f), glm::vec3(0.0f), glm::vec3(70.0f, 1.0, 22.0f)));
+	// Create base grass plane, keeping its CPU data for the lightmap until releaseBakeData
+	std::shared_ptr<SceneNode> grass = getChunkedNode("GrassPlane", Primitives::generateChunkedPlane(16, glm::vec2(35.0f, 11.0f), 32, Mesh::DataRetention::ALL), MaterialLoader::load("grass"), Transform(glm::vec3(0.0f, 1.99f, -12.0f), glm::vec3(0.0f), glm::vec3(70.0f, 1.0, 22.0f)));
 	const glm::vec3 baseScale(1.0f / glm::vec3(70.0f, 1.0f, 22.0f));
 	// Add trees
 	std::shared_ptr<SceneNode> trees = std::make_shared<SceneNode>("Trees", Transform(), grass);
 	grass->addChild(trees);
+	treesNode = trees;
 	std::uniform_real_distribution<float> distX(0.04f, 0.47f);
 	std::uniform_real_distribution<float> distZ(-0.43f, 0.23f);
 	std::uniform_real_distribution<float> distScl(0.8f, 1.2f);
@@ -54,14 +140,14 @@ std::shared_ptr<SceneNode> MainScene::getGrass() {
 	};
 	// Right trees
 	for (uint32_t i = 0; i < 120; ++i) {
-		std::shared_ptr<SceneNode> tree = MeshLoader::loadMesh("assets/meshes/PineTree/scene.gltf", Transform(glm::vec3(-distX(randEngine), 0.0f, distZ(randEngine)), glm::vec3(-90.0f, 0.0f, 0.0f), distScl(randEngine) * baseScale), treeOverrides);
+		std::shared_ptr<SceneNode> tree = MeshLoader::loadMesh("assets/meshes/PineTree/scene.gltf", Transform(glm::vec3(-distX(randEngine), 0.0f, distZ(randEngine)), glm::vec3(-90.0f, 0.0f, 0.0f), distScl(randEngine) * baseScale), treeOverrides, Mesh::DataRetention::NONE);
 		tree->name = tree->name + "R" + std::to_string(i);
 		tree->setParent(trees);
 		trees->addChild(tree);
 	}
 	// Left trees
 	for (uint32_t i = 0; i < 120; ++i) {
-		std::shared_ptr<SceneNode> tree = MeshLoader::loadMesh("assets/meshes/PineTree/scene.gltf", Transform(glm::vec3(distX(randEngine), 0.0f, distZ(randEngine)), glm::vec3(-90.0f, 0.0f, 0.0f), distScl(randEngine) * baseScale), treeOverrides);
+		std::shared_ptr<SceneNode> tree = MeshLoader::loadMesh("assets/meshes/PineTree/scene.gltf", Transform(glm::vec3(distX(randEngine), 0.0f, distZ(randEngine)), glm::vec3(-90.0f, 0.0f, 0.0f), distScl(randEngine) * baseScale), treeOverrides, Mesh::DataRetention::NONE);
 		tree->name = tree->name + "L" + std::to_string(i);
 		tree->setParent(trees);
 		trees->addChild(tree);
@@ -72,37 +158,40 @@ std::shared_ptr<SceneNode> MainScene::getGrass() {
 
 std::shared_ptr<SceneNode> MainScene::getCity() {
 	std::shared_ptr<SceneNode> city = std::make_shared<SceneNode>("City", Transform(glm::vec3(0.0f), glm::vec3(0.0f, 180.0f, 0.0f)));
-	// Add walkway lights
+	cityNode = city;
+	// Add walkway lights, keeping the CPU data of the walkway for the lightmap
 	const std::unordered_map<uint32_t, std::shared_ptr<Material>> walkwayOverrides = {
 		{ 0, MaterialLoader::load("bricks") }
 	};
-	std::shared_ptr<SceneNode> walkway = MeshLoader::loadMesh("assets/meshes/walkways.obj", Transform(), walkwayOverrides);
+	std::shared_ptr<SceneNode> walkway = MeshLoader::loadMesh("assets/meshes/walkways.obj", Transform(), walkwayOverrides, Mesh::DataRetention::ALL);
 	walkway->setParent(city);
 	city->addChild(walkway);
 	// Add cool fountain
 	const std::unordered_map<uint32_t, std::shared_ptr<Material>> statueOverrides = {
 		{ 0, MaterialLoader::load("marble") }
 	};
-	std::shared_ptr<SceneNode> centralStatue = MeshLoader::loadMesh("assets/meshes/DragonStatue/dragon.glb", Transform(glm::vec3(0.0f, 4.5f, 0.0f), glm::vec3(0.0f), glm::vec3(0.025f)), statueOverrides);
+	std::shared_ptr<SceneNode> centralStatue = MeshLoader::loadMesh("assets/meshes/DragonStatue/dragon.glb", Transform(glm::vec3(0.0f, 4.5f, 0.0f), glm::vec3(0.0f), glm::vec3(0.025f)), statueOverrides, Mesh::DataRetention::NONE);
 	centralStatue->setParent(walkway);
 	walkway->addChild(centralStatue);
 	// Add lights
 	std::shared_ptr<SceneNode> lights = std::make_shared<SceneNode>("Lights", Transform(), walkway);
 	walkway->addChild(lights);
+	lightsNode = lights;
+	// Keep the CPU data of the props until releaseBakeData, the HLOD proxies and the lightmap are built from it
 	const std::unordered_map<uint32_t, std::shared_ptr<Material>> lightsOverrides = {
 		{ 0, MaterialLoader::load("lampPost") },
 		{ 3, MaterialLoader::load("lightGlass") }
 	};
 	// Right lights
 	for (uint32_t i = 0; i < 8; ++i) {
-		std::shared_ptr<SceneNode> lightMesh = MeshLoader::loadMesh("assets/meshes/rv_lamp_post_4.obj", Transform(glm::vec3(6.5f + 3.8f * i, 2.15f, 1.2f), glm::vec3(0.0f, 90.0f, 0.0f), glm::vec3(0.1f)), lightsOverrides);
+		std::shared_ptr<SceneNode> lightMesh = MeshLoader::loadMesh("assets/meshes/rv_lamp_post_4.obj", Transform(glm::vec3(6.5f + 3.8f * i, 2.15f, 1.2f), glm::vec3(0.0f, 90.0f, 0.0f), glm::vec3(0.1f)), lightsOverrides, Mesh::DataRetention::ALL);
 		lightMesh->name = lightMesh->name + "R" + std::to_string(i);
 		lightMesh->setParent(lights);
 		lights->addChild(lightMesh);
 	}
 	// Left lights
 	for (uint32_t i = 0; i < 8; ++i) {
-		std::shared_ptr<SceneNode> lightMesh = MeshLoader::loadMesh("assets/meshes/rv_lamp_post_4.obj", Transform(glm::vec3(-6.5f - 3.8f * i, 2.15f, 1.2f), glm::vec3(0.0f, 90.0f, 0.0f), glm::vec3(0.1f)), lightsOverrides);
+		std::shared_ptr<SceneNode> lightMesh = MeshLoader::loadMesh("assets/meshes/rv_lamp_post_4.obj", Transform(glm::vec3(-6.5f - 3.8f * i, 2.15f, 1.2f), glm::vec3(0.0f, 90.0f, 0.0f), glm::vec3(0.1f)), lightsOverrides, Mesh::DataRetention::ALL);
 		lightMesh->name = lightMesh->name + "L" + std::to_string(i);
 		lightMesh->setParent(lights);
 		lights->addChild(lightMesh);
@@ -114,15 +203,16 @@ std::shared_ptr<SceneNode> MainScene::getCity() {
 	// Add houses
 	std::shared_ptr<SceneNode> houses = std::make_shared<SceneNode>("Houses", Transform(), city);
 	city->addChild(houses);
+	housesNode = houses;
 	// Add Houses
 	for (uint32_t i = 0; i < 6; ++i) {
-		std::shared_ptr<SceneNode> house = MeshLoader::loadMesh("assets/meshes/LisboaHouse/scene.gltf", Transform(glm::vec3(6.15f + 5.04 * i, 3.53f, -4.563f), glm::vec3(-90.0f, 0.0f, 0.0f), glm::vec3(1.15f)));
+		std::shared_ptr<SceneNode> house = MeshLoader::loadMesh("assets/meshes/LisboaHouse/scene.gltf", Transform(glm::vec3(6.15f + 5.04 * i, 3.53f, -4.563f), glm::vec3(-90.0f, 0.0f, 0.0f), glm::vec3(1.15f)), std::unordered_map<uint32_t, std::shared_ptr<Material>>(), Mesh::DataRetention::ALL);
 		house->name = house->name + "R" + std::to_string(i);
 		house->setParent(houses);
 		houses->addChild(house);
 	}
 	for (uint32_t i = 0; i < 6; ++i) {
-		std::shared_ptr<SceneNode> house = MeshLoader::loadMesh("assets/meshes/LisboaHouse/scene.gltf", Transform(glm::vec3(-7.7f - 5.04 * i, 3.53f, -4.563f), glm::vec3(-90.0f, 0.0f, 0.0f), glm::vec3(1.15f)));
+		std::shared_ptr<SceneNode> house = MeshLoader::loadMesh("assets/meshes/LisboaHouse/scene.gltf", Transform(glm::vec3(-7.7f - 5.04 * i, 3.53f, -4.563f), glm::vec3(-90.0f, 0.0f, 0.0f), glm::vec3(1.15f)), std::unordered_map<uint32_t, std::shared_ptr<Material>>(), Mesh::DataRetention::ALL);
 		house->name = house->name + "L" + std::to_string(i);
 		house->setParent(houses);
 		houses->addChild(house);
@@ -144,4 +234,116 @@ std::shared_ptr<SceneNode> MainScene::getScene() {
 	city->setParent(scene);
 	// Return the scene
 	return scene;
+}
+
+void MainScene::setupImpostors() {
+	if (treesNode && !treesNode->getChildren().empty()) {
+		Renderer::addImpostor(std::make_shared<Impostor>(treesNode->getChildren(), Renderer::getImpostorDistance()));
+	}
+}
+
+void MainScene::setupHlods() {
+	for (const std::shared_ptr<SceneNode>& node : { housesNode, lightsNode }) {
+		if (node) {
+			Renderer::addHlod(std::make_shared<Hlod>(node, Renderer::getHlodDistance()));
+		}
+	}
+}
+
+void MainScene::setupAmbientOcclusion() {
+	if (cityNode) {
+		AmbientOcclusionBaker::bake(cityNode, "city");
+	}
+}
+
+void MainScene::setupLightmap() {
+	if (cityNode) {
+		Renderer::setLightmap(std::make_shared<Lightmap>(cityNode, "city"));
+	}
+}
+
+void MainScene::releaseBakeData() {
+	if (cityNode) {
+		releaseMeshData(cityNode.get());
+	}
+}
+
+void MainScene::setupWater() {
+	Renderer::setWater(std::make_shared<WaterClipmap>(MaterialLoader::load("water"), glm::vec3(0.0f), glm::vec2(150.0f)));
+}
+
+void MainScene::setupReflectionProbes() {
+	if (!cityNode) {
+		return;
+	}
+	// Fountain in the middle of the walkway, then the two rows of houses, in the city's space
+	const std::pair<glm::vec3, float> probes[] = {
+		{ glm::vec3(0.0f, 3.5f, -2.0f), 10.0f },
+		{ glm::vec3(18.75f, 3.5f, -1.5f), 14.0f },
+		{ glm::vec3(-20.3f, 3.5f, -1.5f), 14.0f }
+	};
+	for (const auto& [position, radius] : probes) {
+		std::shared_ptr<ReflectionProbe> probe = std::make_shared<ReflectionProbe>("ReflectionProbe" + std::to_string(Renderer::getReflectionProbes().size()), Transform(position), radius, ReflectionProbe::DEFAULT_RESOLUTION, cityNode);
+		cityNode->addChild(probe);
+		Renderer::addReflectionProbe(probe);
+	}
+	std::cout << "Built Reflection Probes: " << Renderer::getReflectionProbes().size() << " probes" << std::endl;
+}
+
+void MainScene::setupShadows() {
+	if (!cityNode) {
+		return;
+	}
+	glm::vec3 minValues(std::numeric_limits<float>::max());
+	glm::vec3 maxValues(std::numeric_limits<float>::lowest());
+	collectBounds(cityNode.get(), minValues, maxValues);
+	if (minValues.x > maxValues.x) {
+		return;
+	}
+	ShadowAtlas::setDirectionalBounds(minValues, maxValues);
+	std::cout << "Built Shadows: " << ShadowAtlas::getStatistics().tiles << " tiles" << std::endl;
+}
+
+void MainScene::update(const float time) {
+	if (floatingObjects) {
+		floatingObjects->update(time);
+	}
+}
+
+void MainScene::setupWindowLights() {
+	if (!housesNode) {
+		return;
+	}
+	const size_t firstLight = LightSystem::getLightCount();
+	size_t light = firstLight;
+	for (const std::shared_ptr<SceneNode>& house : housesNode->getChildren()) {
+		glm::vec3 minValues(std::numeric_limits<float>::max());
+		glm::vec3 maxValues(std::numeric_limits<float>::lowest());
+		collectBounds(house.get(), minValues, maxValues);
+		if (minValues.x > maxValues.x) {
+			continue;
+		}
+		const glm::vec3 size = maxValues - minValues;
+		// One dim warm light in front of every window, on the street side and on the back
+		for (const float facadeZ : { maxValues.z + WINDOW_OFFSET, minValues.z - WINDOW_OFFSET }) {
+			for (uint32_t floor = 0; floor < WINDOW_FLOORS; ++floor) {
+				for (uint32_t column = 0; column < WINDOW_COLUMNS; ++column) {
+					const glm::vec3 position(
+						minValues.x + size.x * (static_cast<float>(column) + 0.5f) / WINDOW_COLUMNS,
+						minValues.y + size.y * (static_cast<float>(floor) + 0.5f) / WINDOW_FLOORS,
+						facadeZ
+					);
+					LightSystem::setLight(light++, LightSystem::PointLight{
+						position,
+						glm::vec3(0.02f, 0.015f, 0.01f),
+						glm::vec3(1.0f, 0.75f, 0.45f),
+						glm::vec3(0.3f, 0.25f, 0.2f),
+						4.0f, 0.35f, 1.0f, 0.44f,
+						true
+					});
+				}
+			}
+		}
+	}
+	std::cout << "Built Window Lights: " << light - firstLight << " lights (" << LightSystem::getLightCount() << " in total)" << std::endl;
 }
\ No newline at end of file
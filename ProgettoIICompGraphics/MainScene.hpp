@@ -10,4 +10,65 @@
 
 namespace MainScene {
 	std::shared_ptr<SceneNode> getScene();
-}
+
+	/**
+	 * Creates the impostors of the scene's instanced foliage and adds them to the renderer.
+	 * Call it after the scene has been added to the renderer and OpenGL has been set up.
+	 */
+	void setupImpostors();
+
+	/**
+	 * Merges the static props of the scene in hierarchical levels of detail and adds them to the renderer.
+	 * Call it after the scene has been added to the renderer and OpenGL has been set up.
+	 */
+	void setupHlods();
+
+	/**
+	 * Adds a point light in front of every window of every house to the light system, after the lights already set.
+	 * Call it after the scene has been added to the renderer and the light system has been initialized.
+	 */
+	void setupWindowLights();
+
+	/**
+	 * Bakes the ambient occlusion of the static objects of the city into their vertices, or loads the cached bake.
+	 * Call it after OpenGL has been set up and before the lightmap, so the lightmapped meshes keep the occlusion.
+	 */
+	void setupAmbientOcclusion();
+
+	/**
+	 * Bakes the lights flagged as baked on the static objects of the city, or loads the cached bake, and adds the lightmap to the renderer.
+	 * Call it after the scene has been added to the renderer, OpenGL has been set up and every light has been set.
+	 */
+	void setupLightmap();
+
+	/**
+	 * Frees the CPU copies of the city's meshes, they are only kept for the bakes.
+	 * Call it after every setup that reads them (HLODs, ambient occlusion and lightmap).
+	 */
+	void releaseBakeData();
+
+	/**
+	 * Creates the clipmap of the sea's water surface and adds it to the renderer.
+	 * Call it after OpenGL has been set up.
+	 */
+	void setupWater();
+
+	/**
+	 * Places the reflection probes of the city, at the fountain and in front of each row of houses, and adds them to the renderer.
+	 * Call it after the scene has been added to the renderer and OpenGL has been set up.
+	 */
+	void setupReflectionProbes();
+
+	/**
+	 * Fits the shadows of the sun around the city.
+	 * Call it after the scene has been added to the renderer and the shadow atlas has been initialized.
+	 */
+	void setupShadows();
+
+	/**
+	 * Animates the scene, the doughnuts float on the waves.
+	 *
+	 * \param time The time in seconds, the same sent to the shaders.
+	 */
+	void update(const float time);
+}
\ No newline at end of file
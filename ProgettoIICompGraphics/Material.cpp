@@ -4,14 +4,16 @@
 #include "Texture.hpp"
 #include <stdexcept>
 
-Material::Material(const std::string& _name, const std::shared_ptr<Shader>& _shader, const std::unordered_map<std::string, MaterialValueType>& _values, const std::unordered_map<std::string, std::shared_ptr<Texture>>& _textures, const bool _litFlag, const bool _transparentFlag)
+Material::Material(const std::string& _name, const std::shared_ptr<Shader>& _shader, const std::unordered_map<std::string, MaterialValueType>& _values, const std::unordered_map<std::string, std::shared_ptr<Texture>>& _textures, const bool _litFlag, const bool _transparentFlag, const bool _staticFlag, const uint32_t _resolutionDivisor)
 	:
 	shader(_shader),
 	values(_values),
 	textures(_textures),
 	name(_name),
 	litFlag(_litFlag),
-	transparentFlag(_transparentFlag)
+	transparentFlag(_transparentFlag),
+	staticFlag(_staticFlag),
+	resolutionDivisor(_resolutionDivisor)
 {
 	if (this->shader == nullptr) {
 		std::runtime_error("The material has been initialized without a shader!");
@@ -30,22 +32,27 @@ void Material::setShader(const std::shared_ptr<Shader>& _shader) {
 	this->shader = _shader;
 }
 
+const std::unordered_map<std::string, Material::MaterialValueType>& Material::getProperties() const {
+	return this->values;
+}
+
 std::unordered_map<std::string, Material::MaterialValueType>& Material::getMutableProperties() {
 	return this->values;
 }
 
 static int32_t bindingPoint = 0;
-void Material::activate() const {
-	if (!this->shader) {
+void Material::activate(const Shader* shaderOverride) const {
+	const Shader* activeShader = shaderOverride ? shaderOverride : this->shader.get();
+	if (!activeShader) {
 		return;
 	}
 	// Activate the shader
-	this->shader->activate();
+	activeShader->activate();
 	// Setup all shader uniform properties
 	for (const auto& [uniform, value] : this->values) {
-		const auto visitor = [&uniform, this](const auto& val) {
+		const auto visitor = [&uniform, activeShader](const auto& val) {
 			using T = std::decay_t<decltype(val)>;
-			this->shader->setUniform("material_" + uniform, val);
+			activeShader->setUniform("material_" + uniform, val);
 		};
 		std::visit(visitor, value);
 	}
@@ -53,7 +60,7 @@ void Material::activate() const {
 	// Setup all shader uniform properties
 	for (const auto& [uniform, texturePtr] : this->textures) {
 		texturePtr->activate(bindingPoint);
-		this->shader->setUniform(uniform, bindingPoint++);
+		activeShader->setUniform(uniform, bindingPoint++);
 	}
 }
 
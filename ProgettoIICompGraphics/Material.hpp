@@ -36,6 +36,8 @@ public:
 	const std::string name;
 	const bool litFlag;
 	const bool transparentFlag;
+	const bool staticFlag; /* Never moves, its objects can be lightmapped */
+	const uint32_t resolutionDivisor; /* Transparent objects are drawn at this fraction of the screen resolution (1, 2 or 4) */
 
 	/**
 	 * Constructor for a material.
@@ -46,8 +48,10 @@ public:
 	 * \param textures The material's loaded textures.
 	 * \param _litFlag The fragment shader's code.
 	 * \param _transparentFlag The fragment shader's code.
+	 * \param _staticFlag Flag for materials of objects that never move, they sample their lightmap if they have one.
+	 * \param _resolutionDivisor Divisor of the screen resolution transparent objects are drawn at, see Renderer::setReducedResolutionTransparency.
 	 */
-	Material(const std::string& _name, const std::shared_ptr<Shader>& _shader, const std::unordered_map<std::string, MaterialValueType>& _values, const std::unordered_map<std::string, std::shared_ptr<Texture>>& _textures, const bool _litFlag, const bool _transparentFlag);
+	Material(const std::string& _name, const std::shared_ptr<Shader>& _shader, const std::unordered_map<std::string, MaterialValueType>& _values, const std::unordered_map<std::string, std::shared_ptr<Texture>>& _textures, const bool _litFlag, const bool _transparentFlag, const bool _staticFlag = false, const uint32_t _resolutionDivisor = 1);
 
 	/**
 	 * Destructor for the material class.
@@ -69,6 +73,13 @@ public:
 	*/
 	void setShader(const std::shared_ptr<Shader>& _shader);
 
+	/*
+	* Gets the material's properties for reading.
+	*
+	* \return The material's properties.
+	*/
+	const std::unordered_map<std::string, MaterialValueType>& getProperties() const;
+
 	/*
 	* Gets the material's properties.
 	*
@@ -79,8 +90,9 @@ public:
 	/**
 	 * Activates the material's shader and its properties.
 	 * 
+	 * \param shaderOverride Optional shader to use instead of the material's one (e.g.: for baking passes).
 	 */
-	void activate() const;
+	void activate(const Shader* shaderOverride = nullptr) const;
 
 	/**
 	 * Deactivates the material's shader and materialss.
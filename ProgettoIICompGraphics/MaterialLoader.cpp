@@ -19,10 +19,12 @@ namespace MaterialLoader {
 	static constexpr const char* SHADER_KEY = "shader";
 	static constexpr const char* LIT_KEY = "lit";
 	static constexpr const char* TRANSPARENT_KEY = "transparent";
+	static constexpr const char* STATIC_KEY = "static";
+	static constexpr const char* RESOLUTION_KEY = "resolution";
 	static constexpr const char* PROPERTY_KEY = "p";
 	static constexpr const char* TEXTURE_PROPERTY_KEY = "t";
 
-	static std::tuple<std::string, std::unordered_map<std::string, Material::MaterialValueType>, std::unordered_map<std::string, std::shared_ptr<Texture>>, bool, bool> readMaterialAssetFile(const std::string& materialAssetFile);
+	static std::tuple<std::string, std::unordered_map<std::string, Material::MaterialValueType>, std::unordered_map<std::string, std::shared_ptr<Texture>>, bool, bool, bool, uint32_t> readMaterialAssetFile(const std::string& materialAssetFile);
 	static Material::MaterialValueType parseMaterialValue(const std::string& value, const std::string& type);
 }
 
@@ -69,7 +71,7 @@ Material::MaterialValueType MaterialLoader::parseMaterialValue(const std::string
 	throw std::invalid_argument("Unknown material property type: " + type);
 }
 
-std::tuple<std::string, std::unordered_map<std::string, Material::MaterialValueType>, std::unordered_map<std::string, std::shared_ptr<Texture>>, bool, bool> MaterialLoader::readMaterialAssetFile(const std::string& materialAssetFile) {
+std::tuple<std::string, std::unordered_map<std::string, Material::MaterialValueType>, std::unordered_map<std::string, std::shared_ptr<Texture>>, bool, bool, bool, uint32_t> MaterialLoader::readMaterialAssetFile(const std::string& materialAssetFile) {
 	// Open shader asset file
 	std::ifstream assetFile(MATERIAL_ASSET_DIR + materialAssetFile);
 	if (!assetFile.is_open()) {
@@ -78,7 +80,7 @@ std::tuple<std::string, std::unordered_map<std::string, Material::MaterialValueT
 	// Prepare variables to output
 	std::unordered_map<std::string, Material::MaterialValueType> materialProperties;
 	std::unordered_map<std::string, std::shared_ptr<Texture>> materialTextures;
-	std::string line, shaderText, litText, transparentText;
+	std::string line, shaderText, litText, transparentText, staticText, resolutionText;
 	while (std::getline(assetFile, line)) {
 		// Read all lines
 		std::istringstream iss(line);
@@ -107,6 +109,10 @@ std::tuple<std::string, std::unordered_map<std::string, Material::MaterialValueT
 				litText = value;
 			} else if (key == TRANSPARENT_KEY) {
 				transparentText = value;
+			} else if (key == STATIC_KEY) {
+				staticText = value;
+			} else if (key == RESOLUTION_KEY) {
+				resolutionText = value;
 			}
 		}
 	}
@@ -121,8 +127,13 @@ std::tuple<std::string, std::unordered_map<std::string, Material::MaterialValueT
 	if (transparentText.empty()) {
 		throw std::runtime_error("Missing transparent property in material asset: " + materialAssetFile);
 	}
-	// Return the values
-	return { shaderText, materialProperties, materialTextures, static_cast<bool>(std::stoi(litText)), static_cast<bool>(std::stoi(transparentText)) };
+	// Materials are drawn at full resolution unless they say so
+	const uint32_t resolutionDivisor = resolutionText.empty() ? 1 : static_cast<uint32_t>(std::stoi(resolutionText));
+	if (resolutionDivisor != 1 && resolutionDivisor != 2 && resolutionDivisor != 4) {
+		throw std::runtime_error("Resolution must be 1, 2 or 4 in material asset: " + materialAssetFile);
+	}
+	// Return the values, materials are not static unless they say so
+	return { shaderText, materialProperties, materialTextures, static_cast<bool>(std::stoi(litText)), static_cast<bool>(std::stoi(transparentText)), !staticText.empty() && static_cast<bool>(std::stoi(staticText)), resolutionDivisor };
 }
 
 std::shared_ptr<Material> MaterialLoader::load(const std::string& materialAssetFileName) {
@@ -136,17 +147,17 @@ std::shared_ptr<Material> MaterialLoader::load(const std::string& materialAssetF
 	}
 	std::cout << "Loaded Material: " << materialAssetFileName << std::endl;
 	// Read the file
-	auto [shaderName, propertyMap, textureMap, litFlag, transparentFlag] = readMaterialAssetFile(materialAssetFileName + MATERIAL_ASSET_FILE_EXTENSION);
+	auto [shaderName, propertyMap, textureMap, litFlag, transparentFlag, staticFlag, resolutionDivisor] = readMaterialAssetFile(materialAssetFileName + MATERIAL_ASSET_FILE_EXTENSION);
 	// Load the material
-	loadedMaterials.emplace(materialAssetFileName, std::make_shared<Material>(materialAssetFileName, ShaderLoader::load(shaderName), propertyMap, textureMap, litFlag, transparentFlag));
+	loadedMaterials.emplace(materialAssetFileName, std::make_shared<Material>(materialAssetFileName, ShaderLoader::load(shaderName), propertyMap, textureMap, litFlag, transparentFlag, staticFlag, resolutionDivisor));
 	return loadedMaterials.at(materialAssetFileName);
 }
 
-std::shared_ptr<Material> MaterialLoader::load(const std::string& name, const std::string& shaderName, const std::unordered_map<std::string, Material::MaterialValueType>& properties, const std::unordered_map<std::string, std::shared_ptr<Texture>>& textures, const bool litFlag, const bool transparentFlag) {
+std::shared_ptr<Material> MaterialLoader::load(const std::string& name, const std::string& shaderName, const std::unordered_map<std::string, Material::MaterialValueType>& properties, const std::unordered_map<std::string, std::shared_ptr<Texture>>& textures, const bool litFlag, const bool transparentFlag, const bool staticFlag) {
 	if (isLoaded(name)) {
 		return loadedMaterials.at(name);
 	}
-	loadedMaterials.emplace(name, std::make_shared<Material>(name, ShaderLoader::load(shaderName), properties, textures, litFlag, transparentFlag));
+	loadedMaterials.emplace(name, std::make_shared<Material>(name, ShaderLoader::load(shaderName), properties, textures, litFlag, transparentFlag, staticFlag));
 	return loadedMaterials.at(name);
 }
 
@@ -8,7 +8,7 @@
 
 namespace MaterialLoader {
 	std::shared_ptr<Material> load(const std::string& materialAssetFileName);
-	std::shared_ptr<Material> load(const std::string& name, const std::string& shaderName, const std::unordered_map<std::string, Material::MaterialValueType>& properties = std::unordered_map<std::string, Material::MaterialValueType>(), const std::unordered_map<std::string, std::shared_ptr<Texture>>& textures = std::unordered_map<std::string, std::shared_ptr<Texture>>(), const bool litFlag = true, const bool transparentFlag = false);
+	std::shared_ptr<Material> load(const std::string& name, const std::string& shaderName, const std::unordered_map<std::string, Material::MaterialValueType>& properties = std::unordered_map<std::string, Material::MaterialValueType>(), const std::unordered_map<std::string, std::shared_ptr<Texture>>& textures = std::unordered_map<std::string, std::shared_ptr<Texture>>(), const bool litFlag = true, const bool transparentFlag = false, const bool staticFlag = false);
 	void unloadAll();
 
 	bool isLoaded(const std::string& materialAssetFileName);
@@ -1,18 +1,33 @@
 #include "Mesh.hpp"
 
+#include "Shader.hpp"
 #include "Vertex.hpp"
 #include <glad/glad.h>
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const uint32_t _drawType)
+Mesh::Mesh(std::vector<Vertex>&& _vertices, std::vector<uint32_t>&& _indices, const uint32_t _drawType, const DataRetention _retention, const VertexFormat _vertexFormat)
 	:
-	vertices(vertices),
-	indices(indices),
+	Mesh(std::move(_vertices), std::move(_indices), std::vector<Lod>(), std::vector<Meshlet>(), _drawType, _retention, _vertexFormat)
+{}
+
+Mesh::Mesh(std::vector<Vertex>&& _vertices, std::vector<uint32_t>&& _indices, std::vector<Lod>&& _lods, std::vector<Meshlet>&& _meshlets, const uint32_t _drawType, const DataRetention _retention, const VertexFormat _vertexFormat)
+	:
+	vertices(std::move(_vertices)),
+	positions(),
+	indices(std::move(_indices)),
+	lods(std::move(_lods)),
+	meshlets(std::move(_meshlets)),
+	retention(_retention),
+	vertexFormat(_vertexFormat),
 	drawType(_drawType),
+	aabb(this->vertices),
 	vao(),
-	vbo(this->vertices),
-	ebo(this->indices),
-	aabb(this->vertices)
+	vbo(this->vertices, this->vertexFormat == VertexFormat::COMPACT, this->aabb),
+	ebo(this->indices, this->vertices.size())
 {
+	// Without levels of detail the whole index buffer is the full detail mesh
+	if (this->lods.empty()) {
+		this->lods.emplace_back(Lod{ 0, static_cast<uint32_t>(this->indices.size()), 0.0f });
+	}
 	this->vao.bind();
 	this->vbo.bind();
 	this->ebo.bind();
@@ -20,18 +35,180 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& ind
 	this->vao.unbind();
 	this->vbo.unbind();
 	this->ebo.unbind();
+	this->releaseCpuData();
 }
 
+Mesh::Mesh(const std::vector<Vertex>& _vertices, const std::vector<uint32_t>& _indices, const uint32_t _drawType, const DataRetention _retention, const VertexFormat _vertexFormat)
+	:
+	Mesh(std::vector<Vertex>(_vertices), std::vector<uint32_t>(_indices), _drawType, _retention, _vertexFormat)
+{}
+
 const BoundingBox& Mesh::getBoundingBox() const {
 	return this->aabb;
 }
 
-void Mesh::draw() const {
+const std::vector<Vertex>& Mesh::getVertices() const {
+	return this->vertices;
+}
+
+std::vector<glm::vec3> Mesh::getPositions() const {
+	if (!this->positions.empty()) {
+		return this->positions;
+	}
+	std::vector<glm::vec3> result;
+	result.reserve(this->vertices.size());
+	for (const Vertex& v : this->vertices) {
+		result.emplace_back(v.position);
+	}
+	return result;
+}
+
+const std::vector<uint32_t>& Mesh::getIndices() const {
+	return this->indices;
+}
+
+uint32_t Mesh::getIndexCount(const uint32_t lod) const {
+	return this->lods[lod].indexCount;
+}
+
+uint32_t Mesh::getLodCount() const {
+	return static_cast<uint32_t>(this->lods.size());
+}
+
+const Mesh::Lod& Mesh::getLod(const uint32_t lod) const {
+	return this->lods[lod];
+}
+
+uint32_t Mesh::getMeshletCount() const {
+	return static_cast<uint32_t>(this->meshlets.size());
+}
+
+const std::vector<Mesh::Meshlet>& Mesh::getMeshlets() const {
+	return this->meshlets;
+}
+
+void Mesh::setLightmapUvs(const std::vector<glm::vec2>& uvs) {
+	this->lightmapUvs = std::make_unique<VertexBuffer>(uvs.size() * sizeof(glm::vec2), false);
 	this->vao.bind();
-	glDrawElements(this->drawType, static_cast<int32_t>(indices.size()), GL_UNSIGNED_INT, 0);
+	this->lightmapUvs->bind();
+	this->lightmapUvs->uploadData(uvs.data(), uvs.size() * sizeof(glm::vec2));
+	this->vao.linkAttrib(5, 2, sizeof(glm::vec2), GL_FLOAT, 0);
+	this->vao.unbind();
+	this->lightmapUvs->unbind();
+}
+
+bool Mesh::hasLightmapUvs() const {
+	return this->lightmapUvs != nullptr;
+}
+
+void Mesh::setVertexOcclusion(const std::vector<uint8_t>& values) {
+	this->occlusionBuffer = std::make_unique<VertexBuffer>(values.size(), false);
+	this->vao.bind();
+	this->occlusionBuffer->bind();
+	this->occlusionBuffer->uploadData(values.data(), values.size());
+	this->vao.linkAttrib(6, 1, sizeof(uint8_t), GL_UNSIGNED_BYTE, 0, true);
+	this->vao.unbind();
+	this->occlusionBuffer->unbind();
+	if (this->retention == DataRetention::ALL) {
+		this->occlusion = values;
+	}
+}
+
+const std::vector<uint8_t>& Mesh::getVertexOcclusion() const {
+	return this->occlusion;
+}
+
+void Mesh::releaseData() {
+	// Swap with empty vectors to actually give the memory back
+	std::vector<Vertex>().swap(this->vertices);
+	std::vector<glm::vec3>().swap(this->positions);
+	std::vector<uint32_t>().swap(this->indices);
+	std::vector<uint8_t>().swap(this->occlusion);
+}
+
+uint32_t Mesh::cullMeshlets(const glm::mat4& cameraMatrix, const glm::mat4& modelMatrix, const glm::vec3& viewPoint, std::vector<int32_t>& counts, std::vector<const void*>& offsets, CullingStatistics& statistics) const {
+	// Test in object space: the frustum planes come straight from the model view projection matrix
+	const glm::mat4 mvp = cameraMatrix * modelMatrix;
+	glm::vec4 planes[6];
+	for (int32_t i = 0; i < 3; ++i) {
+		const glm::vec4 row(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]);
+		const glm::vec4 wRow(mvp[0][3], mvp[1][3], mvp[2][3], mvp[3][3]);
+		planes[i * 2] = wRow + row;
+		planes[i * 2 + 1] = wRow - row;
+	}
+	for (glm::vec4& plane : planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+	const glm::vec3 cameraPosition = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(viewPoint, 1.0f));
+	// Mirroring transforms flip the winding, the cones would cull the wrong side
+	const bool coneCulling = glm::determinant(glm::mat3(modelMatrix)) > 0.0f;
+	const size_t indexSize = this->ebo.getIndexSize();
+	const size_t firstRange = counts.size();
+	uint32_t rangeEnd = 0;
+	uint32_t visibleTriangles = 0;
+	for (const Meshlet& meshlet : this->meshlets) {
+		++statistics.testedMeshlets;
+		bool culled = false;
+		for (const glm::vec4& plane : planes) {
+			if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius) {
+				++statistics.frustumCulledMeshlets;
+				culled = true;
+				break;
+			}
+		}
+		if (!culled && coneCulling) {
+			const glm::vec3 toMeshlet = meshlet.center - cameraPosition;
+			if (glm::dot(toMeshlet, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toMeshlet) + meshlet.radius) {
+				++statistics.coneCulledMeshlets;
+				culled = true;
+			}
+		}
+		if (culled) {
+			statistics.rejectedTriangles += meshlet.indexCount / 3;
+			continue;
+		}
+		visibleTriangles += meshlet.indexCount / 3;
+		if (counts.size() > firstRange && rangeEnd == meshlet.indexOffset) {
+			counts.back() += static_cast<int32_t>(meshlet.indexCount);
+		} else {
+			counts.emplace_back(static_cast<int32_t>(meshlet.indexCount));
+			offsets.emplace_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(meshlet.indexOffset) * indexSize));
+		}
+		rangeEnd = meshlet.indexOffset + meshlet.indexCount;
+	}
+	return visibleTriangles;
+}
+
+void Mesh::setDecodingUniforms(const Shader* shader) const {
+	const bool compact = this->vertexFormat == VertexFormat::COMPACT;
+	shader->setUniform("compactVertices", static_cast<int32_t>(compact));
+	if (compact) {
+		shader->setUniform("meshBoundsCenter", (this->aabb.getMaxValues() + this->aabb.getMinValues()) * 0.5f);
+		shader->setUniform("meshBoundsHalfExtent", glm::max((this->aabb.getMaxValues() - this->aabb.getMinValues()) * 0.5f, glm::vec3(1e-6f)));
+	}
+}
+
+void Mesh::draw(const uint32_t lod) const {
+	const Lod& level = this->lods[glm::min(lod, static_cast<uint32_t>(this->lods.size() - 1))];
+	this->vao.bind();
+	glDrawElements(this->drawType, static_cast<int32_t>(level.indexCount), this->ebo.indexType, reinterpret_cast<const void*>(static_cast<uintptr_t>(level.indexOffset) * this->ebo.getIndexSize()));
+}
+
+void Mesh::drawRanges(const int32_t* counts, const void* const* offsets, const int32_t rangeCount) const {
+	this->vao.bind();
+	glMultiDrawElements(this->drawType, counts, this->ebo.indexType, offsets, rangeCount);
 }
 
 void Mesh::setVertexArrayAttributes() const {
+	if (this->vertexFormat == VertexFormat::COMPACT) {
+		// Quantized layout: (0 = snorm16 position + handedness, 1 = snorm16 octahedral normal, 2 = half uv, 3 = snorm16 octahedral tangent)
+		// The bitangent slot is left disabled, the shaders rebuild it from the normal and tangent
+		this->vao.linkAttrib(0, 4, sizeof(CompactVertex), GL_SHORT, offsetof(CompactVertex, position), true);
+		this->vao.linkAttrib(1, 2, sizeof(CompactVertex), GL_SHORT, offsetof(CompactVertex, normal), true);
+		this->vao.linkAttrib(2, 2, sizeof(CompactVertex), GL_HALF_FLOAT, offsetof(CompactVertex, uv));
+		this->vao.linkAttrib(3, 2, sizeof(CompactVertex), GL_SHORT, offsetof(CompactVertex, tangent), true);
+		return;
+	}
 	// Link the vertices' attributes to slots: (0 = vec2 position, 1 = vec2 normal, 2 = vec2 uv, 3 = vec3 tangent, 4 = vec3 bitangent)
 	this->vao.linkAttrib(0, 3, sizeof(Vertex), GL_FLOAT, 0);
 	this->vao.linkAttrib(1, 3, sizeof(Vertex), GL_FLOAT, 3 * sizeof(float));
@@ -39,3 +216,25 @@ void Mesh::setVertexArrayAttributes() const {
 	this->vao.linkAttrib(3, 3, sizeof(Vertex), GL_FLOAT, 8 * sizeof(float));
 	this->vao.linkAttrib(4, 3, sizeof(Vertex), GL_FLOAT, 11 * sizeof(float));
 }
+
+void Mesh::releaseCpuData() {
+	switch (this->retention) {
+		case DataRetention::NONE:
+			// Swap with empty vectors to actually give the memory back
+			std::vector<Vertex>().swap(this->vertices);
+			std::vector<uint32_t>().swap(this->indices);
+			break;
+		case DataRetention::POSITIONS:
+			this->positions.reserve(this->vertices.size());
+			for (const Vertex& v : this->vertices) {
+				this->positions.emplace_back(v.position);
+			}
+			std::vector<Vertex>().swap(this->vertices);
+			this->indices.shrink_to_fit();
+			break;
+		case DataRetention::ALL:
+			this->vertices.shrink_to_fit();
+			this->indices.shrink_to_fit();
+			break;
+	}
+}
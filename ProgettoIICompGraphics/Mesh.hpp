@@ -4,17 +4,84 @@
 #include "ElementBuffer.hpp"
 #include "VertexArray.hpp"
 #include "VertexBuffer.hpp"
+#include <memory>
+
+/**
+ * Forward declaration of the shader class.
+ */
+class Shader;
+
+/**
+ * Policy for the CPU side copies of a mesh's data once it has been uploaded to the GPU.
+ * Declared outside of the mesh so other headers can forward declare it, use it as Mesh::DataRetention.
+ */
+enum class MeshDataRetention : uint8_t {
+	NONE = 0,      // Only the GPU buffers are kept
+	POSITIONS = 1, // Keeps the vertex positions and the indices (picking, BVH building)
+	ALL = 2        // Keeps the full vertex and index data
+};
 
 class Mesh {
+public:
+	using DataRetention = MeshDataRetention;
+
+	/**
+	 * Layout of the vertices in the GPU buffer.
+	 */
+	enum class VertexFormat : uint8_t {
+		FULL = 0,   // Plain Vertex structs
+		COMPACT = 1 // Quantized CompactVertex structs
+	};
+
+	/**
+	 * Range of the index buffer drawn by a level of detail, all levels share the same vertices.
+	 */
+	struct Lod {
+		uint32_t indexOffset; /* First index of the level */
+		uint32_t indexCount; /* Amount of indices of the level */
+		float error; /* Object space deviation from the full detail mesh */
+	};
+
+	/**
+	 * Small cluster of the full detail level's triangles, culled on its own against the frustum and the view direction.
+	 */
+	struct Meshlet {
+		glm::vec3 center; /* Object space center of the bounding sphere */
+		float radius; /* Object space radius of the bounding sphere */
+		glm::vec3 coneAxis; /* Average facing direction of the triangles */
+		float coneCutoff; /* Sine of the normals' spread around the axis, 1 if the cone can't cull */
+		uint32_t indexOffset; /* First index of the meshlet */
+		uint32_t indexCount; /* Amount of indices of the meshlet */
+	};
+
+	/**
+	 * Counters of the meshlet culling, accumulated over every culled draw.
+	 */
+	struct CullingStatistics {
+		uint32_t testedMeshlets; /* Meshlets tested */
+		uint32_t frustumCulledMeshlets; /* Meshlets outside the frustum */
+		uint32_t coneCulledMeshlets; /* Meshlets fully facing away from the camera */
+		uint32_t rejectedTriangles; /* Triangles of the culled meshlets */
+	};
 protected:
 	std::vector<Vertex> vertices;
+	std::vector<glm::vec3> positions;
 	std::vector<uint32_t> indices;
+	std::vector<Lod> lods;
+	std::vector<Meshlet> meshlets;
+	// Second uv set, only meshes made for a lightmap have it
+	std::unique_ptr<VertexBuffer> lightmapUvs;
+	// Baked ambient occlusion of every vertex, the CPU copy is only kept with the rest of the data
+	std::vector<uint8_t> occlusion;
+	std::unique_ptr<VertexBuffer> occlusionBuffer;
 public:
+	const DataRetention retention;
+	const VertexFormat vertexFormat;
 	const uint32_t drawType;
+	const BoundingBox aabb;
 	const VertexArray vao;
 	const VertexBuffer vbo;
 	const ElementBuffer ebo;
-	const BoundingBox aabb;
 public:
 	// Erase copy constructors, as it would break opengl
 	Mesh(const Mesh&) = delete;
@@ -22,12 +89,40 @@ public:
 
 	/**
 	 * Creates a mesh with the given data.
+	 * The vectors are moved into the mesh and used directly as upload memory,
+	 * after the upload they are released according to the retention policy.
 	 *
 	 * \param vertices The vertices that it is composed of.
 	 * \param indices The indices to connect those vertices.
 	 * \param _drawType The type of OpenGL shape it will draw.
+	 * \param _retention What data to keep on the CPU after the upload.
+	 * \param _vertexFormat The layout of the vertices on the GPU.
+	 */
+	Mesh(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices, const uint32_t _drawType, const DataRetention _retention, const VertexFormat _vertexFormat);
+
+	/**
+	 * Creates a mesh with levels of detail, the index vector holds the indices of every level.
+	 *
+	 * \param vertices The vertices shared by all the levels.
+	 * \param indices The indices of all the levels, one after the other.
+	 * \param _lods The index ranges of the levels, from the most to the least detailed.
+	 * \param _meshlets The meshlets of the full detail level, can be empty.
+	 * \param _drawType The type of OpenGL shape it will draw.
+	 * \param _retention What data to keep on the CPU after the upload.
+	 * \param _vertexFormat The layout of the vertices on the GPU.
 	 */
-	Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const uint32_t _drawType);
+	Mesh(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices, std::vector<Lod>&& _lods, std::vector<Meshlet>&& _meshlets, const uint32_t _drawType, const DataRetention _retention, const VertexFormat _vertexFormat);
+
+	/**
+	 * Creates a mesh with a copy of the given data.
+	 *
+	 * \param vertices The vertices that it is composed of.
+	 * \param indices The indices to connect those vertices.
+	 * \param _drawType The type of OpenGL shape it will draw.
+	 * \param _retention What data to keep on the CPU after the upload.
+	 * \param _vertexFormat The layout of the vertices on the GPU.
+	 */
+	Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const uint32_t _drawType, const DataRetention _retention, const VertexFormat _vertexFormat);
 
 	/**
 	 * Getter for the mesh's bounding box.
@@ -36,15 +131,148 @@ public:
 	 */
 	const BoundingBox& getBoundingBox() const;
 
+	/**
+	 * Getter for the CPU copy of the vertices (empty unless the retention is ALL).
+	 *
+	 * \return The mesh's vertices.
+	 */
+	const std::vector<Vertex>& getVertices() const;
+
+	/**
+	 * Getter for the vertex positions (empty if the retention is NONE).
+	 *
+	 * \return A copy of the mesh's vertex positions.
+	 */
+	std::vector<glm::vec3> getPositions() const;
+
+	/**
+	 * Getter for the CPU copy of the indices (empty if the retention is NONE).
+	 * The full detail level comes first, followed by the other levels of detail.
+	 *
+	 * \return The mesh's indices.
+	 */
+	const std::vector<uint32_t>& getIndices() const;
+
+	/**
+	 * Getter for the amount of indices drawn by a level of detail.
+	 *
+	 * \param lod The level of detail.
+	 * \return The level's index count.
+	 */
+	uint32_t getIndexCount(const uint32_t lod = 0) const;
+
+	/**
+	 * Getter for the amount of levels of detail, the full detail mesh included.
+	 *
+	 * \return The mesh's level of detail count.
+	 */
+	uint32_t getLodCount() const;
+
+	/**
+	 * Getter for a level of detail.
+	 *
+	 * \param lod The level of detail.
+	 * \return The level's index range and error.
+	 */
+	const Lod& getLod(const uint32_t lod) const;
+
+	/**
+	 * Getter for the amount of meshlets of the full detail level.
+	 *
+	 * \return The mesh's meshlet count.
+	 */
+	uint32_t getMeshletCount() const;
+
+	/**
+	 * Getter for the meshlets of the full detail level.
+	 *
+	 * \return The mesh's meshlets.
+	 */
+	const std::vector<Meshlet>& getMeshlets() const;
+
+	/**
+	 * Adds a second uv set to the mesh, read by the vertex shaders at location 5 to sample a lightmap.
+	 *
+	 * \param uvs One uv per vertex, in the [0, 1] square of the mesh's area of the lightmap.
+	 */
+	void setLightmapUvs(const std::vector<glm::vec2>& uvs);
+
+	/**
+	 * Checks if the mesh has a second uv set.
+	 *
+	 * \return True if the mesh can sample a lightmap.
+	 */
+	bool hasLightmapUvs() const;
+
+	/**
+	 * Adds the baked ambient occlusion to the mesh, read by the vertex shaders at location 6.
+	 * Meshes without it read 0 there, so they are not occluded.
+	 *
+	 * \param values One value per vertex, from 0 (open) to 255 (fully occluded).
+	 */
+	void setVertexOcclusion(const std::vector<uint8_t>& values);
+
+	/**
+	 * Getter for the baked ambient occlusion.
+	 *
+	 * \return One value per vertex, empty if it was never baked or the mesh doesn't keep its CPU data (Mesh::DataRetention::ALL).
+	 */
+	const std::vector<uint8_t>& getVertexOcclusion() const;
+
+	/**
+	 * Frees every CPU side copy of the data whatever the retention policy, the getters return empty vectors after it.
+	 * Meant for meshes kept with DataRetention::ALL only until the bakes have read them.
+	 *
+	 */
+	void releaseData();
+
+	/**
+	 * Culls the meshlets of the full detail level for an instance and appends the visible index ranges.
+	 * Consecutive visible meshlets are merged in a single range.
+	 *
+	 * \param cameraMatrix The camera's combined matrix.
+	 * \param modelMatrix The model matrix of the instance.
+	 * \param viewPoint The view point in the scene.
+	 * \param counts The index counts of the ranges (output variable).
+	 * \param offsets The byte offsets of the ranges in the index buffer (output variable).
+	 * \param statistics The counters to accumulate the results in.
+	 * \return The amount of visible triangles.
+	 */
+	uint32_t cullMeshlets(const glm::mat4& cameraMatrix, const glm::mat4& modelMatrix, const glm::vec3& viewPoint, std::vector<int32_t>& counts, std::vector<const void*>& offsets, CullingStatistics& statistics) const;
+
+	/**
+	 * Sets the uniforms the vertex shaders need to decode the mesh's vertex format.
+	 * Make sure the shader is active first.
+	 *
+	 * \param shader The shader that will draw the mesh.
+	 */
+	void setDecodingUniforms(const Shader* shader) const;
+
 	/**
 	 * Draws the object to the screen.
 	 *
+	 * \param lod The level of detail to draw.
+	 */
+	virtual void draw(const uint32_t lod = 0) const;
+
+	/**
+	 * Draws ranges of the index buffer with a single call (e.g.: the ones left by the meshlet culling).
+	 *
+	 * \param counts The index counts of the ranges.
+	 * \param offsets The byte offsets of the ranges in the index buffer.
+	 * \param rangeCount The amount of ranges.
 	 */
-	virtual void draw() const;
+	void drawRanges(const int32_t* counts, const void* const* offsets, const int32_t rangeCount) const;
 private:
 	/**
 	 * Function to set the VAO vertices' attributes.
 	 *
 	 */
 	virtual void setVertexArrayAttributes() const;
-};
\ No newline at end of file
+
+	/**
+	 * Frees the CPU side data that the retention policy does not require.
+	 *
+	 */
+	void releaseCpuData();
+};
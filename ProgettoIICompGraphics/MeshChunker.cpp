@@ -0,0 +1,64 @@
+#include "MeshChunker.hpp"
+
+#include "Vertex.hpp"
+#include <algorithm>
+#include <limits>
+
+std::vector<MeshChunker::Chunk> MeshChunker::split(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const uint32_t maxChunkVertices) {
+	std::vector<Chunk> chunks;
+	if (vertices.size() <= maxChunkVertices || indices.size() < 6) {
+		chunks.emplace_back(Chunk{ vertices, indices });
+		return chunks;
+	}
+	// Split over the two widest axes of the bounding box
+	glm::vec3 minValues(std::numeric_limits<float>::max());
+	glm::vec3 maxValues(std::numeric_limits<float>::lowest());
+	for (const Vertex& vertex : vertices) {
+		minValues = glm::min(minValues, vertex.position);
+		maxValues = glm::max(maxValues, vertex.position);
+	}
+	const glm::vec3 extent = glm::max(maxValues - minValues, glm::vec3(1e-6f));
+	uint32_t axes[3] = { 0, 1, 2 };
+	std::sort(axes, axes + 3, [&extent](const uint32_t a, const uint32_t b) { return extent[a] > extent[b]; });
+	const uint32_t axisA = axes[0];
+	const uint32_t axisB = axes[1];
+	// Keep the cells about square in object space
+	const float cellCount = glm::ceil(static_cast<float>(vertices.size()) / static_cast<float>(maxChunkVertices));
+	const float ratio = extent[axisA] / extent[axisB];
+	const uint32_t cellsA = static_cast<uint32_t>(glm::max(glm::ceil(glm::sqrt(cellCount * ratio)), 1.0f));
+	const uint32_t cellsB = static_cast<uint32_t>(glm::max(glm::ceil(glm::sqrt(cellCount / ratio)), 1.0f));
+	// Bucket the triangles by the cell of their centroid
+	std::vector<std::vector<uint32_t>> cellTriangles(static_cast<size_t>(cellsA) * cellsB);
+	for (uint32_t triangle = 0; triangle < indices.size() / 3; ++triangle) {
+		const glm::vec3 centroid = (vertices[indices[triangle * 3]].position + vertices[indices[triangle * 3 + 1]].position + vertices[indices[triangle * 3 + 2]].position) / 3.0f;
+		const uint32_t cellA = std::min(static_cast<uint32_t>((centroid[axisA] - minValues[axisA]) / extent[axisA] * cellsA), cellsA - 1);
+		const uint32_t cellB = std::min(static_cast<uint32_t>((centroid[axisB] - minValues[axisB]) / extent[axisB] * cellsB), cellsB - 1);
+		cellTriangles[cellB * cellsA + cellA].emplace_back(triangle);
+	}
+	// Build every non empty cell with its own vertices
+	std::vector<uint32_t> remap(vertices.size(), std::numeric_limits<uint32_t>::max());
+	for (const std::vector<uint32_t>& triangles : cellTriangles) {
+		if (triangles.empty()) {
+			continue;
+		}
+		Chunk chunk;
+		chunk.indices.reserve(triangles.size() * 3);
+		for (const uint32_t triangle : triangles) {
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				const uint32_t index = indices[triangle * 3 + corner];
+				if (remap[index] == std::numeric_limits<uint32_t>::max()) {
+					remap[index] = static_cast<uint32_t>(chunk.vertices.size());
+					chunk.vertices.emplace_back(vertices[index]);
+				}
+				chunk.indices.emplace_back(remap[index]);
+			}
+		}
+		for (const uint32_t triangle : triangles) {
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				remap[indices[triangle * 3 + corner]] = std::numeric_limits<uint32_t>::max();
+			}
+		}
+		chunks.emplace_back(std::move(chunk));
+	}
+	return chunks;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Forward declaration of the vertex struct.
+ */
+struct Vertex;
+
+namespace MeshChunker {
+	// Meshes with more vertices than this get split when no threshold is given
+	static constexpr uint32_t DEFAULT_MAX_CHUNK_VERTICES = 4096;
+
+	/**
+	 * A piece of a split mesh.
+	 */
+	struct Chunk {
+		std::vector<Vertex> vertices; /* The vertices used by the chunk's triangles */
+		std::vector<uint32_t> indices; /* The triangle list indices of the chunk */
+	};
+
+	/**
+	 * Splits a triangle list in a grid of chunks over its two widest axes, so each piece gets a tight bounding box.
+	 * Triangles are assigned to the cell their centroid falls in, vertices on the borders are duplicated.
+	 * Meshes below the threshold are returned as a single chunk.
+	 *
+	 * \param vertices The vertices of the mesh.
+	 * \param indices The triangle list indices of the mesh.
+	 * \param maxChunkVertices The amount of vertices above which the mesh is split, and roughly the size of each chunk.
+	 * \return The non empty chunks.
+	 */
+	std::vector<Chunk> split(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const uint32_t maxChunkVertices);
+}
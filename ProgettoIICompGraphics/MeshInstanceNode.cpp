@@ -7,7 +7,8 @@ MeshInstanceNode::MeshInstanceNode(const std::string& _name, const std::shared_p
 	SceneNode(_name, _transform, parent),
 	mesh(_mesh),
 	material(_material),
-	boundingBox(this->mesh->getBoundingBox())
+	boundingBox(this->mesh->getBoundingBox()),
+	lodLevel(0)
 {}
 
 void MeshInstanceNode::updateWorldTransform() {
@@ -35,3 +36,11 @@ void MeshInstanceNode::setMaterial(const std::shared_ptr<Material>& _material) {
 const BoundingBox MeshInstanceNode::getBoundingBox() const {
 	return this->boundingBox;
 }
+
+uint32_t MeshInstanceNode::getLodLevel() const {
+	return this->lodLevel;
+}
+
+void MeshInstanceNode::setLodLevel(const uint32_t _lodLevel) {
+	this->lodLevel = _lodLevel;
+}
@@ -11,6 +11,7 @@ private:
 	std::shared_ptr<Mesh> mesh;
 	std::shared_ptr<Material> material;
 	BoundingBox boundingBox;
+	uint32_t lodLevel;
 protected:
 	virtual void updateWorldTransform() override;
 public:
@@ -52,4 +53,18 @@ public:
 	 * \return The object's bounding box.
 	 */
 	const BoundingBox getBoundingBox() const;
+
+	/**
+	 * Getter for the level of detail the node was last drawn with.
+	 *
+	 * \return The node's level of detail.
+	 */
+	uint32_t getLodLevel() const;
+
+	/**
+	 * Setter for the level of detail of the node.
+	 *
+	 * \param _lodLevel The new level of detail.
+	 */
+	void setLodLevel(const uint32_t _lodLevel);
 };
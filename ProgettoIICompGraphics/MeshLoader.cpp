@@ -3,15 +3,20 @@
 #include "MaterialLoader.hpp"
 #include "Mesh.hpp"
 #include "MeshInstanceNode.hpp"
+#include "MeshletBuilder.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
 #include "SceneNode.hpp"
 #include "TextureLoader.hpp"
 #include "Transform.hpp"
 #include "Vertex.hpp"
+#include <algorithm>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <filesystem>
 #include <glad/glad.h>
+#include <iostream>
 #include <stdexcept>
 
 namespace MeshLoader {
@@ -25,6 +30,26 @@ namespace MeshLoader {
     
     static std::string currentFile = "";
     static uint32_t currentNodeIndex = 0;
+    static Mesh::DataRetention currentRetention = Mesh::DataRetention::NONE;
+
+    /**
+     * Totals of the meshes processed while loading a file, logged once per file.
+     * The cache ratios are summed weighted by the triangles and vertices they are relative to.
+     */
+    struct LoadStatistics {
+        size_t meshes = 0;
+        size_t triangles = 0;
+        size_t verticesBefore = 0;
+        size_t verticesAfter = 0;
+        float acmrBefore = 0.0f;
+        float acmrAfter = 0.0f;
+        float atvrBefore = 0.0f;
+        float atvrAfter = 0.0f;
+        std::vector<size_t> lodTriangles; /* Triangles of every level of detail */
+        size_t meshlets = 0;
+        size_t meshletTriangles = 0; /* Triangles of the meshes split in meshlets, small ones are not */
+    };
+    static LoadStatistics currentStatistics;
 }
 
 constexpr glm::mat4 MeshLoader::mat4ToGlm(const aiMatrix4x4& aiMat) {
@@ -49,16 +74,21 @@ std::string MeshLoader::getNodeName(const aiString& str, const std::string& pare
 
 std::shared_ptr<MeshInstanceNode> MeshLoader::processMesh(aiMesh* mesh, const aiScene* scene, const std::unordered_map<uint32_t, std::shared_ptr<Material>>& materialOverrides, const std::shared_ptr<SceneNode>& parent) {
     const std::string nodeName = getNodeName(mesh->mName, parent ? parent->name : "");
-    if (loadedMeshes.find(nodeName) != loadedMeshes.end()) {
+    // The CPU copies depend on the retention, so the same mesh loaded with another one is not shared
+    const std::string meshKey = nodeName + "#" + std::to_string(static_cast<uint32_t>(currentRetention));
+    if (loadedMeshes.find(meshKey) != loadedMeshes.end()) {
         return std::make_shared<MeshInstanceNode>(
             nodeName,
-            loadedMeshes.at(nodeName).second,
-            loadedMeshes.at(nodeName).first,
+            loadedMeshes.at(meshKey).second,
+            loadedMeshes.at(meshKey).first,
             Transform(),
             parent);
     }
+    // Size the upload data up front, the vectors are handed over to the mesh without copies
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
+    vertices.reserve(mesh->mNumVertices);
+    indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
     for (uint32_t i = 0; i < mesh->mNumVertices; ++i) {
         Vertex vertex;
         vertex.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
@@ -182,8 +212,26 @@ std::shared_ptr<MeshInstanceNode> MeshLoader::processMesh(aiMesh* mesh, const ai
     if (!material) {
         throw std::runtime_error("No material has been provided for index: " + std::to_string(mesh->mMaterialIndex));
     }
-    const std::shared_ptr<Mesh> loadedMesh = std::make_shared<Mesh>(vertices, indices, GL_TRIANGLES);
-    loadedMeshes.emplace(nodeName, std::pair<std::shared_ptr<Material>, std::shared_ptr<Mesh>>(material, loadedMesh));
+    const MeshOptimizer::OptimizationStatistics optimization = MeshOptimizer::optimize(vertices, indices);
+    const float triangleCount = static_cast<float>(indices.size() / 3);
+    ++currentStatistics.meshes;
+    currentStatistics.triangles += indices.size() / 3;
+    currentStatistics.verticesBefore += optimization.verticesBefore;
+    currentStatistics.verticesAfter += optimization.verticesAfter;
+    currentStatistics.acmrBefore += optimization.before.acmr * triangleCount;
+    currentStatistics.acmrAfter += optimization.after.acmr * triangleCount;
+    currentStatistics.atvrBefore += optimization.before.atvr * static_cast<float>(optimization.verticesBefore);
+    currentStatistics.atvrAfter += optimization.after.atvr * static_cast<float>(optimization.verticesAfter);
+    std::vector<Mesh::Lod> lods = MeshSimplifier::generateLods(vertices, indices);
+    currentStatistics.lodTriangles.resize(std::max(currentStatistics.lodTriangles.size(), lods.size()), 0);
+    for (size_t i = 0; i < lods.size(); ++i) {
+        currentStatistics.lodTriangles[i] += lods[i].indexCount / 3;
+    }
+    std::vector<Mesh::Meshlet> meshlets = MeshletBuilder::buildMeshlets(vertices, indices, lods[0]);
+    currentStatistics.meshlets += meshlets.size();
+    currentStatistics.meshletTriangles += meshlets.empty() ? 0 : lods[0].indexCount / 3;
+    const std::shared_ptr<Mesh> loadedMesh = std::make_shared<Mesh>(std::move(vertices), std::move(indices), std::move(lods), std::move(meshlets), GL_TRIANGLES, currentRetention, Mesh::VertexFormat::COMPACT);
+    loadedMeshes.emplace(meshKey, std::pair<std::shared_ptr<Material>, std::shared_ptr<Mesh>>(material, loadedMesh));
     return std::make_shared<MeshInstanceNode>(
         nodeName,
         loadedMesh, 
@@ -211,21 +259,38 @@ std::shared_ptr<SceneNode> MeshLoader::processNode(aiNode* node, const aiScene*
     return currentNode;
 }
 
-std::shared_ptr<SceneNode> MeshLoader::loadMesh(const std::string& fileName, const Transform& rootTransform, const std::unordered_map<uint32_t, std::shared_ptr<Material>>& materialOverrides) {
+std::shared_ptr<SceneNode> MeshLoader::loadMesh(const std::string& fileName, const Transform& rootTransform, const std::unordered_map<uint32_t, std::shared_ptr<Material>>& materialOverrides, const Mesh::DataRetention retention) {
 	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(fileName, aiProcess_CalcTangentSpace | aiProcess_OptimizeGraph | aiProcess_OptimizeMeshes | aiProcess_RemoveRedundantMaterials | aiProcess_GenSmoothNormals | aiProcess_Triangulate);
+	const aiScene* scene = importer.ReadFile(fileName, aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices | aiProcess_OptimizeGraph | aiProcess_OptimizeMeshes | aiProcess_RemoveRedundantMaterials | aiProcess_GenSmoothNormals | aiProcess_Triangulate);
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
 		throw std::runtime_error("Failed to open mesh file: " + fileName);
 	}
     // Setup base template variables (in case they are not set in obj file)
     currentFile = fileName;
     currentNodeIndex = 0;
+    currentRetention = retention;
+    currentStatistics = {};
     // Create object tree from file
     const std::shared_ptr<SceneNode> rootNode = processNode(scene->mRootNode, scene, materialOverrides);
     // Set root node position to transform
     rootNode->setPosition(rootTransform.getPosition());
     rootNode->setRotation(rootTransform.getRotation());
     rootNode->setScale(rootTransform.getScale());
+    // Log the new meshes once for the whole file, files whose meshes are all shared have nothing to report
+    if (currentStatistics.meshes > 0) {
+        const float triangles = static_cast<float>(std::max(currentStatistics.triangles, static_cast<size_t>(1)));
+        const float verticesBefore = static_cast<float>(std::max(currentStatistics.verticesBefore, static_cast<size_t>(1)));
+        const float verticesAfter = static_cast<float>(std::max(currentStatistics.verticesAfter, static_cast<size_t>(1)));
+        std::cout << "Loaded mesh: " << fileName << " (" << currentStatistics.meshes << " meshes"
+            << ", vertices " << currentStatistics.verticesBefore << " -> " << currentStatistics.verticesAfter
+            << ", ACMR " << currentStatistics.acmrBefore / triangles << " -> " << currentStatistics.acmrAfter / triangles
+            << ", ATVR " << currentStatistics.atvrBefore / verticesBefore << " -> " << currentStatistics.atvrAfter / verticesAfter
+            << ", LOD triangles";
+        for (const size_t lodTriangles : currentStatistics.lodTriangles) {
+            std::cout << " " << lodTriangles;
+        }
+        std::cout << ", " << currentStatistics.meshlets << " meshlets of " << currentStatistics.meshletTriangles / std::max(currentStatistics.meshlets, static_cast<size_t>(1)) << " triangles on average)" << std::endl;
+    }
     // Free memory and return
     importer.FreeScene();
 	return rootNode;
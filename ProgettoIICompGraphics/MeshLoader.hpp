@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Mesh.hpp"
 #include <string>
 #include <vector>
 #include <memory>
@@ -9,8 +10,8 @@ class MeshInstanceNode;
 class Transform;
 class SceneNode;
 class Material;
-class Mesh;
 
 namespace MeshLoader {
-	std::shared_ptr<SceneNode> loadMesh(const std::string& fileName, const Transform& rootTransform, const std::unordered_map<uint32_t, std::shared_ptr<Material>>& materialOverrides = std::unordered_map<uint32_t, std::shared_ptr<Material>>());
+	// Meshes already loaded from the file with the same retention are shared
+	std::shared_ptr<SceneNode> loadMesh(const std::string& fileName, const Transform& rootTransform, const std::unordered_map<uint32_t, std::shared_ptr<Material>>& materialOverrides, const Mesh::DataRetention retention);
 }
\ No newline at end of file
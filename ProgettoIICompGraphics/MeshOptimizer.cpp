@@ -0,0 +1,291 @@
+#include "MeshOptimizer.hpp"
+
+#include "Hash.hpp"
+#include "Vertex.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace MeshOptimizer {
+	/**
+	 * Hashes the raw bytes of a vertex (FNV-1a).
+	 */
+	struct VertexHash {
+		size_t operator()(const Vertex& vertex) const {
+			return static_cast<size_t>(Hash::fnv1a(&vertex, sizeof(Vertex)));
+		}
+	};
+
+	/**
+	 * Compares the raw bytes of two vertices.
+	 */
+	struct VertexEqual {
+		bool operator()(const Vertex& first, const Vertex& second) const {
+			return std::memcmp(&first, &second, sizeof(Vertex)) == 0;
+		}
+	};
+
+	/**
+	 * Simulates a FIFO cache access, the cache holds the vertices of the last cacheSize misses.
+	 *
+	 * \param index The vertex being accessed.
+	 * \param cacheTime The timestamp of the last miss of each vertex.
+	 * \param timestamp The current timestamp, incremented on each miss.
+	 * \param cacheSize The amount of entries in the cache.
+	 * \return Whether the access was a miss.
+	 */
+	static bool accessCache(const uint32_t index, std::vector<uint32_t>& cacheTime, uint32_t& timestamp, const uint32_t cacheSize);
+}
+
+bool MeshOptimizer::accessCache(const uint32_t index, std::vector<uint32_t>& cacheTime, uint32_t& timestamp, const uint32_t cacheSize) {
+	if (timestamp - cacheTime[index] > cacheSize) {
+		cacheTime[index] = timestamp++;
+		return true;
+	}
+	return false;
+}
+
+MeshOptimizer::CacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, const size_t vertexCount, const uint32_t cacheSize) {
+	CacheStatistics statistics{ 0.0f, 0.0f };
+	if (indices.size() < 3 || vertexCount == 0) {
+		return statistics;
+	}
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t timestamp = cacheSize + 1;
+	size_t misses = 0;
+	size_t referencedCount = 0;
+	for (const uint32_t index : indices) {
+		misses += accessCache(index, cacheTime, timestamp, cacheSize) ? 1 : 0;
+		if (!referenced[index]) {
+			referenced[index] = true;
+			++referencedCount;
+		}
+	}
+	statistics.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	statistics.atvr = static_cast<float>(misses) / static_cast<float>(referencedCount);
+	return statistics;
+}
+
+void MeshOptimizer::weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+	std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> uniqueVertices;
+	uniqueVertices.reserve(vertices.size());
+	std::vector<uint32_t> remap(vertices.size());
+	std::vector<Vertex> welded;
+	welded.reserve(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		const auto [it, inserted] = uniqueVertices.emplace(vertices[i], static_cast<uint32_t>(welded.size()));
+		if (inserted) {
+			welded.emplace_back(vertices[i]);
+		}
+		remap[i] = it->second;
+	}
+	for (uint32_t& index : indices) {
+		index = remap[index];
+	}
+	vertices.swap(welded);
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, const size_t vertexCount, const uint32_t cacheSize) {
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || vertexCount == 0) {
+		return;
+	}
+	// Build the vertex to triangle adjacency, liveTriangles counts the triangles left to emit for each vertex
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (const uint32_t index : indices) {
+		++liveTriangles[index];
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; ++i) {
+		adjacency[adjacencyFill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEndStack;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output;
+	deadEndStack.reserve(triangleCount * 3);
+	output.reserve(triangleCount * 3);
+	uint32_t timestamp = cacheSize + 1;
+	size_t cursor = 0;
+	int64_t fanningVertex = 0;
+	while (fanningVertex >= 0) {
+		// Emit all the triangles around the fanning vertex
+		candidates.clear();
+		for (uint32_t a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; ++a) {
+			const uint32_t triangle = adjacency[a];
+			if (emitted[triangle]) {
+				continue;
+			}
+			for (uint32_t k = 0; k < 3; ++k) {
+				const uint32_t v = indices[triangle * 3 + k];
+				output.emplace_back(v);
+				deadEndStack.emplace_back(v);
+				candidates.emplace_back(v);
+				--liveTriangles[v];
+				accessCache(v, cacheTime, timestamp, cacheSize);
+			}
+			emitted[triangle] = true;
+		}
+		// Pick the candidate that will still be in the cache after its remaining triangles are emitted, the oldest one first
+		fanningVertex = -1;
+		int64_t bestPriority = -1;
+		for (const uint32_t v : candidates) {
+			if (liveTriangles[v] == 0) {
+				continue;
+			}
+			int64_t priority = 0;
+			if (timestamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) {
+				priority = timestamp - cacheTime[v];
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				fanningVertex = v;
+			}
+		}
+		if (fanningVertex >= 0) {
+			continue;
+		}
+		// Dead end, go back to recently used vertices first and then scan the rest of the mesh
+		while (!deadEndStack.empty()) {
+			const uint32_t v = deadEndStack.back();
+			deadEndStack.pop_back();
+			if (liveTriangles[v] > 0) {
+				fanningVertex = v;
+				break;
+			}
+		}
+		while (fanningVertex < 0 && cursor < vertexCount) {
+			if (liveTriangles[cursor] > 0) {
+				fanningVertex = static_cast<int64_t>(cursor);
+			} else {
+				++cursor;
+			}
+		}
+	}
+	indices.swap(output);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const float threshold, const uint32_t cacheSize) {
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2) {
+		return;
+	}
+	const float acmrBefore = analyzeVertexCache(indices, vertices.size(), cacheSize).acmr;
+	const float targetAcmr = acmrBefore * threshold;
+	// Hard boundaries are triangles where the cache restarts from scratch (all three vertices miss)
+	std::vector<size_t> hardClusters;
+	std::vector<uint32_t> cacheTime(vertices.size(), 0);
+	uint32_t timestamp = cacheSize + 1;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		uint32_t misses = 0;
+		for (size_t k = 0; k < 3; ++k) {
+			misses += accessCache(indices[t * 3 + k], cacheTime, timestamp, cacheSize) ? 1 : 0;
+		}
+		if (t == 0 || misses == 3) {
+			hardClusters.emplace_back(t);
+		}
+	}
+	hardClusters.emplace_back(triangleCount);
+	// Soft boundaries split hard clusters as soon as a cold cache start keeps the ACMR under the target
+	std::vector<size_t> clusters;
+	for (size_t c = 0; c + 1 < hardClusters.size(); ++c) {
+		size_t clusterStart = hardClusters[c];
+		size_t misses = 0;
+		timestamp += cacheSize + 1;
+		clusters.emplace_back(clusterStart);
+		for (size_t t = hardClusters[c]; t < hardClusters[c + 1]; ++t) {
+			for (size_t k = 0; k < 3; ++k) {
+				misses += accessCache(indices[t * 3 + k], cacheTime, timestamp, cacheSize) ? 1 : 0;
+			}
+			const size_t clusterTriangles = t - clusterStart + 1;
+			if (t + 1 < hardClusters[c + 1] && static_cast<float>(misses) <= targetAcmr * static_cast<float>(clusterTriangles)) {
+				clusterStart = t + 1;
+				misses = 0;
+				timestamp += cacheSize + 1;
+				clusters.emplace_back(clusterStart);
+			}
+		}
+	}
+	clusters.emplace_back(triangleCount);
+	// Sort clusters by how much they face away from the center of the mesh, those are likely to occlude the others
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		const glm::vec3& p0 = vertices[indices[t * 3]].position;
+		const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+		const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+		const float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+		meshCentroid += (p0 + p1 + p2) * (area / 3.0f);
+		meshArea += area;
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+	std::vector<std::pair<float, size_t>> sortKeys;
+	sortKeys.reserve(clusters.size() - 1);
+	for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float clusterArea = 0.0f;
+		for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+			const glm::vec3& p0 = vertices[indices[t * 3]].position;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+			const glm::vec3 weightedNormal = glm::cross(p1 - p0, p2 - p0);
+			const float area = glm::length(weightedNormal);
+			centroid += (p0 + p1 + p2) * (area / 3.0f);
+			normal += weightedNormal;
+			clusterArea += area;
+		}
+		centroid = clusterArea > 0.0f ? centroid / clusterArea : centroid;
+		const float normalLength = glm::length(normal);
+		const float key = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+		sortKeys.emplace_back(key, c);
+	}
+	std::stable_sort(sortKeys.begin(), sortKeys.end(), [](const auto& first, const auto& second) {
+		return first.first > second.first;
+	});
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (const auto& [key, c] : sortKeys) {
+		output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+	}
+	// Keep the original order if the clusters broke the cache too much
+	if (analyzeVertexCache(output, vertices.size(), cacheSize).acmr <= targetAcmr) {
+		indices.swap(output);
+	}
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+	for (uint32_t& index : indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = static_cast<uint32_t>(reordered.size());
+			reordered.emplace_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(reordered);
+}
+
+MeshOptimizer::OptimizationStatistics MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+	OptimizationStatistics statistics{ vertices.size(), vertices.size(), { 0.0f, 0.0f }, { 0.0f, 0.0f } };
+	if (indices.size() < 3 || indices.size() % 3 != 0) {
+		return statistics;
+	}
+	statistics.before = analyzeVertexCache(indices, vertices.size());
+	weldVertices(vertices, indices);
+	optimizeVertexCache(indices, vertices.size());
+	optimizeOverdraw(indices, vertices);
+	optimizeVertexFetch(vertices, indices);
+	statistics.verticesAfter = vertices.size();
+	statistics.after = analyzeVertexCache(indices, vertices.size());
+	return statistics;
+}
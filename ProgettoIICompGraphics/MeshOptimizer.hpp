@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Forward declaration of the vertex struct.
+ */
+struct Vertex;
+
+namespace MeshOptimizer {
+	// Size of the simulated post-transform vertex cache (FIFO)
+	static constexpr uint32_t CACHE_SIZE = 16;
+
+	/**
+	 * Post-transform vertex cache efficiency of an index buffer.
+	 */
+	struct CacheStatistics {
+		float acmr; /* Average cache miss ratio: transformed vertices per triangle */
+		float atvr; /* Average transform to vertex ratio: transformed vertices per referenced vertex */
+	};
+
+	/**
+	 * Effect of the whole optimization pipeline on a mesh.
+	 */
+	struct OptimizationStatistics {
+		size_t verticesBefore;
+		size_t verticesAfter;
+		CacheStatistics before;
+		CacheStatistics after;
+	};
+
+	/**
+	 * Simulates a FIFO vertex cache over a triangle list.
+	 *
+	 * \param indices The triangle list indices.
+	 * \param vertexCount The amount of vertices referenced by the indices.
+	 * \param cacheSize The amount of entries in the simulated cache.
+	 * \return The cache statistics.
+	 */
+	CacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, const size_t vertexCount, const uint32_t cacheSize = CACHE_SIZE);
+
+	/**
+	 * Merges vertices with the exact same attributes and remaps the indices.
+	 *
+	 * \param vertices The vertices to weld.
+	 * \param indices The indices to remap.
+	 */
+	void weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	/**
+	 * Reorders the triangles for the post-transform vertex cache (Tipsify).
+	 *
+	 * \param indices The triangle list indices to reorder.
+	 * \param vertexCount The amount of vertices referenced by the indices.
+	 * \param cacheSize The amount of entries in the targeted cache.
+	 */
+	void optimizeVertexCache(std::vector<uint32_t>& indices, const size_t vertexCount, const uint32_t cacheSize = CACHE_SIZE);
+
+	/**
+	 * Splits a cache optimized triangle list in clusters and sorts them so outward facing ones are drawn first.
+	 * The reorder is discarded if the ACMR gets worse than the threshold allows.
+	 *
+	 * \param indices The triangle list indices to reorder, should already be cache optimized.
+	 * \param vertices The vertices referenced by the indices.
+	 * \param threshold The maximum allowed ACMR increase (1.05 = 5%).
+	 * \param cacheSize The amount of entries in the targeted cache.
+	 */
+	void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const float threshold = 1.05f, const uint32_t cacheSize = CACHE_SIZE);
+
+	/**
+	 * Reorders the vertices in the order they are first used by the indices, unused vertices are removed.
+	 *
+	 * \param vertices The vertices to reorder.
+	 * \param indices The indices to remap.
+	 */
+	void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	/**
+	 * Runs the whole optimization pipeline on a triangle list.
+	 *
+	 * \param vertices The vertices of the mesh.
+	 * \param indices The triangle list indices of the mesh.
+	 * \return The vertices and the cache efficiency before and after, for the logs of the callers.
+	 */
+	OptimizationStatistics optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+}
@@ -0,0 +1,299 @@
+#include "MeshSimplifier.hpp"
+
+#include "MeshOptimizer.hpp"
+#include "Vertex.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace MeshSimplifier {
+	/**
+	 * Symmetric 4x4 matrix accumulating the squared distances to a set of planes, weighted by their area.
+	 */
+	struct Quadric {
+		double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+		double b2 = 0.0, bc = 0.0, bd = 0.0;
+		double c2 = 0.0, cd = 0.0;
+		double d2 = 0.0;
+		double weight = 0.0;
+
+		void add(const Quadric& other);
+		double evaluate(const glm::vec3& point) const;
+	};
+
+	/**
+	 * Candidate collapse of the vertex "from" onto the vertex "to".
+	 */
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	/**
+	 * Working state of a simplification, kept between levels of detail so the quadrics keep the full history.
+	 */
+	struct Simplification {
+		const std::vector<Vertex>& vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Quadric> quadrics = {};
+		std::vector<bool> locked = {};
+		float error = 0.0f;
+	};
+
+	/**
+	 * Hashes the raw bytes of a position.
+	 */
+	struct PositionHash {
+		size_t operator()(const glm::vec3& position) const {
+			uint32_t bits[3];
+			std::memcpy(bits, &position, sizeof(bits));
+			return (static_cast<size_t>(bits[0]) * 73856093u) ^ (static_cast<size_t>(bits[1]) * 19349663u) ^ (static_cast<size_t>(bits[2]) * 83492791u);
+		}
+	};
+
+	/**
+	 * Creates the quadric of the plane of a triangle.
+	 *
+	 * \param p0 First vertex of the triangle.
+	 * \param p1 Second vertex of the triangle.
+	 * \param p2 Third vertex of the triangle.
+	 * \return The quadric weighted by the triangle's area.
+	 */
+	static Quadric planeQuadric(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2);
+
+	/**
+	 * Sets up the quadrics and the locked vertices of a simplification.
+	 *
+	 * \param state The simplification to initialize.
+	 */
+	static void initialize(Simplification& state);
+
+	/**
+	 * Collapses edges until the index count is reached or no collapse is left.
+	 *
+	 * \param state The simplification to advance.
+	 * \param targetIndexCount The amount of indices to reach.
+	 */
+	static void collapseUntil(Simplification& state, const size_t targetIndexCount);
+}
+
+void MeshSimplifier::Quadric::add(const Quadric& other) {
+	a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+	b2 += other.b2; bc += other.bc; bd += other.bd;
+	c2 += other.c2; cd += other.cd;
+	d2 += other.d2;
+	weight += other.weight;
+}
+
+double MeshSimplifier::Quadric::evaluate(const glm::vec3& point) const {
+	const double x = point.x, y = point.y, z = point.z;
+	const double result = a2 * x * x + b2 * y * y + c2 * z * z
+		+ 2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z)
+		+ d2;
+	return result > 0.0 ? result : 0.0;
+}
+
+MeshSimplifier::Quadric MeshSimplifier::planeQuadric(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+	Quadric quadric;
+	const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+	const float length = glm::length(normal);
+	if (length <= 0.0f) {
+		return quadric;
+	}
+	const double area = 0.5 * length;
+	const double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+	const double d = -(a * p0.x + b * p0.y + c * p0.z);
+	quadric.a2 = a * a * area; quadric.ab = a * b * area; quadric.ac = a * c * area; quadric.ad = a * d * area;
+	quadric.b2 = b * b * area; quadric.bc = b * c * area; quadric.bd = b * d * area;
+	quadric.c2 = c * c * area; quadric.cd = c * d * area;
+	quadric.d2 = d * d * area;
+	quadric.weight = area;
+	return quadric;
+}
+
+void MeshSimplifier::initialize(Simplification& state) {
+	const size_t vertexCount = state.vertices.size();
+	state.quadrics.assign(vertexCount, Quadric());
+	state.locked.assign(vertexCount, false);
+	for (size_t i = 0; i + 2 < state.indices.size(); i += 3) {
+		const uint32_t i0 = state.indices[i], i1 = state.indices[i + 1], i2 = state.indices[i + 2];
+		const Quadric quadric = planeQuadric(state.vertices[i0].position, state.vertices[i1].position, state.vertices[i2].position);
+		state.quadrics[i0].add(quadric);
+		state.quadrics[i1].add(quadric);
+		state.quadrics[i2].add(quadric);
+	}
+	// Lock vertices sharing their position with another one (uv or normal seams)
+	std::unordered_map<glm::vec3, uint32_t, PositionHash> positionOwners;
+	positionOwners.reserve(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v) {
+		const auto [it, inserted] = positionOwners.emplace(state.vertices[v].position, v);
+		if (!inserted) {
+			state.locked[v] = true;
+			state.locked[it->second] = true;
+		}
+	}
+	// Lock vertices on open borders (edges used by a single triangle)
+	std::unordered_map<uint64_t, uint32_t> edgeUses;
+	edgeUses.reserve(state.indices.size());
+	for (size_t i = 0; i + 2 < state.indices.size(); i += 3) {
+		for (size_t k = 0; k < 3; ++k) {
+			const uint32_t a = state.indices[i + k], b = state.indices[i + (k + 1) % 3];
+			const uint64_t key = (static_cast<uint64_t>(glm::min(a, b)) << 32) | glm::max(a, b);
+			++edgeUses[key];
+		}
+	}
+	for (const auto& [key, uses] : edgeUses) {
+		if (uses == 1) {
+			state.locked[static_cast<uint32_t>(key >> 32)] = true;
+			state.locked[static_cast<uint32_t>(key & 0xFFFFFFFFu)] = true;
+		}
+	}
+}
+
+void MeshSimplifier::collapseUntil(Simplification& state, const size_t targetIndexCount) {
+	const size_t vertexCount = state.vertices.size();
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<uint32_t> collapseTarget(vertexCount);
+	std::vector<bool> touched(vertexCount);
+	while (state.indices.size() > targetIndexCount) {
+		const size_t triangleCount = state.indices.size() / 3;
+		// Gather every directed edge starting from a free vertex
+		collapses.clear();
+		for (size_t i = 0; i < state.indices.size(); i += 3) {
+			for (size_t k = 0; k < 3; ++k) {
+				const uint32_t a = state.indices[i + k], b = state.indices[i + (k + 1) % 3];
+				if (!state.locked[a]) {
+					collapses.emplace_back(Collapse{ a, b, 0.0 });
+				}
+				if (!state.locked[b]) {
+					collapses.emplace_back(Collapse{ b, a, 0.0 });
+				}
+			}
+		}
+		for (Collapse& collapse : collapses) {
+			Quadric quadric = state.quadrics[collapse.from];
+			quadric.add(state.quadrics[collapse.to]);
+			collapse.cost = quadric.weight > 0.0 ? quadric.evaluate(state.vertices[collapse.to].position) / quadric.weight : 0.0;
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& first, const Collapse& second) {
+			return first.cost < second.cost;
+		});
+		// Vertex to triangle adjacency for the flip checks
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (const uint32_t index : state.indices) {
+			++adjacencyOffsets[index + 1];
+		}
+		for (size_t v = 0; v < vertexCount; ++v) {
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+		adjacency.resize(state.indices.size());
+		std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < state.indices.size(); ++i) {
+			adjacency[adjacencyFill[state.indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+		// Apply the cheapest collapses, each one freezes the neighbourhood of the moved vertex until the next pass
+		for (uint32_t v = 0; v < vertexCount; ++v) {
+			collapseTarget[v] = v;
+		}
+		std::fill(touched.begin(), touched.end(), false);
+		const size_t trianglesToRemove = (state.indices.size() - targetIndexCount) / 3;
+		size_t removedTriangles = 0;
+		size_t appliedCollapses = 0;
+		for (const Collapse& collapse : collapses) {
+			if (removedTriangles >= trianglesToRemove) {
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to]) {
+				continue;
+			}
+			// Reject collapses that would flip a triangle
+			bool flips = false;
+			size_t degenerateTriangles = 0;
+			const glm::vec3& target = state.vertices[collapse.to].position;
+			for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flips; ++a) {
+				const uint32_t* triangle = &state.indices[static_cast<size_t>(adjacency[a]) * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+					++degenerateTriangles;
+					continue;
+				}
+				const glm::vec3& p0 = state.vertices[triangle[0]].position;
+				const glm::vec3& p1 = state.vertices[triangle[1]].position;
+				const glm::vec3& p2 = state.vertices[triangle[2]].position;
+				const glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+				const glm::vec3 q0 = triangle[0] == collapse.from ? target : p0;
+				const glm::vec3 q1 = triangle[1] == collapse.from ? target : p1;
+				const glm::vec3 q2 = triangle[2] == collapse.from ? target : p2;
+				const glm::vec3 after = glm::cross(q1 - q0, q2 - q0);
+				flips = glm::dot(before, after) <= 0.0f;
+			}
+			if (flips) {
+				continue;
+			}
+			for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; ++a) {
+				const uint32_t* triangle = &state.indices[static_cast<size_t>(adjacency[a]) * 3];
+				touched[triangle[0]] = true;
+				touched[triangle[1]] = true;
+				touched[triangle[2]] = true;
+			}
+			collapseTarget[collapse.from] = collapse.to;
+			state.quadrics[collapse.to].add(state.quadrics[collapse.from]);
+			state.error = glm::max(state.error, static_cast<float>(std::sqrt(collapse.cost)));
+			removedTriangles += degenerateTriangles;
+			++appliedCollapses;
+		}
+		if (appliedCollapses == 0) {
+			break;
+		}
+		// Rewrite the indices and drop the collapsed triangles
+		size_t writeIndex = 0;
+		for (size_t t = 0; t < triangleCount; ++t) {
+			const uint32_t i0 = collapseTarget[state.indices[t * 3]];
+			const uint32_t i1 = collapseTarget[state.indices[t * 3 + 1]];
+			const uint32_t i2 = collapseTarget[state.indices[t * 3 + 2]];
+			if (i0 == i1 || i1 == i2 || i0 == i2) {
+				continue;
+			}
+			state.indices[writeIndex++] = i0;
+			state.indices[writeIndex++] = i1;
+			state.indices[writeIndex++] = i2;
+		}
+		state.indices.resize(writeIndex);
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const size_t targetIndexCount, float* resultError) {
+	Simplification state{ vertices, indices };
+	initialize(state);
+	collapseUntil(state, targetIndexCount);
+	if (resultError) {
+		*resultError = state.error;
+	}
+	return state.indices;
+}
+
+std::vector<Mesh::Lod> MeshSimplifier::generateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const uint32_t lodCount) {
+	std::vector<Mesh::Lod> lods;
+	lods.emplace_back(Mesh::Lod{ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+	if (indices.size() < 3 || indices.size() % 3 != 0) {
+		return lods;
+	}
+	Simplification state{ vertices, indices };
+	initialize(state);
+	for (uint32_t level = 1; level < lodCount; ++level) {
+		const size_t previousCount = lods.back().indexCount;
+		collapseUntil(state, (previousCount / 6) * 3);
+		// Stop once the simplification gets stuck on locked vertices
+		if (state.indices.size() * 10 > previousCount * 9) {
+			break;
+		}
+		std::vector<uint32_t> levelIndices = state.indices;
+		MeshOptimizer::optimizeVertexCache(levelIndices, vertices.size());
+		lods.emplace_back(Mesh::Lod{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(levelIndices.size()), state.error });
+		indices.insert(indices.end(), levelIndices.begin(), levelIndices.end());
+	}
+	return lods;
+}
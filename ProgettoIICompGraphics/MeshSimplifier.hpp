@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Mesh.hpp"
+#include <vector>
+
+/**
+ * Forward declaration of the vertex struct.
+ */
+struct Vertex;
+
+namespace MeshSimplifier {
+	// Maximum amount of levels of detail generated for a mesh, the full detail one included
+	static constexpr uint32_t MAX_LODS = 4;
+
+	/**
+	 * Simplifies a triangle list with quadric error metrics by collapsing edges onto existing vertices,
+	 * so the result can be drawn with the original vertex buffer.
+	 * Vertices on open borders and on attribute seams are never moved to avoid cracks.
+	 *
+	 * \param vertices The vertices of the mesh.
+	 * \param indices The triangle list indices to simplify.
+	 * \param targetIndexCount The amount of indices to reach, the result may have more if no collapse is possible.
+	 * \param resultError Optional output for the object space deviation of the result.
+	 * \return The simplified triangle list indices.
+	 */
+	std::vector<uint32_t> simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const size_t targetIndexCount, float* resultError = nullptr);
+
+	/**
+	 * Generates levels of detail for a mesh and appends their indices to the index vector.
+	 * Every level halves the triangle count of the previous one, levels that barely reduce it are dropped.
+	 *
+	 * \param vertices The vertices of the mesh.
+	 * \param indices The full detail triangle list indices, the levels are appended to it.
+	 * \param lodCount The maximum amount of levels, the full detail one included.
+	 * \return The index ranges of every level, starting with the full detail one.
+	 */
+	std::vector<Mesh::Lod> generateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const uint32_t lodCount = MAX_LODS);
+}
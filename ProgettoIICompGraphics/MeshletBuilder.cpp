@@ -0,0 +1,174 @@
+#include "MeshletBuilder.hpp"
+
+#include "Vertex.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace MeshletBuilder {
+	/**
+	 * Computes the bounding sphere and the normal cone of a range of triangles.
+	 *
+	 * \param vertices The vertices of the mesh.
+	 * \param indices The triangle list indices of the mesh.
+	 * \param normals The unit normal of every triangle of the range, zero for degenerate ones.
+	 * \param indexOffset The first index of the range.
+	 * \param indexCount The amount of indices of the range.
+	 * \return The meshlet covering the range.
+	 */
+	static Mesh::Meshlet computeMeshlet(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& normals, const uint32_t indexOffset, const uint32_t indexCount);
+}
+
+Mesh::Meshlet MeshletBuilder::computeMeshlet(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& normals, const uint32_t indexOffset, const uint32_t indexCount) {
+	Mesh::Meshlet meshlet{ glm::vec3(0.0f), 0.0f, glm::vec3(0.0f), 1.0f, indexOffset, indexCount };
+	// Bounding sphere around the center of the bounding box
+	glm::vec3 minValues(std::numeric_limits<float>::max());
+	glm::vec3 maxValues(std::numeric_limits<float>::lowest());
+	for (uint32_t i = indexOffset; i < indexOffset + indexCount; ++i) {
+		minValues = glm::min(minValues, vertices[indices[i]].position);
+		maxValues = glm::max(maxValues, vertices[indices[i]].position);
+	}
+	meshlet.center = (minValues + maxValues) * 0.5f;
+	for (uint32_t i = indexOffset; i < indexOffset + indexCount; ++i) {
+		meshlet.radius = glm::max(meshlet.radius, glm::distance(meshlet.center, vertices[indices[i]].position));
+	}
+	// Normal cone around the average normal
+	glm::vec3 normalSum(0.0f);
+	for (uint32_t triangle = 0; triangle < indexCount / 3; ++triangle) {
+		normalSum += normals[triangle];
+	}
+	if (glm::length(normalSum) <= 1e-6f) {
+		return meshlet;
+	}
+	meshlet.coneAxis = glm::normalize(normalSum);
+	float minDot = 1.0f;
+	for (uint32_t triangle = 0; triangle < indexCount / 3; ++triangle) {
+		if (normals[triangle] != glm::vec3(0.0f)) {
+			minDot = glm::min(minDot, glm::dot(normals[triangle], meshlet.coneAxis));
+		}
+	}
+	// Normals spread over more than ~84 degrees leave too few view directions to cull from
+	if (minDot > 0.1f) {
+		meshlet.coneCutoff = glm::sqrt(1.0f - minDot * minDot);
+	}
+	return meshlet;
+}
+
+std::vector<Mesh::Meshlet> MeshletBuilder::buildMeshlets(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const Mesh::Lod& lod) {
+	std::vector<Mesh::Meshlet> meshlets;
+	const uint32_t triangleCount = lod.indexCount / 3;
+	if (triangleCount <= MAX_TRIANGLES) {
+		return meshlets;
+	}
+	const uint32_t* source = indices.data() + lod.indexOffset;
+	// Facing of every triangle
+	std::vector<glm::vec3> triangleNormals(triangleCount, glm::vec3(0.0f));
+	for (uint32_t triangle = 0; triangle < triangleCount; ++triangle) {
+		const glm::vec3& p0 = vertices[source[triangle * 3]].position;
+		const glm::vec3 normal = glm::cross(vertices[source[triangle * 3 + 1]].position - p0, vertices[source[triangle * 3 + 2]].position - p0);
+		const float length = glm::length(normal);
+		if (length > 0.0f) {
+			triangleNormals[triangle] = normal / length;
+		}
+	}
+	// Triangles around every vertex
+	std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1, 0);
+	for (uint32_t i = 0; i < lod.indexCount; ++i) {
+		++adjacencyOffsets[source[i] + 1];
+	}
+	for (size_t i = 1; i < adjacencyOffsets.size(); ++i) {
+		adjacencyOffsets[i] += adjacencyOffsets[i - 1];
+	}
+	std::vector<uint32_t> adjacency(lod.indexCount);
+	std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (uint32_t i = 0; i < lod.indexCount; ++i) {
+		adjacency[adjacencyFill[source[i]]++] = i / 3;
+	}
+	// Grow the meshlets
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<bool> inMeshlet(vertices.size(), false);
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint32_t> reorderedIndices;
+	std::vector<glm::vec3> reorderedNormals;
+	reorderedIndices.reserve(lod.indexCount);
+	reorderedNormals.reserve(triangleCount);
+	glm::vec3 normalSum(0.0f);
+	uint32_t meshletStart = 0;
+	uint32_t nextSeed = 0;
+	const auto closeMeshlet = [&]() {
+		const uint32_t start = meshletStart * 3;
+		const uint32_t count = static_cast<uint32_t>(reorderedIndices.size()) - start;
+		const std::vector<glm::vec3> normals(reorderedNormals.begin() + meshletStart, reorderedNormals.end());
+		Mesh::Meshlet meshlet = computeMeshlet(vertices, reorderedIndices, normals, start, count);
+		meshlet.indexOffset += lod.indexOffset;
+		meshlets.emplace_back(meshlet);
+		for (const uint32_t vertex : meshletVertices) {
+			inMeshlet[vertex] = false;
+		}
+		meshletVertices.clear();
+		normalSum = glm::vec3(0.0f);
+		meshletStart = static_cast<uint32_t>(reorderedNormals.size());
+	};
+	const auto newVertexCount = [&](const uint32_t triangle) {
+		uint32_t count = 0;
+		for (uint32_t corner = 0; corner < 3; ++corner) {
+			count += inMeshlet[source[triangle * 3 + corner]] ? 0 : 1;
+		}
+		return count;
+	};
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+		// Prefer adjacent triangles that add few vertices and face like the rest of the meshlet
+		int64_t best = -1;
+		uint32_t bestNewVertices = 4;
+		float bestDot = -2.0f;
+		const glm::vec3 axis = glm::length(normalSum) > 1e-6f ? glm::normalize(normalSum) : glm::vec3(0.0f);
+		for (const uint32_t vertex : meshletVertices) {
+			for (uint32_t i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; ++i) {
+				const uint32_t triangle = adjacency[i];
+				if (emitted[triangle]) {
+					continue;
+				}
+				const uint32_t newVertices = newVertexCount(triangle);
+				if (meshletVertices.size() + newVertices > MAX_VERTICES) {
+					continue;
+				}
+				const float facing = glm::dot(triangleNormals[triangle], axis);
+				if (newVertices < bestNewVertices || (newVertices == bestNewVertices && facing > bestDot)) {
+					best = triangle;
+					bestNewVertices = newVertices;
+					bestDot = facing;
+				}
+			}
+		}
+		// Nothing connected left, start over from the next triangle in the cache optimized order
+		if (best < 0) {
+			while (emitted[nextSeed]) {
+				++nextSeed;
+			}
+			const bool halfFull = (reorderedNormals.size() - meshletStart) * 2 >= MAX_TRIANGLES;
+			if (!meshletVertices.empty() && (halfFull || meshletVertices.size() + newVertexCount(nextSeed) > MAX_VERTICES)) {
+				closeMeshlet();
+			}
+			best = nextSeed;
+		}
+		const uint32_t triangle = static_cast<uint32_t>(best);
+		emitted[triangle] = true;
+		for (uint32_t corner = 0; corner < 3; ++corner) {
+			const uint32_t vertex = source[triangle * 3 + corner];
+			if (!inMeshlet[vertex]) {
+				inMeshlet[vertex] = true;
+				meshletVertices.emplace_back(vertex);
+			}
+			reorderedIndices.emplace_back(vertex);
+		}
+		reorderedNormals.emplace_back(triangleNormals[triangle]);
+		normalSum += triangleNormals[triangle];
+		if (reorderedNormals.size() - meshletStart == MAX_TRIANGLES || meshletVertices.size() + 1 > MAX_VERTICES) {
+			closeMeshlet();
+		}
+	}
+	if (!meshletVertices.empty()) {
+		closeMeshlet();
+	}
+	std::copy(reorderedIndices.begin(), reorderedIndices.end(), indices.begin() + lod.indexOffset);
+	return meshlets;
+}
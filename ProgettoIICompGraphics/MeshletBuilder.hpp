@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Mesh.hpp"
+#include <vector>
+
+/**
+ * Forward declaration of the vertex struct.
+ */
+struct Vertex;
+
+namespace MeshletBuilder {
+	// Limits of a single meshlet
+	static constexpr uint32_t MAX_VERTICES = 64;
+	static constexpr uint32_t MAX_TRIANGLES = 124;
+
+	/**
+	 * Splits a level of detail in meshlets, growing each one over adjacent triangles that face the same way.
+	 * The level's indices are reordered so every meshlet is a contiguous range.
+	 * Meshes that fit in a single meshlet get none, as culling them is the same as culling the whole mesh.
+	 *
+	 * \param vertices The vertices of the mesh.
+	 * \param indices The triangle list indices of the mesh, the level's range is reordered.
+	 * \param lod The level to split.
+	 * \return The meshlets with their bounding sphere and normal cone.
+	 */
+	std::vector<Mesh::Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const Mesh::Lod& lod);
+}
@@ -0,0 +1,123 @@
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Parallel {
+	/**
+	 * Worker threads kept for the whole run, woken up for every range and put back to sleep once it is done.
+	 */
+	struct Pool {
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		const std::function<void(size_t)>* task = nullptr;
+		size_t count = 0;
+		size_t chunkSize = CHUNK_SIZE;
+		std::atomic<size_t> next{ 0 };
+		uint64_t generation = 0; /* Increased for every range, the workers wait for a new one */
+		size_t busyWorkers = 0; /* Workers still on the current range */
+		bool stopping = false;
+
+		/**
+		 * Stops and joins the workers at exit.
+		 *
+		 */
+		~Pool();
+	};
+
+	static Pool pool;
+	// Serializes the ranges started from different threads
+	static std::mutex rangeMutex;
+	// Set on the threads running a task, nested ranges run serially instead of waiting on the busy pool
+	static thread_local bool insideTask = false;
+
+	/**
+	 * Takes chunks of the current range until none is left.
+	 *
+	 */
+	static void runChunks();
+
+	/**
+	 * Loop of a worker thread, runs the chunks of every new range until the pool stops.
+	 *
+	 */
+	static void workerLoop();
+}
+
+Parallel::Pool::~Pool() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->wake.notify_all();
+	for (std::thread& worker : this->workers) {
+		worker.join();
+	}
+}
+
+void Parallel::runChunks() {
+	for (size_t begin = pool.next.fetch_add(pool.chunkSize); begin < pool.count; begin = pool.next.fetch_add(pool.chunkSize)) {
+		for (size_t i = begin; i < std::min(begin + pool.chunkSize, pool.count); ++i) {
+			(*pool.task)(i);
+		}
+	}
+}
+
+void Parallel::workerLoop() {
+	insideTask = true;
+	uint64_t generation = 0;
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	while (true) {
+		pool.wake.wait(lock, [&generation]() { return pool.stopping || pool.generation != generation; });
+		if (pool.stopping) {
+			return;
+		}
+		generation = pool.generation;
+		lock.unlock();
+		runChunks();
+		lock.lock();
+		if (--pool.busyWorkers == 0) {
+			pool.done.notify_one();
+		}
+	}
+}
+
+void Parallel::forEach(const size_t count, const std::function<void(size_t)>& task, const size_t chunkSize) {
+	// Small ranges don't pay for waking the threads
+	if (count <= chunkSize || insideTask) {
+		for (size_t i = 0; i < count; ++i) {
+			task(i);
+		}
+		return;
+	}
+	std::lock_guard<std::mutex> range(rangeMutex);
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	if (pool.workers.empty()) {
+		const size_t workerCount = static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)) - 1;
+		for (size_t i = 0; i < workerCount; ++i) {
+			pool.workers.emplace_back(workerLoop);
+		}
+	}
+	pool.task = &task;
+	pool.count = count;
+	pool.chunkSize = chunkSize;
+	pool.next = 0;
+	pool.busyWorkers = pool.workers.size();
+	++pool.generation;
+	lock.unlock();
+	pool.wake.notify_all();
+	insideTask = true;
+	runChunks();
+	insideTask = false;
+	// The task and the counters stay in use until every worker is back to sleep
+	lock.lock();
+	pool.done.wait(lock, []() { return pool.busyWorkers == 0; });
+	pool.task = nullptr;
+}
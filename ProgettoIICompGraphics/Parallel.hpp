@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace Parallel {
+	// Items taken at once by a worker thread
+	static constexpr size_t CHUNK_SIZE = 256;
+
+	/**
+	 * Runs a task over a range of items on every hardware thread, the calling thread included.
+	 * The worker threads are started by the first call and wait for the next range afterwards, so calling it every frame is cheap.
+	 * The items are handed out in chunks, so the task must be safe to run concurrently on different items.
+	 * Ranges of a single chunk, and ranges started from inside a task, run on the calling thread.
+	 *
+	 * \param count The amount of items.
+	 * \param task The task, called once per item.
+	 * \param chunkSize The items taken at once by a thread, lower it for few expensive items.
+	 */
+	void forEach(const size_t count, const std::function<void(size_t)>& task, const size_t chunkSize = CHUNK_SIZE);
+}
@@ -1,6 +1,8 @@
 #include "Primitives.hpp"
 
 #include "Mesh.hpp"
+#include "MeshChunker.hpp"
+#include "MeshOptimizer.hpp"
 #include "Vertex.hpp"
 #include <glad/glad.h>
 #include <glm/gtc/constants.hpp>
@@ -12,6 +14,15 @@ namespace Primitives {
      * \param indices The indices composing the mesh.
      */
     static void calculateTangentsAndBitangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+    /**
+     * Utility to generate the vertices and indices of a plane.
+     * \param resolution The amount of quads on each side.
+     * \param uvScale The scale of the texture coordinates.
+     * \param vertices The output vertices.
+     * \param indices The output indices.
+     */
+    static void buildPlane(const uint32_t resolution, const glm::vec2 uvScale, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
 }
 
 void Primitives::calculateTangentsAndBitangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
@@ -45,9 +56,9 @@ void Primitives::calculateTangentsAndBitangents(std::vector<Vertex>& vertices, c
     }
 }
 
-std::shared_ptr<Mesh> Primitives::generatePlane(const uint32_t resolution, const glm::vec2 uvScale) {
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
+void Primitives::buildPlane(const uint32_t resolution, const glm::vec2 uvScale, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    vertices.reserve(static_cast<size_t>(resolution + 1) * (resolution + 1));
+    indices.reserve(static_cast<size_t>(resolution) * resolution * 6);
     const float dx = 1.0f / resolution;
     const float dy = 1.0f / resolution;
     // Generate vertices
@@ -79,12 +90,33 @@ std::shared_ptr<Mesh> Primitives::generatePlane(const uint32_t resolution, const
         }
     }
     calculateTangentsAndBitangents(vertices, indices);
-    return std::make_shared<Mesh>(vertices, indices, GL_TRIANGLES);
+}
+
+std::shared_ptr<Mesh> Primitives::generatePlane(const uint32_t resolution, const glm::vec2 uvScale) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    buildPlane(resolution, uvScale, vertices, indices);
+    MeshOptimizer::optimize(vertices, indices);
+    return std::make_shared<Mesh>(std::move(vertices), std::move(indices), GL_TRIANGLES, Mesh::DataRetention::NONE, Mesh::VertexFormat::COMPACT);
+}
+
+std::vector<std::shared_ptr<Mesh>> Primitives::generateChunkedPlane(const uint32_t resolution, const glm::vec2 uvScale, const uint32_t maxChunkVertices, const Mesh::DataRetention retention) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    buildPlane(resolution, uvScale, vertices, indices);
+    std::vector<std::shared_ptr<Mesh>> chunks;
+    for (MeshChunker::Chunk& chunk : MeshChunker::split(vertices, indices, maxChunkVertices)) {
+        MeshOptimizer::optimize(chunk.vertices, chunk.indices);
+        chunks.emplace_back(std::make_shared<Mesh>(std::move(chunk.vertices), std::move(chunk.indices), GL_TRIANGLES, retention, Mesh::VertexFormat::COMPACT));
+    }
+    return chunks;
 }
 
 std::shared_ptr<Mesh> Primitives::generateCube(const uint32_t resolution, const glm::vec2 uvScale) {
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
+    vertices.reserve(static_cast<size_t>(resolution + 1) * (resolution + 1) * 6);
+    indices.reserve(static_cast<size_t>(resolution) * resolution * 36);
     // Calculate side length based on resolution
     const float sideLength = 1.0f / resolution;
     // Generate vertices for each face
@@ -166,12 +198,15 @@ std::shared_ptr<Mesh> Primitives::generateCube(const uint32_t resolution, const
         }
     }
     calculateTangentsAndBitangents(vertices, indices);
-    return std::make_shared<Mesh>(vertices, indices, GL_TRIANGLES);
+    MeshOptimizer::optimize(vertices, indices);
+    return std::make_shared<Mesh>(std::move(vertices), std::move(indices), GL_TRIANGLES, Mesh::DataRetention::NONE, Mesh::VertexFormat::COMPACT);
 }
 
 std::shared_ptr<Mesh> Primitives::generatePyramid(const uint32_t resolution, const glm::vec2 uvScale) {
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
+    vertices.reserve(static_cast<size_t>(resolution + 1) * (resolution + 1) + 12);
+    indices.reserve(static_cast<size_t>(resolution) * resolution * 6 + 12);
     const float height = 1.0f;
     const float halfBase = 0.5f;
     const glm::vec3 apex(0.0f, height, 0.0f);
@@ -238,12 +273,15 @@ std::shared_ptr<Mesh> Primitives::generatePyramid(const uint32_t resolution, con
         indices.emplace_back(baseIndex + 2);
     }
     calculateTangentsAndBitangents(vertices, indices);
-    return std::make_shared<Mesh>(vertices, indices, GL_TRIANGLES);
+    MeshOptimizer::optimize(vertices, indices);
+    return std::make_shared<Mesh>(std::move(vertices), std::move(indices), GL_TRIANGLES, Mesh::DataRetention::NONE, Mesh::VertexFormat::COMPACT);
 }
 
 std::shared_ptr<Mesh> Primitives::generateSphere(const uint32_t resolution, const glm::vec2 uvScale) {
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
+    vertices.reserve(static_cast<size_t>(resolution + 1) * (resolution + 1));
+    indices.reserve(static_cast<size_t>(resolution) * resolution * 6);
     for (uint32_t lat = 0; lat <= resolution; ++lat) {
         const float theta = glm::pi<float>() * lat / resolution;
         const float sinTheta = std::sin(theta);
@@ -271,12 +309,15 @@ std::shared_ptr<Mesh> Primitives::generateSphere(const uint32_t resolution, cons
         }
     }
     calculateTangentsAndBitangents(vertices, indices);
-    return std::make_shared<Mesh>(vertices, indices, GL_TRIANGLES);
+    MeshOptimizer::optimize(vertices, indices);
+    return std::make_shared<Mesh>(std::move(vertices), std::move(indices), GL_TRIANGLES, Mesh::DataRetention::NONE, Mesh::VertexFormat::COMPACT);
 }
 
 std::shared_ptr<Mesh> Primitives::generateCylinder(const float bottomRadius, const float topRadius, const float length, const uint32_t slices, const uint32_t stacks, const glm::vec2 uvScale) {
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
+    vertices.reserve(static_cast<size_t>(slices) * (stacks + 1) + 2);
+    indices.reserve(static_cast<size_t>(slices) * (stacks + 1) * 6);
     // Calculate step sizes for slicing and stacking
     const float sliceStep = glm::pi<float>() * 2.0f / slices;
     const float heightStep = length / stacks;
@@ -335,7 +376,8 @@ std::shared_ptr<Mesh> Primitives::generateCylinder(const float bottomRadius, con
         indices.emplace_back(baseIndex + i);
     }
     calculateTangentsAndBitangents(vertices, indices);
-    return std::make_shared<Mesh>(vertices, indices, GL_TRIANGLES);
+    MeshOptimizer::optimize(vertices, indices);
+    return std::make_shared<Mesh>(std::move(vertices), std::move(indices), GL_TRIANGLES, Mesh::DataRetention::NONE, Mesh::VertexFormat::COMPACT);
 }
 
 std::shared_ptr<Mesh> Primitives::generateCone(const float radius, const float length, const int slices, const int stacks, const glm::vec2 uvScale) {
@@ -345,6 +387,8 @@ std::shared_ptr<Mesh> Primitives::generateCone(const float radius, const float l
 std::shared_ptr<Mesh> Primitives::generateThorus(const float innerRadius, const float circleRadius, const uint32_t resCircle, const uint32_t resSteps, const glm::vec2 uvScale) {
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
+	vertices.reserve(static_cast<size_t>(resSteps + 1) * (resCircle + 1));
+	indices.reserve(static_cast<size_t>(resSteps) * resCircle * 6);
     const float stepCircle = glm::two_pi<float>() / resCircle; // Angle step for the circle
     const float stepSteps = glm::two_pi<float>() / resSteps;   // Angle step for the torus
     for (uint32_t i = 0; i <= resSteps; ++i) {
@@ -384,5 +428,6 @@ std::shared_ptr<Mesh> Primitives::generateThorus(const float innerRadius, const
         }
     }
     calculateTangentsAndBitangents(vertices, indices);
-	return std::make_shared<Mesh>(vertices, indices, GL_TRIANGLES);
+	MeshOptimizer::optimize(vertices, indices);
+	return std::make_shared<Mesh>(std::move(vertices), std::move(indices), GL_TRIANGLES, Mesh::DataRetention::NONE, Mesh::VertexFormat::COMPACT);
 }
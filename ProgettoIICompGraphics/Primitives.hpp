@@ -1,13 +1,20 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <memory>
+#include <vector>
 
 /**
  * Forward declaration of the mesh class.
  */
 class Mesh;
 
+/**
+ * Forward declaration of the policy for the CPU side copies of a mesh.
+ */
+enum class MeshDataRetention : uint8_t;
+
 namespace Primitives {
 	/**
 	 * Generates a heap allocated plane.
@@ -18,6 +25,17 @@ namespace Primitives {
 	 */
 	std::shared_ptr<Mesh> generatePlane(const uint32_t resolution = 1, const glm::vec2 uvScale = glm::vec2(1.0f));
 
+	/**
+	 * Generates a heap allocated plane split in a grid of chunks, so each piece can be culled and sorted on its own.
+	 * 
+	 * \param resolution The amount of subdivisions of the plane.
+	 * \param uvScale Scales the uvs by that amount.
+	 * \param maxChunkVertices The amount of vertices above which the plane is split, and roughly the size of each chunk.
+	 * \param retention What data the chunks keep on the CPU after the upload.
+	 * \return The chunks of the plane.
+	 */
+	std::vector<std::shared_ptr<Mesh>> generateChunkedPlane(const uint32_t resolution, const glm::vec2 uvScale, const uint32_t maxChunkVertices, const MeshDataRetention retention);
+
 	/**
 	 * Generates a heap allocated cube.
 	 *
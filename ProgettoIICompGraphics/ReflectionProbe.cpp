@@ -0,0 +1,119 @@
+#include "ReflectionProbe.hpp"
+
+#include "CubemapPrefilter.hpp"
+#include "FrameBuffer.hpp"
+#include "TextureCubemap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+static constexpr uint32_t ALL_FACES = (1u << ReflectionProbe::FACE_COUNT) - 1;
+
+ReflectionProbe::ReflectionProbe(const std::string& _name, const Transform& _transform, const float _radius, const int32_t resolution, const std::shared_ptr<SceneNode>& parent)
+	:
+	SceneNode(_name, _transform, parent),
+	cubemap(std::make_unique<TextureCubemap>()),
+	frameBuffer(std::make_unique<FrameBuffer>(resolution, resolution, std::vector<int32_t>{ GL_RGB8 })),
+	radius(_radius),
+	staleFaces(ALL_FACES),
+	capturedFaces(0),
+	contentKey(0)
+{
+	for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+		this->cubemap->uploadLevel(resolution, nullptr, face, 0);
+	}
+	// As many levels as the prefiltered sky, so the materials pick the same blur for their roughness
+	const int32_t maxLevel = std::min(static_cast<int32_t>(CubemapPrefilter::LEVEL_COUNT) - 1, static_cast<int32_t>(std::log2(static_cast<float>(resolution))));
+	this->cubemap->setParameter(GL_TEXTURE_MAX_LEVEL, maxLevel);
+	this->cubemap->setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	this->cubemap->unbind();
+}
+
+ReflectionProbe::~ReflectionProbe() = default;
+
+glm::vec3 ReflectionProbe::getPosition() const {
+	return glm::vec3(this->worldTransform.getTransformMatrix()[3]);
+}
+
+float ReflectionProbe::getRadius() const {
+	return this->radius;
+}
+
+int32_t ReflectionProbe::getResolution() const {
+	return this->frameBuffer->width;
+}
+
+bool ReflectionProbe::overlaps(const glm::vec3& minValues, const glm::vec3& maxValues) const {
+	const glm::vec3 position = this->getPosition();
+	return glm::distance(position, glm::clamp(position, minValues, maxValues)) <= this->radius;
+}
+
+glm::mat4 ReflectionProbe::getFaceViewMatrix(const uint32_t face) const {
+	const glm::vec3 position = this->getPosition();
+	return glm::lookAt(position, position + CubeFaces::DIRECTIONS[face], CubeFaces::UPS[face]);
+}
+
+glm::mat4 ReflectionProbe::getProjectionMatrix() const {
+	return glm::perspective(glm::radians(90.0f), 1.0f, NEAR_PLANE, this->radius);
+}
+
+bool ReflectionProbe::updateContentKey(const uint64_t key) {
+	if (key == this->contentKey) {
+		return false;
+	}
+	this->contentKey = key;
+	this->invalidate();
+	return true;
+}
+
+void ReflectionProbe::invalidate() {
+	this->staleFaces = ALL_FACES;
+}
+
+uint32_t ReflectionProbe::getStaleFaceCount() const {
+	uint32_t count = 0;
+	for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+		count += (this->staleFaces >> face) & 1u;
+	}
+	return count;
+}
+
+uint32_t ReflectionProbe::getNextStaleFace() const {
+	for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+		if (this->staleFaces & (1u << face)) {
+			return face;
+		}
+	}
+	return FACE_COUNT;
+}
+
+void ReflectionProbe::beginFace() const {
+	this->frameBuffer->bind();
+	glViewport(0, 0, this->frameBuffer->width, this->frameBuffer->height);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void ReflectionProbe::endFace(const uint32_t face) {
+	// The framebuffer is still bound for reading, copy it into the face
+	this->cubemap->bind();
+	glCopyTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, 0, 0, 0, 0, this->frameBuffer->width, this->frameBuffer->height);
+	this->staleFaces &= ~(1u << face);
+	this->capturedFaces |= 1u << face;
+	// The mip chain spans every face, build it once the last stale one is captured
+	if (this->staleFaces == 0) {
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	}
+	this->cubemap->unbind();
+	this->frameBuffer->unbind();
+}
+
+bool ReflectionProbe::isReady() const {
+	return this->capturedFaces == ALL_FACES;
+}
+
+const TextureCubemap* ReflectionProbe::getCubemap() const {
+	return this->cubemap.get();
+}
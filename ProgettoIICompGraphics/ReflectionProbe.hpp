@@ -0,0 +1,157 @@
+#pragma once
+
+#include "CubeFaces.hpp"
+#include "SceneNode.hpp"
+#include <glm/glm.hpp>
+#include <memory>
+
+/**
+ * Forward declaration of the framebuffer class.
+ */
+class FrameBuffer;
+
+/**
+ * Forward declaration of the cubemap texture class.
+ */
+class TextureCubemap;
+
+/**
+ * A point of the scene whose surroundings are captured in a cubemap, reflected by the objects inside its radius instead of the sky.
+ * The probe only stores the capture, the renderer draws its faces a few at a time (see Renderer::setProbeBudget) and
+ * marks them stale again when the objects inside the radius move or change.
+ */
+class ReflectionProbe : public SceneNode {
+public:
+	static constexpr int32_t DEFAULT_RESOLUTION = 128;
+	static constexpr uint32_t FACE_COUNT = CubeFaces::COUNT;
+	static constexpr float NEAR_PLANE = 0.05f;
+private:
+	std::unique_ptr<TextureCubemap> cubemap;
+	std::unique_ptr<FrameBuffer> frameBuffer;
+	float radius;
+	uint32_t staleFaces; /* Bit per face whose capture is out of date */
+	uint32_t capturedFaces; /* Bit per face captured at least once */
+	uint64_t contentKey; /* Hash of the objects inside the radius at the last check */
+public:
+	// Erase copy constructors, as it would break opengl
+	ReflectionProbe(const ReflectionProbe&) = delete;
+	ReflectionProbe& operator=(const ReflectionProbe&) = delete;
+
+	/**
+	 * Creates a probe and allocates its cubemap, every face starts stale.
+	 *
+	 * \param _name The node's name.
+	 * \param _transform The node's transform, only its position is used.
+	 * \param _radius The distance up to which the objects are captured and reflect the probe.
+	 * \param resolution The texels on each side of the faces.
+	 * \param parent The node's possible parent.
+	 */
+	ReflectionProbe(const std::string& _name, const Transform& _transform, const float _radius, const int32_t resolution = DEFAULT_RESOLUTION, const std::shared_ptr<SceneNode>& parent = nullptr);
+
+	/**
+	 * Destructor for the probe.
+	 *
+	 */
+	~ReflectionProbe();
+
+	/**
+	 * Getter for the world space position of the probe.
+	 *
+	 * \return The point the faces are captured from.
+	 */
+	glm::vec3 getPosition() const;
+
+	/**
+	 * Getter for the radius of the probe.
+	 *
+	 * \return The distance up to which the objects are captured.
+	 */
+	float getRadius() const;
+
+	/**
+	 * Getter for the resolution of the faces.
+	 *
+	 * \return The texels on each side of the faces.
+	 */
+	int32_t getResolution() const;
+
+	/**
+	 * Checks if a box reaches inside the radius of the probe.
+	 *
+	 * \param minValues The minimum corner of the box.
+	 * \param maxValues The maximum corner of the box.
+	 * \return True if the box is at least partly inside the radius.
+	 */
+	bool overlaps(const glm::vec3& minValues, const glm::vec3& maxValues) const;
+
+	/**
+	 * Getter for the view matrix of a face.
+	 *
+	 * \param face The face, in the OpenGL order (+X, -X, +Y, -Y, +Z, -Z).
+	 * \return The view matrix looking through the face.
+	 */
+	glm::mat4 getFaceViewMatrix(const uint32_t face) const;
+
+	/**
+	 * Getter for the projection matrix shared by the faces.
+	 *
+	 * \return The 90 degrees projection ending at the radius.
+	 */
+	glm::mat4 getProjectionMatrix() const;
+
+	/**
+	 * Compares the hash of the objects inside the radius with the last one, every face turns stale if it changed.
+	 *
+	 * \param key The hash of the objects currently inside the radius.
+	 * \return True if the content changed.
+	 */
+	bool updateContentKey(const uint64_t key);
+
+	/**
+	 * Marks every face as stale, so they get captured again.
+	 *
+	 */
+	void invalidate();
+
+	/**
+	 * Getter for the amount of faces to capture again.
+	 *
+	 * \return The stale faces.
+	 */
+	uint32_t getStaleFaceCount() const;
+
+	/**
+	 * Picks the next stale face to capture.
+	 *
+	 * \return The face, FACE_COUNT if none is stale.
+	 */
+	uint32_t getNextStaleFace() const;
+
+	/**
+	 * Binds the framebuffer of the faces and clears it, draw the face after it.
+	 *
+	 */
+	void beginFace() const;
+
+	/**
+	 * Copies the drawn framebuffer into a face and binds the default framebuffer back.
+	 * The cubemap's mip chain is updated once the last stale face is captured.
+	 *
+	 * \param face The face just drawn.
+	 */
+	void endFace(const uint32_t face);
+
+	/**
+	 * Checks if every face has been captured at least once, until then the sky is reflected instead.
+	 *
+	 * \return True if the cubemap can be sampled.
+	 */
+	bool isReady() const;
+
+	/**
+	 * Getter for the captured cubemap.
+	 *
+	 * \return The cubemap of the probe.
+	 */
+	const TextureCubemap* getCubemap() const;
+};
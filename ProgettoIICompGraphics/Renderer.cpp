@@ -1,11 +1,30 @@
 #include "Renderer.hpp"
 
+#include "BoundingBox.hpp"
+#include "EnvironmentLighting.hpp"
+#include "FrameBuffer.hpp"
+#include "Hash.hpp"
+#include "Hlod.hpp"
+#include "Impostor.hpp"
+#include "LightClusters.hpp"
+#include "Lightmap.hpp"
+#include "LightSystem.hpp"
 #include "MeshInstanceNode.hpp"
 #include "Material.hpp"
 #include "Mesh.hpp"
+#include "ReflectionProbe.hpp"
 #include "RenderingQueue.hpp"
 #include "Shader.hpp"
+#include "ShaderLoader.hpp"
+#include "ShadowAtlas.hpp"
+#include "Texture2D.hpp"
+#include "TextureCubemap.hpp"
+#include "VertexArray.hpp"
+#include "WaterClipmap.hpp"
+#include <algorithm>
 #include <glad/glad.h>
+#include <limits>
+#include <unordered_map>
 
 namespace Renderer {
 	// Rendering queues to render objects in a performant way
@@ -19,37 +38,443 @@ namespace Renderer {
 	static std::shared_ptr<Material> cubemapMaterial = nullptr;
 	static std::shared_ptr<Mesh> cubemapMesh = nullptr;
 
+	// Impostors and the instance each of their meshes belongs to
+	static std::vector<std::shared_ptr<Impostor>> impostors;
+	static std::unordered_map<const MeshInstanceNode*, std::pair<const Impostor*, size_t>> impostorInstances;
+	static float impostorDistance = 20.0f;
+
+	// Hierarchical levels of detail and the cluster each of their meshes belongs to
+	static std::vector<std::shared_ptr<Hlod>> hlods;
+	static std::unordered_map<const MeshInstanceNode*, std::pair<const Hlod*, size_t>> hlodClusters;
+	static float hlodDistance = 40.0f;
+
+	// Lightmap of the static objects and the instance each of its meshes belongs to
+	static std::shared_ptr<Lightmap> lightmap = nullptr;
+	static std::unordered_map<const MeshInstanceNode*, size_t> lightmapInstances;
+
+	// Water surface
+	static std::shared_ptr<WaterClipmap> water = nullptr;
+
+	// Reflection probes, a few of their stale faces are captured every frame with a cheap shader
+	static std::vector<std::shared_ptr<ReflectionProbe>> reflectionProbes;
+	static std::shared_ptr<Shader> probeShader = nullptr;
+	static float probeBudget = 1.0f;
+	static size_t checkedProbe = 0;
+	static size_t capturedProbe = 0;
+	static uint32_t capturedProbeFaces = 0;
+	// GPU time of the captures, read back a few frames later so the timer never stalls the pipeline
+	static constexpr uint32_t PROBE_QUERY_COUNT = 3;
+	static constexpr float PROBE_TIME_SMOOTHING = 0.2f;
+	static uint32_t probeQueries[PROBE_QUERY_COUNT] = {};
+	static uint32_t probeQueryFaces[PROBE_QUERY_COUNT] = {}; /* Faces captured inside each query */
+	static uint32_t probeQueryIndex = 0;
+	static float probeFaceTime = 0.0f; /* Average milliseconds per face, 0 until measured */
+
+	// Level of detail selection
+	static constexpr float LOD_PIXEL_ERROR = 1.0f;
+	static constexpr float LOD_HYSTERESIS = 0.75f;
+	static float lodBias = 1.0f;
+
+	// Meshlet culling
+	static bool meshletCulling = true;
+
+	// Deferred path, the opaque Blinn-Phong objects are drawn in a G-buffer and lit by a single screen pass
+	static RenderingQueue deferredQueue;
+	static bool deferredShading = false;
+	static std::unique_ptr<FrameBuffer> gBuffer = nullptr;
+	static std::shared_ptr<Shader> deferrableShader = nullptr;
+	static std::shared_ptr<Shader> gBufferShader = nullptr;
+	static std::shared_ptr<Shader> deferredLightShader = nullptr;
+	static std::unique_ptr<VertexArray> screenQuadVao = nullptr;
+	static uint32_t deferredObjectCount = 0;
+	// Diffuse and shininess, specular and lightmapped flag, ambient, octahedral normal, indirect light
+	static const std::vector<int32_t> GBUFFER_FORMATS = { GL_RGBA8, GL_RGBA8, GL_RGBA8, GL_RG16, GL_R11F_G11F_B10F };
+	static const char* GBUFFER_UNIFORMS[] = { "gDiffuse", "gSpecular", "gAmbient", "gNormal", "gIndirect" };
+
+	// Weighted blended transparency, the transparent objects accumulate in their own targets and are composited once
+	static bool orderIndependentTransparency = false;
+	static std::unique_ptr<FrameBuffer> transparencyBuffer = nullptr;
+	static std::shared_ptr<Shader> compositeShader = nullptr;
+	// Weighted premultiplied colors and revealage, sum of the weights
+	static const std::vector<int32_t> TRANSPARENCY_FORMATS = { GL_RGBA16F, GL_R16F };
+
+	// Reduced resolution transparency, the transparent materials with a resolution divisor are drawn in smaller targets
+	// against a downsampled opaque depth, then upsampled over the scene by the depth of their texels
+	struct ReducedTransparencyTarget {
+		RenderingQueue queue{ false };
+		std::unique_ptr<FrameBuffer> frameBuffer = nullptr;
+	};
+	static constexpr int32_t MAX_RESOLUTION_SHIFT = 2;
+	static bool reducedResolutionTransparency = true;
+	static ReducedTransparencyTarget reducedTargets[MAX_RESOLUTION_SHIFT]; /* Half and quarter resolution */
+	static std::unique_ptr<FrameBuffer> sceneDepthBuffer = nullptr;
+	static std::shared_ptr<Shader> downsampleShader = nullptr;
+	static std::shared_ptr<Shader> upsampleShader = nullptr;
+	// Premultiplied colors and coverage
+	static const std::vector<int32_t> REDUCED_TRANSPARENCY_FORMATS = { GL_RGBA8 };
+
+	// Statistics
+	static uint32_t drawnTriangles = 0;
+	static Mesh::CullingStatistics meshletStatistics = {};
+
 	/**
 	 * Method that sends all of the current objects to the rendering queues.
 	 * \param cameraMatrix The matrix of the camera to render the objects from.
+	 * \param projectionMatrix The projection matrix of the camera, used for the levels of detail.
+	 * \param viewPoint The view point in the scene.
+	 */
+	static void sendDataToQueues(const glm::mat4& cameraMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPoint);
+
+	/**
+	 * Picks the coarsest level of detail whose projected error stays under the threshold.
+	 * A node only switches to a coarser level once it is well under the threshold to avoid popping back and forth.
+	 *
+	 * \param renderable The node to pick the level for.
+	 * \param viewPoint The view point in the scene.
+	 * \param pixelsPerUnit Size in pixels of one world unit at a distance of one.
+	 * \param currentLevel The level the node was last drawn with.
+	 * \return The level of detail to draw.
+	 */
+	static uint32_t selectLod(const MeshInstanceNode* renderable, const glm::vec3& viewPoint, const float pixelsPerUnit, const uint32_t currentLevel);
+
+	/**
+	 * Draws the skybox behind everything, without writing depth.
+	 *
+	 * \param viewMatrix The view matrix of the camera.
+	 * \param projectionMatrix The projection matrix of the camera.
+	 */
+	static void drawSkybox(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+
+	/**
+	 * Picks the cubemap reflected by an object: the one of the closest captured probe around its center.
+	 *
+	 * \param box The world space bounds of the object.
+	 * \return The probe's cubemap, nullptr to reflect the sky.
+	 */
+	static const Texture* findReflections(const BoundingBox& box);
+
+	/**
+	 * Hashes the opaque objects inside the radius of a probe, any moved, added or changed object changes the hash.
+	 *
+	 * \param probe The probe to hash the content of.
+	 * \return The hash of the objects.
+	 */
+	static uint64_t hashProbeContent(const ReflectionProbe& probe);
+
+	/**
+	 * Checks a probe for changed content and captures stale faces until the budget is spent.
+	 *
+	 */
+	static void updateReflectionProbes();
+
+	/**
+	 * Draws a face of a probe: the skybox and the opaque lit objects inside its radius, lit by the sky and the lightmap only.
+	 *
+	 * \param probe The probe to capture.
+	 * \param face The face to capture.
+	 */
+	static void captureProbeFace(ReflectionProbe& probe, const uint32_t face);
+
+	/**
+	 * Draws the deferred queue in the G-buffer, then lights it in the current framebuffer with the lights of each pixel's cluster.
+	 * The light pass writes the depth of the G-buffer, so the forward passes after it are still tested against the objects.
+	 *
+	 * \param cameraMatrix The camera's combined matrix.
+	 * \param viewPoint The view point in the scene.
+	 */
+	static void renderDeferred(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint);
+
+	/**
+	 * Getter for an opaque queue.
+	 *
+	 * \param queue The queue to get.
+	 * \return The rendering queue.
+	 */
+	static RenderingQueue& getOpaqueQueue(const OPAQUE_QUEUE queue);
+
+	/**
+	 * Draws the water and the transparent queues in the targets of the weighted blended transparency, tested against
+	 * a copy of the opaque depth, then composites them over the current framebuffer.
+	 *
+	 * \param cameraMatrix The camera's combined matrix.
+	 * \param viewPoint The view point in the scene.
+	 */
+	static void renderWeightedTransparency(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint);
+
+	/**
+	 * Finds how much smaller than the screen a material is drawn.
+	 *
+	 * \param material The material to check.
+	 * \return Screen pixels per pixel of its target as a power of two, 0 if it is drawn at full resolution.
 	 */
-	static void sendDataToQueues(const glm::mat4& cameraMatrix);
+	static int32_t getResolutionShift(const Material* material);
+
+	/**
+	 * Draws the transparent objects with a resolution divisor in their reduced targets, tested against the farthest
+	 * opaque depth of their blocks, then upsamples every target over the current framebuffer.
+	 *
+	 * \param cameraMatrix The camera's combined matrix.
+	 * \param projectionMatrix The camera's projection matrix, to compare the depths in view space.
+	 * \param viewPoint The view point in the scene.
+	 */
+	static void renderReducedTransparency(const glm::mat4& cameraMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPoint);
 }
 
 void Renderer::addToRenderingQueues(MeshInstanceNode* renderable) {
 	renderingList.emplace_back(renderable);
 }
 
-void Renderer::sendDataToQueues(const glm::mat4& cameraMatrix) {
+uint32_t Renderer::selectLod(const MeshInstanceNode* renderable, const glm::vec3& viewPoint, const float pixelsPerUnit, const uint32_t currentLevel) {
+	const Mesh* mesh = renderable->getMesh();
+	if (mesh->getLodCount() <= 1) {
+		return 0;
+	}
+	// Measure from the closest point of the bounds, inside them the full detail is used
+	const BoundingBox bounds = renderable->getBoundingBox();
+	const float distance = glm::distance(viewPoint, glm::clamp(viewPoint, bounds.getMinValues(), bounds.getMaxValues()));
+	if (distance <= 0.0f) {
+		return 0;
+	}
+	// Errors are in object space, scale them by the largest axis of the node
+	const glm::mat4 worldMatrix = renderable->getWorldTransform().getTransformMatrix();
+	const float scale = glm::max(glm::length(glm::vec3(worldMatrix[0])), glm::max(glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2]))));
+	const float errorToPixels = scale / distance * pixelsPerUnit;
+	const float threshold = LOD_PIXEL_ERROR * lodBias;
+	uint32_t level = glm::min(currentLevel, mesh->getLodCount() - 1);
+	while (level > 0 && mesh->getLod(level).error * errorToPixels > threshold) {
+		--level;
+	}
+	while (level + 1 < mesh->getLodCount() && mesh->getLod(level + 1).error * errorToPixels <= threshold * LOD_HYSTERESIS) {
+		++level;
+	}
+	return level;
+}
+
+void Renderer::drawSkybox(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+	if (!cubemapMaterial || !cubemapMesh) {
+		return;
+	}
+	// Disable depth mask for cubemap and culling
+	glDisable(GL_CULL_FACE);
+	glDepthMask(GL_FALSE);
+	// Draw cubemap using material
+	cubemapMaterial->activate();
+	cubemapMaterial->getShader()->setUniform("projectionMatrix", projectionMatrix);
+	cubemapMaterial->getShader()->setUniform("viewMatrix", viewMatrix);
+	cubemapMesh->setDecodingUniforms(cubemapMaterial->getShader());
+	cubemapMesh->draw();
+	// Re-enable other stuff for rendering
+	glEnable(GL_CULL_FACE);
+	glDepthMask(GL_TRUE);
+}
+
+const Texture* Renderer::findReflections(const BoundingBox& box) {
+	const glm::vec3 center = (box.getMinValues() + box.getMaxValues()) * 0.5f;
+	const Texture* reflections = nullptr;
+	float closest = std::numeric_limits<float>::max();
+	for (const std::shared_ptr<ReflectionProbe>& probe : reflectionProbes) {
+		const float distance = glm::distance(center, probe->getPosition());
+		if (probe->isReady() && distance <= probe->getRadius() && distance < closest) {
+			reflections = probe->getCubemap();
+			closest = distance;
+		}
+	}
+	return reflections;
+}
+
+uint64_t Renderer::hashProbeContent(const ReflectionProbe& probe) {
+	// FNV-1a over the raw bytes
+	uint64_t key = Hash::FNV_OFFSET_BASIS;
+	const auto add = [&key](const void* data, const size_t size) {
+		key = Hash::fnv1a(data, size, key);
+	};
+	for (const MeshInstanceNode* renderable : renderingList) {
+		const Material* material = renderable->getMaterial().get();
+		if (!material->litFlag || material->transparentFlag) {
+			continue;
+		}
+		const BoundingBox box = renderable->getBoundingBox();
+		if (!probe.overlaps(box.getMinValues(), box.getMaxValues())) {
+			continue;
+		}
+		const Mesh* mesh = renderable->getMesh();
+		add(&renderable, sizeof(renderable));
+		add(&mesh, sizeof(mesh));
+		add(&material, sizeof(material));
+		add(&renderable->getWorldTransform().getTransformMatrix(), sizeof(glm::mat4));
+	}
+	return key;
+}
+
+void Renderer::captureProbeFace(ReflectionProbe& probe, const uint32_t face) {
+	const glm::mat4 viewMatrix = probe.getFaceViewMatrix(face);
+	const glm::mat4 projectionMatrix = probe.getProjectionMatrix();
+	const glm::mat4 cameraMatrix = projectionMatrix * viewMatrix;
+	const glm::vec3 position = probe.getPosition();
+	const float pixelsPerUnit = projectionMatrix[1][1] * static_cast<float>(probe.getResolution()) * 0.5f;
+	probe.beginFace();
+	drawSkybox(viewMatrix, projectionMatrix);
+	for (const MeshInstanceNode* renderable : renderingList) {
+		// Only the opaque lit objects inside the radius and the face's frustum
+		const Material* material = renderable->getMaterial().get();
+		if (!material->litFlag || material->transparentFlag) {
+			continue;
+		}
+		const BoundingBox box = renderable->getBoundingBox();
+		if (!probe.overlaps(box.getMinValues(), box.getMaxValues()) || box.isCulled(cameraMatrix)) {
+			continue;
+		}
+		// The probe is small on screen, the levels of detail are picked without the camera's hysteresis
+		const uint32_t lod = selectLod(renderable, position, pixelsPerUnit, 0);
+		Mesh* mesh = renderable->getMesh();
+		const auto lightmapInstance = lightmapInstances.find(renderable);
+		const bool lightmapped = lightmapInstance != lightmapInstances.end();
+		material->activate(probeShader.get());
+		EnvironmentLighting::enable(probeShader.get());
+		probeShader->setUniform("lightmapped", lightmapped ? 1 : 0);
+		if (lightmapped) {
+			mesh = lightmap->getInstanceMesh(lightmapInstance->second);
+			lightmap->getTexture()->activate(Lightmap::TEXTURE_UNIT);
+			probeShader->setUniform("lightmap", Lightmap::TEXTURE_UNIT);
+			probeShader->setUniform("lightmapScaleOffset", lightmap->getInstanceScaleOffset(lightmapInstance->second));
+			glActiveTexture(GL_TEXTURE0);
+		}
+		probeShader->setUniform("cameraMatrix", cameraMatrix);
+		probeShader->setUniform("objMatrix", renderable->getWorldTransform().getTransformMatrix());
+		mesh->setDecodingUniforms(probeShader.get());
+		mesh->draw(lod);
+		material->deactivate();
+	}
+	probe.endFace(face);
+}
+
+void Renderer::updateReflectionProbes() {
+	capturedProbeFaces = 0;
+	if (reflectionProbes.empty()) {
+		return;
+	}
+	// Check a single probe per frame, so the cost of the checks doesn't grow with the probes
+	checkedProbe = (checkedProbe + 1) % reflectionProbes.size();
+	reflectionProbes[checkedProbe]->updateContentKey(hashProbeContent(*reflectionProbes[checkedProbe]));
+	// Average the cost of a face with the oldest timing, its query is reused this frame
+	const uint32_t query = probeQueryIndex;
+	probeQueryIndex = (probeQueryIndex + 1) % PROBE_QUERY_COUNT;
+	int32_t available = GL_FALSE;
+	if (probeQueryFaces[query] > 0) {
+		glGetQueryObjectiv(probeQueries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+	}
+	if (available == GL_TRUE) {
+		uint64_t elapsed = 0;
+		glGetQueryObjectui64v(probeQueries[query], GL_QUERY_RESULT, &elapsed);
+		const float faceTime = static_cast<float>(elapsed) * 1e-6f / static_cast<float>(probeQueryFaces[query]);
+		probeFaceTime = probeFaceTime > 0.0f ? glm::mix(probeFaceTime, faceTime, PROBE_TIME_SMOOTHING) : faceTime;
+	}
+	// Capture the stale faces a probe at a time, as many as the measured cost fits in the budget
+	const uint32_t faceBudget = probeFaceTime > 0.0f ? std::max(static_cast<uint32_t>(probeBudget / probeFaceTime), 1u) : 1u;
+	int32_t viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (probeQueries[0] == 0) {
+		glGenQueries(PROBE_QUERY_COUNT, probeQueries);
+	}
+	glBeginQuery(GL_TIME_ELAPSED, probeQueries[query]);
+	size_t upToDateProbes = 0;
+	while (capturedProbeFaces < faceBudget && upToDateProbes < reflectionProbes.size()) {
+		ReflectionProbe& probe = *reflectionProbes[capturedProbe];
+		const uint32_t face = probe.getNextStaleFace();
+		if (face == ReflectionProbe::FACE_COUNT) {
+			capturedProbe = (capturedProbe + 1) % reflectionProbes.size();
+			++upToDateProbes;
+			continue;
+		}
+		captureProbeFace(probe, face);
+		++capturedProbeFaces;
+	}
+	glEndQuery(GL_TIME_ELAPSED);
+	probeQueryFaces[query] = capturedProbeFaces;
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void Renderer::sendDataToQueues(const glm::mat4& cameraMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPoint) {
+	int32_t viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	const float pixelsPerUnit = projectionMatrix[1][1] * static_cast<float>(viewport[3]) * 0.5f;
+	drawnTriangles = 0;
+	meshletStatistics = {};
+	// The light pass needs the lists of the clusters
+	const bool deferredPath = deferredShading && LightClusters::isEnabled();
+	for (const std::shared_ptr<Impostor>& impostor : impostors) {
+		impostor->update(cameraMatrix, viewPoint);
+		drawnTriangles += impostor->getVisibleCount() * 2;
+	}
+	if (water) {
+		water->update(cameraMatrix, viewPoint);
+		drawnTriangles += water->getVisibleTriangleCount();
+	}
+	for (const std::shared_ptr<Hlod>& hlod : hlods) {
+		hlod->update(viewPoint);
+		// Proxies dither in as their clusters dither out
+		for (size_t i = 0; i < hlod->getClusterCount(); ++i) {
+			const float fade = hlod->getClusterFade(i);
+			MeshInstanceNode* proxy = hlod->getClusterProxy(i);
+			if (fade <= 0.0f) {
+				continue;
+			}
+			const BoundingBox proxyBox = proxy->getBoundingBox();
+			if (proxyBox.isCulled(cameraMatrix)) {
+				continue;
+			}
+			drawnTriangles += proxy->getMesh()->getIndexCount() / 3;
+			const LightSystem::ObjectLights lights = LightSystem::findLights(proxyBox.getMinValues(), proxyBox.getMaxValues());
+			litQueue.addRenderable(proxy->getMesh(), proxy->getMaterial().get(), proxy->getWorldTransform().getTransformMatrix(), lights, 0, 1.0f - fade);
+		}
+	}
 	for (MeshInstanceNode* renderable : renderingList) {
+		// Skip objects fully replaced by their impostor or proxy
+		float fade = 0.0f;
+		const auto impostorInstance = impostorInstances.find(renderable);
+		if (impostorInstance != impostorInstances.end()) {
+			fade = impostorInstance->second.first->getInstanceFade(impostorInstance->second.second);
+		}
+		const auto hlodCluster = hlodClusters.find(renderable);
+		if (hlodCluster != hlodClusters.end()) {
+			fade = glm::max(fade, hlodCluster->second.first->getClusterFade(hlodCluster->second.second));
+		}
+		if (fade >= 1.0f) {
+			continue;
+		}
 		// Skip culled objects
-		if (renderable->getBoundingBox().isCulled(cameraMatrix)) {
+		const BoundingBox box = renderable->getBoundingBox();
+		if (box.isCulled(cameraMatrix)) {
 			continue;
 		}
-		// Check correct rendering queue to send objects to
+		const uint32_t lod = selectLod(renderable, viewPoint, pixelsPerUnit, renderable->getLodLevel());
+		renderable->setLodLevel(lod);
+		// Check correct rendering queue to send objects to, the opaque Blinn-Phong objects go to the G-buffer on the deferred path
 		Material* materialPtr = renderable->getMaterial().get();
-		if (materialPtr->litFlag) {
-			if (materialPtr->transparentFlag) {
-				litTransparentQueue.addRenderable(renderable->getMesh(), materialPtr, renderable->getWorldTransform().getTransformMatrix());
-			} else {
-				litQueue.addRenderable(renderable->getMesh(), materialPtr, renderable->getWorldTransform().getTransformMatrix());
-			}
+		const bool deferred = deferredPath && materialPtr->litFlag && !materialPtr->transparentFlag && materialPtr->getShader() == deferrableShader.get();
+		const int32_t resolutionShift = getResolutionShift(materialPtr);
+		RenderingQueue& queue = deferred ? deferredQueue : resolutionShift > 0 ? reducedTargets[resolutionShift - 1].queue : materialPtr->litFlag
+			? (materialPtr->transparentFlag ? litTransparentQueue : litQueue)
+			: (materialPtr->transparentFlag ? unlitTransparentQueue : unlitQueue);
+		Mesh* mesh = renderable->getMesh();
+		const glm::mat4& modelMatrix = renderable->getWorldTransform().getTransformMatrix();
+		const LightSystem::ObjectLights lights = LightSystem::findLights(box.getMinValues(), box.getMaxValues());
+		const Texture* reflections = materialPtr->litFlag ? findReflections(box) : nullptr;
+		// Lightmapped objects swap in their mesh with the second uv set, it has the same levels of detail and meshlets
+		const Texture* lightmapTexture = nullptr;
+		glm::vec4 lightmapScaleOffset(0.0f);
+		const auto lightmapInstance = lightmapInstances.find(renderable);
+		if (lightmapInstance != lightmapInstances.end()) {
+			mesh = lightmap->getInstanceMesh(lightmapInstance->second);
+			lightmapTexture = lightmap->getTexture();
+			lightmapScaleOffset = lightmap->getInstanceScaleOffset(lightmapInstance->second);
+		}
+		// Full detail meshes only send the meshlets facing the camera inside the frustum
+		if (meshletCulling && lod == 0 && mesh->getMeshletCount() > 1) {
+			drawnTriangles += queue.addCulledRenderable(mesh, materialPtr, modelMatrix, lights, fade, cameraMatrix, viewPoint, meshletStatistics, lightmapTexture, lightmapScaleOffset, reflections);
 		} else {
-			if (materialPtr->transparentFlag) {
-				unlitTransparentQueue.addRenderable(renderable->getMesh(), materialPtr, renderable->getWorldTransform().getTransformMatrix());
-			} else {
-				unlitQueue.addRenderable(renderable->getMesh(), materialPtr, renderable->getWorldTransform().getTransformMatrix());
-			}
+			drawnTriangles += mesh->getIndexCount(lod) / 3;
+			queue.addRenderable(mesh, materialPtr, modelMatrix, lights, lod, fade, lightmapTexture, lightmapScaleOffset, reflections);
 		}
 	}
 }
@@ -67,6 +492,382 @@ const std::vector<MeshInstanceNode *>& Renderer::getAllRenderables() {
 	return renderingList;
 }
 
+void Renderer::addImpostor(const std::shared_ptr<Impostor>& impostor) {
+	impostor->setDistance(impostorDistance);
+	for (size_t i = 0; i < impostor->getInstanceCount(); ++i) {
+		for (const MeshInstanceNode* meshNode : impostor->getInstanceMeshes(i)) {
+			impostorInstances[meshNode] = { impostor.get(), i };
+		}
+	}
+	impostors.emplace_back(impostor);
+}
+
+void Renderer::setImpostorDistance(const float distance) {
+	impostorDistance = glm::max(distance, 0.0f);
+	for (const std::shared_ptr<Impostor>& impostor : impostors) {
+		impostor->setDistance(impostorDistance);
+	}
+}
+
+float Renderer::getImpostorDistance() {
+	return impostorDistance;
+}
+
+void Renderer::addHlod(const std::shared_ptr<Hlod>& hlod) {
+	hlod->setDistance(hlodDistance);
+	for (size_t i = 0; i < hlod->getClusterCount(); ++i) {
+		for (const MeshInstanceNode* meshNode : hlod->getClusterMeshes(i)) {
+			hlodClusters[meshNode] = { hlod.get(), i };
+		}
+	}
+	hlods.emplace_back(hlod);
+}
+
+void Renderer::setHlodDistance(const float distance) {
+	hlodDistance = glm::max(distance, 0.0f);
+	for (const std::shared_ptr<Hlod>& hlod : hlods) {
+		hlod->setDistance(hlodDistance);
+	}
+}
+
+float Renderer::getHlodDistance() {
+	return hlodDistance;
+}
+
+void Renderer::setLightmap(const std::shared_ptr<Lightmap>& _lightmap) {
+	lightmap = _lightmap;
+	lightmapInstances.clear();
+	if (!lightmap) {
+		return;
+	}
+	for (size_t i = 0; i < lightmap->getInstanceCount(); ++i) {
+		lightmapInstances[lightmap->getInstanceNode(i)] = i;
+	}
+}
+
+Lightmap* Renderer::getLightmap() {
+	return lightmap.get();
+}
+
+void Renderer::setWater(const std::shared_ptr<WaterClipmap>& clipmap) {
+	water = clipmap;
+}
+
+void Renderer::addReflectionProbe(const std::shared_ptr<ReflectionProbe>& probe) {
+	if (!probeShader) {
+		probeShader = ShaderLoader::load("probe");
+	}
+	reflectionProbes.emplace_back(probe);
+}
+
+const std::vector<std::shared_ptr<ReflectionProbe>>& Renderer::getReflectionProbes() {
+	return reflectionProbes;
+}
+
+void Renderer::invalidateReflectionProbes() {
+	for (const std::shared_ptr<ReflectionProbe>& probe : reflectionProbes) {
+		probe->invalidate();
+	}
+}
+
+void Renderer::setProbeBudget(const float milliseconds) {
+	probeBudget = glm::max(milliseconds, 0.0f);
+}
+
+float Renderer::getProbeBudget() {
+	return probeBudget;
+}
+
+uint32_t Renderer::getCapturedProbeFaceCount() {
+	return capturedProbeFaces;
+}
+
+void Renderer::setLodBias(const float bias) {
+	lodBias = glm::max(bias, 0.0f);
+}
+
+float Renderer::getLodBias() {
+	return lodBias;
+}
+
+uint32_t Renderer::getDrawnTriangleCount() {
+	return drawnTriangles;
+}
+
+void Renderer::setMeshletCulling(const bool enabled) {
+	meshletCulling = enabled;
+}
+
+bool Renderer::isMeshletCullingEnabled() {
+	return meshletCulling;
+}
+
+const Mesh::CullingStatistics& Renderer::getMeshletStatistics() {
+	return meshletStatistics;
+}
+
+void Renderer::renderDeferred(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint) {
+	deferredObjectCount = static_cast<uint32_t>(deferredQueue.getRenderableCount());
+	if (deferredObjectCount == 0) {
+		return;
+	}
+	int32_t viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (!gBuffer || gBuffer->width != viewport[2] || gBuffer->height != viewport[3]) {
+		gBuffer = std::make_unique<FrameBuffer>(viewport[2], viewport[3], GBUFFER_FORMATS, true, true);
+	}
+	// Geometry pass, the pixels left at the cleared depth are skipped by the light pass so the colors need no clear
+	gBuffer->bind();
+	glViewport(0, 0, gBuffer->width, gBuffer->height);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	deferredQueue.render(cameraMatrix, viewPoint, gBufferShader.get());
+	deferredQueue.clear();
+	gBuffer->unbind();
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	// Light pass over the whole screen, filled even in wireframe
+	int32_t polygonMode[2];
+	glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glDepthFunc(GL_ALWAYS);
+	deferredLightShader->activate();
+	for (size_t i = 0; i < GBUFFER_FORMATS.size(); ++i) {
+		gBuffer->getColorAttachment(i)->activate(static_cast<int32_t>(i));
+		deferredLightShader->setUniform(GBUFFER_UNIFORMS[i], static_cast<int32_t>(i));
+	}
+	const int32_t depthUnit = static_cast<int32_t>(GBUFFER_FORMATS.size());
+	gBuffer->getDepthAttachment()->activate(depthUnit);
+	deferredLightShader->setUniform("gDepth", depthUnit);
+	LightSystem::enable(deferredLightShader.get());
+	LightClusters::enable(deferredLightShader.get());
+	ShadowAtlas::enable(deferredLightShader.get());
+	deferredLightShader->setUniform("cameraPosition", viewPoint);
+	deferredLightShader->setUniform("inverseCameraMatrix", glm::inverse(cameraMatrix));
+	screenQuadVao->bind();
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	screenQuadVao->unbind();
+	// Unbind the G-buffer, it is drawn into again next frame
+	for (size_t i = 0; i < GBUFFER_FORMATS.size(); ++i) {
+		gBuffer->getColorAttachment(i)->deactivate(static_cast<int32_t>(i));
+	}
+	gBuffer->getDepthAttachment()->deactivate(depthUnit);
+	glActiveTexture(GL_TEXTURE0);
+	glDepthFunc(GL_LESS);
+	glPolygonMode(GL_FRONT_AND_BACK, polygonMode[0]);
+}
+
+void Renderer::setDeferredShading(const bool enabled) {
+	if (enabled && !gBufferShader) {
+		deferrableShader = ShaderLoader::load("blinn_phong");
+		gBufferShader = ShaderLoader::load("gbuffer");
+		deferredLightShader = ShaderLoader::load("deferred_light");
+	}
+	if (enabled && !screenQuadVao) {
+		// The screen quad is generated in the vertex shader, an empty vertex array is enough
+		screenQuadVao = std::make_unique<VertexArray>();
+	}
+	deferredShading = enabled;
+}
+
+bool Renderer::isDeferredShadingEnabled() {
+	return deferredShading;
+}
+
+uint32_t Renderer::getDeferredObjectCount() {
+	return deferredObjectCount;
+}
+
+void Renderer::renderWeightedTransparency(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint) {
+	int32_t viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (!transparencyBuffer || transparencyBuffer->width != viewport[2] || transparencyBuffer->height != viewport[3]) {
+		transparencyBuffer = std::make_unique<FrameBuffer>(viewport[2], viewport[3], TRANSPARENCY_FORMATS, true, true);
+	}
+	// The opaque depth of the current framebuffer is copied in, so the transparent surfaces behind it are rejected
+	transparencyBuffer->getDepthAttachment()->bind();
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewport[0], viewport[1], viewport[2], viewport[3]);
+	transparencyBuffer->getDepthAttachment()->unbind();
+	transparencyBuffer->bind();
+	glViewport(0, 0, transparencyBuffer->width, transparencyBuffer->height);
+	const float clearAccumulation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	const float clearWeights[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+	glClearBufferfv(GL_COLOR, 1, clearWeights);
+	// Colors and weights add up, the revealage in the alpha of the accumulation is multiplied by every transparency
+	glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+	if (water && getResolutionShift(water->getMaterial()) == 0) {
+		water->render(cameraMatrix, viewPoint, true);
+	}
+	litTransparentQueue.render(cameraMatrix, viewPoint);
+	unlitTransparentQueue.render(cameraMatrix, viewPoint);
+	transparencyBuffer->unbind();
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	// Composite the average color over the scene, by how much of it the surfaces hide
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	int32_t polygonMode[2];
+	glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glDisable(GL_DEPTH_TEST);
+	compositeShader->activate();
+	transparencyBuffer->getColorAttachment(0)->activate(0);
+	compositeShader->setUniform("accumulation", 0);
+	transparencyBuffer->getColorAttachment(1)->activate(1);
+	compositeShader->setUniform("weights", 1);
+	screenQuadVao->bind();
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	screenQuadVao->unbind();
+	transparencyBuffer->getColorAttachment(0)->deactivate(0);
+	transparencyBuffer->getColorAttachment(1)->deactivate(1);
+	glActiveTexture(GL_TEXTURE0);
+	glEnable(GL_DEPTH_TEST);
+	glPolygonMode(GL_FRONT_AND_BACK, polygonMode[0]);
+}
+
+void Renderer::setOrderIndependentTransparency(const bool enabled) {
+	if (enabled && !compositeShader) {
+		compositeShader = ShaderLoader::load("oit_composite");
+	}
+	if (enabled && !screenQuadVao) {
+		screenQuadVao = std::make_unique<VertexArray>();
+	}
+	orderIndependentTransparency = enabled;
+	litTransparentQueue.setWeightedTransparency(enabled);
+	unlitTransparentQueue.setWeightedTransparency(enabled);
+}
+
+bool Renderer::isOrderIndependentTransparencyEnabled() {
+	return orderIndependentTransparency;
+}
+
+int32_t Renderer::getResolutionShift(const Material* material) {
+	if (!reducedResolutionTransparency || !material->transparentFlag) {
+		return 0;
+	}
+	return material->resolutionDivisor >= 4 ? 2 : material->resolutionDivisor >= 2 ? 1 : 0;
+}
+
+void Renderer::renderReducedTransparency(const glm::mat4& cameraMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPoint) {
+	const int32_t waterShift = water ? getResolutionShift(water->getMaterial()) : 0;
+	bool anyTarget = waterShift > 0;
+	for (const ReducedTransparencyTarget& target : reducedTargets) {
+		anyTarget = anyTarget || target.queue.getRenderableCount() > 0;
+	}
+	if (!anyTarget) {
+		return;
+	}
+	if (!upsampleShader) {
+		downsampleShader = ShaderLoader::load("depth_downsample");
+		upsampleShader = ShaderLoader::load("transparency_upsample");
+	}
+	if (!screenQuadVao) {
+		screenQuadVao = std::make_unique<VertexArray>();
+	}
+	int32_t viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	int32_t polygonMode[2];
+	glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+	// The opaque depth of the current framebuffer is copied in, to be downsampled and to upsample by
+	if (!sceneDepthBuffer || sceneDepthBuffer->width != viewport[2] || sceneDepthBuffer->height != viewport[3]) {
+		sceneDepthBuffer = std::make_unique<FrameBuffer>(viewport[2], viewport[3], std::vector<int32_t>(), true, true);
+	}
+	const std::shared_ptr<Texture2D>& sceneDepth = sceneDepthBuffer->getDepthAttachment();
+	sceneDepth->bind();
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewport[0], viewport[1], viewport[2], viewport[3]);
+	sceneDepth->unbind();
+	for (int32_t shift = 1; shift <= MAX_RESOLUTION_SHIFT; ++shift) {
+		ReducedTransparencyTarget& target = reducedTargets[shift - 1];
+		const bool drawWater = waterShift == shift;
+		if (target.queue.getRenderableCount() == 0 && !drawWater) {
+			continue;
+		}
+		const int32_t width = std::max(viewport[2] >> shift, 1);
+		const int32_t height = std::max(viewport[3] >> shift, 1);
+		if (!target.frameBuffer || target.frameBuffer->width != width || target.frameBuffer->height != height) {
+			target.frameBuffer = std::make_unique<FrameBuffer>(width, height, REDUCED_TRANSPARENCY_FORMATS, true, true);
+		}
+		target.frameBuffer->bind();
+		glViewport(0, 0, width, height);
+		// Downsample the opaque depth, keeping the farthest of every block
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_ALWAYS);
+		downsampleShader->activate();
+		sceneDepth->activate(0);
+		downsampleShader->setUniform("sceneDepth", 0);
+		downsampleShader->setUniform("resolutionShift", shift);
+		screenQuadVao->bind();
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		screenQuadVao->unbind();
+		sceneDepth->deactivate(0);
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_FALSE);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glPolygonMode(GL_FRONT_AND_BACK, polygonMode[0]);
+		// Blend the premultiplied colors over nothing, the coverage adds up in alpha
+		const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glClearBufferfv(GL_COLOR, 0, clearColor);
+		glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		if (drawWater) {
+			water->render(cameraMatrix, viewPoint, false, shift);
+		}
+		target.queue.setResolutionShift(shift);
+		target.queue.render(cameraMatrix, viewPoint);
+		target.queue.clear();
+		target.frameBuffer->unbind();
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		// Upsample over the scene, every pixel takes the texels that saw the same opaque surface
+		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glDisable(GL_DEPTH_TEST);
+		upsampleShader->activate();
+		target.frameBuffer->getColorAttachment(0)->activate(0);
+		upsampleShader->setUniform("transparency", 0);
+		target.frameBuffer->getDepthAttachment()->activate(1);
+		upsampleShader->setUniform("reducedDepth", 1);
+		sceneDepth->activate(2);
+		upsampleShader->setUniform("sceneDepth", 2);
+		upsampleShader->setUniform("resolutionShift", shift);
+		upsampleShader->setUniform("depthProjection", glm::vec2(projectionMatrix[2][2], projectionMatrix[3][2]));
+		screenQuadVao->bind();
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		screenQuadVao->unbind();
+		target.frameBuffer->getColorAttachment(0)->deactivate(0);
+		target.frameBuffer->getDepthAttachment()->deactivate(1);
+		sceneDepth->deactivate(2);
+		glActiveTexture(GL_TEXTURE0);
+		glEnable(GL_DEPTH_TEST);
+		glPolygonMode(GL_FRONT_AND_BACK, polygonMode[0]);
+	}
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void Renderer::setReducedResolutionTransparency(const bool enabled) {
+	reducedResolutionTransparency = enabled;
+}
+
+bool Renderer::isReducedResolutionTransparencyEnabled() {
+	return reducedResolutionTransparency;
+}
+
+RenderingQueue& Renderer::getOpaqueQueue(const OPAQUE_QUEUE queue) {
+	switch (queue) {
+		case OPAQUE_QUEUE::UNLIT:
+			return unlitQueue;
+		case OPAQUE_QUEUE::DEFERRED:
+			return deferredQueue;
+		default:
+			return litQueue;
+	}
+}
+
+void Renderer::setDepthPrePass(const OPAQUE_QUEUE queue, const bool enabled) {
+	getOpaqueQueue(queue).setDepthPrePass(enabled);
+}
+
+bool Renderer::isDepthPrePassEnabled(const OPAQUE_QUEUE queue) {
+	return getOpaqueQueue(queue).isDepthPrePassEnabled();
+}
+
 void Renderer::setupOpengl() {
 	// Set depth testing function
 	glEnable(GL_DEPTH_TEST);
@@ -76,6 +877,8 @@ void Renderer::setupOpengl() {
 	glFrontFace(GL_CCW);
 	// Set blending function
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	// Filter across the faces of cubemaps, the small levels of the prefiltered reflections would show their seams
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 }
 
 void Renderer::toggleWireframe() {
@@ -85,34 +888,46 @@ void Renderer::toggleWireframe() {
 }
 
 void Renderer::renderAll(const glm::mat4& cameraMatrix, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPoint) {
+	// Upload the lights changed since the last frame
+	LightSystem::flush();
+	// Replace the distant lights with their clusters' representatives
+	LightSystem::updateCut(viewPoint);
+	// Draw the shadow tiles whose lights or casters changed
+	ShadowAtlas::update(renderingList, cameraMatrix, projectionMatrix, viewPoint);
+	// Capture the stale faces of the reflection probes before the frame uses them
+	updateReflectionProbes();
 	// Send renderables to queues
-	sendDataToQueues(cameraMatrix);
+	sendDataToQueues(cameraMatrix, projectionMatrix, viewPoint);
+	// Assign the lights to the clusters of this view
+	LightClusters::update(viewMatrix, projectionMatrix);
 	// Draw skybox
-	if (cubemapMaterial && cubemapMesh) {
-		// Disable depth mask for cubemap and culling
-		glDisable(GL_CULL_FACE);
-		glDepthMask(GL_FALSE);
-		// Draw cubemap using material
-		cubemapMaterial->activate();
-		cubemapMaterial->getShader()->setUniform("projectionMatrix", projectionMatrix);
-		cubemapMaterial->getShader()->setUniform("viewMatrix", viewMatrix);
-		cubemapMesh->draw();
-		// Re-enable other stuff for rendering
-		glEnable(GL_CULL_FACE);
-		glDepthMask(GL_TRUE);
-	}
-	// Render opaque objects
+	drawSkybox(viewMatrix, projectionMatrix);
+	// Render opaque objects, the deferred ones first
+	renderDeferred(cameraMatrix, viewPoint);
 	litQueue.render(cameraMatrix, viewPoint);
 	litQueue.clear();
 	unlitQueue.render(cameraMatrix, viewPoint);
 	unlitQueue.clear();
+	// Render far instances as impostors
+	for (const std::shared_ptr<Impostor>& impostor : impostors) {
+		impostor->render(cameraMatrix, viewPoint);
+	}
 	// Enable blending for transparency
 	glEnable(GL_BLEND);
 	glDepthMask(GL_FALSE);
-	// Render transparent objects
-	litTransparentQueue.render(cameraMatrix, viewPoint);
+	// The reduced targets first, the water lies behind most of the other transparent objects
+	renderReducedTransparency(cameraMatrix, projectionMatrix, viewPoint);
+	if (orderIndependentTransparency) {
+		renderWeightedTransparency(cameraMatrix, viewPoint);
+	} else {
+		// Render transparent objects, the water first as it lies behind most of them
+		if (water && getResolutionShift(water->getMaterial()) == 0) {
+			water->render(cameraMatrix, viewPoint);
+		}
+		litTransparentQueue.render(cameraMatrix, viewPoint);
+		unlitTransparentQueue.render(cameraMatrix, viewPoint);
+	}
 	litTransparentQueue.clear();
-	unlitTransparentQueue.render(cameraMatrix, viewPoint);
 	unlitTransparentQueue.clear();
 	// Disable blending for transparency
 	glDisable(GL_BLEND);
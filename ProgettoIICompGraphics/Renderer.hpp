@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Mesh.hpp"
 #include <glm/glm.hpp>
 #include <memory>
 
@@ -9,16 +10,42 @@
 class MeshInstanceNode;
 
 /**
- * Foward declaration of the mesh class.
+ * Foward declaration of the material class.
  */
-class Mesh;
+class Material;
 
 /**
- * Foward declaration of the material class.
+ * Foward declaration of the impostor class.
  */
-class Material;
+class Impostor;
+
+/**
+ * Foward declaration of the hierarchical level of detail class.
+ */
+class Hlod;
+
+/**
+ * Foward declaration of the lightmap class.
+ */
+class Lightmap;
+
+class WaterClipmap;
+
+/**
+ * Foward declaration of the reflection probe class.
+ */
+class ReflectionProbe;
 
 namespace Renderer {
+	/**
+	 * The queues of opaque objects, each can have its own depth pre-pass.
+	 */
+	enum class OPAQUE_QUEUE : uint32_t {
+		LIT = 0,
+		UNLIT = 1,
+		DEFERRED = 2
+	};
+
 	/**
 	 * Toggles between wireframe and normal mode.
 	 */
@@ -60,4 +87,227 @@ namespace Renderer {
 	 * \param material The cubemap's material
 	 */
 	void setCubemap(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material);
-};
+
+	/**
+	 * Changes the global level of detail bias, higher values switch to coarser levels closer to the camera.
+	 *
+	 * \param bias The new bias (1 = one pixel of error allowed).
+	 */
+	void setLodBias(const float bias);
+
+	/**
+	 * Getter for the global level of detail bias.
+	 *
+	 * \return The current bias.
+	 */
+	float getLodBias();
+
+	/**
+	 * Adds an impostor, its instances' meshes are faded out in favour of it when far away.
+	 * The meshes must already be in the rendering queues.
+	 *
+	 * \param impostor The impostor to add.
+	 */
+	void addImpostor(const std::shared_ptr<Impostor>& impostor);
+
+	/**
+	 * Changes the distance at which all the impostors replace their meshes.
+	 *
+	 * \param distance The new distance.
+	 */
+	void setImpostorDistance(const float distance);
+
+	/**
+	 * Getter for the distance at which the impostors replace their meshes.
+	 *
+	 * \return The current distance.
+	 */
+	float getImpostorDistance();
+
+	/**
+	 * Adds a hierarchical level of detail, its clusters' meshes are faded out in favour of the proxies when far away.
+	 * The meshes must already be in the rendering queues.
+	 *
+	 * \param hlod The hierarchical level of detail to add.
+	 */
+	void addHlod(const std::shared_ptr<Hlod>& hlod);
+
+	/**
+	 * Changes the distance at which all the hierarchical levels of detail replace their clusters.
+	 *
+	 * \param distance The new distance.
+	 */
+	void setHlodDistance(const float distance);
+
+	/**
+	 * Getter for the distance at which the hierarchical levels of detail replace their clusters.
+	 *
+	 * \return The current distance.
+	 */
+	float getHlodDistance();
+
+	/**
+	 * Setter for the lightmap, its objects are drawn with their lightmapped meshes.
+	 * The meshes must already be in the rendering queues.
+	 *
+	 * \param _lightmap The lightmap of the static objects, nullptr removes it.
+	 */
+	void setLightmap(const std::shared_ptr<Lightmap>& _lightmap);
+
+	/**
+	 * Getter for the lightmap.
+	 *
+	 * \return The lightmap of the static objects, nullptr if there is none.
+	 */
+	Lightmap* getLightmap();
+
+	/**
+	 * Setter for the water surface, drawn before the other transparent objects.
+	 *
+	 * \param clipmap The clipmap of the water.
+	 */
+	void setWater(const std::shared_ptr<WaterClipmap>& clipmap);
+
+	/**
+	 * Adds a reflection probe, the lit objects inside its radius reflect its cubemap instead of the sky once every face is captured.
+	 * The probe must be in the scene and OpenGL must be set up.
+	 *
+	 * \param probe The probe to add.
+	 */
+	void addReflectionProbe(const std::shared_ptr<ReflectionProbe>& probe);
+
+	/**
+	 * Getter for the reflection probes.
+	 *
+	 * \return Every probe added to the renderer.
+	 */
+	const std::vector<std::shared_ptr<ReflectionProbe>>& getReflectionProbes();
+
+	/**
+	 * Marks every face of every reflection probe as stale, so they get captured again over the next frames.
+	 *
+	 */
+	void invalidateReflectionProbes();
+
+	/**
+	 * Changes the time spent every frame capturing the stale faces of the reflection probes.
+	 * The faces fitting in it are estimated from the GPU time of the captures in the previous frames,
+	 * at least one stale face is captured every frame, whatever the budget.
+	 *
+	 * \param milliseconds The new budget, in milliseconds of GPU time.
+	 */
+	void setProbeBudget(const float milliseconds);
+
+	/**
+	 * Getter for the time spent every frame capturing the stale faces of the reflection probes.
+	 *
+	 * \return The current budget, in milliseconds of GPU time.
+	 */
+	float getProbeBudget();
+
+	/**
+	 * Getter for the amount of reflection probe faces captured in the last frame.
+	 *
+	 * \return The faces captured in the last frame.
+	 */
+	uint32_t getCapturedProbeFaceCount();
+
+	/**
+	 * Getter for the amount of triangles sent to the GPU in the last frame.
+	 *
+	 * \return The triangle count of the last frame.
+	 */
+	uint32_t getDrawnTriangleCount();
+
+	/**
+	 * Toggles the per meshlet frustum and backface culling of the full detail meshes.
+	 *
+	 * \param enabled The new state.
+	 */
+	void setMeshletCulling(const bool enabled);
+
+	/**
+	 * Getter for the state of the meshlet culling.
+	 *
+	 * \return True if the meshlets are culled.
+	 */
+	bool isMeshletCullingEnabled();
+
+	/**
+	 * Getter for the meshlet culling results of the last frame.
+	 *
+	 * \return The culling counters of the last frame.
+	 */
+	const Mesh::CullingStatistics& getMeshletStatistics();
+
+	/**
+	 * Toggles the deferred path: the opaque objects drawn with the Blinn-Phong shader write a G-buffer that is lit
+	 * once per pixel with the lights of its cluster, the rest of the objects stay forward shaded.
+	 * It only runs while the clustered lights are enabled, OpenGL must be set up.
+	 *
+	 * \param enabled The new state.
+	 */
+	void setDeferredShading(const bool enabled);
+
+	/**
+	 * Getter for the state of the deferred path.
+	 *
+	 * \return True if the opaque Blinn-Phong objects are deferred.
+	 */
+	bool isDeferredShadingEnabled();
+
+	/**
+	 * Getter for the amount of objects drawn in the G-buffer in the last frame.
+	 *
+	 * \return The deferred objects of the last frame.
+	 */
+	uint32_t getDeferredObjectCount();
+
+	/**
+	 * Toggles the depth pre-pass of an opaque queue, see RenderingQueue::setDepthPrePass.
+	 *
+	 * \param queue The queue to toggle the pre-pass of.
+	 * \param enabled The new state.
+	 */
+	void setDepthPrePass(const OPAQUE_QUEUE queue, const bool enabled);
+
+	/**
+	 * Getter for the state of the depth pre-pass of an opaque queue.
+	 *
+	 * \param queue The queue to check.
+	 * \return True if the queue draws its depth before its colors.
+	 */
+	bool isDepthPrePassEnabled(const OPAQUE_QUEUE queue);
+
+	/**
+	 * Toggles the weighted blended order independent transparency: the water and the transparent queues are drawn
+	 * unsorted in an accumulation and a revealage target, then composited over the opaque scene in one pass.
+	 * OpenGL must be set up.
+	 *
+	 * \param enabled The new state.
+	 */
+	void setOrderIndependentTransparency(const bool enabled);
+
+	/**
+	 * Getter for the state of the order independent transparency.
+	 *
+	 * \return True if the transparent objects are drawn with weighted blending.
+	 */
+	bool isOrderIndependentTransparencyEnabled();
+
+	/**
+	 * Toggles the reduced resolution transparency: the transparent materials with a resolution key (see MaterialLoader)
+	 * are drawn at half or quarter resolution against a downsampled opaque depth, then upsampled over the scene by
+	 * weighting the texels whose depth matches the pixel's. When disabled every material is drawn at full resolution.
+	 *
+	 * \param enabled The new state.
+	 */
+	void setReducedResolutionTransparency(const bool enabled);
+
+	/**
+	 * Getter for the state of the reduced resolution transparency.
+	 *
+	 * \return True if the materials with a resolution divisor are drawn in the reduced targets.
+	 */
+	bool isReducedResolutionTransparencyEnabled();
+};
\ No newline at end of file
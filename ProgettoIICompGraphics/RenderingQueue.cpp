@@ -1,51 +1,142 @@
 #include "RenderingQueue.hpp"
 
+#include "EnvironmentLighting.hpp"
+#include "LightClusters.hpp"
+#include "Lightmap.hpp"
 #include "LightSystem.hpp"
 #include "Material.hpp"
 #include "Mesh.hpp"
 #include "Shader.hpp"
+#include "ShaderLoader.hpp"
+#include "ShadowAtlas.hpp"
+#include "Texture.hpp"
 #include <algorithm>
 #include <glad/glad.h>
 #include <glfw/glfw3.h>
 
 RenderingQueue::RenderingQueue(const bool _closestFirst)
 	:
+	renderables(),
+	rangeCounts(),
+	rangeOffsets(),
 	closestFirst(_closestFirst),
-	renderables()
+	depthPrePass(false),
+	weightedTransparency(false),
+	resolutionShift(0)
 {}
 
-void RenderingQueue::addRenderable(Mesh* mesh, Material* material, const glm::mat4& modelMatrix) {
-	this->renderables.emplace_back(std::make_tuple(mesh, material, modelMatrix));
-}
-
-void RenderingQueue::render(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint) {
-	// Sort objects for quick rendering
-	std::sort(this->renderables.begin(), this->renderables.end(), [this, &viewPoint](const auto& first, const auto& second) {
-		const glm::vec3 position1 = glm::vec3(std::get<2>(first)[3]);
-		const glm::vec3 position2 = glm::vec3(std::get<2>(second)[3]);
-		const glm::vec3 point1 = viewPoint - position1;
-		const glm::vec3 point2 = viewPoint - position2;
-		return this->closestFirst
-			? glm::distance(viewPoint, point1) > glm::distance(viewPoint, point2)
-			: glm::distance(viewPoint, point1) < glm::distance(viewPoint, point2);
-	});
+void RenderingQueue::addRenderable(Mesh* mesh, Material* material, const glm::mat4& modelMatrix, const LightSystem::ObjectLights& lights, const uint32_t lod, const float fade, const Texture* lightmap, const glm::vec4& lightmapScaleOffset, const Texture* reflections) {
+	this->renderables.emplace_back(Renderable{ mesh, material, modelMatrix, lod, fade, 0, 0, lights, lightmap, lightmapScaleOffset, reflections });
+}
+
+uint32_t RenderingQueue::addCulledRenderable(Mesh* mesh, Material* material, const glm::mat4& modelMatrix, const LightSystem::ObjectLights& lights, const float fade, const glm::mat4& cameraMatrix, const glm::vec3& viewPoint, Mesh::CullingStatistics& statistics, const Texture* lightmap, const glm::vec4& lightmapScaleOffset, const Texture* reflections) {
+	const uint32_t firstRange = static_cast<uint32_t>(this->rangeCounts.size());
+	const uint32_t visibleTriangles = mesh->cullMeshlets(cameraMatrix, modelMatrix, viewPoint, this->rangeCounts, this->rangeOffsets, statistics);
+	const uint32_t rangeCount = static_cast<uint32_t>(this->rangeCounts.size()) - firstRange;
+	if (rangeCount > 0) {
+		this->renderables.emplace_back(Renderable{ mesh, material, modelMatrix, 0, fade, firstRange, rangeCount, lights, lightmap, lightmapScaleOffset, reflections });
+	}
+	return visibleTriangles;
+}
+
+void RenderingQueue::draw(const Renderable& renderable) const {
+	if (renderable.rangeCount > 0) {
+		renderable.mesh->drawRanges(&this->rangeCounts[renderable.firstRange], &this->rangeOffsets[renderable.firstRange], static_cast<int32_t>(renderable.rangeCount));
+	} else {
+		renderable.mesh->draw(renderable.lod);
+	}
+}
+
+void RenderingQueue::render(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint, const Shader* shaderOverride) {
+	// Sort objects for quick rendering, the weighted transparency doesn't depend on the order
+	if (!this->weightedTransparency) {
+		std::sort(this->renderables.begin(), this->renderables.end(), [this, &viewPoint](const auto& first, const auto& second) {
+			const float distance1 = glm::distance(viewPoint, glm::vec3(first.modelMatrix[3]));
+			const float distance2 = glm::distance(viewPoint, glm::vec3(second.modelMatrix[3]));
+			return this->closestFirst ? distance1 < distance2 : distance1 > distance2;
+		});
+	}
+	// Lay down the depth first, the color pass then only shades the fragments that are left
+	if (this->depthPrePass && !this->renderables.empty()) {
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		for (const Renderable& renderable : this->renderables) {
+			const std::shared_ptr<Shader> depthShader = ShaderLoader::loadDepthVariant(renderable.material->getShader()->name);
+			renderable.material->activate(depthShader.get());
+			depthShader->setUniform("glfwTime", static_cast<float>(glfwGetTime()));
+			depthShader->setUniform("cameraMatrix", cameraMatrix);
+			depthShader->setUniform("objMatrix", renderable.modelMatrix);
+			depthShader->setUniform("fadeOut", renderable.fade);
+			renderable.mesh->setDecodingUniforms(depthShader.get());
+			this->draw(renderable);
+			renderable.material->deactivate();
+		}
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
 	// Render all objects
-	for (auto [meshPtr, materialPtr, model] : this->renderables) {
-		materialPtr->activate();
+	for (const Renderable& renderable : this->renderables) {
+		const auto& [meshPtr, materialPtr, model, lod, fade, firstRange, rangeCount, lights, lightmap, lightmapScaleOffset, reflections] = renderable;
+		const Shader* shader = shaderOverride ? shaderOverride : materialPtr->getShader();
+		materialPtr->activate(shader);
 		// Activate lighting
-		LightSystem::enableAt(0);
-		const uint32_t blockIndex = glGetUniformBlockIndex(materialPtr->getShader()->id, "lightBuffer");
-		glUniformBlockBinding(materialPtr->getShader()->id, blockIndex, 0);
+		LightSystem::enable(shader);
+		LightClusters::enable(shader);
+		EnvironmentLighting::enable(shader, reflections);
+		ShadowAtlas::enable(shader);
+		LightSystem::enableObjectLights(shader, lights);
+		// Lightmapped objects skip the baked lights and read them from their rectangle of the lightmap
+		shader->setUniform("lightmapped", lightmap != nullptr ? 1 : 0);
+		if (lightmap) {
+			lightmap->activate(Lightmap::TEXTURE_UNIT);
+			shader->setUniform("lightmap", Lightmap::TEXTURE_UNIT);
+			shader->setUniform("lightmapScaleOffset", lightmapScaleOffset);
+			glActiveTexture(GL_TEXTURE0);
+		}
 		// Continue rendering normally
-		materialPtr->getShader()->setUniform("glfwTime", static_cast<float>(glfwGetTime()));
-		materialPtr->getShader()->setUniform("cameraPosition", viewPoint);
-		materialPtr->getShader()->setUniform("cameraMatrix", cameraMatrix);
-		materialPtr->getShader()->setUniform("objMatrix", model);
-		meshPtr->draw();
+		shader->setUniform("glfwTime", static_cast<float>(glfwGetTime()));
+		shader->setUniform("cameraPosition", viewPoint);
+		shader->setUniform("cameraMatrix", cameraMatrix);
+		shader->setUniform("objMatrix", model);
+		shader->setUniform("fadeOut", fade);
+		shader->setUniform("weightedTransparency", this->weightedTransparency ? 1 : 0);
+		shader->setUniform("resolutionShift", this->resolutionShift);
+		meshPtr->setDecodingUniforms(shader);
+		this->draw(renderable);
 		materialPtr->deactivate();
 	}
+	if (this->depthPrePass && !this->renderables.empty()) {
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+}
+
+size_t RenderingQueue::getRenderableCount() const {
+	return this->renderables.size();
 }
 
 void RenderingQueue::clear() {
 	this->renderables.clear();
+	this->rangeCounts.clear();
+	this->rangeOffsets.clear();
+}
+
+void RenderingQueue::setDepthPrePass(const bool enabled) {
+	this->depthPrePass = enabled;
+}
+
+bool RenderingQueue::isDepthPrePassEnabled() const {
+	return this->depthPrePass;
+}
+
+void RenderingQueue::setWeightedTransparency(const bool enabled) {
+	this->weightedTransparency = enabled;
+}
+
+bool RenderingQueue::isWeightedTransparencyEnabled() const {
+	return this->weightedTransparency;
+}
+
+void RenderingQueue::setResolutionShift(const int32_t shift) {
+	this->resolutionShift = shift;
 }
\ No newline at end of file
@@ -1,23 +1,59 @@
 #pragma once
 
+#include "LightSystem.hpp"
+#include "Mesh.hpp"
 #include <glm/glm.hpp>
 #include <vector>
 
 /**
- * Foward declaration of the mesh class.
+ * Foward declaration of the material class.
  */
-class Mesh;
+class Material;
 
 /**
- * Foward declaration of the material class.
+ * Foward declaration of the shader class.
  */
-class Material;
+class Shader;
+
+/**
+ * Foward declaration of the texture class.
+ */
+class Texture;
 
 class RenderingQueue {
+public:
+	/**
+	 * Everything needed to draw an object.
+	 */
+	struct Renderable {
+		Mesh* mesh;
+		Material* material;
+		glm::mat4 modelMatrix;
+		uint32_t lod;
+		float fade;
+		uint32_t firstRange; /* First index range left by the meshlet culling */
+		uint32_t rangeCount; /* Amount of index ranges, 0 draws the whole level of detail */
+		LightSystem::ObjectLights lights; /* Lights reaching the object */
+		const Texture* lightmap; /* Baked lighting of static objects, nullptr if not lightmapped */
+		glm::vec4 lightmapScaleOffset; /* Rectangle of the object in the lightmap */
+		const Texture* reflections; /* Cubemap of the reflection probe around the object, nullptr reflects the sky */
+	};
 private:
-	std::vector<std::tuple<Mesh*, Material *, glm::mat4>> renderables;
+	std::vector<Renderable> renderables;
+	std::vector<int32_t> rangeCounts;
+	std::vector<const void*> rangeOffsets;
 
 	const bool closestFirst;
+	bool depthPrePass; /* Draws the depth of every object before shading them with an equal depth test */
+	bool weightedTransparency; /* Writes the targets of the weighted blended transparency, no sorting needed */
+	int32_t resolutionShift; /* Screen pixels per pixel of the target as a power of two */
+
+	/**
+	 * Draws the mesh of a renderable, only the ranges left by the meshlet culling if there are any.
+	 *
+	 * \param renderable The renderable to draw, its material must already be active.
+	 */
+	void draw(const Renderable& renderable) const;
 public:
 	/**
 	 * Creates a rendering queue.
@@ -32,16 +68,89 @@ public:
 	 * \param mesh The mesh to draw.
 	 * \param material The material to draw the mesh with.
 	 * \param modelMatrix The model matrix of the object to render.
+	 * \param lights The lights reaching the object.
+	 * \param lod The level of detail of the mesh to draw.
+	 * \param fade How much the object is dithered out (0-1), used while an impostor replaces it.
+	 * \param lightmap The lightmap of the object, nullptr if it is not lightmapped.
+	 * \param lightmapScaleOffset The rectangle of the object in the lightmap (scale.xy, offset.xy).
+	 * \param reflections The cubemap of the reflection probe around the object, nullptr to reflect the sky.
+	 */
+	void addRenderable(Mesh* mesh, Material* material, const glm::mat4& modelMatrix, const LightSystem::ObjectLights& lights, const uint32_t lod = 0, const float fade = 0.0f, const Texture* lightmap = nullptr, const glm::vec4& lightmapScaleOffset = glm::vec4(0.0f), const Texture* reflections = nullptr);
+
+	/**
+	 * Adds a renderable at full detail, only keeping the meshlets visible from the camera.
+	 * Nothing is added if every meshlet gets culled.
+	 *
+	 * \param mesh The mesh to draw, it must have meshlets.
+	 * \param material The material to draw the mesh with.
+	 * \param modelMatrix The model matrix of the object to render.
+	 * \param lights The lights reaching the object.
+	 * \param fade How much the object is dithered out (0-1), used while an impostor replaces it.
+	 * \param cameraMatrix The camera's combined matrix.
+	 * \param viewPoint The point the scene is rendered from.
+	 * \param statistics The counters to accumulate the culling results in.
+	 * \param lightmap The lightmap of the object, nullptr if it is not lightmapped.
+	 * \param lightmapScaleOffset The rectangle of the object in the lightmap (scale.xy, offset.xy).
+	 * \param reflections The cubemap of the reflection probe around the object, nullptr to reflect the sky.
+	 * \return The amount of visible triangles.
 	 */
-	void addRenderable(Mesh* mesh, Material* material, const glm::mat4& modelMatrix);
+	uint32_t addCulledRenderable(Mesh* mesh, Material* material, const glm::mat4& modelMatrix, const LightSystem::ObjectLights& lights, const float fade, const glm::mat4& cameraMatrix, const glm::vec3& viewPoint, Mesh::CullingStatistics& statistics, const Texture* lightmap = nullptr, const glm::vec4& lightmapScaleOffset = glm::vec4(0.0f), const Texture* reflections = nullptr);
 
 	/**
 	 * Renders all of the objects in the queue.
 	 * 
 	 * \param cameraMatrix The camera's combined matrix.
 	 * \param viewPoint The point the scene is rendered from.
+	 * \param shaderOverride A shader to draw every object with instead of the ones of their materials.
+	 */
+	void render(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint, const Shader* shaderOverride = nullptr);
+
+	/**
+	 * Getter for the amount of objects in the queue.
+	 *
+	 * \return The objects to render.
+	 */
+	size_t getRenderableCount() const;
+
+	/**
+	 * Toggles the depth pre-pass: the objects are first drawn with depth only shaders, so the color pass only shades
+	 * the visible fragment of every pixel. Alpha tested materials discard the same fragments in both passes.
+	 * Only meant for opaque queues, as the color pass doesn't write depth.
+	 *
+	 * \param enabled The new state.
+	 */
+	void setDepthPrePass(const bool enabled);
+
+	/**
+	 * Getter for the state of the depth pre-pass.
+	 *
+	 * \return True if the depth is drawn before the colors.
+	 */
+	bool isDepthPrePassEnabled() const;
+
+	/**
+	 * Toggles the weighted blended transparency: the shaders write weighted colors and revealage instead of their
+	 * blended color, so the objects are drawn in any order and the queue is not sorted.
+	 * The targets and the blending must already be set up, see Renderer::setOrderIndependentTransparency.
+	 *
+	 * \param enabled The new state.
+	 */
+	void setWeightedTransparency(const bool enabled);
+
+	/**
+	 * Getter for the state of the weighted blended transparency.
+	 *
+	 * \return True if the queue writes the weighted targets.
+	 */
+	bool isWeightedTransparencyEnabled() const;
+
+	/**
+	 * Sets how much smaller than the screen the target the queue is drawn into is, so the shaders still find the
+	 * light clusters of their pixels. See Renderer::setReducedResolutionTransparency.
+	 *
+	 * \param shift Screen pixels per pixel of the target as a power of two, 0 at full resolution.
 	 */
-	void render(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint);
+	void setResolutionShift(const int32_t shift);
 
 	/**
 	 * Removes all the objects from the queue.
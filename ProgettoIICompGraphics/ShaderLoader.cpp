@@ -10,6 +10,7 @@
 
 namespace ShaderLoader {
 	static std::unordered_map<std::string, std::shared_ptr<Shader>> loadedShaders;
+	static std::unordered_map<std::string, std::string> depthVariants; // Depth only shader picked for each shader name
 
 	static constexpr const char* SHADER_ASSET_DIR = "assets/shaders/";
 	static constexpr const char* SHADER_ASSET_FILE_EXTENSION = ".shader";
@@ -18,7 +19,13 @@ namespace ShaderLoader {
 	static constexpr const char* VERTEX_KEY = "vertex";
 	static constexpr const char* FRAGMENT_KEY = "fragment";
 
+	static constexpr const char* DEPTH_SHADER = "depth";
+	static constexpr const char* DEPTH_VARIANT_SUFFIX = "_depth";
+
+	static constexpr const char* INCLUDE_DIRECTIVE = "#include";
+
 	static std::string readShaderSource(const std::string& shaderFile);
+	static std::string resolveIncludes(const std::string& source, const std::string& shaderFile);
 	static std::pair<std::string, std::string> readShaderAssetFile(const std::string& shaderAssetFile);
 }
 
@@ -37,7 +44,31 @@ std::string ShaderLoader::readShaderSource(const std::string& shaderFile) {
 	std::string contents(static_cast<uint64_t>(size), ' ');
 	file.read(&contents[0], static_cast<int64_t>(contents.size()));
 	file.close();
-	return contents;
+	return resolveIncludes(contents, shaderFile);
+}
+
+std::string ShaderLoader::resolveIncludes(const std::string& source, const std::string& shaderFile) {
+	// GLSL has no includes, paste the shared sources (e.g.: vertex_decode.glsl) in place of their directive
+	std::istringstream lines(source);
+	std::ostringstream resolved;
+	std::string line;
+	uint32_t lineNumber = 0;
+	while (std::getline(lines, line)) {
+		++lineNumber;
+		if (line.rfind(INCLUDE_DIRECTIVE, 0) != 0) {
+			resolved << line << '\n';
+			continue;
+		}
+		const size_t nameStart = line.find('"');
+		const size_t nameEnd = line.find('"', nameStart + 1);
+		if (nameStart == std::string::npos || nameEnd == std::string::npos) {
+			throw std::runtime_error("Malformed include in shader file: " + shaderFile);
+		}
+		// Included files can include others, the line directive keeps the compiler's errors on the right lines
+		resolved << "#line 1\n" << readShaderSource(SHADER_SOURCE_DIR + line.substr(nameStart + 1, nameEnd - nameStart - 1)) << '\n';
+		resolved << "#line " << lineNumber + 1 << '\n';
+	}
+	return resolved.str();
 }
 
 std::pair<std::string, std::string> ShaderLoader::readShaderAssetFile(const std::string& shaderAssetFile) {
@@ -87,8 +118,20 @@ std::shared_ptr<Shader> ShaderLoader::load(const std::string& shaderAssetFileNam
 	return loadedShaders.at(shaderAssetFileName);
 }
 
+std::shared_ptr<Shader> ShaderLoader::loadDepthVariant(const std::string& shaderAssetFileName) {
+	// Shaders that move their vertices or discard in their own way have a variant next to them, the file is only looked for once
+	auto variant = depthVariants.find(shaderAssetFileName);
+	if (variant == depthVariants.end()) {
+		const std::string variantName = shaderAssetFileName + DEPTH_VARIANT_SUFFIX;
+		const bool hasVariant = std::ifstream(SHADER_ASSET_DIR + variantName + SHADER_ASSET_FILE_EXTENSION).is_open();
+		variant = depthVariants.emplace(shaderAssetFileName, hasVariant ? variantName : DEPTH_SHADER).first;
+	}
+	return ShaderLoader::load(variant->second);
+}
+
 void ShaderLoader::unloadAll() {
 	loadedShaders.clear();
+	depthVariants.clear();
 }
 
 bool ShaderLoader::isLoaded(const std::string& shaderAssetFileName) {
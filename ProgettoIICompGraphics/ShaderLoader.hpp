@@ -8,6 +8,8 @@ class Shader;
 
 namespace ShaderLoader {
 	std::shared_ptr<Shader> load(const std::string& shaderAssetFileName);
+	// Depth only shader of another one: its "<name>_depth" asset if there is one, the plain depth shader otherwise
+	std::shared_ptr<Shader> loadDepthVariant(const std::string& shaderAssetFileName);
 	void unloadAll();
 
 	bool isLoaded(const std::string& shaderAssetFileName);
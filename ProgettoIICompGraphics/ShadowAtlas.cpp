@@ -0,0 +1,529 @@
+#include "ShadowAtlas.hpp"
+
+#include "BoundingBox.hpp"
+#include "CubeFaces.hpp"
+#include "FrameBuffer.hpp"
+#include "Hash.hpp"
+#include "LightSystem.hpp"
+#include "Material.hpp"
+#include "Mesh.hpp"
+#include "MeshInstanceNode.hpp"
+#include "Shader.hpp"
+#include "ShaderLoader.hpp"
+#include "Texture2D.hpp"
+#include "UniformBuffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace ShadowAtlas {
+	// Point light faces are a bit wider than 90 degrees, so fragments next to their edges still land inside the tile
+	static constexpr float POINT_FACE_FOV = 95.0f;
+	static constexpr float NEAR_PLANE = 0.05f;
+	// Tiles of the lights out of the view shrink by this much, they are kept so their casters stay cached
+	static constexpr float HIDDEN_LIGHT_SCALE = 0.25f;
+	// Slope scaled depth bias of the casters, the shaders also move the receivers along their normal
+	static constexpr float SLOPE_BIAS = 1.5f;
+	static constexpr float CONSTANT_BIAS = 4.0f;
+
+	/**
+	 * Layout of the shadowsBuffer uniform block (std140).
+	 */
+	struct ShadowParameters {
+		glm::mat4 matrices[MAX_TILES]; /* World space to the texture space of the atlas, depth included */
+		glm::vec4 rects[MAX_TILES]; /* Texture space bounds of the tiles, a texel inside their edges (min.xy, max.xy) */
+		glm::vec4 texels[MAX_TILES]; /* World size of a texel (x), per unit of distance from the light if perspective (y = 1) */
+		glm::vec4 settings; /* 1 if enabled (x), texture space size of a texel (y) */
+	};
+
+	/**
+	 * A light with shadows and its tiles.
+	 */
+	struct ShadowLight {
+		size_t index; /* Slot in the LightSystem */
+		uint32_t firstTile;
+		uint32_t tileCount;
+		int32_t wantedSize; /* Size asked by the importance of the light, 0 if it has no tiles */
+		int32_t tileSize; /* Size packed in the atlas, can be smaller than the wanted one */
+		LightSystem::Light drawnLight; /* The light the tiles were set up for */
+		bool staticDirty; /* The static casters have to be drawn again */
+		uint64_t dynamicKey; /* Hash of the moving casters drawn on top of the static ones */
+	};
+
+	/**
+	 * A tile of the atlas.
+	 */
+	struct Tile {
+		glm::ivec2 origin; /* First texel in the atlas */
+		glm::mat4 cameraMatrix; /* Projection and view of the light through the tile */
+	};
+
+	/**
+	 * The motion of a shadow caster.
+	 */
+	struct Caster {
+		glm::mat4 matrix; /* World matrix at the last update */
+		glm::vec3 minValues; /* World bounds at the last update */
+		glm::vec3 maxValues;
+		uint32_t stillFrames; /* Updates since it last moved, up to STILL_FRAMES */
+	};
+
+	static std::unique_ptr<UniformBuffer> shadowsBuffer = nullptr;
+	static std::unique_ptr<FrameBuffer> staticAtlas = nullptr;
+	static std::unique_ptr<FrameBuffer> atlas = nullptr;
+	static std::shared_ptr<Shader> shader = nullptr;
+	static ShadowParameters parameters{};
+	static std::vector<ShadowLight> shadowLights;
+	static Tile tiles[MAX_TILES];
+	static uint32_t tileCount = 0;
+	static glm::vec3 directionalMin(0.0f);
+	static glm::vec3 directionalMax(0.0f);
+	static bool directionalBounds = false;
+	static bool enabled = true;
+	static Statistics statistics{};
+
+	// Casters seen so far and the per frame lists
+	static std::unordered_map<const MeshInstanceNode*, Caster> casters;
+	static std::vector<const MeshInstanceNode*> staticCasters;
+	static std::vector<const MeshInstanceNode*> movingCasters;
+	static std::vector<std::pair<glm::vec3, glm::vec3>> staticChanges;
+
+	/**
+	 * Picks the size of the tiles of a light from how large its range appears on screen.
+	 *
+	 * \param light The light.
+	 * \param cameraMatrix The camera's combined matrix.
+	 * \param viewPoint The view point in the scene.
+	 * \param pixelsPerUnit Size in pixels of one world unit at a distance of one.
+	 * \return The texels on each side of the tiles, 0 if the light gets none.
+	 */
+	static int32_t importanceSize(const LightSystem::Light& light, const glm::mat4& cameraMatrix, const glm::vec3& viewPoint, const float pixelsPerUnit);
+
+	/**
+	 * Packs the tiles of every light in the atlas, largest first, halving the largest ones until they all fit.
+	 * The lights whose tiles moved or changed size get their static casters drawn again.
+	 *
+	 */
+	static void pack();
+
+	/**
+	 * Computes the matrices of the tiles of a light and stores them in the parameters.
+	 *
+	 * \param shadowLight The light.
+	 */
+	static void setupTiles(const ShadowLight& shadowLight);
+
+	/**
+	 * Checks if a box casts shadows in any tile of a light.
+	 *
+	 * \param shadowLight The light.
+	 * \param minValues The minimum corner of the box.
+	 * \param maxValues The maximum corner of the box.
+	 * \return True if the box is inside the frustum of a tile.
+	 */
+	static bool reaches(const ShadowLight& shadowLight, const glm::vec3& minValues, const glm::vec3& maxValues);
+
+	/**
+	 * Draws the casters inside a tile of the bound atlas.
+	 *
+	 * \param list The casters to draw.
+	 * \param tile The tile to draw in.
+	 * \param size The texels on each side of the tile.
+	 * \param fullDetail Draws the full detail meshes instead of the levels the casters were last drawn with.
+	 */
+	static void drawCasters(const std::vector<const MeshInstanceNode*>& list, const Tile& tile, const int32_t size, const bool fullDetail);
+
+	/**
+	 * Uploads the parameters to the uniform block.
+	 *
+	 */
+	static void upload();
+}
+
+int32_t ShadowAtlas::importanceSize(const LightSystem::Light& light, const glm::mat4& cameraMatrix, const glm::vec3& viewPoint, const float pixelsPerUnit) {
+	switch (light.type) {
+		case LightSystem::LIGHT_TYPE::DIRECTIONAL:
+			return directionalBounds ? DIRECTIONAL_TILE_SIZE : 0;
+		case LightSystem::LIGHT_TYPE::POINT:
+		case LightSystem::LIGHT_TYPE::SPOT: {
+			// Diameter in pixels of the range, as if the camera were never inside it
+			float pixels = 2.0f * light.range / glm::max(glm::distance(viewPoint, light.position), light.range) * pixelsPerUnit;
+			if (BoundingBox(light.position - light.range, light.position + light.range).isCulled(cameraMatrix)) {
+				pixels *= HIDDEN_LIGHT_SCALE;
+			}
+			// Point lights split the same texels among their faces
+			if (light.type == LightSystem::LIGHT_TYPE::POINT) {
+				pixels *= 0.5f;
+			}
+			int32_t size = MIN_TILE_SIZE;
+			while (size < MAX_TILE_SIZE && static_cast<float>(size) < pixels) {
+				size *= 2;
+			}
+			return size;
+		}
+		default:
+			return 0;
+	}
+}
+
+void ShadowAtlas::pack() {
+	std::vector<ShadowLight*> order;
+	uint64_t area = 0;
+	for (ShadowLight& shadowLight : shadowLights) {
+		shadowLight.staticDirty |= shadowLight.tileSize != shadowLight.wantedSize;
+		shadowLight.tileSize = shadowLight.wantedSize;
+		if (shadowLight.tileSize > 0) {
+			order.emplace_back(&shadowLight);
+			area += static_cast<uint64_t>(shadowLight.tileCount) * shadowLight.tileSize * shadowLight.tileSize;
+		}
+	}
+	const uint64_t capacity = static_cast<uint64_t>(ATLAS_SIZE) * ATLAS_SIZE;
+	while (area > capacity) {
+		ShadowLight* largest = nullptr;
+		for (ShadowLight* shadowLight : order) {
+			if (shadowLight->tileSize > MIN_TILE_SIZE && (!largest || shadowLight->tileSize > largest->tileSize)) {
+				largest = shadowLight;
+			}
+		}
+		if (!largest) {
+			throw std::runtime_error("Too many shadow tiles for the atlas: " + std::to_string(tileCount));
+		}
+		const uint64_t tileArea = static_cast<uint64_t>(largest->tileSize) * largest->tileSize;
+		area -= largest->tileCount * (tileArea - tileArea / 4);
+		largest->tileSize /= 2;
+		largest->staticDirty = true;
+	}
+	// Power of two squares laid out largest first along a Morton curve of the smallest tiles never overlap
+	std::stable_sort(order.begin(), order.end(), [](const ShadowLight* first, const ShadowLight* second) {
+		return first->tileSize > second->tileSize;
+	});
+	uint64_t offset = 0;
+	for (ShadowLight* shadowLight : order) {
+		for (uint32_t i = 0; i < shadowLight->tileCount; ++i) {
+			const uint64_t cell = offset / (static_cast<uint64_t>(MIN_TILE_SIZE) * MIN_TILE_SIZE);
+			glm::ivec2 origin(0);
+			for (uint32_t bit = 0; bit < 16; ++bit) {
+				origin.x |= static_cast<int32_t>((cell >> (2 * bit)) & 1) << bit;
+				origin.y |= static_cast<int32_t>((cell >> (2 * bit + 1)) & 1) << bit;
+			}
+			origin *= MIN_TILE_SIZE;
+			Tile& tile = tiles[shadowLight->firstTile + i];
+			shadowLight->staticDirty |= tile.origin != origin;
+			tile.origin = origin;
+			offset += static_cast<uint64_t>(shadowLight->tileSize) * shadowLight->tileSize;
+		}
+	}
+	for (const ShadowLight& shadowLight : shadowLights) {
+		if (shadowLight.staticDirty) {
+			ShadowAtlas::setupTiles(shadowLight);
+		}
+	}
+}
+
+void ShadowAtlas::setupTiles(const ShadowLight& shadowLight) {
+	const LightSystem::Light& light = shadowLight.drawnLight;
+	const float size = static_cast<float>(shadowLight.tileSize);
+	for (uint32_t i = 0; i < shadowLight.tileCount; ++i) {
+		const uint32_t index = shadowLight.firstTile + i;
+		Tile& tile = tiles[index];
+		glm::vec4 texel(0.0f);
+		if (shadowLight.tileSize == 0) {
+			tile.cameraMatrix = glm::mat4(1.0f);
+		} else if (light.type == LightSystem::LIGHT_TYPE::DIRECTIONAL) {
+			// Orthographic projection fit around the bounds, seen from the light
+			const glm::vec3 center = (directionalMin + directionalMax) * 0.5f;
+			const float radius = glm::max(glm::distance(directionalMin, directionalMax) * 0.5f, NEAR_PLANE);
+			const glm::vec3 up = std::abs(light.direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			const glm::mat4 viewMatrix = glm::lookAt(center - light.direction * radius, center, up);
+			glm::vec3 minView(std::numeric_limits<float>::max());
+			glm::vec3 maxView(std::numeric_limits<float>::lowest());
+			for (uint32_t corner = 0; corner < 8; ++corner) {
+				const glm::vec3 point((corner & 1) ? directionalMax.x : directionalMin.x, (corner & 2) ? directionalMax.y : directionalMin.y, (corner & 4) ? directionalMax.z : directionalMin.z);
+				const glm::vec3 viewPoint = glm::vec3(viewMatrix * glm::vec4(point, 1.0f));
+				minView = glm::min(minView, viewPoint);
+				maxView = glm::max(maxView, viewPoint);
+			}
+			tile.cameraMatrix = glm::ortho(minView.x, maxView.x, minView.y, maxView.y, -maxView.z, -minView.z) * viewMatrix;
+			texel = glm::vec4(glm::max(maxView.x - minView.x, maxView.y - minView.y) / size, 0.0f, 0.0f, 0.0f);
+		} else {
+			// Perspective projection through the cone of spot lights or a cube face of point lights
+			const bool point = light.type == LightSystem::LIGHT_TYPE::POINT;
+			const glm::vec3 direction = point ? CubeFaces::DIRECTIONS[i] : light.direction;
+			const glm::vec3 up = point ? CubeFaces::UPS[i] : (std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+			const float fov = point ? glm::radians(POINT_FACE_FOV) : glm::clamp(2.0f * std::acos(glm::clamp(light.outerCutOff, -1.0f, 1.0f)), glm::radians(10.0f), glm::radians(170.0f));
+			tile.cameraMatrix = glm::perspective(fov, 1.0f, NEAR_PLANE, glm::max(light.range, NEAR_PLANE * 2.0f)) * glm::lookAt(light.position, light.position + direction, up);
+			texel = glm::vec4(2.0f * std::tan(fov * 0.5f) / size, 1.0f, 0.0f, 0.0f);
+		}
+		// From clip space to the tile's rectangle of the atlas, depth to [0, 1]
+		const glm::vec2 scale = glm::vec2(size / static_cast<float>(ATLAS_SIZE));
+		const glm::vec2 offset = glm::vec2(tile.origin) / static_cast<float>(ATLAS_SIZE);
+		glm::mat4 toAtlas(1.0f);
+		toAtlas[0][0] = scale.x * 0.5f;
+		toAtlas[1][1] = scale.y * 0.5f;
+		toAtlas[2][2] = 0.5f;
+		toAtlas[3] = glm::vec4(offset + scale * 0.5f, 0.5f, 1.0f);
+		parameters.matrices[index] = toAtlas * tile.cameraMatrix;
+		parameters.rects[index] = glm::vec4(offset + 1.0f / ATLAS_SIZE, offset + scale - 1.0f / ATLAS_SIZE);
+		parameters.texels[index] = texel;
+	}
+}
+
+bool ShadowAtlas::reaches(const ShadowLight& shadowLight, const glm::vec3& minValues, const glm::vec3& maxValues) {
+	const BoundingBox box(minValues, maxValues);
+	for (uint32_t i = 0; i < shadowLight.tileCount; ++i) {
+		if (!box.isCulled(tiles[shadowLight.firstTile + i].cameraMatrix)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void ShadowAtlas::drawCasters(const std::vector<const MeshInstanceNode*>& list, const Tile& tile, const int32_t size, const bool fullDetail) {
+	glViewport(tile.origin.x, tile.origin.y, size, size);
+	glScissor(tile.origin.x, tile.origin.y, size, size);
+	for (const MeshInstanceNode* caster : list) {
+		if (caster->getBoundingBox().isCulled(tile.cameraMatrix)) {
+			continue;
+		}
+		const Material* material = caster->getMaterial().get();
+		material->activate(shader.get());
+		shader->setUniform("cameraMatrix", tile.cameraMatrix);
+		shader->setUniform("objMatrix", caster->getWorldTransform().getTransformMatrix());
+		caster->getMesh()->setDecodingUniforms(shader.get());
+		caster->getMesh()->draw(fullDetail ? 0 : caster->getLodLevel());
+		material->deactivate();
+		++statistics.drawnCasters;
+	}
+}
+
+void ShadowAtlas::upload() {
+	parameters.settings = glm::vec4(enabled ? 1.0f : 0.0f, 1.0f / ATLAS_SIZE, 0.0f, 0.0f);
+	shadowsBuffer->bind();
+	shadowsBuffer->uploadSubData(&parameters, sizeof(ShadowParameters), 0);
+	shadowsBuffer->unbind();
+}
+
+void ShadowAtlas::initialize() {
+	shadowsBuffer = std::make_unique<UniformBuffer>(false);
+	shadowsBuffer->bind();
+	shadowsBuffer->uploadData(sizeof(ShadowParameters));
+	shadowsBuffer->unbind();
+	staticAtlas = std::make_unique<FrameBuffer>(ATLAS_SIZE, ATLAS_SIZE, std::vector<int32_t>{}, true, true);
+	atlas = std::make_unique<FrameBuffer>(ATLAS_SIZE, ATLAS_SIZE, std::vector<int32_t>{}, true, true);
+	// Hardware comparison, every tap is a bilinear blend of four depth tests
+	const std::shared_ptr<Texture2D>& depth = atlas->getDepthAttachment();
+	depth->bind();
+	depth->setParameters({
+		{ GL_TEXTURE_MIN_FILTER, GL_LINEAR },
+		{ GL_TEXTURE_MAG_FILTER, GL_LINEAR },
+		{ GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE },
+		{ GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL }
+	});
+	depth->unbind();
+	shader = ShaderLoader::load("shadow");
+	ShadowAtlas::upload();
+}
+
+void ShadowAtlas::addLight(const size_t light) {
+	const std::vector<LightSystem::Light>& lights = LightSystem::getAllLights();
+	if (light >= lights.size()) {
+		throw std::runtime_error("Light " + std::to_string(light) + " has to be set before it casts shadows!");
+	}
+	const uint32_t count = lights[light].type == LightSystem::LIGHT_TYPE::POINT ? CubeFaces::COUNT : 1;
+	if (tileCount + count > MAX_TILES) {
+		throw std::runtime_error("Too many shadow tiles, light " + std::to_string(light) + " needs " + std::to_string(count) + " more");
+	}
+	ShadowLight shadowLight{};
+	shadowLight.index = light;
+	shadowLight.firstTile = tileCount;
+	shadowLight.tileCount = count;
+	shadowLight.staticDirty = true;
+	shadowLights.emplace_back(shadowLight);
+	tileCount += count;
+	LightSystem::setShadow(light, shadowLight.firstTile + 1);
+}
+
+void ShadowAtlas::setDirectionalBounds(const glm::vec3& minValues, const glm::vec3& maxValues) {
+	directionalMin = minValues;
+	directionalMax = maxValues;
+	directionalBounds = true;
+	for (ShadowLight& shadowLight : shadowLights) {
+		if (shadowLight.drawnLight.type == LightSystem::LIGHT_TYPE::DIRECTIONAL) {
+			shadowLight.staticDirty = true;
+			ShadowAtlas::setupTiles(shadowLight);
+		}
+	}
+}
+
+void ShadowAtlas::update(const std::vector<MeshInstanceNode*>& renderables, const glm::mat4& cameraMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPoint) {
+	statistics = Statistics{ tileCount, 0, 0, 0, 0 };
+	if (!enabled || shadowLights.empty()) {
+		return;
+	}
+	// Sort the opaque casters by motion, the boxes entering or leaving the static ones dirty the tiles they reach
+	staticCasters.clear();
+	movingCasters.clear();
+	staticChanges.clear();
+	for (const MeshInstanceNode* renderable : renderables) {
+		if (renderable->getMaterial()->transparentFlag || renderable->getMesh()->drawType != GL_TRIANGLES) {
+			continue;
+		}
+		const BoundingBox box = renderable->getBoundingBox();
+		const glm::mat4& matrix = renderable->getWorldTransform().getTransformMatrix();
+		const auto [entry, inserted] = casters.try_emplace(renderable, Caster{ matrix, box.getMinValues(), box.getMaxValues(), STILL_FRAMES });
+		Caster& caster = entry->second;
+		if (inserted) {
+			staticChanges.emplace_back(box.getMinValues(), box.getMaxValues());
+		} else if (caster.matrix != matrix) {
+			if (caster.stillFrames >= STILL_FRAMES) {
+				staticChanges.emplace_back(caster.minValues, caster.maxValues);
+			}
+			caster = Caster{ matrix, box.getMinValues(), box.getMaxValues(), 0 };
+		} else if (caster.stillFrames < STILL_FRAMES && ++caster.stillFrames == STILL_FRAMES) {
+			staticChanges.emplace_back(box.getMinValues(), box.getMaxValues());
+		}
+		(caster.stillFrames >= STILL_FRAMES ? staticCasters : movingCasters).emplace_back(renderable);
+	}
+	statistics.movingCasters = static_cast<uint32_t>(movingCasters.size());
+	// Follow the changes of the lights and size their tiles for the camera
+	int32_t viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	const float pixelsPerUnit = projectionMatrix[1][1] * static_cast<float>(viewport[3]) * 0.5f;
+	const std::vector<LightSystem::Light>& lights = LightSystem::getAllLights();
+	bool repack = false;
+	bool changed = false;
+	for (ShadowLight& shadowLight : shadowLights) {
+		const LightSystem::Light light = shadowLight.index < lights.size() ? lights[shadowLight.index] : LightSystem::Light{};
+		// Setting a light again unlinks it from its tiles
+		LightSystem::setShadow(shadowLight.index, shadowLight.firstTile + 1);
+		LightSystem::Light compared = light;
+		compared.shadow = shadowLight.drawnLight.shadow;
+		if (std::memcmp(&compared, &shadowLight.drawnLight, sizeof(LightSystem::Light)) != 0) {
+			shadowLight.drawnLight = compared;
+			shadowLight.staticDirty = true;
+			ShadowAtlas::setupTiles(shadowLight);
+			changed = true;
+		}
+		int32_t size = importanceSize(light, cameraMatrix, viewPoint, pixelsPerUnit);
+		// Only shrink once the light asks for less than half the texels, so sizes don't flicker between two levels
+		if (size < shadowLight.wantedSize && size * 2 >= shadowLight.wantedSize) {
+			size = shadowLight.wantedSize;
+		}
+		if (size != shadowLight.wantedSize) {
+			shadowLight.wantedSize = size;
+			repack = true;
+		}
+	}
+	if (repack) {
+		ShadowAtlas::pack();
+		changed = true;
+	}
+	if (changed) {
+		ShadowAtlas::upload();
+	}
+	for (ShadowLight& shadowLight : shadowLights) {
+		for (const auto& [minValues, maxValues] : staticChanges) {
+			if (!shadowLight.staticDirty && reaches(shadowLight, minValues, maxValues)) {
+				shadowLight.staticDirty = true;
+			}
+		}
+	}
+	// Draw the tiles whose static or moving casters changed
+	glEnable(GL_SCISSOR_TEST);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glEnable(GL_DEPTH_CLAMP);
+	glPolygonOffset(SLOPE_BIAS, CONSTANT_BIAS);
+	for (ShadowLight& shadowLight : shadowLights) {
+		if (shadowLight.tileSize == 0) {
+			continue;
+		}
+		bool composite = false;
+		if (shadowLight.staticDirty) {
+			staticAtlas->bind();
+			for (uint32_t i = 0; i < shadowLight.tileCount; ++i) {
+				const Tile& tile = tiles[shadowLight.firstTile + i];
+				glScissor(tile.origin.x, tile.origin.y, shadowLight.tileSize, shadowLight.tileSize);
+				glClear(GL_DEPTH_BUFFER_BIT);
+				drawCasters(staticCasters, tile, shadowLight.tileSize, true);
+			}
+			shadowLight.staticDirty = false;
+			statistics.staticTiles += shadowLight.tileCount;
+			composite = true;
+		}
+		// FNV-1a over the moving casters reaching the light
+		uint64_t key = Hash::FNV_OFFSET_BASIS;
+		const auto add = [&key](const void* data, const size_t size) {
+			key = Hash::fnv1a(data, size, key);
+		};
+		for (const MeshInstanceNode* caster : movingCasters) {
+			const BoundingBox box = caster->getBoundingBox();
+			if (reaches(shadowLight, box.getMinValues(), box.getMaxValues())) {
+				const uint32_t lod = caster->getLodLevel();
+				add(&caster, sizeof(caster));
+				add(&caster->getWorldTransform().getTransformMatrix(), sizeof(glm::mat4));
+				add(&lod, sizeof(lod));
+			}
+		}
+		if (!composite && key == shadowLight.dynamicKey) {
+			continue;
+		}
+		shadowLight.dynamicKey = key;
+		statistics.dynamicTiles += shadowLight.tileCount;
+		for (uint32_t i = 0; i < shadowLight.tileCount; ++i) {
+			const Tile& tile = tiles[shadowLight.firstTile + i];
+			const glm::ivec2 end = tile.origin + shadowLight.tileSize;
+			glScissor(tile.origin.x, tile.origin.y, shadowLight.tileSize, shadowLight.tileSize);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, staticAtlas->id);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, atlas->id);
+			glBlitFramebuffer(tile.origin.x, tile.origin.y, end.x, end.y, tile.origin.x, tile.origin.y, end.x, end.y, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+			atlas->bind();
+			drawCasters(movingCasters, tile, shadowLight.tileSize, false);
+		}
+	}
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_DEPTH_CLAMP);
+	atlas->unbind();
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void ShadowAtlas::enable(const Shader* shader) {
+	shadowsBuffer->activate(BINDING_POINT);
+	const uint32_t blockIndex = glGetUniformBlockIndex(shader->id, "shadowsBuffer");
+	if (blockIndex != GL_INVALID_INDEX) {
+		glUniformBlockBinding(shader->id, blockIndex, BINDING_POINT);
+	}
+	atlas->getDepthAttachment()->activate(TEXTURE_UNIT);
+	shader->setUniform("shadowAtlas", TEXTURE_UNIT);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void ShadowAtlas::invalidate() {
+	for (ShadowLight& shadowLight : shadowLights) {
+		shadowLight.staticDirty = true;
+	}
+}
+
+void ShadowAtlas::setEnabled(const bool _enabled) {
+	// The casters may have moved while the tiles were not updated
+	if (_enabled && !enabled) {
+		ShadowAtlas::invalidate();
+	}
+	enabled = _enabled;
+	ShadowAtlas::upload();
+}
+
+bool ShadowAtlas::isEnabled() {
+	return enabled;
+}
+
+const ShadowAtlas::Statistics& ShadowAtlas::getStatistics() {
+	return statistics;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * Forward declaration of the mesh instance node class.
+ */
+class MeshInstanceNode;
+
+/**
+ * Forward declaration of the shader class.
+ */
+class Shader;
+
+/**
+ * Shadow maps of the lights of the LightSystem, packed as square tiles of a single depth atlas and cached between frames.
+ * Directional lights get a tile over fixed bounds, spot lights a tile over their cone, point lights a tile per cube face.
+ * Tiles are sized by how large the range of their light appears on screen and packed again when a size changes.
+ * Casters are static once they haven't moved for STILL_FRAMES frames: they are drawn in a static copy of the atlas only
+ * when a light, a tile or a static caster changes. Every frame, only the tiles whose moving casters changed get their
+ * static depth copied back and the moving casters drawn on top, the others are left untouched.
+ */
+namespace ShadowAtlas {
+	// Same values on shader
+	static constexpr uint32_t MAX_TILES = 32;
+	static constexpr uint32_t BINDING_POINT = 3;
+	static constexpr int32_t TEXTURE_UNIT = 10;
+
+	static constexpr int32_t ATLAS_SIZE = 4096;
+	static constexpr int32_t MIN_TILE_SIZE = 128;
+	static constexpr int32_t MAX_TILE_SIZE = 1024;
+	static constexpr int32_t DIRECTIONAL_TILE_SIZE = 2048;
+	// Frames a caster has to stay still before it is drawn with the static ones
+	static constexpr uint32_t STILL_FRAMES = 30;
+
+	/**
+	 * Counters of the last update.
+	 */
+	struct Statistics {
+		uint32_t tiles; /* Tiles in the atlas */
+		uint32_t staticTiles; /* Tiles whose static casters were drawn again */
+		uint32_t dynamicTiles; /* Tiles whose moving casters were drawn again */
+		uint32_t drawnCasters; /* Casters drawn in all the tiles */
+		uint32_t movingCasters; /* Casters that moved in the last STILL_FRAMES frames */
+	};
+
+	/**
+	 * Creates the atlases and the uniform block, must be called after LightSystem::initialize.
+	 *
+	 */
+	void initialize();
+
+	/**
+	 * Gives shadows to a light, it needs one tile or six for point lights.
+	 * The light must already be set in the LightSystem.
+	 *
+	 * \param light The slot of the light in the LightSystem.
+	 */
+	void addLight(const size_t light);
+
+	/**
+	 * Sets the box the shadows of the directional lights cover, there are none until it is set.
+	 *
+	 * \param minValues The minimum corner of the box.
+	 * \param maxValues The maximum corner of the box.
+	 */
+	void setDirectionalBounds(const glm::vec3& minValues, const glm::vec3& maxValues);
+
+	/**
+	 * Sizes and packs the tiles for the camera, then draws the tiles whose casters or lights changed.
+	 * Call it once per frame after LightSystem::flush, the viewport is kept.
+	 *
+	 * \param renderables The objects of the scene, the opaque ones cast shadows.
+	 * \param cameraMatrix The camera's combined matrix.
+	 * \param projectionMatrix The camera's projection matrix.
+	 * \param viewPoint The view point in the scene.
+	 */
+	void update(const std::vector<MeshInstanceNode*>& renderables, const glm::mat4& cameraMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPoint);
+
+	/**
+	 * Binds the uniform block and the atlas to a shader, the shader must already be active.
+	 *
+	 * \param shader The shader to bind the shadows to.
+	 */
+	void enable(const Shader* shader);
+
+	/**
+	 * Draws every tile again in the next update.
+	 *
+	 */
+	void invalidate();
+
+	/**
+	 * Toggles the shadows, the shaders skip the atlas when disabled and the tiles are not updated.
+	 *
+	 * \param _enabled The new state.
+	 */
+	void setEnabled(const bool _enabled);
+
+	/**
+	 * Getter for the state of the shadows.
+	 *
+	 * \return True if the lights cast shadows.
+	 */
+	bool isEnabled();
+
+	/**
+	 * Getter for the counters of the last update.
+	 *
+	 * \return The statistics of the last update.
+	 */
+	const Statistics& getStatistics();
+}
@@ -68,8 +68,8 @@ public:
 	void deactivate(const int32_t bindingPoint) const;
 
 	/**
-	 * Unbinds the texture
+	 * Unbinds the texture (virtual to allow override).
 	 *
 	 */
-	void unbind() const;
+	virtual void unbind() const;
 };
@@ -12,4 +12,11 @@ void Texture2D::uploadData(const int32_t width, const int32_t height, const uint
 	if (genMipMaps) {
 		glGenerateMipmap(this->textureType);
 	}
+}
+
+void Texture2D::uploadData(const int32_t width, const int32_t height, const float* data, const bool genMipMaps) const {
+	glTexImage2D(this->textureType, 0, this->internalFormat, width, height, 0, this->externalFormat, GL_FLOAT, reinterpret_cast<const void *>(data));
+	if (genMipMaps) {
+		glGenerateMipmap(this->textureType);
+	}
 }
\ No newline at end of file
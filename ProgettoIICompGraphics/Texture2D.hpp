@@ -31,4 +31,14 @@ public:
 	 * \param genMipMaps Flag to generate mipmaps.
 	 */
 	void uploadData(const int32_t width, const int32_t height, const uint8_t* data, const bool genMipMaps = true) const;
+
+	/**
+	 * Uploads floating point texture data to the GPU (e.g.: for GL_RGB16F textures).
+	 *
+	 * \param width The witdth of the data image to put on the gpu.
+	 * \param height The height of the data image to put on the gpu.
+	 * \param data The data's reference pointer.
+	 * \param genMipMaps Flag to generate mipmaps.
+	 */
+	void uploadData(const int32_t width, const int32_t height, const float* data, const bool genMipMaps = true) const;
 };
@@ -0,0 +1,35 @@
+#include "TextureBuffer.hpp"
+
+#include <glad/glad.h>
+
+TextureBuffer::TextureBuffer(const int32_t _internalFormat)
+	:
+	Texture(GL_TEXTURE_BUFFER),
+	buffer(GL_TEXTURE_BUFFER, true),
+	internalFormat(_internalFormat)
+{
+	// The texture keeps pointing at the buffer when its storage gets reallocated
+	this->buffer.bind();
+	glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+	glTexBuffer(GL_TEXTURE_BUFFER, this->internalFormat, this->buffer.id);
+	this->buffer.unbind();
+}
+
+void TextureBuffer::uploadData(const void* data, const size_t size) const {
+	this->buffer.bind();
+	glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	if (data) {
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+	}
+	this->buffer.unbind();
+}
+
+void TextureBuffer::uploadSubData(const void* data, const size_t size, const size_t offset) const {
+	this->buffer.bind();
+	glBufferSubData(GL_TEXTURE_BUFFER, offset, size, data);
+	this->buffer.unbind();
+}
+
+void TextureBuffer::unbind() const {
+	glBindTexture(this->textureType, 0);
+}
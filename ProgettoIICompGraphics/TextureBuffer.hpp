@@ -0,0 +1,48 @@
+#pragma once
+
+#include "SimpleBuffer.hpp"
+#include "Texture.hpp"
+
+/**
+ * Buffer texture, lets shaders read large arrays with texelFetch where a uniform buffer would be too small.
+ */
+class TextureBuffer : public Texture {
+private:
+	const SimpleBuffer buffer;
+public:
+	const int32_t internalFormat;
+public:
+	// Erase copy constructors, as it would break opengl
+	TextureBuffer(const TextureBuffer&) = delete;
+	TextureBuffer& operator=(const TextureBuffer&) = delete;
+
+	/**
+	 * Creates a buffer texture and the buffer holding its texels.
+	 *
+	 * \param _internalFormat The format of a texel (e.g.: GL_RG32UI).
+	 */
+	TextureBuffer(const int32_t _internalFormat);
+
+	/**
+	 * Replaces the texels, the old storage is orphaned so the upload doesn't wait on draws still reading it.
+	 *
+	 * \param data The texels to upload, can be null to only allocate them.
+	 * \param size The size in bytes of the texels.
+	 */
+	void uploadData(const void* data, const size_t size) const;
+
+	/**
+	 * Overwrites part of the texels, the buffer must already be large enough.
+	 *
+	 * \param data The texels to upload.
+	 * \param size The size in bytes of the texels.
+	 * \param offset The offset in bytes from the start of the buffer.
+	 */
+	void uploadSubData(const void* data, const size_t size, const size_t offset) const;
+
+	/**
+	 * Unbinds the texture, buffer textures can't fall back to the dummy texture.
+	 *
+	 */
+	void unbind() const override;
+};
@@ -27,3 +27,11 @@ void TextureCubemap::uploadData(const int32_t width, const int32_t height, const
 	}
 	cubemapTextures[face].uploadData(width, height, data, false);
 }
+
+void TextureCubemap::uploadLevel(const int32_t size, const uint8_t* data, const uint32_t face, const int32_t level) const {
+	if (face >= 6) {
+		throw std::runtime_error("The face value passed to the cubemap does not exist");
+	}
+	this->bind();
+	glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(data));
+}
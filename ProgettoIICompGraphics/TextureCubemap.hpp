@@ -27,4 +27,14 @@ public:
 	 * \param face The face to set the data to.
 	 */
 	void uploadData(const int32_t width, const int32_t height, const uint8_t* data, const uint32_t face) const;
+
+	/**
+	 * Uploads a level of the mip chain of a face to the GPU.
+	 *
+	 * \param size The texels on each side of the level.
+	 * \param data The RGB texels of the level.
+	 * \param face The face to set the data to.
+	 * \param level The level of the mip chain, 0 being the largest.
+	 */
+	void uploadLevel(const int32_t size, const uint8_t* data, const uint32_t face, const int32_t level) const;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "TextureLoader.hpp"
 
+#include "CubemapPrefilter.hpp"
 #include "Texture.hpp"
 #include "Texture2D.hpp"
 #include "TextureCubemap.hpp"
@@ -16,6 +17,8 @@ namespace TextureLoader {
 	static std::tuple<int32_t, int32_t, int32_t, int32_t, uint8_t*> loadTextureData(const std::string& file, const bool flip = true);
 
 	static constexpr const char* TEXTURE_ASSET_DIR = "assets/textures/";
+	// Appended to the directory of a cubemap to tell its prefiltered mip chain apart from the faces
+	static constexpr const char* PREFILTERED_SUFFIX = "#prefiltered";
 }
 
 std::tuple<int32_t, int32_t, int32_t, int32_t, uint8_t*> TextureLoader::loadTextureData(const std::string& file, const bool flip) {
@@ -67,11 +70,29 @@ std::shared_ptr<Texture> TextureLoader::load(const std::string& textureName, con
 	return loadedTextures.at(textureName);
 }
 
-std::shared_ptr<Texture> TextureLoader::loadCubemap(const std::string& cubemapDirectory) {
+std::shared_ptr<Texture> TextureLoader::loadCubemap(const std::string& cubemapDirectory, const bool prefiltered) {
 	// Return null pointer if empty
 	if (cubemapDirectory.empty()) {
 		return nullptr;
 	}
+	if (prefiltered) {
+		const std::string cubemapName = cubemapDirectory + PREFILTERED_SUFFIX;
+		if (loadedCubemaps.find(cubemapName) != loadedCubemaps.end()) {
+			return loadedCubemaps.at(cubemapName);
+		}
+		// The cooked levels become the mip chain, so the roughness picks the level
+		const std::vector<CubemapPrefilter::Level> levels = CubemapPrefilter::load(cubemapDirectory);
+		const std::shared_ptr<TextureCubemap> cubemap = std::make_shared<TextureCubemap>();
+		for (size_t level = 0; level < levels.size(); ++level) {
+			for (uint32_t face = 0; face < 6; ++face) {
+				cubemap->uploadLevel(static_cast<int32_t>(levels[level].size), levels[level].faces[face].data(), face, static_cast<int32_t>(level));
+			}
+		}
+		cubemap->setParameter(GL_TEXTURE_MAX_LEVEL, static_cast<int32_t>(levels.size() - 1));
+		cubemap->setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		loadedCubemaps.emplace(cubemapName, cubemap);
+		return cubemap;
+	}
 	// If shader already loaded, return ref
 	if (loadedCubemaps.find(cubemapDirectory) != loadedCubemaps.end()) {
 		return loadedCubemaps.at(cubemapDirectory);
@@ -80,13 +101,17 @@ std::shared_ptr<Texture> TextureLoader::loadCubemap(const std::string& cubemapDi
 	loadedCubemaps.emplace(cubemapDirectory, std::make_shared<TextureCubemap>());
 	// Load faces of cubemap
 	for (uint32_t i = 0; i < 6; ++i) {
-		auto [imageWidth, imageHeight, inFormat, outFormat, data] = loadTextureData(TEXTURE_ASSET_DIR + cubemapDirectory + "/" + std::to_string(i) + ".jpg", false);
+		auto [imageWidth, imageHeight, inFormat, outFormat, data] = loadTextureData(getCubemapFacePath(cubemapDirectory, i), false);
 		loadedCubemaps.at(cubemapDirectory)->uploadData(imageWidth, imageHeight, data, i);
 		stbi_image_free(data);
 	}
 	return loadedCubemaps.at(cubemapDirectory);
 }
 
+std::string TextureLoader::getCubemapFacePath(const std::string& cubemapDirectory, const uint32_t face) {
+	return TEXTURE_ASSET_DIR + cubemapDirectory + "/" + std::to_string(face) + ".jpg";
+}
+
 void TextureLoader::unloadAll() {
 	loadedTextures.clear();
 	loadedCubemaps.clear();
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -8,7 +9,8 @@ class Texture;
 
 namespace TextureLoader {
 	std::shared_ptr<Texture> load(const std::string& textureName, const bool flipImage = false);
-	std::shared_ptr<Texture> loadCubemap(const std::string& cubemapDirectory);
+	std::shared_ptr<Texture> loadCubemap(const std::string& cubemapDirectory, const bool prefiltered = false);
+	std::string getCubemapFacePath(const std::string& cubemapDirectory, const uint32_t face);
 	void unloadAll();
 
 	bool isLoaded(const std::string& textureName);
@@ -0,0 +1,246 @@
+#include "TriangleBvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRIANGLE_BVH_SSE
+#include <emmintrin.h>
+#endif
+
+// Triangles whose determinant is this close to zero are parallel to the ray
+static constexpr float PARALLEL_EPSILON = 1e-10f;
+
+TriangleBvh::TriangleBvh(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+	:
+	nodes(),
+	packs(),
+	triangleCount(indices.size() / 3)
+{
+	const uint32_t count = static_cast<uint32_t>(this->triangleCount);
+	std::vector<Triangle> triangles;
+	std::vector<glm::vec3> centers;
+	triangles.reserve(count);
+	centers.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		const glm::vec3& a = positions[indices[i * 3]];
+		const glm::vec3& b = positions[indices[i * 3 + 1]];
+		const glm::vec3& c = positions[indices[i * 3 + 2]];
+		triangles.emplace_back(Triangle{ a, b - a, c - a, i });
+		centers.emplace_back((a + b + c) / 3.0f);
+	}
+	// A binary tree with a leaf per few triangles has less than twice as many nodes
+	this->nodes.reserve(2 * (count / MAX_LEAF_TRIANGLES + 1));
+	this->nodes.emplace_back(Node{ glm::vec3(0.0f), 0, glm::vec3(0.0f), count });
+	this->split(0, triangles, centers);
+	// Move the triangles of every leaf into its pack
+	for (Node& node : this->nodes) {
+		if (node.count == 0) {
+			continue;
+		}
+		TrianglePack pack{};
+		for (uint32_t lane = 0; lane < node.count; ++lane) {
+			const Triangle& triangle = triangles[node.first + lane];
+			pack.vertexX[lane] = triangle.vertex.x;
+			pack.vertexY[lane] = triangle.vertex.y;
+			pack.vertexZ[lane] = triangle.vertex.z;
+			pack.edge1X[lane] = triangle.edge1.x;
+			pack.edge1Y[lane] = triangle.edge1.y;
+			pack.edge1Z[lane] = triangle.edge1.z;
+			pack.edge2X[lane] = triangle.edge2.x;
+			pack.edge2Y[lane] = triangle.edge2.y;
+			pack.edge2Z[lane] = triangle.edge2.z;
+			pack.ids[lane] = triangle.id;
+		}
+		node.first = static_cast<uint32_t>(this->packs.size());
+		this->packs.emplace_back(pack);
+	}
+}
+
+void TriangleBvh::split(const uint32_t node, std::vector<Triangle>& triangles, std::vector<glm::vec3>& centers) {
+	const uint32_t first = this->nodes[node].first;
+	const uint32_t count = this->nodes[node].count;
+	// Bounds of the triangles and of their centers
+	glm::vec3 minValues(std::numeric_limits<float>::max());
+	glm::vec3 maxValues(std::numeric_limits<float>::lowest());
+	glm::vec3 minCenter(std::numeric_limits<float>::max());
+	glm::vec3 maxCenter(std::numeric_limits<float>::lowest());
+	for (uint32_t i = first; i < first + count; ++i) {
+		const Triangle& triangle = triangles[i];
+		minValues = glm::min(minValues, glm::min(triangle.vertex, glm::min(triangle.vertex + triangle.edge1, triangle.vertex + triangle.edge2)));
+		maxValues = glm::max(maxValues, glm::max(triangle.vertex, glm::max(triangle.vertex + triangle.edge1, triangle.vertex + triangle.edge2)));
+		minCenter = glm::min(minCenter, centers[i]);
+		maxCenter = glm::max(maxCenter, centers[i]);
+	}
+	this->nodes[node].minValues = minValues;
+	this->nodes[node].maxValues = maxValues;
+	if (count <= MAX_LEAF_TRIANGLES) {
+		return;
+	}
+	const glm::vec3 extent = maxCenter - minCenter;
+	const int32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+	// Sort triangles and centers together by the center along the axis, around the median
+	std::vector<uint32_t> order(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		order[i] = first + i;
+	}
+	const uint32_t half = count / 2;
+	std::nth_element(order.begin(), order.begin() + half, order.end(), [&centers, axis](const uint32_t a, const uint32_t b) {
+		return centers[a][axis] < centers[b][axis];
+	});
+	std::vector<Triangle> sortedTriangles(count, triangles[first]);
+	std::vector<glm::vec3> sortedCenters(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		sortedTriangles[i] = triangles[order[i]];
+		sortedCenters[i] = centers[order[i]];
+	}
+	std::copy(sortedTriangles.begin(), sortedTriangles.end(), triangles.begin() + first);
+	std::copy(sortedCenters.begin(), sortedCenters.end(), centers.begin() + first);
+	// Children are stored next to each other
+	const uint32_t children = static_cast<uint32_t>(this->nodes.size());
+	this->nodes.emplace_back(Node{ glm::vec3(0.0f), first, glm::vec3(0.0f), half });
+	this->nodes.emplace_back(Node{ glm::vec3(0.0f), first + half, glm::vec3(0.0f), count - half });
+	this->nodes[node].first = children;
+	this->nodes[node].count = 0;
+	this->split(children, triangles, centers);
+	this->split(children + 1, triangles, centers);
+}
+
+bool TriangleBvh::traverse(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, const bool anyHit, Hit& hit) const {
+	if (this->packs.empty()) {
+		return false;
+	}
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	hit.distance = maxDistance;
+	bool found = false;
+#ifdef TRIANGLE_BVH_SSE
+	const __m128 originX = _mm_set1_ps(origin.x);
+	const __m128 originY = _mm_set1_ps(origin.y);
+	const __m128 originZ = _mm_set1_ps(origin.z);
+	const __m128 directionX = _mm_set1_ps(direction.x);
+	const __m128 directionY = _mm_set1_ps(direction.y);
+	const __m128 directionZ = _mm_set1_ps(direction.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 epsilon = _mm_set1_ps(PARALLEL_EPSILON);
+#endif
+	// The depth of a median split tree grows with the log of the triangles, 64 levels are never reached
+	uint32_t stack[64];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const Node& node = this->nodes[stack[--stackSize]];
+		// Slab test against the node's box
+		const glm::vec3 nearHits = (node.minValues - origin) * inverseDirection;
+		const glm::vec3 farHits = (node.maxValues - origin) * inverseDirection;
+		const glm::vec3 entries = glm::min(nearHits, farHits);
+		const glm::vec3 exits = glm::max(nearHits, farHits);
+		const float entry = glm::max(glm::max(entries.x, entries.y), glm::max(entries.z, 0.0f));
+		const float exit = glm::min(glm::min(exits.x, exits.y), glm::min(exits.z, hit.distance));
+		if (entry > exit) {
+			continue;
+		}
+		if (node.count == 0) {
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+			continue;
+		}
+		// Moller-Trumbore against the triangles of the leaf
+		const TrianglePack& pack = this->packs[node.first];
+#ifdef TRIANGLE_BVH_SSE
+		const __m128 edge1X = _mm_load_ps(pack.edge1X);
+		const __m128 edge1Y = _mm_load_ps(pack.edge1Y);
+		const __m128 edge1Z = _mm_load_ps(pack.edge1Z);
+		const __m128 edge2X = _mm_load_ps(pack.edge2X);
+		const __m128 edge2Y = _mm_load_ps(pack.edge2Y);
+		const __m128 edge2Z = _mm_load_ps(pack.edge2Z);
+		const __m128 pX = _mm_sub_ps(_mm_mul_ps(directionY, edge2Z), _mm_mul_ps(directionZ, edge2Y));
+		const __m128 pY = _mm_sub_ps(_mm_mul_ps(directionZ, edge2X), _mm_mul_ps(directionX, edge2Z));
+		const __m128 pZ = _mm_sub_ps(_mm_mul_ps(directionX, edge2Y), _mm_mul_ps(directionY, edge2X));
+		const __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge1X, pX), _mm_mul_ps(edge1Y, pY)), _mm_mul_ps(edge1Z, pZ));
+		const __m128 inverseDeterminant = _mm_div_ps(one, determinant);
+		const __m128 toOriginX = _mm_sub_ps(originX, _mm_load_ps(pack.vertexX));
+		const __m128 toOriginY = _mm_sub_ps(originY, _mm_load_ps(pack.vertexY));
+		const __m128 toOriginZ = _mm_sub_ps(originZ, _mm_load_ps(pack.vertexZ));
+		const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(toOriginX, pX), _mm_mul_ps(toOriginY, pY)), _mm_mul_ps(toOriginZ, pZ)), inverseDeterminant);
+		const __m128 qX = _mm_sub_ps(_mm_mul_ps(toOriginY, edge1Z), _mm_mul_ps(toOriginZ, edge1Y));
+		const __m128 qY = _mm_sub_ps(_mm_mul_ps(toOriginZ, edge1X), _mm_mul_ps(toOriginX, edge1Z));
+		const __m128 qZ = _mm_sub_ps(_mm_mul_ps(toOriginX, edge1Y), _mm_mul_ps(toOriginY, edge1X));
+		const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qX), _mm_mul_ps(directionY, qY)), _mm_mul_ps(directionZ, qZ)), inverseDeterminant);
+		const __m128 distance = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edge2X, qX), _mm_mul_ps(edge2Y, qY)), _mm_mul_ps(edge2Z, qZ)), inverseDeterminant);
+		// Degenerate lanes have a zero determinant, their NaNs fail every comparison
+		__m128 inside = _mm_cmpgt_ps(_mm_andnot_ps(signMask, determinant), epsilon);
+		inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+		inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+		inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpgt_ps(distance, zero), _mm_cmplt_ps(distance, _mm_set1_ps(hit.distance))));
+		const int32_t mask = _mm_movemask_ps(inside);
+		if (mask == 0) {
+			continue;
+		}
+		alignas(16) float distances[MAX_LEAF_TRIANGLES];
+		alignas(16) float us[MAX_LEAF_TRIANGLES];
+		alignas(16) float vs[MAX_LEAF_TRIANGLES];
+		_mm_store_ps(distances, distance);
+		_mm_store_ps(us, u);
+		_mm_store_ps(vs, v);
+		for (uint32_t lane = 0; lane < MAX_LEAF_TRIANGLES; ++lane) {
+			if ((mask & (1 << lane)) && distances[lane] < hit.distance) {
+				hit = Hit{ pack.ids[lane], distances[lane], glm::vec2(us[lane], vs[lane]) };
+				found = true;
+			}
+		}
+		if (found && anyHit) {
+			return true;
+		}
+#else
+		for (uint32_t lane = 0; lane < node.count; ++lane) {
+			const glm::vec3 edge1(pack.edge1X[lane], pack.edge1Y[lane], pack.edge1Z[lane]);
+			const glm::vec3 edge2(pack.edge2X[lane], pack.edge2Y[lane], pack.edge2Z[lane]);
+			const glm::vec3 p = glm::cross(direction, edge2);
+			const float determinant = glm::dot(edge1, p);
+			if (std::abs(determinant) < PARALLEL_EPSILON) {
+				continue;
+			}
+			const float inverseDeterminant = 1.0f / determinant;
+			const glm::vec3 toOrigin = origin - glm::vec3(pack.vertexX[lane], pack.vertexY[lane], pack.vertexZ[lane]);
+			const float u = glm::dot(toOrigin, p) * inverseDeterminant;
+			if (u < 0.0f || u > 1.0f) {
+				continue;
+			}
+			const glm::vec3 q = glm::cross(toOrigin, edge1);
+			const float v = glm::dot(direction, q) * inverseDeterminant;
+			if (v < 0.0f || u + v > 1.0f) {
+				continue;
+			}
+			const float distance = glm::dot(edge2, q) * inverseDeterminant;
+			if (distance > 0.0f && distance < hit.distance) {
+				hit = Hit{ pack.ids[lane], distance, glm::vec2(u, v) };
+				found = true;
+				if (anyHit) {
+					return true;
+				}
+			}
+		}
+#endif
+	}
+	return found;
+}
+
+bool TriangleBvh::intersect(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, Hit& hit) const {
+	return this->traverse(origin, direction, maxDistance, false, hit);
+}
+
+bool TriangleBvh::isOccluded(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance) const {
+	Hit hit;
+	return this->traverse(origin, direction, maxDistance, true, hit);
+}
+
+size_t TriangleBvh::getTriangleCount() const {
+	return this->triangleCount;
+}
+
+size_t TriangleBvh::getNodeCount() const {
+	return this->nodes.size();
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * Bounding volume hierarchy over a world space triangle soup, for ray casts on the CPU.
+ * Nodes split their triangles at the median of the longest axis of their centers, the queries are thread safe.
+ * Every leaf stores its triangles by component, so a ray is tested against all of them at once with SSE.
+ */
+class TriangleBvh {
+public:
+	// Triangles kept in a leaf at most, one SSE lane each
+	static constexpr uint32_t MAX_LEAF_TRIANGLES = 4;
+
+	/**
+	 * The closest triangle hit by a ray.
+	 */
+	struct Hit {
+		uint32_t triangle; /* Index of the triangle in the order it was given */
+		float distance; /* Distance along the ray */
+		glm::vec2 barycentrics; /* Weights of the second and third vertex */
+	};
+private:
+	/**
+	 * A node of the hierarchy, inner nodes store their children one after the other.
+	 */
+	struct Node {
+		glm::vec3 minValues;
+		uint32_t first; /* First child of inner nodes, triangle pack of leaves */
+		glm::vec3 maxValues;
+		uint32_t count; /* Triangles of leaves, 0 for inner nodes */
+	};
+
+	/**
+	 * A triangle stored as a vertex and the two edges leaving it.
+	 */
+	struct Triangle {
+		glm::vec3 vertex;
+		glm::vec3 edge1;
+		glm::vec3 edge2;
+		uint32_t id;
+	};
+
+	/**
+	 * The triangles of a leaf stored by component, the unused lanes are degenerate and never hit.
+	 */
+	struct TrianglePack {
+		alignas(16) float vertexX[MAX_LEAF_TRIANGLES];
+		alignas(16) float vertexY[MAX_LEAF_TRIANGLES];
+		alignas(16) float vertexZ[MAX_LEAF_TRIANGLES];
+		alignas(16) float edge1X[MAX_LEAF_TRIANGLES];
+		alignas(16) float edge1Y[MAX_LEAF_TRIANGLES];
+		alignas(16) float edge1Z[MAX_LEAF_TRIANGLES];
+		alignas(16) float edge2X[MAX_LEAF_TRIANGLES];
+		alignas(16) float edge2Y[MAX_LEAF_TRIANGLES];
+		alignas(16) float edge2Z[MAX_LEAF_TRIANGLES];
+		uint32_t ids[MAX_LEAF_TRIANGLES];
+	};
+
+	std::vector<Node> nodes;
+	std::vector<TrianglePack> packs;
+	size_t triangleCount;
+
+	/**
+	 * Splits a node until its leaves hold at most MAX_LEAF_TRIANGLES triangles.
+	 *
+	 * \param node The index of the node, its triangles must be set.
+	 * \param triangles The triangles, reordered so every node's ones are contiguous.
+	 * \param centers The center of every triangle, reordered with them.
+	 */
+	void split(const uint32_t node, std::vector<Triangle>& triangles, std::vector<glm::vec3>& centers);
+
+	/**
+	 * Walks the hierarchy along a ray.
+	 *
+	 * \param origin The origin of the ray.
+	 * \param direction The unit direction of the ray.
+	 * \param maxDistance The length of the ray.
+	 * \param anyHit Stops at the first hit found instead of the closest one.
+	 * \param hit The hit found (output variable).
+	 * \return True if the ray hit a triangle.
+	 */
+	bool traverse(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, const bool anyHit, Hit& hit) const;
+public:
+	/**
+	 * Builds the hierarchy of a triangle list.
+	 *
+	 * \param positions The world space vertices.
+	 * \param indices The triangle list indices.
+	 */
+	TriangleBvh(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+
+	/**
+	 * Finds the closest triangle along a ray, both faces of the triangles are hit.
+	 *
+	 * \param origin The origin of the ray.
+	 * \param direction The unit direction of the ray.
+	 * \param maxDistance The length of the ray.
+	 * \param hit The closest hit (output variable).
+	 * \return True if the ray hit a triangle.
+	 */
+	bool intersect(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, Hit& hit) const;
+
+	/**
+	 * Checks if any triangle blocks a ray.
+	 *
+	 * \param origin The origin of the ray.
+	 * \param direction The unit direction of the ray.
+	 * \param maxDistance The length of the ray.
+	 * \return True if the ray hit a triangle.
+	 */
+	bool isOccluded(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance) const;
+
+	/**
+	 * Getter for the amount of triangles.
+	 *
+	 * \return The amount of triangles in the hierarchy.
+	 */
+	size_t getTriangleCount() const;
+
+	/**
+	 * Getter for the amount of nodes.
+	 *
+	 * \return The amount of nodes in the hierarchy.
+	 */
+	size_t getNodeCount() const;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/glm.hpp>
 
 /**
@@ -11,4 +12,14 @@ struct Vertex {
 	glm::vec2 uv = glm::vec2(0.0f);
 	glm::vec3 tangent = glm::vec3(0.0f); /* Used to transform tangent space textures to object space */
 	glm::vec3 bitangent = glm::vec3(0.0f); /* Used to transform tangent space textures to object space */
-};
\ No newline at end of file
+};
+
+/**
+ * Quantized version of the vertex struct (20 bytes instead of 56), decoded in the vertex shaders.
+ */
+struct CompactVertex {
+	int16_t position[4]; /* Normalized position relative to the mesh's bounding box, w holds the bitangent's handedness */
+	int16_t normal[2]; /* Octahedral encoded normal */
+	int16_t tangent[2]; /* Octahedral encoded tangent, the bitangent is rebuilt as cross(normal, tangent) * handedness */
+	uint16_t uv[2]; /* Half float uvs */
+};
@@ -40,8 +40,17 @@ public:
 	 * \param sturctSize The size of the struct passed to this VAO.
 	 * \param valueType The value's type (float, int etc..)
 	 * \param offset The offset to read from compared to the 0th element of the vertex.
+	 * \param normalized Flag to map integer values to the [-1, 1] or [0, 1] range.
 	 */
-	void linkAttrib(const uint32_t layout, const uint32_t numComponents, const size_t sturctSize, const uint32_t valueType, const size_t offset) const;
+	void linkAttrib(const uint32_t layout, const uint32_t numComponents, const size_t sturctSize, const uint32_t valueType, const size_t offset, const bool normalized = false) const;
+
+	/**
+	 * Makes an attribute advance once per instance instead of once per vertex.
+	 *
+	 * \param layout The layout id of the attribute.
+	 * \param divisor The amount of instances that share the same value.
+	 */
+	void setAttribDivisor(const uint32_t layout, const uint32_t divisor = 1) const;
 
 	/**
 	 * Activates this VertexArray to draw the object.
@@ -1,12 +1,89 @@
 #include "VertexBuffer.hpp"
 
+#include "BoundingBox.hpp"
 #include "Vertex.hpp"
 #include <glad/glad.h>
+#include <glm/gtc/packing.hpp>
+
+/**
+ * Converts a value in the [-1, 1] range to a normalized short.
+ */
+static int16_t toSnorm16(const float value) {
+	return static_cast<int16_t>(glm::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+/**
+ * Encodes a unit vector to two normalized shorts with the octahedral mapping.
+ */
+static void encodeOctahedral(const glm::vec3& direction, int16_t* out) {
+	const float length = glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z);
+	if (length <= 0.0f || glm::any(glm::isnan(direction))) {
+		out[0] = 0;
+		out[1] = 0;
+		return;
+	}
+	glm::vec2 encoded = glm::vec2(direction.x, direction.y) / length;
+	// Fold the lower hemisphere over the diagonals
+	if (direction.z < 0.0f) {
+		encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * glm::vec2(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	out[0] = toSnorm16(encoded.x);
+	out[1] = toSnorm16(encoded.y);
+}
 
 VertexBuffer::VertexBuffer(const std::vector<Vertex>& vertices, const bool dynamic)
 	:
-	SimpleBuffer(GL_ARRAY_BUFFER, dynamic)
+	SimpleBuffer(GL_ARRAY_BUFFER, dynamic),
+	compact(false)
 {
 	this->bind();
 	glBufferData(this->type, static_cast<int64_t>(vertices.size() * sizeof(Vertex)), vertices.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+}
+
+VertexBuffer::VertexBuffer(const std::vector<Vertex>& vertices, const bool _compact, const BoundingBox& bounds, const bool dynamic)
+	:
+	SimpleBuffer(GL_ARRAY_BUFFER, dynamic),
+	compact(_compact)
+{
+	this->bind();
+	if (!this->compact) {
+		glBufferData(this->type, static_cast<int64_t>(vertices.size() * sizeof(Vertex)), vertices.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+		return;
+	}
+	// Positions are stored relative to the center of the bounding box
+	const glm::vec3 center = (bounds.getMaxValues() + bounds.getMinValues()) * 0.5f;
+	const glm::vec3 halfExtent = glm::max((bounds.getMaxValues() - bounds.getMinValues()) * 0.5f, glm::vec3(1e-6f));
+	std::vector<CompactVertex> packed(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		const Vertex& v = vertices[i];
+		CompactVertex& p = packed[i];
+		const glm::vec3 position = (v.position - center) / halfExtent;
+		p.position[0] = toSnorm16(position.x);
+		p.position[1] = toSnorm16(position.y);
+		p.position[2] = toSnorm16(position.z);
+		// Store the handedness so the bitangent can be rebuilt
+		p.position[3] = glm::dot(glm::cross(v.normal, v.tangent), v.bitangent) < 0.0f ? -32767 : 32767;
+		encodeOctahedral(v.normal, p.normal);
+		encodeOctahedral(v.tangent, p.tangent);
+		p.uv[0] = glm::packHalf1x16(v.uv.x);
+		p.uv[1] = glm::packHalf1x16(v.uv.y);
+	}
+	glBufferData(this->type, static_cast<int64_t>(packed.size() * sizeof(CompactVertex)), packed.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+}
+
+VertexBuffer::VertexBuffer(const size_t size, const bool dynamic)
+	:
+	SimpleBuffer(GL_ARRAY_BUFFER, dynamic),
+	compact(false)
+{
+	this->bind();
+	this->uploadData(nullptr, size);
+}
+
+void VertexBuffer::uploadData(const void* data, const size_t size) const {
+	glBufferData(this->type, static_cast<int64_t>(size), data, this->isDynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+}
+
+void VertexBuffer::uploadSubData(const void* data, const size_t dataSize, const size_t offset) const {
+	glBufferSubData(this->type, static_cast<int64_t>(offset), static_cast<int64_t>(dataSize), data);
 }
\ No newline at end of file
@@ -8,7 +8,14 @@
  */
 struct Vertex;
 
+/**
+ * Forward declaration for the bounding box class.
+ */
+class BoundingBox;
+
 class VertexBuffer : public SimpleBuffer {
+public:
+	const bool compact;
 public:
 	// Erase copy constructors, as it would break opengl
 	VertexBuffer(const VertexBuffer&) = delete;
@@ -21,4 +28,41 @@ public:
 	 * \param dynamic Flag to check if the data can be overwritten.
 	 */
 	VertexBuffer(const std::vector<Vertex>& vertices, const bool dynamic = false);
-};
\ No newline at end of file
+
+	/**
+	 * Constructor for the vertex buffer, optionally quantizing the vertices to the CompactVertex format.
+	 *
+	 * \param vertices The vertices to save in the GPU buffer.
+	 * \param _compact Flag to upload the vertices in the CompactVertex format.
+	 * \param bounds The bounding box the compact positions are relative to.
+	 * \param dynamic Flag to check if the data can be overwritten.
+	 */
+	VertexBuffer(const std::vector<Vertex>& vertices, const bool _compact, const BoundingBox& bounds, const bool dynamic = false);
+
+	/**
+	 * Constructor for a vertex buffer holding arbitrary data (e.g.: per instance attributes).
+	 *
+	 * \param size The amount of bytes to allocate.
+	 * \param dynamic Flag to check if the data can be overwritten.
+	 */
+	VertexBuffer(const size_t size, const bool dynamic = true);
+
+	/**
+	 * Uploads data to the buffer, reallocating it.
+	 * Make sure the buffer is bound first.
+	 *
+	 * \param data The data to pass to the buffer.
+	 * \param size The amount of bytes to pass to the buffer.
+	 */
+	void uploadData(const void* data, const size_t size) const;
+
+	/**
+	 * Uploads data on a specific part of the buffer.
+	 * Make sure the buffer is bound first.
+	 *
+	 * \param data The data to pass to the buffer.
+	 * \param dataSize The amount of bytes to pass to the buffer.
+	 * \param offset The offset from the start of the buffer to overwrite the data from.
+	 */
+	void uploadSubData(const void* data, const size_t dataSize, const size_t offset) const;
+};
@@ -0,0 +1,245 @@
+#include "WaterClipmap.hpp"
+
+#include "BoundingBox.hpp"
+#include "EnvironmentLighting.hpp"
+#include "LightClusters.hpp"
+#include "LightSystem.hpp"
+#include "Material.hpp"
+#include "Shader.hpp"
+#include "ShadowAtlas.hpp"
+#include <cstddef>
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+#include <glm/gtc/constants.hpp>
+#include <iostream>
+
+WaterClipmap::WaterClipmap(const std::shared_ptr<Material>& _material, const glm::vec3& center, const glm::vec2& size, const float _spacing)
+	:
+	material(_material),
+	geometry(WaterClipmap::buildGeometry()),
+	vao(),
+	patchVbo(geometry.vertices.size() * sizeof(glm::vec2), false),
+	patchEbo(geometry.indices, geometry.vertices.size()),
+	instanceVbo(64 * sizeof(InstanceData)),
+	instanceCapacity(64),
+	visibleInstances(),
+	uploadedInstances(),
+	waveFadeStart(0.0f),
+	waveFadeEnd(0.0f),
+	boundsMin(glm::vec2(center.x, center.z) - size * 0.5f),
+	boundsMax(glm::vec2(center.x, center.z) + size * 0.5f),
+	height(center.y),
+	spacing(glm::max(_spacing, 0.001f)),
+	levelCount(1),
+	visibleTriangles(0),
+	lights()
+{
+	// Add levels until the coarsest one reaches across the whole sea from any point of it
+	const float seaSize = glm::max(size.x, size.y);
+	while (static_cast<float>(LEVEL_SIZE / 2 - 2) * this->spacing * static_cast<float>(1u << (this->levelCount - 1)) < seaSize) {
+		++this->levelCount;
+	}
+	this->vao.bind();
+	this->patchVbo.bind();
+	this->patchVbo.uploadData(this->geometry.vertices.data(), this->geometry.vertices.size() * sizeof(glm::vec2));
+	this->patchEbo.bind();
+	this->vao.linkAttrib(0, 2, sizeof(glm::vec2), GL_FLOAT, 0);
+	this->instanceVbo.bind();
+	this->vao.linkAttrib(1, 4, sizeof(InstanceData), GL_FLOAT, offsetof(InstanceData, cornerCenter));
+	this->vao.linkAttrib(2, 1, sizeof(InstanceData), GL_FLOAT, offsetof(InstanceData, spacing));
+	this->vao.setAttribDivisor(1);
+	this->vao.setAttribDivisor(2);
+	this->vao.unbind();
+	this->instanceVbo.unbind();
+	this->patchVbo.unbind();
+	std::cout << "Built Water Clipmap: " << this->levelCount << " levels, " << this->geometry.vertices.size() << " patch vertices, " << this->geometry.indices.size() << " patch indices" << std::endl;
+}
+
+WaterClipmap::~WaterClipmap() = default;
+
+WaterClipmap::PatchGeometry WaterClipmap::buildGeometry() {
+	PatchGeometry patches;
+	const auto addGrid = [&patches](const Piece piece, const uint32_t quadsX, const uint32_t quadsZ) {
+		const uint32_t baseVertex = static_cast<uint32_t>(patches.vertices.size());
+		patches.pieces[piece] = PieceRange{ static_cast<uint32_t>(patches.indices.size()), quadsX * quadsZ * 6, glm::uvec2(quadsX, quadsZ) };
+		for (uint32_t z = 0; z <= quadsZ; ++z) {
+			for (uint32_t x = 0; x <= quadsX; ++x) {
+				patches.vertices.emplace_back(static_cast<float>(x), static_cast<float>(z));
+			}
+		}
+		// Same winding as the planes of the primitives, facing up
+		for (uint32_t z = 0; z < quadsZ; ++z) {
+			for (uint32_t x = 0; x < quadsX; ++x) {
+				const uint32_t topLeft = baseVertex + z * (quadsX + 1) + x;
+				const uint32_t topRight = topLeft + 1;
+				const uint32_t bottomLeft = topLeft + quadsX + 1;
+				const uint32_t bottomRight = bottomLeft + 1;
+				patches.indices.insert(patches.indices.end(), { topLeft, bottomLeft, topRight, topRight, bottomLeft, bottomRight });
+			}
+		}
+	};
+	addGrid(BLOCK, BLOCK_SIZE, BLOCK_SIZE);
+	addGrid(FIXUP_VERTICAL, 2, BLOCK_SIZE);
+	addGrid(FIXUP_HORIZONTAL, BLOCK_SIZE, 2);
+	// The finer level leaves one row and one column of the ring's hole uncovered, the vertical trim takes the corner
+	addGrid(TRIM_VERTICAL, 1, 2 * BLOCK_SIZE + 2);
+	addGrid(TRIM_HORIZONTAL, 2 * BLOCK_SIZE + 1, 1);
+	addGrid(CENTER, 2, 2);
+	return patches;
+}
+
+void WaterClipmap::addInstance(const Piece piece, const glm::ivec2& corner, const glm::ivec2& levelCenter, const float levelSpacing, const float waveExtent, const glm::mat4& cameraMatrix) {
+	const glm::vec2 minCorner = glm::vec2(corner) * levelSpacing;
+	const glm::vec2 maxCorner = glm::vec2(corner + glm::ivec2(this->geometry.pieces[piece].size)) * levelSpacing;
+	// Skip pieces outside the sea, the ones crossing its border get clamped in the vertex shader
+	if (glm::any(glm::greaterThanEqual(minCorner, this->boundsMax)) || glm::any(glm::lessThanEqual(maxCorner, this->boundsMin))) {
+		return;
+	}
+	const glm::vec2 clampedMin = glm::max(minCorner, this->boundsMin);
+	const glm::vec2 clampedMax = glm::min(maxCorner, this->boundsMax);
+	if (BoundingBox(glm::vec3(clampedMin.x, this->height - waveExtent, clampedMin.y), glm::vec3(clampedMax.x, this->height + waveExtent, clampedMax.y)).isCulled(cameraMatrix)) {
+		return;
+	}
+	this->visibleInstances[piece].emplace_back(InstanceData{ glm::vec4(corner.x, corner.y, levelCenter.x, levelCenter.y), levelSpacing });
+	this->visibleTriangles += this->geometry.pieces[piece].indexCount / 3;
+}
+
+void WaterClipmap::update(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint) {
+	for (std::vector<InstanceData>& instances : this->visibleInstances) {
+		instances.clear();
+	}
+	this->visibleTriangles = 0;
+	// Read the waves from the material, they can be edited at runtime
+	float waveHeight = 0.0f;
+	float waveFrequency = 0.0f;
+	for (const auto& [property, value] : this->material->getProperties()) {
+		if (property == "waveHeight" && std::holds_alternative<float>(value)) {
+			waveHeight = std::get<float>(value);
+		} else if (property == "waveFrequency" && std::holds_alternative<float>(value)) {
+			waveFrequency = std::get<float>(value);
+		}
+	}
+	// Sum of the amplitudes of the four waves of the shader
+	const float waveExtent = glm::abs(waveHeight) * (1.0f + 1.0f / 2.0f + 1.0f / 3.0f + 1.0f / 4.0f);
+	this->lights = LightSystem::findLights(glm::vec3(this->boundsMin.x, this->height - waveExtent, this->boundsMin.y), glm::vec3(this->boundsMax.x, this->height + waveExtent, this->boundsMax.y));
+	// Waves are only evaluated by the levels sampling them at least three times per wavelength
+	const float wavelength = waveFrequency > 0.0f ? glm::two_pi<float>() / waveFrequency : 0.0f;
+	float waveSpacing = this->spacing;
+	for (uint32_t level = 1; level < this->levelCount && waveSpacing * 2.0f <= wavelength / 3.0f; ++level) {
+		waveSpacing *= 2.0f;
+	}
+	this->waveFadeEnd = waveSpacing <= wavelength / 3.0f ? static_cast<float>(LEVEL_SIZE / 2 - 3) * waveSpacing : 0.0f;
+	this->waveFadeStart = this->waveFadeEnd * 0.5f;
+	// Place every level in vertices of its own grid, the origin of each one lies on the grid of the next coarser level
+	const int32_t halfSize = static_cast<int32_t>(LEVEL_SIZE / 2);
+	const int32_t block = static_cast<int32_t>(BLOCK_SIZE);
+	const int32_t fixup = 2 * block;
+	glm::ivec2 origin = 2 * glm::ivec2(glm::floor((glm::vec2(viewPoint.x, viewPoint.z) / this->spacing - static_cast<float>(halfSize)) * 0.5f));
+	float levelSpacing = this->spacing;
+	for (uint32_t level = 0; level < this->levelCount; ++level) {
+		const glm::ivec2 center = origin + halfSize;
+		// Ring of blocks, the finest level fills its middle as well
+		const int32_t blockOffsets[4] = { 0, block, fixup + 2, fixup + 2 + block };
+		for (int32_t z = 0; z < 4; ++z) {
+			for (int32_t x = 0; x < 4; ++x) {
+				const bool inside = (x == 1 || x == 2) && (z == 1 || z == 2);
+				if (level == 0 || !inside) {
+					this->addInstance(BLOCK, origin + glm::ivec2(blockOffsets[x], blockOffsets[z]), center, levelSpacing, waveExtent, cameraMatrix);
+				}
+			}
+		}
+		// Strips between the blocks
+		for (int32_t i = 0; i < 4; ++i) {
+			if (level == 0 || i == 0 || i == 3) {
+				this->addInstance(FIXUP_VERTICAL, origin + glm::ivec2(fixup, blockOffsets[i]), center, levelSpacing, waveExtent, cameraMatrix);
+				this->addInstance(FIXUP_HORIZONTAL, origin + glm::ivec2(blockOffsets[i], fixup), center, levelSpacing, waveExtent, cameraMatrix);
+			}
+		}
+		if (level == 0) {
+			this->addInstance(CENTER, origin + glm::ivec2(fixup), center, levelSpacing, waveExtent, cameraMatrix);
+		}
+		// The next level's hole starts on an odd vertex so its origin is even, the trim fills the side the finer level leaves open
+		if (level + 1 < this->levelCount) {
+			const glm::ivec2 finerOrigin = origin / 2;
+			const glm::ivec2 hole = finerOrigin - (1 - glm::abs(finerOrigin % 2));
+			const glm::ivec2 trim(hole.x == finerOrigin.x ? hole.x + halfSize : hole.x, hole.y == finerOrigin.y ? hole.y + halfSize : hole.y);
+			origin = hole - block;
+			levelSpacing *= 2.0f;
+			const glm::ivec2 coarserCenter = origin + halfSize;
+			this->addInstance(TRIM_VERTICAL, glm::ivec2(trim.x, hole.y), coarserCenter, levelSpacing, waveExtent, cameraMatrix);
+			this->addInstance(TRIM_HORIZONTAL, glm::ivec2(trim.x == hole.x ? hole.x + 1 : hole.x, trim.y), coarserCenter, levelSpacing, waveExtent, cameraMatrix);
+		}
+	}
+	// Pack the instances piece after piece
+	this->uploadedInstances.clear();
+	for (const std::vector<InstanceData>& instances : this->visibleInstances) {
+		this->uploadedInstances.insert(this->uploadedInstances.end(), instances.begin(), instances.end());
+	}
+	if (this->uploadedInstances.empty()) {
+		return;
+	}
+	this->instanceVbo.bind();
+	if (this->uploadedInstances.size() > this->instanceCapacity) {
+		this->instanceCapacity = this->uploadedInstances.size();
+		this->instanceVbo.uploadData(this->uploadedInstances.data(), this->uploadedInstances.size() * sizeof(InstanceData));
+	} else {
+		this->instanceVbo.uploadSubData(this->uploadedInstances.data(), this->uploadedInstances.size() * sizeof(InstanceData), 0);
+	}
+	this->instanceVbo.unbind();
+}
+
+void WaterClipmap::render(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint, const bool weightedTransparency, const int32_t resolutionShift) const {
+	if (this->uploadedInstances.empty()) {
+		return;
+	}
+	this->material->activate();
+	const Shader* shader = this->material->getShader();
+	// Activate lighting
+	LightSystem::enable(shader);
+	LightClusters::enable(shader);
+	EnvironmentLighting::enable(shader);
+	ShadowAtlas::enable(shader);
+	LightSystem::enableObjectLights(shader, this->lights);
+	shader->setUniform("weightedTransparency", weightedTransparency ? 1 : 0);
+	shader->setUniform("resolutionShift", resolutionShift);
+	shader->setUniform("glfwTime", static_cast<float>(glfwGetTime()));
+	shader->setUniform("cameraPosition", viewPoint);
+	shader->setUniform("cameraMatrix", cameraMatrix);
+	shader->setUniform("fadeOut", 0.0f);
+	shader->setUniform("seaHeight", this->height);
+	shader->setUniform("seaBoundsMin", this->boundsMin);
+	shader->setUniform("seaBoundsMax", this->boundsMax);
+	shader->setUniform("waveFadeStart", this->waveFadeStart);
+	shader->setUniform("waveFadeEnd", this->waveFadeEnd);
+	this->vao.bind();
+	this->instanceVbo.bind();
+	// Without base instances, the instance attributes are pointed at the first instance of every piece
+	size_t firstInstance = 0;
+	for (uint32_t piece = 0; piece < PIECE_COUNT; ++piece) {
+		const size_t instanceCount = this->visibleInstances[piece].size();
+		if (instanceCount == 0) {
+			continue;
+		}
+		const size_t offset = firstInstance * sizeof(InstanceData);
+		this->vao.linkAttrib(1, 4, sizeof(InstanceData), GL_FLOAT, offset + offsetof(InstanceData, cornerCenter));
+		this->vao.linkAttrib(2, 1, sizeof(InstanceData), GL_FLOAT, offset + offsetof(InstanceData, spacing));
+		const PieceRange& range = this->geometry.pieces[piece];
+		glDrawElementsInstanced(GL_TRIANGLES, static_cast<int32_t>(range.indexCount), this->patchEbo.indexType, reinterpret_cast<const void*>(static_cast<uintptr_t>(range.indexOffset) * this->patchEbo.getIndexSize()), static_cast<int32_t>(instanceCount));
+		firstInstance += instanceCount;
+	}
+	this->instanceVbo.unbind();
+	this->vao.unbind();
+	this->material->deactivate();
+}
+
+const Material* WaterClipmap::getMaterial() const {
+	return this->material.get();
+}
+
+uint32_t WaterClipmap::getLevelCount() const {
+	return this->levelCount;
+}
+
+uint32_t WaterClipmap::getVisibleTriangleCount() const {
+	return this->visibleTriangles;
+}
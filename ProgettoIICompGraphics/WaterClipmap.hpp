@@ -0,0 +1,166 @@
+#pragma once
+
+#include "ElementBuffer.hpp"
+#include "LightSystem.hpp"
+#include "VertexArray.hpp"
+#include "VertexBuffer.hpp"
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+/**
+ * Forward declaration of the material class.
+ */
+class Material;
+
+/**
+ * Water surface drawn as nested clipmap rings centred on the camera.
+ * Every level is a ring of instanced patches with twice the spacing of the previous one, so the vertex count
+ * only depends on the amount of levels and not on the size of the sea. Levels snap to the grid of the next coarser one,
+ * the vertices close to the outer edge of a level morph onto the coarser grid so the rings stitch without cracks.
+ * The waves are computed in the vertex shader of the material, which is expected to read the patch layout (e.g.: water.shader).
+ */
+class WaterClipmap {
+public:
+	static constexpr uint32_t BLOCK_SIZE = 15; // Quads on each side of a block
+	static constexpr uint32_t LEVEL_SIZE = 4 * BLOCK_SIZE + 2; // Quads on each side of a level
+	static constexpr float DEFAULT_SPACING = 0.3f;
+private:
+	/**
+	 * The patch meshes a level is built from.
+	 */
+	enum Piece {
+		BLOCK, /* Square patch, 12 of them make a ring */
+		FIXUP_VERTICAL, /* 2 quads wide strip filling the gap between the blocks along z */
+		FIXUP_HORIZONTAL, /* 2 quads wide strip filling the gap between the blocks along x */
+		TRIM_VERTICAL, /* 1 quad wide strip along z, filling the space left around the finer level */
+		TRIM_HORIZONTAL, /* 1 quad wide strip along x, filling the space left around the finer level */
+		CENTER, /* Square filling the middle of the finest level */
+		PIECE_COUNT
+	};
+
+	/**
+	 * Range of the shared index buffer used by a piece.
+	 */
+	struct PieceRange {
+		uint32_t indexOffset;
+		uint32_t indexCount;
+		glm::uvec2 size; /* Quads of the piece along x and z */
+	};
+
+	/**
+	 * Per instance data sent to the GPU.
+	 */
+	struct InstanceData {
+		glm::vec4 cornerCenter; /* Corner of the piece and center of its level (xz), in vertices of the level's grid */
+		float spacing; /* Distance between the vertices of the piece's level */
+	};
+
+	/**
+	 * The geometry of every piece, built before the buffers.
+	 */
+	struct PatchGeometry {
+		std::vector<glm::vec2> vertices;
+		std::vector<uint32_t> indices;
+		PieceRange pieces[PIECE_COUNT];
+	};
+
+	std::shared_ptr<Material> material;
+	const PatchGeometry geometry;
+	const VertexArray vao;
+	const VertexBuffer patchVbo;
+	const ElementBuffer patchEbo;
+	const VertexBuffer instanceVbo;
+	size_t instanceCapacity;
+
+	std::vector<InstanceData> visibleInstances[PIECE_COUNT];
+	std::vector<InstanceData> uploadedInstances;
+	float waveFadeStart;
+	float waveFadeEnd;
+	glm::vec2 boundsMin;
+	glm::vec2 boundsMax;
+	float height;
+	float spacing;
+	uint32_t levelCount;
+	uint32_t visibleTriangles;
+	LightSystem::ObjectLights lights;
+
+	/**
+	 * Builds the vertices and indices of every piece.
+	 *
+	 * \return The geometry of the pieces.
+	 */
+	static PatchGeometry buildGeometry();
+
+	/**
+	 * Adds a piece to the visible ones if it is inside the sea and the frustum.
+	 *
+	 * \param piece The piece to add.
+	 * \param corner The corner of the piece (xz), in vertices of the level's grid.
+	 * \param levelCenter The center of the piece's level (xz), in vertices of the level's grid.
+	 * \param levelSpacing The distance between the vertices of the piece's level.
+	 * \param waveExtent The maximum vertical displacement of the waves.
+	 * \param cameraMatrix The matrix of the camera.
+	 */
+	void addInstance(const Piece piece, const glm::ivec2& corner, const glm::ivec2& levelCenter, const float levelSpacing, const float waveExtent, const glm::mat4& cameraMatrix);
+public:
+	// Erase copy constructors, as it would break opengl
+	WaterClipmap(const WaterClipmap&) = delete;
+	WaterClipmap& operator=(const WaterClipmap&) = delete;
+
+	/**
+	 * Builds the patches of the clipmap.
+	 * Make sure the OpenGL state has been set up first.
+	 *
+	 * \param _material The water material, its waveHeight property is used to pad the culling bounds.
+	 * \param center The world position of the center of the sea.
+	 * \param size The width of the sea along x and z.
+	 * \param _spacing The distance between the vertices of the finest level.
+	 */
+	WaterClipmap(const std::shared_ptr<Material>& _material, const glm::vec3& center, const glm::vec2& size, const float _spacing = DEFAULT_SPACING);
+
+	/**
+	 * Destructor for the clipmap.
+	 *
+	 */
+	~WaterClipmap();
+
+	/**
+	 * Moves the levels around the camera and collects the visible patches.
+	 *
+	 * \param cameraMatrix The matrix of the camera.
+	 * \param viewPoint The view point in the scene.
+	 */
+	void update(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint);
+
+	/**
+	 * Draws the visible patches with the water material, blending should already be set up.
+	 *
+	 * \param cameraMatrix The matrix of the camera.
+	 * \param viewPoint The view point in the scene.
+	 * \param weightedTransparency Flag to write the targets of the weighted blended transparency instead of blending.
+	 * \param resolutionShift Screen pixels per pixel of the target as a power of two, for the reduced resolution transparency.
+	 */
+	void render(const glm::mat4& cameraMatrix, const glm::vec3& viewPoint, const bool weightedTransparency = false, const int32_t resolutionShift = 0) const;
+
+	/**
+	 * Getter for the material of the water.
+	 *
+	 * \return The water material.
+	 */
+	const Material* getMaterial() const;
+
+	/**
+	 * Getter for the amount of levels.
+	 *
+	 * \return The amount of levels.
+	 */
+	uint32_t getLevelCount() const;
+
+	/**
+	 * Getter for the amount of triangles drawn by the last update.
+	 *
+	 * \return The amount of triangles.
+	 */
+	uint32_t getVisibleTriangleCount() const;
+};
@@ -0,0 +1,162 @@
+#include "WaveModel.hpp"
+
+#include "Material.hpp"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WAVE_MODEL_SSE
+#include <emmintrin.h>
+#endif
+
+namespace WaveModel {
+	// Same constants as the shader, the phase step is deliberately not exactly pi / 2
+	static constexpr uint32_t WAVE_COUNT = 4;
+	static constexpr float PHASE_STEP = 3.14f / 2.0f;
+	static constexpr float PI = 3.14159265358979f;
+	static constexpr float TWO_PI = 2.0f * PI;
+	static constexpr float HALF_PI = 0.5f * PI;
+
+	/**
+	 * The normalized direction of every wave.
+	 */
+	static const glm::vec2 directions[WAVE_COUNT] = {
+		glm::normalize(glm::vec2(0.25f, 0.75f)),
+		glm::normalize(glm::vec2(0.5f, 0.5f)),
+		glm::vec2(1.0f, 0.0f),
+		glm::vec2(0.0f, 1.0f)
+	};
+
+	/**
+	 * Evaluates a single point.
+	 *
+	 * \param parameters The wave parameters.
+	 * \param time The time in seconds.
+	 * \param x The world x coordinate of the point.
+	 * \param z The world z coordinate of the point.
+	 * \param height The output displacement along y.
+	 * \param normal The output unit normal, can be null.
+	 */
+	static void evaluatePoint(const Parameters& parameters, const float time, const float x, const float z, float& height, glm::vec3* normal);
+
+#ifdef WAVE_MODEL_SSE
+	/**
+	 * Sine of four angles, reduced to [-pi/2, pi/2] and approximated with a degree 9 polynomial (error below 4e-6).
+	 *
+	 * \param angles The angles in radians.
+	 * \return The sines of the angles.
+	 */
+	static __m128 sin4(__m128 angles);
+#endif
+}
+
+WaveModel::Parameters WaveModel::fromMaterial(const Material& material) {
+	Parameters parameters{ 0.0f, 0.0f, 0.0f };
+	for (const auto& [property, value] : material.getProperties()) {
+		if (!std::holds_alternative<float>(value)) {
+			continue;
+		}
+		if (property == "waveHeight") {
+			parameters.waveHeight = std::get<float>(value);
+		} else if (property == "waveSpeed") {
+			parameters.waveSpeed = std::get<float>(value);
+		} else if (property == "waveFrequency") {
+			parameters.waveFrequency = std::get<float>(value);
+		}
+	}
+	return parameters;
+}
+
+void WaveModel::evaluatePoint(const Parameters& parameters, const float time, const float x, const float z, float& height, glm::vec3* normal) {
+	height = 0.0f;
+	glm::vec2 slope(0.0f);
+	for (uint32_t i = 0; i < WAVE_COUNT; ++i) {
+		const float angle = (x * directions[i].x + z * directions[i].y) * parameters.waveFrequency + time * parameters.waveSpeed + static_cast<float>(i) * PHASE_STEP;
+		const float amplitude = parameters.waveHeight / static_cast<float>(i + 1);
+		height += std::sin(angle) * amplitude;
+		slope += std::cos(angle) * amplitude * parameters.waveFrequency * directions[i];
+	}
+	if (normal) {
+		*normal = glm::normalize(glm::vec3(-slope.x, 1.0f, -slope.y));
+	}
+}
+
+#ifdef WAVE_MODEL_SSE
+__m128 WaveModel::sin4(__m128 angles) {
+	// Wrap to [-pi, pi]
+	const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(angles, _mm_set1_ps(1.0f / TWO_PI))));
+	__m128 x = _mm_sub_ps(angles, _mm_mul_ps(turns, _mm_set1_ps(TWO_PI)));
+	// Mirror around +-pi/2, sin(pi - x) = sin(x)
+	const __m128 signs = _mm_and_ps(x, _mm_set1_ps(-0.0f));
+	const __m128 mirror = _mm_or_ps(_mm_set1_ps(PI), signs);
+	const __m128 outside = _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), _mm_set1_ps(HALF_PI));
+	x = _mm_or_ps(_mm_and_ps(outside, _mm_sub_ps(mirror, x)), _mm_andnot_ps(outside, x));
+	// Taylor series up to x^9
+	const __m128 x2 = _mm_mul_ps(x, x);
+	__m128 result = _mm_set1_ps(1.0f / 362880.0f);
+	result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(-1.0f / 5040.0f));
+	result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(1.0f / 120.0f));
+	result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(-1.0f / 6.0f));
+	result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(1.0f));
+	return _mm_mul_ps(result, x);
+}
+#endif
+
+void WaveModel::evaluate(const Parameters& parameters, const float time, const size_t count, const float* x, const float* z, float* heights, glm::vec3* normals) {
+	size_t first = 0;
+#ifdef WAVE_MODEL_SSE
+	// Per wave constants, shared by every batch
+	__m128 directionX[WAVE_COUNT];
+	__m128 directionZ[WAVE_COUNT];
+	__m128 frequencyX[WAVE_COUNT];
+	__m128 frequencyZ[WAVE_COUNT];
+	__m128 phases[WAVE_COUNT];
+	__m128 amplitudes[WAVE_COUNT];
+	__m128 slopeScales[WAVE_COUNT];
+	for (uint32_t i = 0; i < WAVE_COUNT; ++i) {
+		const float amplitude = parameters.waveHeight / static_cast<float>(i + 1);
+		directionX[i] = _mm_set1_ps(directions[i].x);
+		directionZ[i] = _mm_set1_ps(directions[i].y);
+		frequencyX[i] = _mm_set1_ps(directions[i].x * parameters.waveFrequency);
+		frequencyZ[i] = _mm_set1_ps(directions[i].y * parameters.waveFrequency);
+		phases[i] = _mm_set1_ps(time * parameters.waveSpeed + static_cast<float>(i) * PHASE_STEP);
+		amplitudes[i] = _mm_set1_ps(amplitude);
+		slopeScales[i] = _mm_set1_ps(amplitude * parameters.waveFrequency);
+	}
+	const __m128 quarterTurn = _mm_set1_ps(HALF_PI);
+	for (; first + 4 <= count; first += 4) {
+		const __m128 pointX = _mm_loadu_ps(x + first);
+		const __m128 pointZ = _mm_loadu_ps(z + first);
+		__m128 height = _mm_setzero_ps();
+		__m128 slopeX = _mm_setzero_ps();
+		__m128 slopeZ = _mm_setzero_ps();
+		for (uint32_t i = 0; i < WAVE_COUNT; ++i) {
+			const __m128 angle = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pointX, frequencyX[i]), _mm_mul_ps(pointZ, frequencyZ[i])), phases[i]);
+			height = _mm_add_ps(height, _mm_mul_ps(WaveModel::sin4(angle), amplitudes[i]));
+			if (normals) {
+				// cos(x) = sin(x + pi/2)
+				const __m128 slope = _mm_mul_ps(WaveModel::sin4(_mm_add_ps(angle, quarterTurn)), slopeScales[i]);
+				slopeX = _mm_add_ps(slopeX, _mm_mul_ps(slope, directionX[i]));
+				slopeZ = _mm_add_ps(slopeZ, _mm_mul_ps(slope, directionZ[i]));
+			}
+		}
+		_mm_storeu_ps(heights + first, height);
+		if (normals) {
+			// Normalize (-slopeX, 1, -slopeZ)
+			const __m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(slopeX, slopeX), _mm_mul_ps(slopeZ, slopeZ)), _mm_set1_ps(1.0f))));
+			alignas(16) float normalX[4];
+			alignas(16) float normalY[4];
+			alignas(16) float normalZ[4];
+			_mm_store_ps(normalX, _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), slopeX), inverseLength));
+			_mm_store_ps(normalY, inverseLength);
+			_mm_store_ps(normalZ, _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), slopeZ), inverseLength));
+			for (size_t i = 0; i < 4; ++i) {
+				normals[first + i] = glm::vec3(normalX[i], normalY[i], normalZ[i]);
+			}
+		}
+	}
+#endif
+	// Remaining points, or all of them without SSE
+	for (size_t i = first; i < count; ++i) {
+		WaveModel::evaluatePoint(parameters, time, x[i], z[i], heights[i], normals ? normals + i : nullptr);
+	}
+}
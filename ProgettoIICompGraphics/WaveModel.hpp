@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/**
+ * Forward declaration of the material class.
+ */
+class Material;
+
+/**
+ * CPU version of the four-wave sum displacing the water in water.vert.glsl, so the scene can react to the surface.
+ * Query points are evaluated four at a time with SSE when the target supports it.
+ */
+namespace WaveModel {
+	/**
+	 * The properties of the waves, named as in the water material.
+	 */
+	struct Parameters {
+		float waveHeight; /* Amplitude of the first wave, the others get smaller */
+		float waveSpeed; /* Phase change per second */
+		float waveFrequency; /* Phase change per world unit */
+	};
+
+	/**
+	 * Reads the wave properties of a material, missing ones are zero.
+	 *
+	 * \param material The water material.
+	 * \return The wave parameters.
+	 */
+	Parameters fromMaterial(const Material& material);
+
+	/**
+	 * Evaluates the height and normal of the surface at a batch of points.
+	 *
+	 * \param parameters The wave parameters.
+	 * \param time The time in seconds, the same sent to the shader as glfwTime.
+	 * \param count The amount of points.
+	 * \param x The world x coordinate of every point.
+	 * \param z The world z coordinate of every point.
+	 * \param heights The output displacement of every point along y.
+	 * \param normals The output unit normal of every point, can be null.
+	 */
+	void evaluate(const Parameters& parameters, const float time, const size_t count, const float* x, const float* z, float* heights, glm::vec3* normals);
+}
@@ -0,0 +1,2 @@
+vertex fullscreen.vert.glsl
+fragment deferred_light.frag.glsl
\ No newline at end of file
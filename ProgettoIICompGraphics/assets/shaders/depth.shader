@@ -0,0 +1,2 @@
+vertex depth.vert.glsl
+fragment depth.frag.glsl
\ No newline at end of file
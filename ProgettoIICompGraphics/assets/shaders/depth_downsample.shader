@@ -0,0 +1,2 @@
+vertex fullscreen.vert.glsl
+fragment depth_downsample.frag.glsl
\ No newline at end of file
@@ -0,0 +1,2 @@
+vertex hlod.vert.glsl
+fragment hlod.frag.glsl
\ No newline at end of file
@@ -0,0 +1,2 @@
+vertex hlod_atlas.vert.glsl
+fragment hlod_atlas.frag.glsl
\ No newline at end of file
@@ -0,0 +1,2 @@
+vertex hlod_depth.vert.glsl
+fragment hlod_depth.frag.glsl
\ No newline at end of file
@@ -0,0 +1,2 @@
+vertex impostor.vert.glsl
+fragment impostor.frag.glsl
\ No newline at end of file
@@ -0,0 +1,2 @@
+vertex base.vert.glsl
+fragment impostor_bake.frag.glsl
\ No newline at end of file
@@ -0,0 +1,2 @@
+vertex leaves_depth.vert.glsl
+fragment depth.frag.glsl
\ No newline at end of file
@@ -0,0 +1,2 @@
+vertex fullscreen.vert.glsl
+fragment oit_composite.frag.glsl
\ No newline at end of file
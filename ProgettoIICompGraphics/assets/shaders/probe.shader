@@ -0,0 +1,2 @@
+vertex base.vert.glsl
+fragment probe.frag.glsl
\ No newline at end of file
@@ -0,0 +1,2 @@
+vertex base.vert.glsl
+fragment shadow.frag.glsl
\ No newline at end of file
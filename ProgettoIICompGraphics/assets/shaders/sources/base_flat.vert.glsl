@@ -1,11 +1,13 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
+layout(location = 0) in vec4 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aUv;
 layout(location = 3) in vec3 aTangent;
 layout(location = 4) in vec3 aBitangent;
 
+#include "vertex_decode.glsl"
+
 flat out vec3 normalIn;
 out vec2 uvIn;
 out vec3 worldPosition;
@@ -14,15 +16,17 @@ flat out mat3 TBN;
 
 uniform mat4 objMatrix;
 uniform mat4 cameraMatrix;
+// Same transform on the depth pre-pass, its depth has to match exactly for the equal depth test
+invariant gl_Position;
 
 void main() {
-    worldPosition = vec3(objMatrix * vec4(aPos, 1.0));
+    worldPosition = vec3(objMatrix * vec4(decodePosition(), 1.0));
     gl_Position = cameraMatrix * vec4(worldPosition, 1.0);
     normalMatrix = transpose(inverse(mat3(objMatrix)));
-    normalIn = normalize(normalMatrix * aNormal);
+    normalIn = normalize(normalMatrix * decodeNormal());
     uvIn = aUv;
 
-    vec3 tangent = normalize(mat3(objMatrix) * aTangent);
-    vec3 bitangent = normalize(mat3(objMatrix) * aBitangent);
+    vec3 tangent = normalize(mat3(objMatrix) * decodeTangent());
+    vec3 bitangent = normalize(mat3(objMatrix) * decodeBitangent());
     TBN = mat3(tangent, bitangent, normalIn);
 }
\ No newline at end of file
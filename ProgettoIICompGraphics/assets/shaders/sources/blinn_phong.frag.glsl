@@ -1,16 +1,20 @@
 #version 330 core
 
-#define MAX_LIGHTS 32u
-
-out vec4 fragColor;
+layout(location = 0) out vec4 fragColor;
+// Sum of the weights of the weighted blended transparency, see Renderer::setOrderIndependentTransparency
+layout(location = 1) out float weightOut;
 
 in vec3 normalIn;
 in vec2 uvIn;
+in float occlusionIn;
+in vec2 lightmapUvIn;
 in vec3 worldPosition;
 in mat3 normalMatrix;
 in mat3 TBN;
 
 uniform vec3 cameraPosition;
+uniform bool weightedTransparency;
+uniform float fadeOut;
 
 uniform vec4 material_color;
 uniform vec4 material_ambient;
@@ -18,87 +22,110 @@ uniform vec4 material_diffuse;
 uniform vec4 material_specular;
 uniform float material_shininess;
 uniform float material_cutoutThreshold;
+uniform float material_reflectivity;
+uniform float material_roughness;
 
 uniform sampler2D albedo0;
 uniform sampler2D diffuse0;
 uniform sampler2D specular0;
 uniform sampler2D normal0;
 
-struct Light {
-	vec3 position;
-	uint type;
-	vec3 direction;
-	float range;
-	vec3 ambient;
-	float constant;
-	vec3 diffuse;
-	float linear;
-	vec3 specular;
-	float quadratic;
-	float cutOff;
-	float outerCutOff;
-	vec2 padding;
-};
-
-layout(std140) uniform lightsBuffer{
-	Light[MAX_LIGHTS] lights;
-};
-
-vec4 directionalLight(Light light, vec3 normal, vec3 viewDir);
-vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir);
+// Baked lighting of static objects, the baked lights are skipped when it is set
+uniform bool lightmapped;
+uniform sampler2D lightmap;
+
+#include "lights.glsl"
+#include "clusters.glsl"
+#include "environment.glsl"
+
+vec4 directionalLight(Light light, vec3 normal, vec3 viewDir, float shadow);
+vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);
+vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);
 
 vec4 calcDiffuse(vec3 lightDiffuse, float diffuseFactor);
 vec4 calcAmbient(vec3 lightAmbient);
 vec4 calcSpecular(vec3 lightSpecular, float specularFactor);
 
 bool isTextureValid(sampler2D tex);
+float ditherThreshold();
+float transparencyWeight(float alpha);
 
 void main() {
+	// Dither out while an impostor replaces the object
+	if (fadeOut > 0.0 && ditherThreshold() < fadeOut) {
+		discard;
+	}
+	// Alpha test before the lighting, the depth pre-pass tests the same value
+	vec4 albedo = material_color * texture(albedo0, uvIn);
+	if (albedo.a <= material_cutoutThreshold) {
+		discard;
+	}
 	vec4 combinedLighting = vec4(0.0);
 	vec3 viewDir = normalize(cameraPosition - worldPosition);
 	vec3 normal = normalIn;
 	if (isTextureValid(normal0)) {
 		normal = normalize(TBN * texture(normal0, uvIn).xyz);
 	}
-	for (uint i = 0u; i < MAX_LIGHTS; ++i) {
-		Light light = lights[i];
-		if (light.type == 0u) {
+	uvec2 clusterRange = clusterLightRange();
+	for (uint i = 0u; i < clusterRange.y; ++i) {
+		Light light = getLight(clusterLightIndex(clusterRange, i));
+		if (light.type == 0u || (lightmapped && (light.flags & LIGHT_FLAG_BAKED) != 0u)) {
 			continue;
 		}
 		else if (light.type == 1u) {
-			combinedLighting += directionalLight(light, normal, viewDir);
+			combinedLighting += directionalLight(light, normal, viewDir, lightShadow(light, worldPosition, normalIn));
 		}
 		else if (light.type == 2u) {
-			combinedLighting += pointLight(light, normal, worldPosition, viewDir);
+			combinedLighting += pointLight(light, normal, worldPosition, viewDir, lightShadow(light, worldPosition, normalIn));
 		}
 		else if (light.type == 3u) {
-			combinedLighting += spotLight(light, normal, worldPosition, viewDir);
+			combinedLighting += spotLight(light, normal, worldPosition, viewDir, lightShadow(light, worldPosition, normalIn));
 		}
 	}
-	vec4 endColor = material_color * texture(albedo0, uvIn) * combinedLighting;
-	if (endColor.a <= material_cutoutThreshold) {
-		discard;
+	combinedLighting += calcAmbient(environmentLight(normal));
+	if (lightmapped) {
+		combinedLighting += material_diffuse * texture(diffuse0, uvIn) * vec4(texture(lightmap, lightmapUvIn).rgb, 1.0);
+	}
+	vec4 endColor = albedo * combinedLighting;
+	if (material_reflectivity > 0.0) {
+		endColor.rgb += environmentSpecular(normal, viewDir, material_reflectivity, material_roughness) * texture(specular0, uvIn).r;
 	}
 	fragColor = endColor;
+	// Weighted blended transparency: the color premultiplied and weighted by depth, the weights summed aside
+	if (weightedTransparency) {
+		float alpha = clamp(endColor.a, 0.0, 1.0);
+		float weight = transparencyWeight(alpha);
+		fragColor = vec4(endColor.rgb * alpha * weight, alpha);
+		weightOut = alpha * weight;
+	}
 }
 
 bool isTextureValid(sampler2D tex) {
 	return texture(tex, vec2(0.5, 0.5)) != vec4(1.0, 1.0, 1.0, 1.0);
 }
 
+float ditherThreshold() {
+	const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+	ivec2 pixel = ivec2(gl_FragCoord.xy) % 4;
+	return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
+
 vec4 calcDiffuse(vec3 lightDiffuse, float diffuseFactor) {
 	return material_diffuse * texture(diffuse0, uvIn) * vec4(lightDiffuse, 1.0) * diffuseFactor;
 }
 
+vec4 calcAmbient(vec3 lightAmbient) {
+	return material_ambient * vec4(lightAmbient * (1.0 - occlusionIn), 1.0);
+}
+
 vec4 calcSpecular(vec3 lightSpecular, float specularFactor) {
 	return material_specular * texture(specular0, uvIn).r * vec4(lightSpecular, 1.0) * specularFactor;
 }
 
-vec4 directionalLight(Light light, vec3 normal, vec3 viewDir) {
+vec4 directionalLight(Light light, vec3 normal, vec3 viewDir, float shadow) {
 	vec3 lightDir = normalize(-light.direction);
 	// Ambient
-	vec4 ambient = material_ambient * vec4(light.ambient, 1.0);
+	vec4 ambient = calcAmbient(light.ambient);
 	// Diffuse
 	float diff = max(dot(normal, lightDir), 0.0);
 	vec4 diffuse = calcDiffuse(light.diffuse, diff);
@@ -109,11 +136,11 @@ vec4 directionalLight(Light light, vec3 normal, vec3 viewDir) {
 		float spec = pow(max(dot(normal, halfVec), 0.0), material_shininess);
 		specular = calcSpecular(light.specular, spec);
 	}
-	// Return values
-	return (ambient + diffuse + specular);
+	// Return values, the shadow only blocks the direct light
+	return (ambient + shadow * (diffuse + specular));
 }
 
-vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
+vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow) {
 	vec3 lightDir = normalize(light.position - fragPos);
 	float distance = length(light.position - fragPos);
 	// Check if the fragment is outside the light's range
@@ -125,7 +152,7 @@ vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
 	// Clamp attenuation to avoid exceeding range
 	attenuation = max(attenuation, 0.0);
 	// Ambient
-	vec4 ambient = material_ambient * vec4(light.ambient, 1.0);
+	vec4 ambient = calcAmbient(light.ambient);
 	// Diffuse
 	float diff = max(dot(normal, lightDir), 0.0);
 	vec4 diffuse = calcDiffuse(light.diffuse, diff);
@@ -136,11 +163,11 @@ vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
 		float spec = pow(max(dot(normal, halfVec), 0.0), material_shininess);
 		specular = calcSpecular(light.specular, spec);
 	}
-	// Return values
-	return attenuation * (ambient + diffuse + specular);
+	// Return values, the shadow only blocks the direct light
+	return attenuation * (ambient + shadow * (diffuse + specular));
 }
 
-vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
+vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow) {
 	vec3 lightDir = normalize(light.position - fragPos);
 	float distance = length(light.position - fragPos);
 	// Check if the fragment is outside the light's range
@@ -155,7 +182,7 @@ vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
 	float epsilon = light.cutOff - light.outerCutOff;
 	float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
 	// Ambient
-	vec4 ambient = material_ambient * vec4(light.ambient, 1.0);
+	vec4 ambient = calcAmbient(light.ambient);
 	// Diffuse
 	float diff = max(dot(normal, lightDir), 0.0);
 	vec4 diffuse = calcDiffuse(light.diffuse, diff);
@@ -166,6 +193,11 @@ vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
 		float spec = pow(max(dot(normal, halfVec), 0.0), material_shininess);
 		specular = calcSpecular(light.specular, spec);
 	}
-	// Return values
-	return attenuation * intensity * (ambient + diffuse + specular);
+	// Return values, the shadow only blocks the direct light
+	return attenuation * intensity * (ambient + shadow * (diffuse + specular));
+}
+
+float transparencyWeight(float alpha) {
+	// Closer and more opaque fragments weigh more (McGuire and Bavoil's depth weight), kept in the range of half floats
+	return clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+// Light lists of the clustered culling (see LightClusters), included by the shaders lighting per pixel
+
+#define MAX_OBJECT_LIGHTS 16u
+
+layout(std140) uniform clustersBuffer{
+	uvec4 clusterGrid;
+	vec4 clusterDepth;
+	vec4 clusterTileScale;
+};
+
+uniform usamplerBuffer clusterLights;
+uniform usamplerBuffer clusterLightIndices;
+
+// Screen pixels per pixel of the target as a power of two, see Renderer::setReducedResolutionTransparency
+uniform int resolutionShift;
+
+// Lights reaching the object, used when the clustered culling is off
+uniform uint objectLightCount;
+uniform uint objectLights[MAX_OBJECT_LIGHTS];
+
+uvec2 clusterLightRange(float depth) {
+	// Linear view depth back from the window depth
+	float ndcDepth = depth * 2.0 - 1.0;
+	float viewDepth = 2.0 * clusterDepth.x * clusterDepth.y / (clusterDepth.y + clusterDepth.x - ndcDepth * (clusterDepth.y - clusterDepth.x));
+	uint slice = uint(clamp(log(viewDepth) * clusterDepth.z + clusterDepth.w, 0.0, float(clusterGrid.z - 1u)));
+	uvec2 tile = min(uvec2(gl_FragCoord.xy * float(1 << resolutionShift) * clusterTileScale.xy), clusterGrid.xy - 1u);
+	return texelFetch(clusterLights, int((slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x)).xy;
+}
+
+uvec2 clusterLightRange() {
+	// The object's own lights when the culling is off
+	if (clusterGrid.w == 0u) {
+		return uvec2(0u, objectLightCount);
+	}
+	return clusterLightRange(gl_FragCoord.z);
+}
+
+uint clusterLightIndex(uvec2 range, uint i) {
+	return clusterGrid.w == 0u ? objectLights[i] : texelFetch(clusterLightIndices, int(range.x + i)).x;
+}
@@ -1,17 +1,19 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
+layout(location = 0) in vec4 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aUv;
 layout(location = 3) in vec3 aTangent;
 layout(location = 4) in vec3 aBitangent;
 
+#include "vertex_decode.glsl"
+
 out vec3 uv;
 
 uniform mat4 viewMatrix;
 uniform mat4 projectionMatrix;
 
 void main() {
-    gl_Position = projectionMatrix * mat4(mat3(viewMatrix)) * vec4(aPos, 1.0);
-    uv = aPos;
+    gl_Position = projectionMatrix * mat4(mat3(viewMatrix)) * vec4(decodePosition(), 1.0);
+    uv = decodePosition();
 }
\ No newline at end of file
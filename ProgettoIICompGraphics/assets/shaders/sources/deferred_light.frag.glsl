@@ -0,0 +1,107 @@
+#version 330 core
+
+// Same value on the G-buffer shader
+#define MAX_SHININESS 256.0
+
+out vec4 fragColor;
+
+in vec2 uvIn;
+
+// The G-buffer, see gbuffer.frag
+uniform sampler2D gDiffuse;
+uniform sampler2D gSpecular;
+uniform sampler2D gAmbient;
+uniform sampler2D gNormal;
+uniform sampler2D gIndirect;
+uniform sampler2D gDepth;
+
+uniform vec3 cameraPosition;
+uniform mat4 inverseCameraMatrix;
+
+// A pixel of the G-buffer
+struct Surface {
+	vec3 position;
+	vec3 normal;
+	vec3 diffuse;
+	vec3 specular;
+	vec3 ambient;
+	float shininess;
+};
+
+#include "lights.glsl"
+#include "clusters.glsl"
+
+vec3 lightSurface(Light light, Surface surface, vec3 viewDir);
+vec3 octDecode(vec2 e);
+
+void main() {
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, pixel, 0).r;
+	// Nothing was drawn, the sky stays
+	if (depth >= 1.0) {
+		discard;
+	}
+	// Write the depth of the G-buffer, so the forward passes after this one are tested against it
+	gl_FragDepth = depth;
+	vec4 diffuseShininess = texelFetch(gDiffuse, pixel, 0);
+	vec4 specularLightmapped = texelFetch(gSpecular, pixel, 0);
+	vec4 world = inverseCameraMatrix * vec4(uvIn * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	Surface surface;
+	surface.position = world.xyz / world.w;
+	surface.normal = octDecode(texelFetch(gNormal, pixel, 0).xy * 2.0 - 1.0);
+	surface.diffuse = diffuseShininess.rgb;
+	surface.specular = specularLightmapped.rgb;
+	surface.ambient = texelFetch(gAmbient, pixel, 0).rgb;
+	surface.shininess = diffuseShininess.a * MAX_SHININESS;
+	bool lightmapped = specularLightmapped.a > 0.5;
+	vec3 viewDir = normalize(cameraPosition - surface.position);
+	vec3 color = texelFetch(gIndirect, pixel, 0).rgb;
+	// The lights of the pixel's cluster, the deferred path only runs with the clustered culling on
+	uvec2 clusterRange = clusterLightRange(depth);
+	for (uint i = 0u; i < clusterRange.y; ++i) {
+		Light light = getLight(clusterLightIndex(clusterRange, i));
+		if (light.type == 0u || (lightmapped && (light.flags & LIGHT_FLAG_BAKED) != 0u)) {
+			continue;
+		}
+		color += lightSurface(light, surface, viewDir);
+	}
+	fragColor = vec4(color, 1.0);
+}
+
+vec3 lightSurface(Light light, Surface surface, vec3 viewDir) {
+	// Same Blinn-Phong terms as the forward shader, for the three kinds of lights
+	vec3 lightDir = normalize(-light.direction);
+	float attenuation = 1.0;
+	if (light.type != 1u) {
+		lightDir = normalize(light.position - surface.position);
+		float distance = length(light.position - surface.position);
+		// Check if the fragment is outside the light's range
+		if (distance > light.range) {
+			return vec3(0.0);
+		}
+		attenuation = max(1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance)), 0.0);
+		// Spotlight intensity
+		if (light.type == 3u) {
+			float theta = dot(lightDir, normalize(-light.direction));
+			float epsilon = light.cutOff - light.outerCutOff;
+			attenuation *= clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+		}
+	}
+	vec3 ambient = surface.ambient * light.ambient;
+	vec3 diffuse = surface.diffuse * light.diffuse * max(dot(surface.normal, lightDir), 0.0);
+	vec3 specular = vec3(0.0);
+	if (surface.shininess != 0.0) {
+		vec3 halfVec = normalize(viewDir + lightDir);
+		specular = surface.specular * light.specular * pow(max(dot(surface.normal, halfVec), 0.0), surface.shininess);
+	}
+	// The shadow only blocks the direct light
+	return attenuation * (ambient + lightShadow(light, surface.position, surface.normal) * (diffuse + specular));
+}
+
+vec3 octDecode(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0.0) {
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(v);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+
+layout(location = 0) in vec4 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aUv;
+layout(location = 3) in vec3 aTangent;
+layout(location = 4) in vec3 aBitangent;
+
+#include "vertex_decode.glsl"
+
+out vec2 uvIn;
+
+uniform mat4 objMatrix;
+uniform mat4 cameraMatrix;
+// Same transform as the material shaders, the color pass tests their depth for equality
+invariant gl_Position;
+
+void main() {
+    // Depth pre-pass: the position and the uvs for the alpha test, nothing else
+    vec3 worldPosition = vec3(objMatrix * vec4(decodePosition(), 1.0));
+    gl_Position = cameraMatrix * vec4(worldPosition, 1.0);
+    uvIn = aUv;
+}
@@ -0,0 +1,22 @@
+#version 330 core
+
+in vec2 uvIn;
+
+// Copy of the opaque depth at full resolution
+uniform sampler2D sceneDepth;
+// Screen pixels per pixel of the target as a power of two
+uniform int resolutionShift;
+
+void main() {
+	// Keep the farthest depth of the block, so no transparent surface in front of part of it gets rejected
+	int blockSize = 1 << resolutionShift;
+	ivec2 firstPixel = ivec2(gl_FragCoord.xy) * blockSize;
+	ivec2 maxPixel = textureSize(sceneDepth, 0) - 1;
+	float depth = 0.0;
+	for (int y = 0; y < blockSize; ++y) {
+		for (int x = 0; x < blockSize; ++x) {
+			depth = max(depth, texelFetch(sceneDepth, min(firstPixel + ivec2(x, y), maxPixel), 0).r);
+		}
+	}
+	gl_FragDepth = depth;
+}
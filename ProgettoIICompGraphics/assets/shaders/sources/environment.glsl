@@ -0,0 +1,33 @@
+// Lighting from the sky (see EnvironmentLighting), included by every shader it lights, forward and deferred alike
+
+// Irradiance of the skybox in spherical harmonics
+layout(std140) uniform environmentBuffer{
+	vec4 environmentIrradiance[9];
+	vec4 environmentReflection;
+};
+
+// Prefiltered mip chain of the sky, rougher levels are blurrier
+uniform samplerCube environmentMap;
+
+vec3 environmentLight(vec3 normal) {
+	// The harmonics' polynomials, the coefficients already hold their normalization and the cosine lobe
+	vec3 irradiance = environmentIrradiance[0].rgb
+		+ environmentIrradiance[1].rgb * normal.y
+		+ environmentIrradiance[2].rgb * normal.z
+		+ environmentIrradiance[3].rgb * normal.x
+		+ environmentIrradiance[4].rgb * (normal.x * normal.y)
+		+ environmentIrradiance[5].rgb * (normal.y * normal.z)
+		+ environmentIrradiance[6].rgb * (3.0 * normal.z * normal.z - 1.0)
+		+ environmentIrradiance[7].rgb * (normal.x * normal.z)
+		+ environmentIrradiance[8].rgb * (normal.x * normal.x - normal.y * normal.y);
+	return max(irradiance, vec3(0.0));
+}
+
+vec3 environmentSpecular(vec3 normal, vec3 viewDir, float reflectivity, float roughness) {
+	// Reflection of the sky, Schlick's fresnel grows less towards the edges the rougher the material
+	vec3 reflected = reflect(-viewDir, normal);
+	float edge = pow(1.0 - max(dot(normal, viewDir), 0.0), 5.0);
+	float fresnel = reflectivity + (max(1.0 - roughness, reflectivity) - reflectivity) * edge;
+	vec3 reflection = textureLod(environmentMap, reflected, roughness * environmentReflection.x).rgb;
+	return reflection * fresnel * environmentReflection.y;
+}
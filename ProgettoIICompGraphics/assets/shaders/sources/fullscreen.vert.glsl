@@ -0,0 +1,10 @@
+#version 330 core
+
+out vec2 uvIn;
+
+void main() {
+    // Screen covering quad of the full screen passes, a 4 vertices triangle strip without any vertex buffer
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    uvIn = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,95 @@
+#version 330 core
+
+// Same value on the deferred light pass
+#define MAX_SHININESS 256.0
+
+// Compact G-buffer of the deferred path, see Renderer::setDeferredShading
+layout(location = 0) out vec4 diffuseOut; /* Diffuse color (rgb), shininess over MAX_SHININESS (a) */
+layout(location = 1) out vec4 specularOut; /* Specular color (rgb), 1 if lightmapped (a) */
+layout(location = 2) out vec4 ambientOut; /* Ambient color, occlusion included (rgb) */
+layout(location = 3) out vec2 normalOut; /* Octahedral normal, remapped to [0, 1] */
+layout(location = 4) out vec3 indirectOut; /* Light that doesn't come from the LightSystem: sky, lightmap and reflections */
+
+in vec3 normalIn;
+in vec2 uvIn;
+in float occlusionIn;
+in vec2 lightmapUvIn;
+in vec3 worldPosition;
+in mat3 normalMatrix;
+in mat3 TBN;
+
+uniform vec3 cameraPosition;
+uniform float fadeOut;
+
+uniform vec4 material_color;
+uniform vec4 material_ambient;
+uniform vec4 material_diffuse;
+uniform vec4 material_specular;
+uniform float material_shininess;
+uniform float material_cutoutThreshold;
+uniform float material_reflectivity;
+uniform float material_roughness;
+
+uniform sampler2D albedo0;
+uniform sampler2D diffuse0;
+uniform sampler2D specular0;
+uniform sampler2D normal0;
+
+// Baked lighting of static objects, the light pass skips the baked lights when it is set
+uniform bool lightmapped;
+uniform sampler2D lightmap;
+
+#include "environment.glsl"
+
+bool isTextureValid(sampler2D tex);
+float ditherThreshold();
+vec2 octEncode(vec3 v);
+
+void main() {
+	// Dither out while an impostor replaces the object
+	if (fadeOut > 0.0 && ditherThreshold() < fadeOut) {
+		discard;
+	}
+	vec4 albedo = material_color * texture(albedo0, uvIn);
+	if (albedo.a <= material_cutoutThreshold) {
+		discard;
+	}
+	vec3 normal = normalIn;
+	if (isTextureValid(normal0)) {
+		normal = normalize(TBN * texture(normal0, uvIn).xyz);
+	}
+	// The material terms of the lighting functions, already multiplied by the albedo
+	vec3 diffuse = albedo.rgb * material_diffuse.rgb * texture(diffuse0, uvIn).rgb;
+	float specularMask = texture(specular0, uvIn).r;
+	vec3 ambient = albedo.rgb * material_ambient.rgb * (1.0 - occlusionIn);
+	diffuseOut = vec4(diffuse, clamp(material_shininess / MAX_SHININESS, 0.0, 1.0));
+	specularOut = vec4(albedo.rgb * material_specular.rgb * specularMask, lightmapped ? 1.0 : 0.0);
+	ambientOut = vec4(ambient, 1.0);
+	normalOut = octEncode(normal) * 0.5 + 0.5;
+	// Everything the forward shaders add outside of the light loop
+	vec3 indirect = ambient * environmentLight(normal);
+	if (lightmapped) {
+		indirect += diffuse * texture(lightmap, lightmapUvIn).rgb;
+	}
+	if (material_reflectivity > 0.0) {
+		vec3 viewDir = normalize(cameraPosition - worldPosition);
+		indirect += environmentSpecular(normal, viewDir, material_reflectivity, material_roughness) * specularMask;
+	}
+	indirectOut = indirect;
+}
+
+bool isTextureValid(sampler2D tex) {
+	return texture(tex, vec2(0.5, 0.5)) != vec4(1.0, 1.0, 1.0, 1.0);
+}
+
+float ditherThreshold() {
+	const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+	ivec2 pixel = ivec2(gl_FragCoord.xy) % 4;
+	return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
+
+vec2 octEncode(vec3 v) {
+	// Project on the octahedron, then fold the lower half over the upper one
+	v /= abs(v.x) + abs(v.y) + abs(v.z);
+	return v.z >= 0.0 ? v.xy : (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
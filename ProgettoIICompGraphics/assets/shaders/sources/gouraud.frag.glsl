@@ -3,11 +3,28 @@
 in vec4 lightingColor;
 in vec2 uvIn;
 
-out vec4 fragColor;
+layout(location = 0) out vec4 fragColor;
+// Sum of the weights of the weighted blended transparency, see Renderer::setOrderIndependentTransparency
+layout(location = 1) out float weightOut;
 
+uniform bool weightedTransparency;
 uniform sampler2D albedo0;
 
+float transparencyWeight(float alpha);
+
 void main() {
     vec4 textureColor = texture(albedo0, uvIn);
     fragColor = lightingColor * textureColor;
+    // Weighted blended transparency: the color premultiplied and weighted by depth, the weights summed aside
+    if (weightedTransparency) {
+        float alpha = clamp(fragColor.a, 0.0, 1.0);
+        float weight = transparencyWeight(alpha);
+        weightOut = alpha * weight;
+        fragColor = vec4(fragColor.rgb * alpha * weight, alpha);
+    }
+}
+
+float transparencyWeight(float alpha) {
+    // Closer and more opaque fragments weigh more (McGuire and Bavoil's depth weight), kept in the range of half floats
+    return clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
 }
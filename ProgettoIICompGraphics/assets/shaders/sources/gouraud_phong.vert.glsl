@@ -1,79 +1,74 @@
 #version 330 core
 
-#define MAX_LIGHTS 32u
+#define MAX_OBJECT_LIGHTS 16u
 
-layout(location = 0) in vec3 aPos;
+layout(location = 0) in vec4 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aUv;
 layout(location = 3) in vec3 aTangent;
 layout(location = 4) in vec3 aBitangent;
+// Baked ambient occlusion of static meshes, reads 0 (open) when the mesh has none
+layout(location = 6) in float aOcclusion;
+
+#include "vertex_decode.glsl"
 
 out vec4 lightingColor;
 out vec2 uvIn;
 
 uniform mat4 objMatrix;
 uniform mat4 cameraMatrix;
+// Same transform on the depth pre-pass, its depth has to match exactly for the equal depth test
+invariant gl_Position;
 uniform vec3 cameraPosition;
 
-struct Light {
-    vec3 position;
-    uint type;
-    vec3 direction;
-    float range;
-    vec3 ambient;
-    float constant;
-    vec3 diffuse;
-    float linear;
-    vec3 specular;
-    float quadratic;
-    float cutOff;
-    float outerCutOff;
-    vec2 padding;
-};
+#include "lights.glsl"
+
+// Lights reaching the object
+uniform uint objectLightCount;
+uniform uint objectLights[MAX_OBJECT_LIGHTS];
 
-layout(std140) uniform lightsBuffer{
-    Light[MAX_LIGHTS] lights;
-};
+#include "environment.glsl"
 
 uniform vec4 material_ambient;
 uniform vec4 material_diffuse;
 uniform vec4 material_specular;
 uniform float material_shininess;
 
-vec4 directionalLight(Light light, vec3 normal, vec3 viewDir);
-vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec4 directionalLight(Light light, vec3 normal, vec3 viewDir, float shadow);
+vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);
+vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);
 
 void main() {
-    vec3 worldPosition = vec3(objMatrix * vec4(aPos, 1.0));
+    vec3 worldPosition = vec3(objMatrix * vec4(decodePosition(), 1.0));
     gl_Position = cameraMatrix * vec4(worldPosition, 1.0);
     uvIn = aUv;
     // Calculate normal
     mat3 normalMatrix = transpose(inverse(mat3(objMatrix)));
-    vec3 normal = normalize(normalMatrix * aNormal);
+    vec3 normal = normalize(normalMatrix * decodeNormal());
     vec3 viewDir = normalize(cameraPosition - worldPosition);
     // Add lighting
     vec4 combinedLighting = vec4(0.0);
-    for (uint i = 0u; i < MAX_LIGHTS; ++i) {
-        Light light = lights[i];
+    for (uint i = 0u; i < objectLightCount; ++i) {
+        Light light = getLight(objectLights[i]);
         if (light.type == 0u) {
             continue;
         }
         else if (light.type == 1u) {
-            combinedLighting += directionalLight(light, normal, viewDir);
+            combinedLighting += directionalLight(light, normal, viewDir, lightShadow(light, worldPosition, normal));
         }
         else if (light.type == 2u) {
-            combinedLighting += pointLight(light, normal, worldPosition, viewDir);
+            combinedLighting += pointLight(light, normal, worldPosition, viewDir, lightShadow(light, worldPosition, normal));
         }
         else if (light.type == 3u) {
-            combinedLighting += spotLight(light, normal, worldPosition, viewDir);
+            combinedLighting += spotLight(light, normal, worldPosition, viewDir, lightShadow(light, worldPosition, normal));
         }
     }
+    combinedLighting += material_ambient * vec4(environmentLight(normal) * (1.0 - aOcclusion), 1.0);
     // Pass color to fragment for interpolation
     lightingColor = combinedLighting;
 }
 
-vec4 directionalLight(Light light, vec3 normal, vec3 viewDir) {
+vec4 directionalLight(Light light, vec3 normal, vec3 viewDir, float shadow) {
     vec3 lightDir = normalize(-light.direction);
     float diff = max(dot(normal, lightDir), 0.0);
     vec3 halfVec = normalize(viewDir + lightDir);
@@ -82,13 +77,14 @@ vec4 directionalLight(Light light, vec3 normal, vec3 viewDir) {
         vec3 reflectDir = reflect(-lightDir, normal);
         spec = pow(max(dot(viewDir, reflectDir), 0.0), material_shininess);
     }
-    vec4 ambient = material_ambient * vec4(light.ambient, 1.0);
+    vec4 ambient = material_ambient * vec4(light.ambient * (1.0 - aOcclusion), 1.0);
     vec4 diffuse = material_diffuse * vec4(light.diffuse, 1.0) * diff;
     vec4 specular = material_specular * vec4(light.specular, 1.0) * spec;
-    return ambient + diffuse + specular;
+    // The shadow only blocks the direct light
+    return ambient + shadow * (diffuse + specular);
 }
 
-vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
+vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow) {
     vec3 lightDir = normalize(light.position - fragPos);
     float distance = length(light.position - fragPos);
     if (distance > light.range) {
@@ -102,13 +98,13 @@ vec4 pointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
         vec3 reflectDir = reflect(-lightDir, normal);
         spec = pow(max(dot(viewDir, reflectDir), 0.0), material_shininess);
     }
-    vec4 ambient = material_ambient * vec4(light.ambient, 1.0);
+    vec4 ambient = material_ambient * vec4(light.ambient * (1.0 - aOcclusion), 1.0);
     vec4 diffuse = material_diffuse * vec4(light.diffuse, 1.0) * diff;
     vec4 specular = material_specular * vec4(light.specular, 1.0) * spec;
-    return attenuation * (ambient + diffuse + specular);
+    return attenuation * (ambient + shadow * (diffuse + specular));
 }
 
-vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
+vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow) {
     vec3 lightDir = normalize(light.position - fragPos);
     float distance = length(light.position - fragPos);
     if (distance > light.range) {
@@ -125,8 +121,8 @@ vec4 spotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir) {
         vec3 reflectDir = reflect(-lightDir, normal);
         spec = pow(max(dot(viewDir, reflectDir), 0.0), material_shininess);
     }
-    vec4 ambient = material_ambient * vec4(light.ambient, 1.0);
+    vec4 ambient = material_ambient * vec4(light.ambient * (1.0 - aOcclusion), 1.0);
     vec4 diffuse = material_diffuse * vec4(light.diffuse, 1.0) * diff;
     vec4 specular = material_specular * vec4(light.specular, 1.0) * spec;
-    return attenuation * intensity * (ambient + diffuse + specular);
+    return attenuation * intensity * (ambient + shadow * (diffuse + specular));
 }
@@ -0,0 +1,65 @@
+#version 330 core
+
+out vec4 fragColor;
+
+in vec3 normalIn;
+in vec2 uvIn;
+in vec3 worldPosition;
+in vec3 atlasCellIn;
+
+uniform float fadeOut;
+
+uniform sampler2D atlas;
+
+#include "lights.glsl"
+#include "clusters.glsl"
+#include "environment.glsl"
+
+float ditherThreshold();
+vec3 lightContribution(Light light, vec3 normal);
+
+void main() {
+	// Mirrored pattern, so the proxy fills exactly the pixels the replaced meshes dither out
+	if (fadeOut > 0.0 && 1.0 - ditherThreshold() < fadeOut) {
+		discard;
+	}
+	// Wrap the uvs inside the material's cell, the gradients of the unwrapped uvs avoid seams at the wrap
+	vec2 atlasUv = atlasCellIn.xy + fract(uvIn) * atlasCellIn.z;
+	vec4 albedo = textureGrad(atlas, atlasUv, dFdx(uvIn) * atlasCellIn.z, dFdy(uvIn) * atlasCellIn.z);
+	vec3 normal = normalize(normalIn);
+	vec3 combinedLighting = vec3(0.0);
+	uvec2 clusterRange = clusterLightRange();
+	for (uint i = 0u; i < clusterRange.y; ++i) {
+		Light light = getLight(clusterLightIndex(clusterRange, i));
+		if (light.type != 0u) {
+			combinedLighting += lightContribution(light, normal);
+		}
+	}
+	combinedLighting += environmentLight(normal);
+	fragColor = vec4(albedo.rgb * combinedLighting, 1.0);
+}
+
+float ditherThreshold() {
+	const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+	ivec2 pixel = ivec2(gl_FragCoord.xy) % 4;
+	return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
+
+// Ambient and diffuse only, the merged materials lose their specular maps
+vec3 lightContribution(Light light, vec3 normal) {
+	if (light.type == 1u) {
+		return light.ambient + lightShadow(light, worldPosition, normal) * light.diffuse * max(dot(normal, normalize(-light.direction)), 0.0);
+	}
+	vec3 lightDir = normalize(light.position - worldPosition);
+	float distance = length(light.position - worldPosition);
+	if (distance > light.range) {
+		return vec3(0.0);
+	}
+	float attenuation = max(1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance)), 0.0);
+	float intensity = 1.0;
+	if (light.type == 3u) {
+		float theta = dot(lightDir, normalize(-light.direction));
+		intensity = clamp((theta - light.outerCutOff) / (light.cutOff - light.outerCutOff), 0.0, 1.0);
+	}
+	return attenuation * intensity * (light.ambient + lightShadow(light, worldPosition, normal) * light.diffuse * max(dot(normal, lightDir), 0.0));
+}
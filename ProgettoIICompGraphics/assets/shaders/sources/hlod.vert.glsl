@@ -0,0 +1,25 @@
+#version 330 core
+
+layout(location = 0) in vec4 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aUv;
+layout(location = 3) in vec3 aTangent;
+
+out vec3 normalIn;
+out vec2 uvIn;
+out vec3 worldPosition;
+out vec3 atlasCellIn;
+
+uniform mat4 objMatrix;
+uniform mat4 cameraMatrix;
+// Same transform on the depth pre-pass, its depth has to match exactly for the equal depth test
+invariant gl_Position;
+
+void main() {
+    // Proxies always use the full vertex format, the tangent slot holds the atlas cell (offset.xy, scale)
+    worldPosition = vec3(objMatrix * vec4(aPos.xyz, 1.0));
+    gl_Position = cameraMatrix * vec4(worldPosition, 1.0);
+    normalIn = normalize(transpose(inverse(mat3(objMatrix))) * aNormal);
+    uvIn = aUv;
+    atlasCellIn = aTangent;
+}
@@ -0,0 +1,15 @@
+#version 330 core
+
+out vec4 fragColor;
+
+in vec2 uvIn;
+
+uniform vec4 material_color;
+uniform vec4 material_diffuse;
+
+uniform sampler2D albedo0;
+
+void main() {
+	// Store the diffuse reflectance, the proxies light it with a single color per texel
+	fragColor = vec4((material_color * texture(albedo0, uvIn) * material_diffuse).rgb, 1.0);
+}
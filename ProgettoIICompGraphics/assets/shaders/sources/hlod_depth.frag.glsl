@@ -0,0 +1,18 @@
+#version 330 core
+
+uniform float fadeOut;
+
+float ditherThreshold();
+
+void main() {
+	// Only the depth is written, with the mirrored pattern of the proxies
+	if (fadeOut > 0.0 && 1.0 - ditherThreshold() < fadeOut) {
+		discard;
+	}
+}
+
+float ditherThreshold() {
+	const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+	ivec2 pixel = ivec2(gl_FragCoord.xy) % 4;
+	return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+layout(location = 0) in vec4 aPos;
+
+uniform mat4 objMatrix;
+uniform mat4 cameraMatrix;
+// Same transform as the proxy shader, the color pass tests its depth for equality
+invariant gl_Position;
+
+void main() {
+    // Depth pre-pass of the proxies, they always use the full vertex format
+    vec3 worldPosition = vec3(objMatrix * vec4(aPos.xyz, 1.0));
+    gl_Position = cameraMatrix * vec4(worldPosition, 1.0);
+}
@@ -0,0 +1,66 @@
+#version 330 core
+
+out vec4 fragColor;
+
+in vec2 uvIn[2];
+in float viewBlend;
+in float fadeIn;
+in vec3 worldPosition;
+
+uniform sampler2D albedoAtlas;
+uniform sampler2D normalAtlas;
+
+#include "lights.glsl"
+#include "clusters.glsl"
+#include "environment.glsl"
+
+float ditherThreshold();
+vec3 lightContribution(Light light, vec3 normal);
+
+void main() {
+	// Dither in as the meshes dither out
+	if (ditherThreshold() >= fadeIn) {
+		discard;
+	}
+	vec4 albedo = mix(texture(albedoAtlas, uvIn[0]), texture(albedoAtlas, uvIn[1]), viewBlend);
+	if (albedo.a < 0.5) {
+		discard;
+	}
+	vec4 packedNormal = mix(texture(normalAtlas, uvIn[0]), texture(normalAtlas, uvIn[1]), viewBlend);
+	vec3 normal = normalize(packedNormal.xyz / max(packedNormal.a, 0.0001) * 2.0 - 1.0);
+	vec3 combinedLighting = vec3(0.0);
+	uvec2 clusterRange = clusterLightRange();
+	for (uint i = 0u; i < clusterRange.y; ++i) {
+		Light light = getLight(clusterLightIndex(clusterRange, i));
+		if (light.type != 0u) {
+			combinedLighting += lightContribution(light, normal);
+		}
+	}
+	combinedLighting += environmentLight(normal);
+	fragColor = vec4(albedo.rgb / albedo.a * combinedLighting, 1.0);
+}
+
+float ditherThreshold() {
+	const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+	ivec2 pixel = ivec2(gl_FragCoord.xy) % 4;
+	return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
+
+// Ambient and diffuse only, the baked normals are too coarse for specular highlights
+vec3 lightContribution(Light light, vec3 normal) {
+	if (light.type == 1u) {
+		return light.ambient + lightShadow(light, worldPosition, normal) * light.diffuse * max(dot(normal, normalize(-light.direction)), 0.0);
+	}
+	vec3 lightDir = normalize(light.position - worldPosition);
+	float distance = length(light.position - worldPosition);
+	if (distance > light.range) {
+		return vec3(0.0);
+	}
+	float attenuation = max(1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance)), 0.0);
+	float intensity = 1.0;
+	if (light.type == 3u) {
+		float theta = dot(lightDir, normalize(-light.direction));
+		intensity = clamp((theta - light.outerCutOff) / (light.cutOff - light.outerCutOff), 0.0, 1.0);
+	}
+	return attenuation * intensity * (light.ambient + lightShadow(light, worldPosition, normal) * light.diffuse * max(dot(normal, lightDir), 0.0));
+}
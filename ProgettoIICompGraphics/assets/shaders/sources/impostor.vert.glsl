@@ -0,0 +1,44 @@
+#version 330 core
+
+layout(location = 0) in vec2 aCorner;
+layout(location = 1) in vec4 aPositionScale;
+layout(location = 2) in float aFade;
+
+out vec2 uvIn[2];
+out float viewBlend;
+out float fadeIn;
+out vec3 worldPosition;
+
+uniform mat4 cameraMatrix;
+uniform vec3 cameraPosition;
+uniform vec3 boundsCenter;
+uniform vec2 halfSize;
+uniform uvec2 atlasGrid;
+uniform uint viewCount;
+
+const float PI = 3.14159265359;
+
+// Position of a corner of a view in the atlas
+vec2 atlasUv(uint view, vec2 corner) {
+    vec2 cell = vec2(float(view % atlasGrid.x), float(view / atlasGrid.x));
+    return (cell + corner * 0.5 + 0.5) / vec2(atlasGrid);
+}
+
+void main() {
+    float scale = aPositionScale.w;
+    vec3 center = aPositionScale.xyz + boundsCenter * scale;
+    // Rotate around the vertical axis only, so the impostor stays upright
+    vec3 toCamera = cameraPosition - center;
+    vec2 horizontal = length(toCamera.xz) > 0.0001 ? normalize(toCamera.xz) : vec2(0.0, 1.0);
+    vec3 right = vec3(horizontal.y, 0.0, -horizontal.x);
+    worldPosition = center + (right * aCorner.x * halfSize.x + vec3(0.0, aCorner.y * halfSize.y, 0.0)) * scale;
+    gl_Position = cameraMatrix * vec4(worldPosition, 1.0);
+    // Pick the two baked views closest to the camera angle
+    float angle = atan(horizontal.x, horizontal.y);
+    float view = fract(angle / (2.0 * PI)) * float(viewCount);
+    uint first = uint(floor(view)) % viewCount;
+    uvIn[0] = atlasUv(first, aCorner);
+    uvIn[1] = atlasUv((first + 1u) % viewCount, aCorner);
+    viewBlend = fract(view);
+    fadeIn = aFade;
+}
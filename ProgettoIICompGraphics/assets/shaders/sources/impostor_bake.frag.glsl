@@ -0,0 +1,36 @@
+#version 330 core
+
+layout(location = 0) out vec4 albedoOut;
+layout(location = 1) out vec4 normalOut;
+
+in vec3 normalIn;
+in vec2 uvIn;
+in vec3 worldPosition;
+in mat3 normalMatrix;
+in mat3 TBN;
+
+uniform vec4 material_color;
+uniform float material_cutoutThreshold;
+
+uniform sampler2D albedo0;
+uniform sampler2D normal0;
+
+bool isTextureValid(sampler2D tex);
+
+void main() {
+	vec4 albedo = material_color * texture(albedo0, uvIn);
+	if (albedo.a <= material_cutoutThreshold) {
+		discard;
+	}
+	vec3 normal = normalIn;
+	if (isTextureValid(normal0)) {
+		normal = normalize(TBN * texture(normal0, uvIn).xyz);
+	}
+	// Lighting is applied when the impostor is drawn, store the unlit color and the world space normal
+	albedoOut = vec4(albedo.rgb, 1.0);
+	normalOut = vec4(normal * 0.5 + 0.5, 1.0);
+}
+
+bool isTextureValid(sampler2D tex) {
+	return texture(tex, vec2(0.5, 0.5)) != vec4(1.0, 1.0, 1.0, 1.0);
+}
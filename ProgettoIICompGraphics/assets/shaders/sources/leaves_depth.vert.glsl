@@ -0,0 +1,27 @@
+#version 330 core
+
+layout(location = 0) in vec4 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aUv;
+layout(location = 3) in vec3 aTangent;
+layout(location = 4) in vec3 aBitangent;
+
+#include "vertex_decode.glsl"
+
+out vec2 uvIn;
+
+uniform float glfwTime;
+uniform mat4 objMatrix;
+uniform mat4 cameraMatrix;
+uniform vec3 material_windDirection;
+uniform float material_windStrength;
+// Same transform as the leaves shader, the color pass tests its depth for equality
+invariant gl_Position;
+
+void main() {
+    // Depth pre-pass of the leaves, swayed by the same wind
+    vec3 worldPosition = vec3(objMatrix * vec4(decodePosition(), 1.0));
+    worldPosition += material_windDirection * sin(glfwTime + 0.5 * length(worldPosition * material_windDirection)) * material_windStrength;
+    gl_Position = cameraMatrix * vec4(worldPosition, 1.0);
+    uvIn = aUv;
+}
@@ -0,0 +1,98 @@
+// Lights of the LightSystem and their shadows, included by every shader lighting with them (see ShaderLoader)
+
+#define LIGHT_FLAG_BAKED 1u
+#define MAX_SHADOW_TILES 32u
+#define SHADOW_NORMAL_OFFSET 1.5
+
+struct Light {
+	vec3 position;
+	uint type;
+	vec3 direction;
+	float range;
+	vec3 ambient;
+	float constant;
+	vec3 diffuse;
+	float linear;
+	vec3 specular;
+	float quadratic;
+	float cutOff;
+	float outerCutOff;
+	uint flags;
+	uint shadow;
+};
+
+// Every light of the LightSystem, read through getLight
+uniform usamplerBuffer lights;
+
+// Shadow maps of the lights packed in a single atlas, see ShadowAtlas
+layout(std140) uniform shadowsBuffer{
+	mat4 shadowMatrices[MAX_SHADOW_TILES];
+	vec4 shadowRects[MAX_SHADOW_TILES];
+	vec4 shadowTexels[MAX_SHADOW_TILES];
+	vec4 shadowSettings;
+};
+
+uniform sampler2DShadow shadowAtlas;
+
+Light getLight(uint index) {
+	// Every light takes 6 texels, laid out as LightSystem::Light
+	int texel = int(index) * 6;
+	uvec4 positionType = texelFetch(lights, texel);
+	uvec4 directionRange = texelFetch(lights, texel + 1);
+	uvec4 ambientConstant = texelFetch(lights, texel + 2);
+	uvec4 diffuseLinear = texelFetch(lights, texel + 3);
+	uvec4 specularQuadratic = texelFetch(lights, texel + 4);
+	uvec4 cutOffs = texelFetch(lights, texel + 5);
+	Light light;
+	light.position = uintBitsToFloat(positionType.xyz);
+	light.type = positionType.w;
+	light.direction = uintBitsToFloat(directionRange.xyz);
+	light.range = uintBitsToFloat(directionRange.w);
+	light.ambient = uintBitsToFloat(ambientConstant.xyz);
+	light.constant = uintBitsToFloat(ambientConstant.w);
+	light.diffuse = uintBitsToFloat(diffuseLinear.xyz);
+	light.linear = uintBitsToFloat(diffuseLinear.w);
+	light.specular = uintBitsToFloat(specularQuadratic.xyz);
+	light.quadratic = uintBitsToFloat(specularQuadratic.w);
+	light.cutOff = uintBitsToFloat(cutOffs.x);
+	light.outerCutOff = uintBitsToFloat(cutOffs.y);
+	light.flags = cutOffs.z;
+	light.shadow = cutOffs.w;
+	return light;
+}
+
+float lightShadow(Light light, vec3 fragPos, vec3 normal) {
+	if (light.shadow == 0u || shadowSettings.x == 0.0) {
+		return 1.0;
+	}
+	uint tile = light.shadow - 1u;
+	vec3 fromLight = fragPos - light.position;
+	// Point lights have a tile per cube face, in the +X, -X, +Y, -Y, +Z, -Z order
+	if (light.type == 2u) {
+		vec3 magnitude = abs(fromLight);
+		if (magnitude.x >= magnitude.y && magnitude.x >= magnitude.z) {
+			tile += fromLight.x >= 0.0 ? 0u : 1u;
+		}
+		else if (magnitude.y >= magnitude.z) {
+			tile += fromLight.y >= 0.0 ? 2u : 3u;
+		}
+		else {
+			tile += fromLight.z >= 0.0 ? 4u : 5u;
+		}
+	}
+	// Move the point along the normal by about a texel of the tile, against self shadowing
+	float texel = shadowTexels[tile].x * (shadowTexels[tile].y > 0.0 ? length(fromLight) : 1.0);
+	vec4 projected = shadowMatrices[tile] * vec4(fragPos + normal * texel * SHADOW_NORMAL_OFFSET, 1.0);
+	vec3 coords = projected.xyz / projected.w;
+	vec4 rect = shadowRects[tile];
+	if (coords.z >= 1.0 || any(lessThan(coords.xy, rect.xy - shadowSettings.y)) || any(greaterThan(coords.xy, rect.zw + shadowSettings.y))) {
+		return 1.0;
+	}
+	// Four bilinear comparisons kept inside the tile
+	float lit = 0.0;
+	for (int i = 0; i < 4; ++i) {
+		vec2 offset = (vec2(float(i & 1), float(i >> 1)) - 0.5) * shadowSettings.y;
+		lit += texture(shadowAtlas, vec3(clamp(coords.xy + offset, rect.xy, rect.zw), coords.z));
+	}
+	return lit * 0.25;
+}
@@ -0,0 +1,22 @@
+#version 330 core
+
+out vec4 fragColor;
+
+in vec2 uvIn;
+
+// Targets of the weighted blended transparency, see Renderer::setOrderIndependentTransparency
+uniform sampler2D accumulation; /* Weighted premultiplied colors (rgb), revealage (a) */
+uniform sampler2D weights; /* Sum of the weights */
+
+void main() {
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 accumulated = texelFetch(accumulation, pixel, 0);
+	// No transparent surface covers the pixel
+	float revealage = accumulated.a;
+	if (revealage >= 1.0) {
+		discard;
+	}
+	// Average color of the surfaces, blended over the opaque scene by how much of it they hide
+	vec3 color = accumulated.rgb / clamp(texelFetch(weights, pixel, 0).r, 1e-4, 5e4);
+	fragColor = vec4(color, 1.0 - revealage);
+}
@@ -0,0 +1,35 @@
+#version 330 core
+
+out vec4 fragColor;
+
+in vec3 normalIn;
+in vec2 uvIn;
+in float occlusionIn;
+in vec2 lightmapUvIn;
+
+uniform vec4 material_color;
+uniform vec4 material_ambient;
+uniform vec4 material_diffuse;
+uniform float material_cutoutThreshold;
+
+uniform sampler2D albedo0;
+uniform sampler2D diffuse0;
+
+// Baked lighting of static objects
+uniform bool lightmapped;
+uniform sampler2D lightmap;
+
+#include "environment.glsl"
+
+void main() {
+	// Cheap lighting for the reflection probes: the sky light and the lightmap, no dynamic lights, speculars nor reflections
+	vec4 albedo = material_color * texture(albedo0, uvIn);
+	if (albedo.a <= material_cutoutThreshold) {
+		discard;
+	}
+	vec3 lighting = material_ambient.rgb * environmentLight(normalize(normalIn)) * (1.0 - occlusionIn);
+	if (lightmapped) {
+		lighting += material_diffuse.rgb * texture(diffuse0, uvIn).rgb * texture(lightmap, lightmapUvIn).rgb;
+	}
+	fragColor = vec4(albedo.rgb * lighting, 1.0);
+}
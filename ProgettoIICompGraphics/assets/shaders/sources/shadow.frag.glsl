@@ -0,0 +1,15 @@
+#version 330 core
+
+in vec2 uvIn;
+
+uniform vec4 material_color;
+uniform float material_cutoutThreshold;
+
+uniform sampler2D albedo0;
+
+void main() {
+	// Only the depth is written, cut out texels cast no shadow
+	if ((material_color * texture(albedo0, uvIn)).a <= material_cutoutThreshold) {
+		discard;
+	}
+}
@@ -0,0 +1,43 @@
+#version 330 core
+
+out vec4 fragColor;
+
+in vec2 uvIn;
+
+// Reduced resolution transparency, see Renderer::setReducedResolutionTransparency
+uniform sampler2D transparency; /* Premultiplied colors (rgb), coverage (a) */
+uniform sampler2D reducedDepth; /* Downsampled opaque depth the transparency was tested against */
+uniform sampler2D sceneDepth; /* Opaque depth at full resolution */
+uniform int resolutionShift;
+uniform vec2 depthProjection; /* Projection matrix entries [2][2] and [3][2], to get the view depth back */
+
+float viewDepth(float depth) {
+	return depthProjection.y / (depth * 2.0 - 1.0 + depthProjection.x);
+}
+
+void main() {
+	float depth = viewDepth(texelFetch(sceneDepth, ivec2(gl_FragCoord.xy), 0).r);
+	// Position in the reduced target, between the centers of its four closest texels
+	vec2 position = gl_FragCoord.xy / float(1 << resolutionShift) - 0.5;
+	ivec2 firstTexel = ivec2(floor(position));
+	vec2 fraction = position - vec2(firstTexel);
+	ivec2 maxTexel = textureSize(transparency, 0) - 1;
+	vec4 color = vec4(0.0);
+	float totalWeight = 0.0;
+	for (int i = 0; i < 4; ++i) {
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 texel = clamp(firstTexel + offset, ivec2(0), maxTexel);
+		vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+		// Texels that saw another opaque surface than the pixel barely count, so the edges don't bleed
+		float difference = abs(viewDepth(texelFetch(reducedDepth, texel, 0).r) - depth) / depth;
+		float weight = bilinear.x * bilinear.y / (difference + 1e-3);
+		color += texelFetch(transparency, texel, 0) * weight;
+		totalWeight += weight;
+	}
+	color /= max(totalWeight, 1e-6);
+	// No transparent surface covers the pixel
+	if (color.a <= 0.0) {
+		discard;
+	}
+	fragColor = color;
+}
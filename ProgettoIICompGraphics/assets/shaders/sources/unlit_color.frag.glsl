@@ -1,9 +1,16 @@
 #version 330 core
 
-out vec4 fragColor;
+layout(location = 0) out vec4 fragColor;
+// Sum of the weights of the weighted blended transparency, see Renderer::setOrderIndependentTransparency
+layout(location = 1) out float weightOut;
 
+uniform bool weightedTransparency;
 uniform vec3 material_color;
 
 void main() {
 	fragColor = vec4(material_color, 1.0);
+	// Opaque color, it covers whatever is behind it with a weight of one
+	if (weightedTransparency) {
+		weightOut = 1.0;
+	}
 }
\ No newline at end of file
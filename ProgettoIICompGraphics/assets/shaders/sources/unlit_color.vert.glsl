@@ -1,15 +1,19 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
+layout(location = 0) in vec4 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aUv;
 layout(location = 3) in vec3 aTangent;
 layout(location = 4) in vec3 aBitangent;
 
+#include "vertex_decode.glsl"
+
 uniform mat4 objMatrix;
 uniform mat4 cameraMatrix;
+// Same transform on the depth pre-pass, its depth has to match exactly for the equal depth test
+invariant gl_Position;
 
 void main() {
-    vec3 worldPosition = vec3(objMatrix * vec4(aPos, 1.0));
+    vec3 worldPosition = vec3(objMatrix * vec4(decodePosition(), 1.0));
     gl_Position = cameraMatrix * vec4(worldPosition, 1.0);
 }
\ No newline at end of file
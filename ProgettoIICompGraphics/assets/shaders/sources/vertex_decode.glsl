@@ -0,0 +1,31 @@
+// Decoding of the mesh vertex formats, included by every vertex shader drawing meshes (see ShaderLoader)
+// The including shader declares aPos (location 0), aNormal (1), aTangent (3) and aBitangent (4) before it
+
+uniform bool compactVertices;
+uniform vec3 meshBoundsCenter;
+uniform vec3 meshBoundsHalfExtent;
+
+// Compact meshes store snorm positions relative to their bounds and octahedral normals/tangents
+vec3 octDecode(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
+vec3 decodePosition() {
+    return compactVertices ? meshBoundsCenter + aPos.xyz * meshBoundsHalfExtent : aPos.xyz;
+}
+
+vec3 decodeNormal() {
+    return compactVertices ? octDecode(aNormal.xy) : aNormal;
+}
+
+vec3 decodeTangent() {
+    return compactVertices ? octDecode(aTangent.xy) : aTangent;
+}
+
+vec3 decodeBitangent() {
+    return compactVertices ? cross(decodeNormal(), decodeTangent()) * aPos.w : aBitangent;
+}
@@ -1,16 +1,24 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
-layout(location = 2) in vec2 aUv;
-layout(location = 3) in vec3 aTangent;
-layout(location = 4) in vec3 aBitangent;
+// Vertex of a clipmap patch, in quads of its level
+layout(location = 0) in vec2 aGrid;
+// Corner of the patch and center of its level, in vertices of the level's grid
+layout(location = 1) in vec4 aCornerCenter;
+// Distance between the vertices of the level
+layout(location = 2) in float aSpacing;
 
 out vec3 normalIn;
+out float occlusionIn;
 out vec3 worldPosition;
 
-uniform mat4 objMatrix;
 uniform mat4 cameraMatrix;
+uniform vec3 cameraPosition;
+
+uniform float seaHeight;
+uniform vec2 seaBoundsMin;
+uniform vec2 seaBoundsMax;
+uniform float waveFadeStart;
+uniform float waveFadeEnd;
 
 uniform float glfwTime;
 uniform float material_waveHeight;
@@ -19,25 +27,35 @@ uniform float material_waveFrequency;
 
 const vec2 directions[4] = vec2[](vec2(0.25, 0.75), vec2(0.5, 0.5), vec2(1, 0), vec2(0, 1));
 
+// Half the quads on each side of a level, and the fraction of it after which vertices morph onto the coarser level
+const float LEVEL_HALF_SIZE = 31.0;
+const float MORPH_START = 0.7;
+
 void main() {
-    // Transform vertex position to world space
-    worldPosition = vec3(objMatrix * vec4(aPos, 1.0));
-    // Compute wave displacement
+    // Work in whole vertices of the level, so neighbouring levels compute the exact same positions on their shared border
+    vec2 gridPosition = aCornerCenter.xy + aGrid;
+    vec2 fromCenter = abs(gridPosition - aCornerCenter.zw) / LEVEL_HALF_SIZE;
+    float morph = clamp((max(fromCenter.x, fromCenter.y) - MORPH_START) / (1.0 - MORPH_START), 0.0, 1.0);
+    // Odd vertices slide onto their even neighbour, which is a vertex of the coarser level
+    gridPosition -= mod(gridPosition, 2.0) * morph;
+    vec2 position = clamp(gridPosition * aSpacing, seaBoundsMin, seaBoundsMax);
+    // Waves fade out where the grid gets too coarse to sample them
+    float waveFade = waveFadeEnd > 0.0 ? 1.0 - smoothstep(waveFadeStart, waveFadeEnd, distance(position, cameraPosition.xz)) : 0.0;
     float waveSum = 0.0;
-    vec3 waveNormal = vec3(0.0, 1.0, 0.0);
-    for (int i = 0; i < 4; i++) {
-        vec2 direction = normalize(directions[i]);
-        float phase = float(i) * 3.14 / 2.0; // Different phase for each wave
-        float wave = sin(dot(worldPosition.xz, direction) * material_waveFrequency + glfwTime * material_waveSpeed + phase);
-        // Add weighted contribution of this wave
-        waveSum += wave * material_waveHeight / float(i + 1);
-        // Accumulate normals for lighting (gradient approximation)
-        waveNormal += vec3(-direction.x * wave, 1.0, -direction.y * wave) * material_waveHeight;
+    vec2 slope = vec2(0.0);
+    if (waveFade > 0.0) {
+        for (int i = 0; i < 4; i++) {
+            vec2 direction = normalize(directions[i]);
+            float phase = float(i) * 3.14 / 2.0; // Different phase for each wave
+            float angle = dot(position, direction) * material_waveFrequency + glfwTime * material_waveSpeed + phase;
+            float amplitude = material_waveHeight / float(i + 1) * waveFade;
+            // Add weighted contribution of this wave and its derivative
+            waveSum += sin(angle) * amplitude;
+            slope += cos(angle) * amplitude * material_waveFrequency * direction;
+        }
     }
-    // Apply wave displacement to the vertex's y-coordinate
-    worldPosition.y += waveSum;
-    // Recalculate normal based on wave slope
-    normalIn = normalize(mat3(transpose(inverse(objMatrix))) * normalize(waveNormal));
-    // Transform to clip space for rendering
+    worldPosition = vec3(position.x, seaHeight + waveSum, position.y);
+    normalIn = normalize(vec3(-slope.x, 1.0, -slope.y));
+    occlusionIn = 0.0;
     gl_Position = cameraMatrix * vec4(worldPosition, 1.0);
-}
\ No newline at end of file
+}
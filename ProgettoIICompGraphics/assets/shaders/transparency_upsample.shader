@@ -0,0 +1,2 @@
+vertex fullscreen.vert.glsl
+fragment transparency_upsample.frag.glsl
\ No newline at end of file
@@ -3,7 +3,9 @@
 
 #include "Camera.hpp"
 #include "CameraControls.hpp"
+#include "EnvironmentLighting.hpp"
 #include "GUI.hpp"
+#include "LightClusters.hpp"
 #include "LightSystem.hpp"
 #include "MainScene.hpp"
 #include "MaterialLoader.hpp"
@@ -13,6 +15,7 @@
 #include "Renderer.hpp"
 #include "SceneNode.hpp"
 #include "ShaderLoader.hpp"
+#include "ShadowAtlas.hpp"
 #include "Texture.hpp"
 #include "TextureLoader.hpp"
 #include "Transform.hpp"
@@ -60,13 +63,17 @@ int main() {
 	}
 	// Initialize light System
 	LightSystem::initialize();
+	LightClusters::initialize();
+	EnvironmentLighting::initialize();
+	ShadowAtlas::initialize();
 	LightSystem::setLight(0, LightSystem::DirectionalLight{ 
 		glm::vec3(-0.25f, -0.5f, 1.0f),
 		glm::vec3(0.17f, 0.25f, 0.22f), 
 		glm::vec3(0.4f, 0.58f, 0.62f), 
-		glm::vec3(0.0f, 1.0f, 0.76f)
+		glm::vec3(0.0f, 1.0f, 0.76f),
+		true
 	});
-	// Add more lights to reflect current scene
+	// Add more lights to reflect current scene, the static ones are baked in the lightmap
 	for (uint32_t i = 0; i < 8; ++i) {
 		LightSystem::setLight(1 + i, LightSystem::SpotLight{ 
 			glm::vec3(6.5f + 3.8f * i, 4.0f, 0.7f), 
@@ -75,7 +82,8 @@ int main() {
 			glm::vec3(1.0f, 1.0f, 0.0f),
 			glm::vec3(1.0f, 0.95f, 0.6f),
 			glm::vec3(1.0f, 1.0f, 0.0f),
-			15.0f, 0.2f, 0.65f, 0.2f
+			15.0f, 0.2f, 0.65f, 0.2f,
+			true
 		});
 	}
 	for (uint32_t i = 0; i < 8; ++i) {
@@ -86,7 +94,8 @@ int main() {
 			glm::vec3(1.0f, 1.0f, 0.0f),
 			glm::vec3(1.0f, 0.95f, 0.6f),
 			glm::vec3(1.0f, 1.0f, 0.0f),
-			15.0f, 0.2f, 0.65f, 0.2f
+			15.0f, 0.2f, 0.65f, 0.2f,
+			true
 		});
 	}
 	LightSystem::setLight(17, LightSystem::PointLight{
@@ -96,13 +105,28 @@ int main() {
 		glm::vec3(1.0f, 0.0f, 1.0f),
 		15.0f, 0.015f, 0.02f, 0.1f
 		});
+	// The sun, the street lamps and the purple light cast shadows, the window lights are too dim to need them
+	for (size_t i = 0; i <= 17; ++i) {
+		ShadowAtlas::addLight(i);
+	}
+	MainScene::setupWindowLights();
 	// Setup cubemap
 	std::shared_ptr<Mesh> cubemapMesh = Primitives::generateCube(1);
 	Renderer::setCubemap(cubemapMesh, MaterialLoader::load("cubemap"));
+	EnvironmentLighting::setCubemap("StarrySky");
 	// Setup dummy texture
 	Texture::dummyTexture = TextureLoader::load("dummy.png");
 	// Add objects to rendering queue
 	Renderer::setupOpengl();
+	// Bake impostors and HLODs and build the water once the OpenGL state is ready
+	MainScene::setupImpostors();
+	MainScene::setupHlods();
+	MainScene::setupAmbientOcclusion();
+	MainScene::setupLightmap();
+	MainScene::releaseBakeData();
+	MainScene::setupWater();
+	MainScene::setupReflectionProbes();
+	MainScene::setupShadows();
 	// Start the draw loop
 	double prevTime = glfwGetTime();
 	while (!window.shouldClose()) {
@@ -122,12 +146,15 @@ int main() {
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		// Get new GUI Frame
 		gui.newFrame(window.getDimensions());
+		// Animate the scene
+		MainScene::update(static_cast<float>(glfwGetTime()));
 		// Test draw
 		Renderer::renderAll(cam.getCameraMatrix(), cam.getViewMatrix(), cam.getProjectionMatrix(), cam.getTransform().getPosition());
 		// Draw gui
 		gui.drawLightsEditor();
 		gui.drawInspector(scene.get());
 		gui.drawControls();
+		gui.drawRendererSettings();
 		gui.drawResources();
 		gui.drawSelection(CameraControls::getSelection());
 		gui.endRendering();